@@ -0,0 +1,290 @@
+/*--------------------------------------------------------------------*/
+/* benchcompare.c                                                     */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* Compare the SymTable implementations with reference structures
+   through compare.h. The program is built once per subject:
+   benchcomparelist, benchcomparehash, benchcomparehamt and
+   benchcomparearray over the SymTable implementations, and benchcomparehsearch,
+   benchcomparetsearch and benchcompareunordered over glibc's
+   hsearch_r, tsearch and std::unordered_map. Every subject runs the
+   same workload: random keys (BENCH_RANDOM) are put into a new table,
+   looked up, looked up among keys never put, and freed.
+
+   Each binding count runs in a child process, so the peak resident
+   set size that the child reports covers that count alone. It
+   includes the keys of the workload, which are the same for every
+   subject. Bytes per binding are the heap bytes the table holds after
+   the puts, from mallinfo2, divided by the number of bindings; they
+   include the copies of the keys.
+
+   Usage: benchcompare<subject> [-n bindings,...] [-m max-bindings]
+      [-t trials] [-s seed]
+
+   Results are written to stdout as CSV, one row per binding count,
+   with median nanoseconds per operation. comparetable.awk turns the
+   rows of every subject into the table of the readme. */
+
+#define _GNU_SOURCE
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "compare.h"
+#include "benchutil.h"
+
+/* The separately timed phases of one trial, in the order they run. */
+
+enum Phase {PHASE_PUT, PHASE_GET, PHASE_MISS, PHASE_FREE, PHASE_COUNT};
+
+/* A trial repeats its phases on new tables until it has put at least
+   MIN_TRIAL_PUTS bindings or run for MIN_TRIAL_SECONDS, so that small
+   tables are timed over more than a few microseconds without making
+   the list implementation repeat its quadratic work. */
+enum {MIN_TRIAL_PUTS = 1000000};
+static const double MIN_TRIAL_SECONDS = 0.2;
+
+enum {DEFAULT_TRIALS = 3, DEFAULT_SEED = 217};
+
+static const char acDefaultBindings[] =
+   "50,500,5000,50000,500000,5000000";
+
+/*--------------------------------------------------------------------*/
+
+/* return the bytes of heap memory in use, from mallinfo2. */
+
+static size_t heapInUse(void)
+{
+   struct mallinfo2 sInfo = mallinfo2();
+   return sInfo.uordblks + sInfo.hblkhd;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run one trial over psKeys, storing the seconds each phase consumed
+   per operation in adSeconds. If puHeld is not NULL, store in *puHeld
+   the heap bytes held by the first table after its puts; only the
+   first trial measures them, since later trials reuse the chunks that
+   the earlier ones freed. Return 1 (TRUE) if every operation
+   produced the expected result, and 0 (FALSE) otherwise. */
+
+static int runTrial(const struct BenchKeys *psKeys,
+   double adSeconds[PHASE_COUNT], size_t *puHeld)
+{
+   Compare_T oCompare;
+   size_t uCount = psKeys->uCount;
+   size_t uGood = 0;
+   size_t uRound;
+   size_t uHeap;
+   size_t u;
+   double dTrialStart = Bench_now();
+   double dStart;
+
+   for (u = 0; u < PHASE_COUNT; u++)
+      adSeconds[u] = 0.0;
+
+   for (uRound = 0; uRound * uCount < MIN_TRIAL_PUTS &&
+         (uRound == 0 || Bench_now() - dTrialStart < MIN_TRIAL_SECONDS);
+         uRound++)
+   {
+      uHeap = heapInUse();
+      dStart = Bench_now();
+      oCompare = Compare_new(uCount);
+      if (oCompare == NULL)
+         return 0;
+      for (u = 0; u < uCount; u++)
+         uGood += (size_t)Compare_put(oCompare, psKeys->ppcKeys[u],
+            psKeys->ppcKeys[u]);
+      adSeconds[PHASE_PUT] += Bench_now() - dStart;
+      if (uRound == 0 && puHeld != NULL)
+         *puHeld = heapInUse() - uHeap;
+
+      dStart = Bench_now();
+      for (u = 0; u < uCount; u++)
+      {
+         const char *pcKey = psKeys->ppcKeys[psKeys->puLookups[u]];
+         uGood += (Compare_get(oCompare, pcKey) == pcKey);
+      }
+      adSeconds[PHASE_GET] += Bench_now() - dStart;
+
+      dStart = Bench_now();
+      for (u = 0; u < uCount; u++)
+         uGood += (Compare_get(oCompare,
+            psKeys->ppcKeys[uCount + u]) == NULL);
+      adSeconds[PHASE_MISS] += Bench_now() - dStart;
+
+      dStart = Bench_now();
+      Compare_free(oCompare);
+      adSeconds[PHASE_FREE] += Bench_now() - dStart;
+   }
+   for (u = 0; u < PHASE_COUNT; u++)
+      adSeconds[u] /= (double)(uCount * uRound);
+   return uGood == 3 * uCount * uRound;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run uTrials trials with uCount bindings and write their row to
+   stdout. Return 1 (TRUE) on success, or 0 (FALSE) if insufficient
+   memory is available or an operation produced a wrong result. */
+
+static int runCount(size_t uCount, size_t uTrials, uint64_t uSeed)
+{
+   struct BenchKeys sKeys;
+   struct BenchSummary asSummaries[PHASE_COUNT];
+   struct rusage sUsage;
+   double adTrial[PHASE_COUNT];
+   double *pdSeconds;
+   size_t uHeld = 0;
+   size_t uTrial;
+   int iPhase;
+   int iSuccessful = 1;
+
+   if (! Bench_makeKeys(&sKeys, BENCH_RANDOM, uCount, uSeed))
+      return 0;
+   pdSeconds = (double*)malloc(PHASE_COUNT * uTrials * sizeof(double));
+   if (pdSeconds == NULL)
+   {
+      Bench_freeKeys(&sKeys);
+      return 0;
+   }
+
+   for (uTrial = 0; uTrial < uTrials && iSuccessful; uTrial++)
+   {
+      iSuccessful = runTrial(&sKeys, adTrial,
+         uTrial == 0 ? &uHeld : NULL);
+      for (iPhase = 0; iPhase < PHASE_COUNT; iPhase++)
+         pdSeconds[iPhase * uTrials + uTrial] = adTrial[iPhase];
+   }
+
+   if (iSuccessful)
+   {
+      for (iPhase = 0; iPhase < PHASE_COUNT; iPhase++)
+         Bench_summarize(pdSeconds + iPhase * uTrials, uTrials,
+            &asSummaries[iPhase]);
+      getrusage(RUSAGE_SELF, &sUsage);
+      printf("%s,%lu,%lu,%.2f,%.2f,%.2f,%.2f,%.3f,%.3f,%ld,%.1f\n",
+         Compare_name, (unsigned long)uCount, (unsigned long)uTrials,
+         asSummaries[PHASE_PUT].dMedian * 1e9,
+         asSummaries[PHASE_GET].dMedian * 1e9,
+         asSummaries[PHASE_MISS].dMedian * 1e9,
+         asSummaries[PHASE_FREE].dMedian * 1e9,
+         1e-6 / asSummaries[PHASE_PUT].dMedian,
+         1e-6 / asSummaries[PHASE_GET].dMedian,
+         sUsage.ru_maxrss, (double)uHeld / (double)uCount);
+   }
+   else
+      fprintf(stderr, "%s: wrong result with %lu bindings\n",
+         Compare_name, (unsigned long)uCount);
+
+   free(pdSeconds);
+   Bench_freeKeys(&sKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write a usage message for program pcProgram to stderr. */
+
+static void usage(const char *pcProgram)
+{
+   fprintf(stderr,
+      "Usage: %s [-n bindings,...] [-m max-bindings] [-t trials] "
+      "[-s seed]\n"
+      "bindings default to %s; counts above max-bindings are "
+      "skipped\n", pcProgram, acDefaultBindings);
+}
+
+/* Run the comparison for the subject this program is linked with.
+   argv holds the options described by usage. Exit with EXIT_FAILURE
+   if the options are malformed or a run fails. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   char acBindings[256];
+   unsigned long ulMax = 0;
+   unsigned long ulTrials = DEFAULT_TRIALS;
+   unsigned long ulSeed = DEFAULT_SEED;
+   unsigned long ulCount;
+   unsigned long *pulOption;
+   char *pcCount;
+   pid_t iChild;
+   int iStatus;
+   int i;
+
+   strcpy(acBindings, acDefaultBindings);
+   for (i = 1; i < argc; i += 2)
+   {
+      if (i + 1 >= argc)
+      {
+         usage(argv[0]);
+         exit(EXIT_FAILURE);
+      }
+      if (strcmp(argv[i], "-n") == 0)
+      {
+         if (strlen(argv[i + 1]) >= sizeof(acBindings))
+         {
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+         }
+         strcpy(acBindings, argv[i + 1]);
+         continue;
+      }
+      if (strcmp(argv[i], "-m") == 0)
+         pulOption = &ulMax;
+      else if (strcmp(argv[i], "-t") == 0)
+         pulOption = &ulTrials;
+      else if (strcmp(argv[i], "-s") == 0)
+         pulOption = &ulSeed;
+      else
+         pulOption = NULL;
+      if (pulOption == NULL ||
+            sscanf(argv[i + 1], "%lu", pulOption) != 1 || ulTrials == 0)
+      {
+         usage(argv[0]);
+         exit(EXIT_FAILURE);
+      }
+   }
+
+   printf("backend,bindings,trials,put_ns,get_ns,miss_ns,free_ns,"
+      "put_mops,get_mops,peak_rss_kib,bytes_per_binding\n");
+   for (pcCount = strtok(acBindings, ","); pcCount != NULL;
+         pcCount = strtok(NULL, ","))
+   {
+      if (sscanf(pcCount, "%lu", &ulCount) != 1 || ulCount == 0)
+      {
+         usage(argv[0]);
+         exit(EXIT_FAILURE);
+      }
+      if (ulMax != 0 && ulCount > ulMax)
+         continue;
+
+      /* the child must not inherit unwritten output */
+      fflush(stdout);
+      iChild = fork();
+      if (iChild < 0)
+      {
+         perror(argv[0]);
+         exit(EXIT_FAILURE);
+      }
+      if (iChild == 0)
+      {
+         i = runCount((size_t)ulCount, (size_t)ulTrials,
+            (uint64_t)ulSeed);
+         fflush(stdout);
+         _exit(i ? 0 : 1);
+      }
+      if (waitpid(iChild, &iStatus, 0) != iChild ||
+            ! WIFEXITED(iStatus) || WEXITSTATUS(iStatus) != 0)
+      {
+         fprintf(stderr, "%s: the run with %lu bindings failed\n",
+            argv[0], ulCount);
+         exit(EXIT_FAILURE);
+      }
+   }
+   return 0;
+}
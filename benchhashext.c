@@ -0,0 +1,2607 @@
+/*--------------------------------------------------------------------*/
+/* benchhashext.c                                                     */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* Benchmark the extensions of the hash table implementation
+   (symtablehash.h) and the typed tables of symtablegen.h. Each
+   workload (-w) exercises one of them:
+
+   flood   keys chosen to land in a single bucket. An attacker who
+           knows a table's hash key can pick such keys, so the
+           benchmark plays that attacker with SymTable_newSeeded and
+           SymTable_bucketOf, and compares the default tree fallback
+           ("flood-tree") with plain chains ("flood-chain").
+   image   starting up from an image: rebuilding a table with puts
+           versus SymTable_openMapped, which checks the image, and
+           SymTable_openMappedTrusted, which does not, on an image
+           written by SymTable_save.
+   freeze  lookups in a live table versus the perfect hash table
+           SymTable_freeze makes of it.
+   snapshot a consistent view of a table that keeps changing: copying
+           the table versus SymTable_snapshot, and the cost of the
+           writes that follow either. Built with SYMTABLE_STATS, it
+           also reports the allocations each write makes to preserve
+           the snapshot's view (its write amplification).
+   scope   names resolved through SCOPE_DEPTH nested scopes: one table
+           per scope searched innermost first with SymTable_get
+           ("chained") versus one SymTableScope object ("scope"), and
+           the cost of entering and leaving the scopes with either.
+   filter  lookups of which 9 in 10 miss, in a table without a
+           filter ("plain") versus one with a filter
+           (SymTable_setFilter), and the cost of filling either.
+   typed   integer keys and values of type double: formatted into
+           strings and boxed in SymTable_T ("string") versus stored as
+           they are in a table from symtablegen.h ("typed").
+   tiny    many tables of a few bindings each, held at once: the cost
+           of creating, filling, reading and freeing them, and the
+           heap each holds.
+   sharded 1 to 64 threads making a mix of puts, gets and removes on
+           one table: a single lock ("global") versus the shards of
+           SymTable_newSharded ("sharded").
+   writers 1 to 64 threads putting and removing keys on one sharded
+           table and reading its length after each: not at all,
+           without locks (SymTable_getLength) or under every lock
+           (SymTable_getExactLength).
+   writer  random keys put one at a time with SymTable_put ("direct")
+           versus logged by a writer and applied bucket by bucket
+           (SymTable_writerPut), and lookups in either table.
+   build   a table made from an array of random keys with SymTable_put
+           versus SymTable_buildParallel with 1 thread up to one per
+           processor.
+   text    a table written to a text file and read back: fprintf and
+           fgets versus SymTableText_dump and SymTableText_load.
+   latency random keys put and looked up in a table that is not timed
+           versus one timed by SymTable_setTracing, and the
+           percentiles of the timed table's latencies.
+
+   Results are written to stdout as CSV, in the format of
+   benchsymtable.c. */
+
+#include <assert.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "symtablehash.h"
+#include "symtablescope.h"
+#include "symtabletext.h"
+#include "benchutil.h"
+
+/* the table of the typed workload */
+#define SYMTABLE_GEN_NAME IntTable
+#define SYMTABLE_GEN_KEY long
+#define SYMTABLE_GEN_VALUE double
+#define SYMTABLE_GEN_HASH(key) SymTableGen_hashInteger((uint64_t)(key))
+#include "symtablegen.h"
+
+enum {DEFAULT_TRIALS = 5, DEFAULT_SEED = 217};
+
+/* the workloads, and the number of bindings each uses unless -n is
+   given */
+enum Workload {WORKLOAD_FLOOD, WORKLOAD_IMAGE, WORKLOAD_FREEZE,
+   WORKLOAD_SNAPSHOT, WORKLOAD_SCOPE, WORKLOAD_FILTER,
+   WORKLOAD_TYPED, WORKLOAD_TINY, WORKLOAD_SHARDED, WORKLOAD_WRITERS,
+   WORKLOAD_WRITER, WORKLOAD_BUILD, WORKLOAD_TEXT,
+   WORKLOAD_LATENCY, WORKLOAD_COUNT};
+
+static const char *apcWorkloadNames[WORKLOAD_COUNT] = {
+   "flood", "image", "freeze", "snapshot", "scope", "filter", "typed",
+   "tiny", "sharded", "writers", "writer", "build", "text",
+   "latency"
+};
+
+static const size_t auDefaultBindings[WORKLOAD_COUNT] = {
+   4000, 1000000, 100000, 500000, 100000, 100000, 1000000, 100000,
+   100000, 100000, 1000000, 1000000, 1000000, 1000000
+};
+
+/* the file that holds the image of the image workload */
+static const char *pcImagePath = "benchhashext.img";
+
+/* the longest key the benchmark crafts, including '\0' */
+enum {KEY_SIZE = 24};
+
+/* the tree threshold of SymTable_new tables */
+enum {DEFAULT_TREE_THRESHOLD = 8};
+
+/*--------------------------------------------------------------------*/
+
+/* Fill acKeys with uCount distinct decimal keys that all land in one
+   bucket of a table with hash key (uSeed, ~uSeed) once that table
+   holds uCount bindings. The table grows as the keys go in, so the
+   keys are picked against a table that has already grown to its
+   final bucket count. Return 1 (TRUE) on success or 0 (FALSE) if
+   insufficient memory is available. */
+
+static int makeFloodKeys(char acKeys[][KEY_SIZE], size_t uCount,
+   uint64_t uSeed)
+{
+   SymTable_T oSymTable;
+   size_t uBucket;
+   size_t uFound = 0;
+   unsigned long ul;
+
+   oSymTable = SymTable_newSeeded(uSeed, ~uSeed);
+   if (oSymTable == NULL)
+      return 0;
+   for (ul = 0; ul < uCount; ul++)
+   {
+      sprintf(acKeys[0], "filler%lu", ul);
+      if (! SymTable_put(oSymTable, acKeys[0], NULL))
+      {
+         SymTable_free(oSymTable);
+         return 0;
+      }
+   }
+   uBucket = SymTable_bucketOf(oSymTable, "0");
+   for (ul = 0; uFound < uCount; ul++)
+   {
+      sprintf(acKeys[uFound], "%lu", ul);
+      if (SymTable_bucketOf(oSymTable, acKeys[uFound]) == uBucket)
+         uFound++;
+   }
+   SymTable_free(oSymTable);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run one trial: put the uCount keys of acKeys into a table with hash
+   key (uSeed, ~uSeed) and tree threshold uThreshold, then get each of
+   them. Store the seconds consumed by the puts in *pdPut and by the
+   gets in *pdGet. Return 1 (TRUE) if every operation produced the
+   expected result, and 0 (FALSE) otherwise. */
+
+static int runTrial(char acKeys[][KEY_SIZE], size_t uCount,
+   uint64_t uSeed, size_t uThreshold, double *pdPut, double *pdGet)
+{
+   SymTable_T oSymTable;
+   size_t u;
+   size_t uGood = 0;
+   double dStart;
+
+   oSymTable = SymTable_newSeeded(uSeed, ~uSeed);
+   if (oSymTable == NULL)
+      return 0;
+   SymTable_setTreeThreshold(oSymTable, uThreshold);
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+      uGood += (size_t)SymTable_put(oSymTable, acKeys[u], acKeys[u]);
+   *pdPut = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+      uGood += (SymTable_get(oSymTable, acKeys[u]) == acKeys[u]);
+   *pdGet = Bench_now() - dStart;
+
+   SymTable_free(oSymTable);
+   return uGood == 2 * uCount;
+}
+
+/* Benchmark uCount flood keys with tree threshold uThreshold over
+   uTrials trials, writing one CSV row per phase to stdout under the
+   workload name pcWorkload. Return 1 (TRUE) on success and 0 (FALSE)
+   on failure. */
+
+static int benchFlood(const char *pcWorkload, char acKeys[][KEY_SIZE],
+   size_t uCount, size_t uTrials, uint64_t uSeed, size_t uThreshold)
+{
+   struct BenchSummary sSummary;
+   double *pdPut;
+   double *pdGet;
+   size_t uTrial;
+   int iSuccessful = 1;
+
+   pdPut = (double*)malloc(uTrials * sizeof(double));
+   pdGet = (double*)malloc(uTrials * sizeof(double));
+   if (pdPut == NULL || pdGet == NULL)
+   {
+      free(pdPut);
+      free(pdGet);
+      return 0;
+   }
+
+   for (uTrial = 0; uTrial < uTrials && iSuccessful; uTrial++)
+      iSuccessful = runTrial(acKeys, uCount, uSeed, uThreshold,
+         &pdPut[uTrial], &pdGet[uTrial]);
+
+   if (iSuccessful)
+   {
+      Bench_summarize(pdPut, uTrials, &sSummary);
+      Bench_writeRow(stdout, "hash", pcWorkload, "put", uCount, uCount,
+         uTrials, &sSummary, -1.0);
+      Bench_summarize(pdGet, uTrials, &sSummary);
+      Bench_writeRow(stdout, "hash", pcWorkload, "get", uCount, uCount,
+         uTrials, &sSummary, -1.0);
+   }
+   else
+      fprintf(stderr, "hash: wrong result for workload %s\n",
+         pcWorkload);
+
+   free(pdPut);
+   free(pdGet);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Benchmark the flood workload with uCount bindings over uTrials
+   trials. Return 1 (TRUE) on success and 0 (FALSE) on failure. */
+
+static int benchFloodWorkload(size_t uCount, size_t uTrials,
+   uint64_t uSeed)
+{
+   char (*acKeys)[KEY_SIZE];
+   int iSuccessful;
+
+   acKeys = malloc((uCount + 1) * sizeof(*acKeys));
+   if (acKeys == NULL || ! makeFloodKeys(acKeys, uCount, uSeed))
+   {
+      free(acKeys);
+      return 0;
+   }
+   iSuccessful = benchFlood("flood-tree", acKeys, uCount, uTrials, uSeed,
+         DEFAULT_TREE_THRESHOLD) &&
+      benchFlood("flood-chain", acKeys, uCount, uTrials, uSeed, 0);
+   free(acKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* the most phases a trial of a workload times */
+enum {MAX_PHASE_COUNT = 8};
+
+/* A trial function runs trial uTrial of a workload with context
+   pvTrial, storing the seconds consumed by each phase in adSeconds.
+   It returns 1 (TRUE) if every operation produced the expected
+   result, and 0 (FALSE) otherwise. */
+
+typedef int (*TrialFunction)(void *pvTrial, size_t uTrial,
+   double adSeconds[MAX_PHASE_COUNT]);
+
+/* Run uTrials trials of pfTrial with context pvTrial, each timing
+   iPhases phases, storing the seconds consumed by phase iPhase of
+   trial uTrial in pdSeconds[iPhase * uTrials + uTrial]. Stop at the
+   first trial that fails, without storing any of its phases. Return
+   1 (TRUE) if every trial succeeded, and 0 (FALSE) otherwise. */
+
+static int runTrials(TrialFunction pfTrial, void *pvTrial, int iPhases,
+   size_t uTrials, double *pdSeconds)
+{
+   double adTrial[MAX_PHASE_COUNT];
+   size_t uTrial;
+   int iPhase;
+
+   assert(iPhases <= MAX_PHASE_COUNT);
+
+   for (uTrial = 0; uTrial < uTrials; uTrial++)
+   {
+      if (! pfTrial(pvTrial, uTrial, adTrial))
+         return 0;
+      for (iPhase = 0; iPhase < iPhases; iPhase++)
+         pdSeconds[iPhase * uTrials + uTrial] = adTrial[iPhase];
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The separately timed phases of one image trial, in the order they
+   run, and the number of operations each times for uCount bindings:
+   rebuild is the start-up cost of a table built with puts, open and
+   open-trusted the start-up cost of a mapped image up to its first
+   lookup, with and without checking the image. */
+
+enum ImagePhase {IMAGE_REBUILD, IMAGE_SAVE, IMAGE_OPEN, IMAGE_OPEN_TRUSTED,
+   IMAGE_GET_LIVE, IMAGE_GET_MAPPED, IMAGE_PHASE_COUNT};
+
+static const char *apcImagePhaseNames[IMAGE_PHASE_COUNT] = {
+   "rebuild", "save", "open", "open-trusted", "get-live", "get-mapped"
+};
+
+static size_t imagePhaseOps(int iPhase, size_t uCount)
+{
+   return iPhase == IMAGE_OPEN || iPhase == IMAGE_OPEN_TRUSTED ? 1 :
+      uCount;
+}
+
+/* the key array whose slots are the values of the image workload */
+static const void *pvKeyBase;
+
+/* Write the index of pvValue, the address of a slot of the key array
+   at pvKeyBase, as 8 bytes into pvBuffer if uSize allows, and return
+   8. */
+
+static size_t encodeIndex(const void *pvValue, void *pvBuffer,
+   size_t uSize)
+{
+   uint64_t uIndex;
+   uIndex = (uint64_t)((const char* const*)pvValue -
+      (const char* const*)pvKeyBase);
+   if (uSize >= sizeof(uIndex))
+      memcpy(pvBuffer, &uIndex, sizeof(uIndex));
+   return sizeof(uIndex);
+}
+
+/* Run one image trial over psKeys, storing the seconds consumed by
+   each phase in adSeconds. Return 1 (TRUE) if every operation
+   produced the expected result, and 0 (FALSE) otherwise. */
+
+static int runImageTrial(const struct BenchKeys *psKeys,
+   double adSeconds[IMAGE_PHASE_COUNT])
+{
+   SymTable_T oSymTable;
+   SymTable_T oMapped;
+   FILE *psFile;
+   size_t uCount = psKeys->uCount;
+   size_t uGood = 0;
+   size_t u;
+   double dStart;
+   int iSaved;
+
+   /* Each binding's value is the address of its key's slot in
+      ppcKeys, which encodeIndex turns into the key's index. */
+   pvKeyBase = psKeys->ppcKeys;
+   dStart = Bench_now();
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return 0;
+   for (u = 0; u < uCount; u++)
+      uGood += (size_t)SymTable_put(oSymTable, psKeys->ppcKeys[u],
+         &psKeys->ppcKeys[u]);
+   adSeconds[IMAGE_REBUILD] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   psFile = fopen(pcImagePath, "wb");
+   iSaved = psFile != NULL &&
+      SymTable_save(oSymTable, psFile, encodeIndex);
+   if (psFile != NULL)
+      iSaved &= fclose(psFile) == 0;
+   adSeconds[IMAGE_SAVE] = Bench_now() - dStart;
+   if (! iSaved)
+   {
+      SymTable_free(oSymTable);
+      return 0;
+   }
+
+   dStart = Bench_now();
+   oMapped = SymTable_openMapped(pcImagePath);
+   if (oMapped == NULL)
+   {
+      SymTable_free(oSymTable);
+      return 0;
+   }
+   uGood += SymTable_contains(oMapped, psKeys->ppcKeys[0]);
+   adSeconds[IMAGE_OPEN] = Bench_now() - dStart;
+   SymTable_free(oMapped);
+
+   dStart = Bench_now();
+   oMapped = SymTable_openMappedTrusted(pcImagePath);
+   if (oMapped == NULL)
+   {
+      SymTable_free(oSymTable);
+      return 0;
+   }
+   uGood += SymTable_contains(oMapped, psKeys->ppcKeys[0]);
+   adSeconds[IMAGE_OPEN_TRUSTED] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+   {
+      size_t uIndex = psKeys->puLookups[u];
+      uGood += (SymTable_get(oSymTable, psKeys->ppcKeys[uIndex]) ==
+         &psKeys->ppcKeys[uIndex]);
+   }
+   adSeconds[IMAGE_GET_LIVE] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+   {
+      size_t uIndex = psKeys->puLookups[u];
+      const uint64_t *puValue = SymTable_get(oMapped,
+         psKeys->ppcKeys[uIndex]);
+      uGood += (puValue != NULL && *puValue == (uint64_t)uIndex);
+   }
+   adSeconds[IMAGE_GET_MAPPED] = Bench_now() - dStart;
+
+   SymTable_free(oMapped);
+   SymTable_free(oSymTable);
+   return uGood == 3 * uCount + 2;
+}
+
+/* Run one image trial over the keys pvKeys: a TrialFunction. */
+
+static int imageTrial(void *pvKeys, size_t uTrial,
+   double adSeconds[MAX_PHASE_COUNT])
+{
+   (void)uTrial;
+   return runImageTrial((const struct BenchKeys*)pvKeys, adSeconds);
+}
+
+/* Benchmark the image workload with uCount random keys over uTrials
+   trials. Return 1 (TRUE) on success and 0 (FALSE) on failure. */
+
+static int benchImageWorkload(size_t uCount, size_t uTrials,
+   uint64_t uSeed)
+{
+   struct BenchKeys sKeys;
+   struct BenchSummary sSummary;
+   double *pdSeconds;
+   int iPhase;
+   int iSuccessful = 1;
+
+   if (! Bench_makeKeys(&sKeys, BENCH_RANDOM, uCount, uSeed))
+      return 0;
+   pdSeconds = (double*)
+      malloc(IMAGE_PHASE_COUNT * uTrials * sizeof(double));
+   if (pdSeconds == NULL)
+   {
+      Bench_freeKeys(&sKeys);
+      return 0;
+   }
+
+   iSuccessful = runTrials(imageTrial, &sKeys, IMAGE_PHASE_COUNT, uTrials,
+      pdSeconds);
+   (void)remove(pcImagePath);
+
+   if (iSuccessful)
+      for (iPhase = 0; iPhase < IMAGE_PHASE_COUNT; iPhase++)
+      {
+         Bench_summarize(pdSeconds + iPhase * uTrials, uTrials,
+            &sSummary);
+         Bench_writeRow(stdout, "hash", "image",
+            apcImagePhaseNames[iPhase], uCount,
+            imagePhaseOps(iPhase, uCount), uTrials, &sSummary, -1.0);
+      }
+   else
+      fprintf(stderr, "hash: wrong result for workload image\n");
+
+   free(pdSeconds);
+   Bench_freeKeys(&sKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The separately timed phases of one freeze trial, in the order they
+   run. */
+
+enum FreezePhase {FREEZE_FREEZE, FREEZE_GET_LIVE, FREEZE_GET_FROZEN,
+   FREEZE_MISS_LIVE, FREEZE_MISS_FROZEN, FREEZE_PHASE_COUNT};
+
+static const char *apcFreezePhaseNames[FREEZE_PHASE_COUNT] = {
+   "freeze", "get-live", "get-frozen", "miss-live", "miss-frozen"
+};
+
+/* Time uCount lookups of the keys of psKeys in oSymTable, the hits in
+   lookup order if iHits and the misses otherwise. Store in *puGood the
+   number of correct results. Return the seconds consumed. */
+
+static double timeLookups(SymTable_T oSymTable,
+   const struct BenchKeys *psKeys, int iHits, size_t *puGood)
+{
+   size_t uCount = psKeys->uCount;
+   size_t u;
+   double dStart;
+
+   dStart = Bench_now();
+   if (iHits)
+      for (u = 0; u < uCount; u++)
+      {
+         const char *pcKey = psKeys->ppcKeys[psKeys->puLookups[u]];
+         *puGood += (SymTable_get(oSymTable, pcKey) == pcKey);
+      }
+   else
+      for (u = 0; u < uCount; u++)
+         *puGood += (SymTable_get(oSymTable,
+            psKeys->ppcKeys[uCount + u]) == NULL);
+   return Bench_now() - dStart;
+}
+
+/* Run one freeze trial over psKeys, storing the seconds consumed by
+   each phase in adSeconds. Return 1 (TRUE) if every operation
+   produced the expected result, and 0 (FALSE) otherwise. */
+
+static int runFreezeTrial(const struct BenchKeys *psKeys,
+   double adSeconds[FREEZE_PHASE_COUNT])
+{
+   SymTable_T oSymTable;
+   SymTable_T oFrozen;
+   size_t uCount = psKeys->uCount;
+   size_t uGood = 0;
+   size_t u;
+   double dStart;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return 0;
+   for (u = 0; u < uCount; u++)
+      uGood += (size_t)SymTable_put(oSymTable, psKeys->ppcKeys[u],
+         psKeys->ppcKeys[u]);
+
+   dStart = Bench_now();
+   oFrozen = SymTable_freeze(oSymTable);
+   adSeconds[FREEZE_FREEZE] = Bench_now() - dStart;
+   if (oFrozen == NULL)
+   {
+      SymTable_free(oSymTable);
+      return 0;
+   }
+
+   adSeconds[FREEZE_GET_LIVE] = timeLookups(oSymTable, psKeys, 1, &uGood);
+   adSeconds[FREEZE_GET_FROZEN] = timeLookups(oFrozen, psKeys, 1, &uGood);
+   adSeconds[FREEZE_MISS_LIVE] = timeLookups(oSymTable, psKeys, 0, &uGood);
+   adSeconds[FREEZE_MISS_FROZEN] = timeLookups(oFrozen, psKeys, 0, &uGood);
+
+   SymTable_free(oFrozen);
+   SymTable_free(oSymTable);
+   return uGood == 5 * uCount;
+}
+
+/* Run one freeze trial over the keys pvKeys: a TrialFunction. */
+
+static int freezeTrial(void *pvKeys, size_t uTrial,
+   double adSeconds[MAX_PHASE_COUNT])
+{
+   (void)uTrial;
+   return runFreezeTrial((const struct BenchKeys*)pvKeys, adSeconds);
+}
+
+/* Benchmark the freeze workload with uCount random keys over uTrials
+   trials. Return 1 (TRUE) on success and 0 (FALSE) on failure. */
+
+static int benchFreezeWorkload(size_t uCount, size_t uTrials,
+   uint64_t uSeed)
+{
+   struct BenchKeys sKeys;
+   struct BenchSummary sSummary;
+   double *pdSeconds;
+   int iPhase;
+   int iSuccessful = 1;
+
+   if (! Bench_makeKeys(&sKeys, BENCH_RANDOM, uCount, uSeed))
+      return 0;
+   pdSeconds = (double*)
+      malloc(FREEZE_PHASE_COUNT * uTrials * sizeof(double));
+   if (pdSeconds == NULL)
+   {
+      Bench_freeKeys(&sKeys);
+      return 0;
+   }
+
+   iSuccessful = runTrials(freezeTrial, &sKeys, FREEZE_PHASE_COUNT, uTrials,
+      pdSeconds);
+
+   if (iSuccessful)
+      for (iPhase = 0; iPhase < FREEZE_PHASE_COUNT; iPhase++)
+      {
+         Bench_summarize(pdSeconds + iPhase * uTrials, uTrials,
+            &sSummary);
+         Bench_writeRow(stdout, "hash", "freeze",
+            apcFreezePhaseNames[iPhase], uCount, uCount, uTrials,
+            &sSummary, -1.0);
+      }
+   else
+      fprintf(stderr, "hash: wrong result for workload freeze\n");
+
+   free(pdSeconds);
+   Bench_freeKeys(&sKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The separately timed phases of one snapshot trial, in the order
+   they run: copy and snapshot each take one view of the whole table;
+   the replaces change 1 binding in SNAPSHOT_WRITE_DIVISOR, in random
+   order, with no view and with a snapshot outstanding; the maps visit
+   the live table and the snapshot. */
+
+enum SnapshotPhase {SNAPSHOT_COPY, SNAPSHOT_SNAPSHOT, SNAPSHOT_REPLACE_LIVE,
+   SNAPSHOT_REPLACE_SNAPSHOT, SNAPSHOT_MAP_LIVE, SNAPSHOT_MAP_SNAPSHOT,
+   SNAPSHOT_PHASE_COUNT};
+
+static const char *apcSnapshotPhaseNames[SNAPSHOT_PHASE_COUNT] = {
+   "copy", "snapshot", "replace-live", "replace-snapshot", "map-live",
+   "map-snapshot"
+};
+
+enum {SNAPSHOT_WRITE_DIVISOR = 100};
+
+static size_t snapshotPhaseOps(int iPhase, size_t uCount)
+{
+   switch (iPhase)
+   {
+      case SNAPSHOT_COPY:
+      case SNAPSHOT_SNAPSHOT:
+         return 1;
+      case SNAPSHOT_REPLACE_LIVE:
+      case SNAPSHOT_REPLACE_SNAPSHOT:
+         return uCount / SNAPSHOT_WRITE_DIVISOR;
+      default:
+         return uCount;
+   }
+}
+
+/* Put the binding of pcKey and pvValue into the table pvExtra. */
+
+static void copyBinding(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   (void)SymTable_put((SymTable_T)pvExtra, pcKey, pvValue);
+}
+
+/* Add 1 to the count at pvExtra if pvValue is the key itself, as the
+   snapshot workload binds every key before replacing values with
+   NULL. */
+
+static void countOriginal(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   *(size_t*)pvExtra += (pvValue != NULL &&
+      strcmp(pcKey, (const char*)pvValue) == 0);
+}
+
+/* Replace the values of the first uCount / SNAPSHOT_WRITE_DIVISOR
+   keys of psKeys in lookup order in oSymTable with NULL. Add to
+   *puGood the number of replaces that found their key. Return the
+   seconds consumed. */
+
+static double timeReplaces(SymTable_T oSymTable,
+   const struct BenchKeys *psKeys, size_t *puGood)
+{
+   size_t uWrites = psKeys->uCount / SNAPSHOT_WRITE_DIVISOR;
+   size_t u;
+   double dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < uWrites; u++)
+   {
+      size_t uIndex = psKeys->puLookups[u];
+      *puGood += (SymTable_replace(oSymTable, psKeys->ppcKeys[uIndex],
+         NULL) != NULL);
+   }
+   return Bench_now() - dStart;
+}
+
+/* Run one snapshot trial over psKeys, storing the seconds consumed by
+   each phase in adSeconds and the allocations counted during the
+   replaces with a snapshot outstanding in *puAllocs. Return 1 (TRUE)
+   if every operation produced the expected result, and 0 (FALSE)
+   otherwise. */
+
+static int runSnapshotTrial(const struct BenchKeys *psKeys,
+   double adSeconds[SNAPSHOT_PHASE_COUNT], size_t *puAllocs)
+{
+   SymTable_T oSymTable;
+   SymTable_T oCopy;
+   SymTable_T oSnapshot;
+   struct SymTableStats sStats;
+   size_t uCount = psKeys->uCount;
+   size_t uWrites = uCount / SNAPSHOT_WRITE_DIVISOR;
+   size_t uGood = 0;
+   size_t uOriginals = 0;
+   size_t u;
+   double dStart;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return 0;
+   for (u = 0; u < uCount; u++)
+      uGood += (size_t)SymTable_put(oSymTable, psKeys->ppcKeys[u],
+         psKeys->ppcKeys[u]);
+
+   dStart = Bench_now();
+   oCopy = SymTable_new();
+   if (oCopy != NULL)
+      SymTable_map(oSymTable, copyBinding, oCopy);
+   adSeconds[SNAPSHOT_COPY] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   oSnapshot = SymTable_snapshot(oSymTable);
+   adSeconds[SNAPSHOT_SNAPSHOT] = Bench_now() - dStart;
+   if (oCopy == NULL || oSnapshot == NULL)
+   {
+      if (oCopy != NULL)
+         SymTable_free(oCopy);
+      if (oSnapshot != NULL)
+         SymTable_free(oSnapshot);
+      SymTable_free(oSymTable);
+      return 0;
+   }
+
+   adSeconds[SNAPSHOT_REPLACE_LIVE] = timeReplaces(oCopy, psKeys, &uGood);
+   SymTable_resetStats(oSymTable);
+   adSeconds[SNAPSHOT_REPLACE_SNAPSHOT] = timeReplaces(oSymTable, psKeys,
+      &uGood);
+   SymTable_getStats(oSymTable, &sStats);
+   *puAllocs = sStats.uAllocs;
+
+   dStart = Bench_now();
+   SymTable_map(oSymTable, countOriginal, &uOriginals);
+   adSeconds[SNAPSHOT_MAP_LIVE] = Bench_now() - dStart;
+   uGood += (uOriginals == uCount - uWrites);
+
+   uOriginals = 0;
+   dStart = Bench_now();
+   SymTable_map(oSnapshot, countOriginal, &uOriginals);
+   adSeconds[SNAPSHOT_MAP_SNAPSHOT] = Bench_now() - dStart;
+   uGood += (uOriginals == uCount);
+
+   SymTable_free(oSnapshot);
+   SymTable_free(oCopy);
+   SymTable_free(oSymTable);
+   return uGood == uCount + 2 * uWrites + 2;
+}
+
+/* the context of the trials of the snapshot workload */
+struct SnapshotTrial
+{
+   /* the keys */
+   const struct BenchKeys *psKeys;
+
+   /* where to accumulate the allocations of the replaces */
+   size_t *puAllocs;
+};
+
+/* Run one snapshot trial with the struct SnapshotTrial pvTrial: a
+   TrialFunction. */
+
+static int snapshotTrial(void *pvTrial, size_t uTrial,
+   double adSeconds[MAX_PHASE_COUNT])
+{
+   struct SnapshotTrial *psTrial = (struct SnapshotTrial*)pvTrial;
+   (void)uTrial;
+   return runSnapshotTrial(psTrial->psKeys, adSeconds, psTrial->puAllocs);
+}
+
+/* Benchmark the snapshot workload with uCount random keys over
+   uTrials trials. Return 1 (TRUE) on success and 0 (FALSE) on
+   failure. */
+
+static int benchSnapshotWorkload(size_t uCount, size_t uTrials,
+   uint64_t uSeed)
+{
+   struct BenchKeys sKeys;
+   struct BenchSummary sSummary;
+   struct SnapshotTrial sTrial;
+   double *pdSeconds;
+   size_t uAllocs = 0;
+   size_t uWrites = uCount / SNAPSHOT_WRITE_DIVISOR;
+   int iPhase;
+   int iSuccessful = 1;
+
+   if (! Bench_makeKeys(&sKeys, BENCH_RANDOM, uCount, uSeed))
+      return 0;
+   pdSeconds = (double*)
+      malloc(SNAPSHOT_PHASE_COUNT * uTrials * sizeof(double));
+   if (pdSeconds == NULL)
+   {
+      Bench_freeKeys(&sKeys);
+      return 0;
+   }
+
+   sTrial.psKeys = &sKeys;
+   sTrial.puAllocs = &uAllocs;
+   iSuccessful = runTrials(snapshotTrial, &sTrial, SNAPSHOT_PHASE_COUNT,
+      uTrials, pdSeconds);
+
+   if (iSuccessful)
+   {
+      for (iPhase = 0; iPhase < SNAPSHOT_PHASE_COUNT; iPhase++)
+      {
+         Bench_summarize(pdSeconds + iPhase * uTrials, uTrials,
+            &sSummary);
+         Bench_writeRow(stdout, "hash", "snapshot",
+            apcSnapshotPhaseNames[iPhase], uCount,
+            snapshotPhaseOps(iPhase, uCount), uTrials, &sSummary, -1.0);
+      }
+      /* the counters read 0 unless the table counts them */
+      if (uAllocs != 0 && uWrites != 0)
+         fprintf(stderr, "hash: snapshot: %.2f allocations per replace\n",
+            (double)uAllocs / (double)uWrites);
+   }
+   else
+      fprintf(stderr, "hash: wrong result for workload snapshot\n");
+
+   free(pdSeconds);
+   Bench_freeKeys(&sKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The scope workload spreads its keys evenly over SCOPE_DEPTH nested
+   scopes, the first uCount / SCOPE_DEPTH in the outermost, and
+   resolves them in random order from the innermost scope, so an
+   average lookup walks half the scopes. */
+
+enum ScopePhase {SCOPE_ENTER_CHAINED, SCOPE_ENTER_SCOPE,
+   SCOPE_RESOLVE_CHAINED, SCOPE_RESOLVE_SCOPE, SCOPE_EXIT_CHAINED,
+   SCOPE_EXIT_SCOPE, SCOPE_PHASE_COUNT};
+
+static const char *apcScopePhaseNames[SCOPE_PHASE_COUNT] = {
+   "enter-chained", "enter-scope", "resolve-chained", "resolve-scope",
+   "exit-chained", "exit-scope"
+};
+
+enum {SCOPE_DEPTH = 16};
+
+/* Return the scope of the scope workload that binds key uKey of
+   uCount. */
+
+static size_t scopeOf(size_t uKey, size_t uCount)
+{
+   return uKey * SCOPE_DEPTH / uCount;
+}
+
+/* Run one scope trial over psKeys, storing the seconds consumed by
+   each phase in adSeconds. Return 1 (TRUE) if every operation
+   produced the expected result, and 0 (FALSE) otherwise. */
+
+static int runScopeTrial(const struct BenchKeys *psKeys,
+   double adSeconds[SCOPE_PHASE_COUNT])
+{
+   SymTable_T aoTables[SCOPE_DEPTH];
+   SymTableScope_T oScope;
+   size_t uCount = psKeys->uCount;
+   size_t uGood = 0;
+   size_t uDepth;
+   size_t u;
+   void *pvValue;
+   double dStart;
+   int iDepth;
+
+   dStart = Bench_now();
+   for (uDepth = 0, u = 0; uDepth < SCOPE_DEPTH; uDepth++)
+   {
+      aoTables[uDepth] = SymTable_new();
+      if (aoTables[uDepth] == NULL)
+      {
+         while (uDepth > 0)
+            SymTable_free(aoTables[--uDepth]);
+         return 0;
+      }
+      for (; u < uCount && scopeOf(u, uCount) == uDepth; u++)
+         uGood += (size_t)SymTable_put(aoTables[uDepth],
+            psKeys->ppcKeys[u], psKeys->ppcKeys[u]);
+   }
+   adSeconds[SCOPE_ENTER_CHAINED] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   oScope = SymTableScope_new();
+   for (uDepth = 0, u = 0; oScope != NULL && uDepth < SCOPE_DEPTH;
+         uDepth++)
+   {
+      if (uDepth > 0)
+         uGood += (size_t)SymTableScope_push(oScope);
+      for (; u < uCount && scopeOf(u, uCount) == uDepth; u++)
+         uGood += (size_t)SymTableScope_put(oScope, psKeys->ppcKeys[u],
+            psKeys->ppcKeys[u]);
+   }
+   adSeconds[SCOPE_ENTER_SCOPE] = Bench_now() - dStart;
+   if (oScope == NULL)
+   {
+      for (uDepth = 0; uDepth < SCOPE_DEPTH; uDepth++)
+         SymTable_free(aoTables[uDepth]);
+      return 0;
+   }
+
+   /* each chained lookup searches the innermost table first*/
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+   {
+      const char *pcKey = psKeys->ppcKeys[psKeys->puLookups[u]];
+      pvValue = NULL;
+      for (iDepth = SCOPE_DEPTH - 1; iDepth >= 0 && pvValue == NULL;
+            iDepth--)
+         pvValue = SymTable_get(aoTables[iDepth], pcKey);
+      uGood += (pvValue == pcKey);
+   }
+   adSeconds[SCOPE_RESOLVE_CHAINED] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+   {
+      const char *pcKey = psKeys->ppcKeys[psKeys->puLookups[u]];
+      uGood += (SymTableScope_get(oScope, pcKey, NULL) == pcKey);
+   }
+   adSeconds[SCOPE_RESOLVE_SCOPE] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   for (iDepth = SCOPE_DEPTH - 1; iDepth >= 0; iDepth--)
+      SymTable_free(aoTables[iDepth]);
+   adSeconds[SCOPE_EXIT_CHAINED] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   while (SymTableScope_getDepth(oScope) > 0)
+      SymTableScope_pop(oScope);
+   adSeconds[SCOPE_EXIT_SCOPE] = Bench_now() - dStart;
+   uGood += (SymTableScope_get(oScope, psKeys->ppcKeys[uCount - 1],
+      NULL) == NULL);
+   SymTableScope_free(oScope);
+
+   return uGood == 4 * uCount + SCOPE_DEPTH;
+}
+
+/* Run one scope trial over the keys pvKeys: a TrialFunction. */
+
+static int scopeTrial(void *pvKeys, size_t uTrial,
+   double adSeconds[MAX_PHASE_COUNT])
+{
+   (void)uTrial;
+   return runScopeTrial((const struct BenchKeys*)pvKeys, adSeconds);
+}
+
+/* Benchmark the scope workload with uCount random keys over uTrials
+   trials. Return 1 (TRUE) on success and 0 (FALSE) on failure. */
+
+static int benchScopeWorkload(size_t uCount, size_t uTrials,
+   uint64_t uSeed)
+{
+   struct BenchKeys sKeys;
+   struct BenchSummary sSummary;
+   double *pdSeconds;
+   int iPhase;
+   int iSuccessful = 1;
+
+   /* every scope, the innermost included, binds at least one key*/
+   if (uCount < SCOPE_DEPTH)
+      uCount = SCOPE_DEPTH;
+   if (! Bench_makeKeys(&sKeys, BENCH_RANDOM, uCount, uSeed))
+      return 0;
+   pdSeconds = (double*)
+      malloc(SCOPE_PHASE_COUNT * uTrials * sizeof(double));
+   if (pdSeconds == NULL)
+   {
+      Bench_freeKeys(&sKeys);
+      return 0;
+   }
+
+   iSuccessful = runTrials(scopeTrial, &sKeys, SCOPE_PHASE_COUNT, uTrials,
+      pdSeconds);
+
+   if (iSuccessful)
+      for (iPhase = 0; iPhase < SCOPE_PHASE_COUNT; iPhase++)
+      {
+         Bench_summarize(pdSeconds + iPhase * uTrials, uTrials,
+            &sSummary);
+         Bench_writeRow(stdout, "hash", "scope",
+            apcScopePhaseNames[iPhase], uCount, uCount, uTrials,
+            &sSummary, -1.0);
+      }
+   else
+      fprintf(stderr, "hash: wrong result for workload scope\n");
+
+   free(pdSeconds);
+   Bench_freeKeys(&sKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The filter workload binds uCount random keys and then makes
+   FILTER_ROUND lookups per key: one of the key itself and the rest of
+   keys that are never bound, drawn in random order from uCount of
+   them, so that FILTER_ROUND - 1 in FILTER_ROUND lookups miss. */
+
+enum FilterPhase {FILTER_PUT_PLAIN, FILTER_PUT_FILTER,
+   FILTER_LOOKUP_PLAIN, FILTER_LOOKUP_FILTER, FILTER_PHASE_COUNT};
+
+static const char *apcFilterPhaseNames[FILTER_PHASE_COUNT] = {
+   "put-plain", "put-filter", "lookup-plain", "lookup-filter"
+};
+
+enum {FILTER_ROUND = 10};
+
+/* Put the inserted keys of psKeys into oSymTable. Add to *puGood the
+   number of puts that succeeded. Return the seconds consumed. */
+
+static double timeFilterPuts(SymTable_T oSymTable,
+   const struct BenchKeys *psKeys, size_t *puGood)
+{
+   size_t u;
+   double dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < psKeys->uCount; u++)
+      *puGood += (size_t)SymTable_put(oSymTable, psKeys->ppcKeys[u],
+         psKeys->ppcKeys[u]);
+   return Bench_now() - dStart;
+}
+
+/* Make the lookups of the filter workload in oSymTable, which holds
+   the inserted keys of psKeys. Add to *puGood the number of lookups
+   that found their key. Return the seconds consumed. */
+
+static double timeFilterLookups(SymTable_T oSymTable,
+   const struct BenchKeys *psKeys, size_t *puGood)
+{
+   size_t uCount = psKeys->uCount;
+   size_t u;
+   size_t v;
+   double dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+   {
+      *puGood += (size_t)SymTable_contains(oSymTable,
+         psKeys->ppcKeys[psKeys->puLookups[u]]);
+      for (v = 1; v < FILTER_ROUND; v++)
+         *puGood += (size_t)SymTable_contains(oSymTable,
+            psKeys->ppcKeys[uCount + psKeys->puLookups[
+               (u * (FILTER_ROUND - 1) + v) % uCount]]);
+   }
+   return Bench_now() - dStart;
+}
+
+/* Run one filter trial over psKeys, storing the seconds consumed by
+   each phase in adSeconds. Return 1 (TRUE) if every operation
+   produced the expected result, and 0 (FALSE) otherwise. */
+
+static int runFilterTrial(const struct BenchKeys *psKeys,
+   double adSeconds[FILTER_PHASE_COUNT])
+{
+   SymTable_T oPlain;
+   SymTable_T oFiltered;
+   size_t uGood = 0;
+
+   oPlain = SymTable_new();
+   oFiltered = SymTable_new();
+   if (oPlain == NULL || oFiltered == NULL ||
+         ! SymTable_setFilter(oFiltered, 1))
+   {
+      if (oPlain != NULL)
+         SymTable_free(oPlain);
+      if (oFiltered != NULL)
+         SymTable_free(oFiltered);
+      return 0;
+   }
+
+   adSeconds[FILTER_PUT_PLAIN] = timeFilterPuts(oPlain, psKeys, &uGood);
+   adSeconds[FILTER_PUT_FILTER] = timeFilterPuts(oFiltered, psKeys,
+      &uGood);
+   adSeconds[FILTER_LOOKUP_PLAIN] = timeFilterLookups(oPlain, psKeys,
+      &uGood);
+   adSeconds[FILTER_LOOKUP_FILTER] = timeFilterLookups(oFiltered, psKeys,
+      &uGood);
+
+   SymTable_free(oFiltered);
+   SymTable_free(oPlain);
+   return uGood == 4 * psKeys->uCount;
+}
+
+/* Run one filter trial over the keys pvKeys: a TrialFunction. */
+
+static int filterTrial(void *pvKeys, size_t uTrial,
+   double adSeconds[MAX_PHASE_COUNT])
+{
+   (void)uTrial;
+   return runFilterTrial((const struct BenchKeys*)pvKeys, adSeconds);
+}
+
+/* Benchmark the filter workload with uCount bound random keys over
+   uTrials trials. Return 1 (TRUE) on success and 0 (FALSE) on
+   failure. */
+
+static int benchFilterWorkload(size_t uCount, size_t uTrials,
+   uint64_t uSeed)
+{
+   struct BenchKeys sKeys;
+   struct BenchSummary sSummary;
+   double *pdSeconds;
+   int iPhase;
+   int iSuccessful = 1;
+
+   if (! Bench_makeKeys(&sKeys, BENCH_RANDOM, uCount, uSeed))
+      return 0;
+   pdSeconds = (double*)
+      malloc(FILTER_PHASE_COUNT * uTrials * sizeof(double));
+   if (pdSeconds == NULL)
+   {
+      Bench_freeKeys(&sKeys);
+      return 0;
+   }
+
+   iSuccessful = runTrials(filterTrial, &sKeys, FILTER_PHASE_COUNT, uTrials,
+      pdSeconds);
+
+   if (iSuccessful)
+      for (iPhase = 0; iPhase < FILTER_PHASE_COUNT; iPhase++)
+      {
+         Bench_summarize(pdSeconds + iPhase * uTrials, uTrials,
+            &sSummary);
+         Bench_writeRow(stdout, "hash", "filter",
+            apcFilterPhaseNames[iPhase], uCount,
+            iPhase < FILTER_LOOKUP_PLAIN ? uCount : FILTER_ROUND * uCount,
+            uTrials, &sSummary, -1.0);
+      }
+   else
+      fprintf(stderr, "hash: wrong result for workload filter\n");
+
+   free(pdSeconds);
+   Bench_freeKeys(&sKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The typed workload binds the integers 0 to uCount - 1, in random
+   order, each to half its value, and then looks each up once in
+   another random order. The string path formats each key into a
+   buffer, as testsymtable.c's testLargeTable does, and allocates each
+   value. */
+
+enum TypedPhase {TYPED_PUT_STRING, TYPED_PUT_TYPED, TYPED_GET_STRING,
+   TYPED_GET_TYPED, TYPED_PHASE_COUNT};
+
+static const char *apcTypedPhaseNames[TYPED_PHASE_COUNT] = {
+   "put-string", "put-typed", "get-string", "get-typed"
+};
+
+/* Free the boxed value pvValue. pcKey and pvExtra are unused. */
+
+static void freeBox(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvExtra;
+   free(pvValue);
+}
+
+/* Run one typed trial, putting the keys in the order of puPuts and
+   getting them in the order of puGets, each a permutation of the
+   uCount keys, storing the seconds consumed by each phase in
+   adSeconds. Return 1 (TRUE) if every operation produced the expected
+   result, and 0 (FALSE) otherwise. */
+
+static int runTypedTrial(const size_t *puPuts, const size_t *puGets,
+   size_t uCount, double adSeconds[TYPED_PHASE_COUNT])
+{
+   SymTable_T oStrings;
+   IntTable_T oInts;
+   char acKey[KEY_SIZE];
+   double *pdBox;
+   double *pdValue;
+   size_t uGood = 0;
+   size_t u;
+   double dStart;
+
+   oStrings = SymTable_new();
+   oInts = IntTable_new();
+   if (oStrings == NULL || oInts == NULL)
+   {
+      if (oStrings != NULL)
+         SymTable_free(oStrings);
+      IntTable_free(oInts);
+      return 0;
+   }
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)puPuts[u]);
+      pdBox = (double*)malloc(sizeof(double));
+      if (pdBox == NULL)
+         continue;
+      *pdBox = (double)puPuts[u] / 2;
+      if (SymTable_put(oStrings, acKey, pdBox))
+         uGood++;
+      else
+         free(pdBox);
+   }
+   adSeconds[TYPED_PUT_STRING] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+      uGood += (size_t)IntTable_put(oInts, (long)puPuts[u],
+         (double)puPuts[u] / 2);
+   adSeconds[TYPED_PUT_TYPED] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)puGets[u]);
+      pdValue = (double*)SymTable_get(oStrings, acKey);
+      uGood += (pdValue != NULL && *pdValue == (double)puGets[u] / 2);
+   }
+   adSeconds[TYPED_GET_STRING] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+   {
+      pdValue = IntTable_get(oInts, (long)puGets[u]);
+      uGood += (pdValue != NULL && *pdValue == (double)puGets[u] / 2);
+   }
+   adSeconds[TYPED_GET_TYPED] = Bench_now() - dStart;
+
+   SymTable_map(oStrings, freeBox, NULL);
+   SymTable_free(oStrings);
+   IntTable_free(oInts);
+   return uGood == 4 * uCount;
+}
+
+/* the context of the trials of the typed workload */
+struct TypedTrial
+{
+   /* the order in which the integer keys are put */
+   const size_t *puPuts;
+
+   /* the order in which the integer keys are looked up */
+   const size_t *puGets;
+
+   /* the number of keys */
+   size_t uCount;
+};
+
+/* Run one typed trial with the struct TypedTrial pvTrial: a
+   TrialFunction. */
+
+static int typedTrial(void *pvTrial, size_t uTrial,
+   double adSeconds[MAX_PHASE_COUNT])
+{
+   struct TypedTrial *psTrial = (struct TypedTrial*)pvTrial;
+   (void)uTrial;
+   return runTypedTrial(psTrial->puPuts, psTrial->puGets,
+      psTrial->uCount, adSeconds);
+}
+
+/* Benchmark the typed workload with uCount integer keys over uTrials
+   trials. Return 1 (TRUE) on success and 0 (FALSE) on failure. */
+
+static int benchTypedWorkload(size_t uCount, size_t uTrials,
+   uint64_t uSeed)
+{
+   struct BenchKeys sKeys;
+   struct BenchSummary sSummary;
+   struct TypedTrial sTrial;
+   double *pdSeconds;
+   size_t *puPuts;
+   size_t u;
+   int iPhase;
+   int iSuccessful = 1;
+
+   /* only the lookup order of the keys is used: it is a permutation,
+      from which the put order is derived*/
+   if (! Bench_makeKeys(&sKeys, BENCH_RANDOM, uCount, uSeed))
+      return 0;
+   pdSeconds = (double*)
+      malloc(TYPED_PHASE_COUNT * uTrials * sizeof(double));
+   puPuts = (size_t*)malloc(uCount * sizeof(size_t));
+   if (pdSeconds == NULL || puPuts == NULL)
+   {
+      free(pdSeconds);
+      free(puPuts);
+      Bench_freeKeys(&sKeys);
+      return 0;
+   }
+   for (u = 0; u < uCount; u++)
+      puPuts[u] = sKeys.puLookups[(u + uCount / 2) % uCount];
+
+   sTrial.puPuts = puPuts;
+   sTrial.puGets = sKeys.puLookups;
+   sTrial.uCount = uCount;
+   iSuccessful = runTrials(typedTrial, &sTrial, TYPED_PHASE_COUNT,
+      uTrials, pdSeconds);
+
+   if (iSuccessful)
+      for (iPhase = 0; iPhase < TYPED_PHASE_COUNT; iPhase++)
+      {
+         Bench_summarize(pdSeconds + iPhase * uTrials, uTrials,
+            &sSummary);
+         Bench_writeRow(stdout, "hash", "typed",
+            apcTypedPhaseNames[iPhase], uCount, uCount, uTrials,
+            &sSummary, -1.0);
+      }
+   else
+      fprintf(stderr, "hash: wrong result for workload typed\n");
+
+   free(puPuts);
+   free(pdSeconds);
+   Bench_freeKeys(&sKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The tiny workload holds uCount tables at once, as a program that
+   gives each of many objects a table of its own does: it creates them
+   empty, puts TINY_BINDINGS random keys into each, looks each key up
+   and frees the tables. The first trial also measures the heap bytes
+   an empty table and a table of TINY_BINDINGS bindings hold, from
+   mallinfo2, including the copies of the keys. */
+
+enum TinyPhase {TINY_NEW, TINY_PUT, TINY_GET, TINY_FREE,
+   TINY_PHASE_COUNT};
+
+static const char *apcTinyPhaseNames[TINY_PHASE_COUNT] = {
+   "new", "put", "get", "free"
+};
+
+enum {TINY_BINDINGS = 4};
+
+/* Return the bytes of heap memory in use, from mallinfo2. */
+
+static size_t heapInUse(void)
+{
+   struct mallinfo2 sInfo = mallinfo2();
+   return sInfo.uordblks + sInfo.hblkhd;
+}
+
+/* Run one tiny trial with the uCount tables of poTables over psKeys,
+   which holds TINY_BINDINGS keys per table, storing the seconds
+   consumed by each phase in adSeconds. If puEmpty is not NULL, store
+   in *puEmpty and *puFilled the heap bytes the tables hold after the
+   new and put phases. Return 1 (TRUE) if every operation produced the
+   expected result, and 0 (FALSE) otherwise. */
+
+static int runTinyTrial(const struct BenchKeys *psKeys,
+   SymTable_T *poTables, size_t uCount,
+   double adSeconds[TINY_PHASE_COUNT], size_t *puEmpty, size_t *puFilled)
+{
+   const char *pcKey;
+   size_t uGood = 0;
+   size_t uHeap;
+   size_t u;
+   size_t v;
+   double dStart;
+
+   uHeap = heapInUse();
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+   {
+      poTables[u] = SymTable_new();
+      uGood += poTables[u] != NULL;
+   }
+   adSeconds[TINY_NEW] = Bench_now() - dStart;
+   if (uGood != uCount)
+   {
+      for (u = 0; u < uCount; u++)
+         if (poTables[u] != NULL)
+            SymTable_free(poTables[u]);
+      return 0;
+   }
+   if (puEmpty != NULL)
+      *puEmpty = heapInUse() - uHeap;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+      for (v = 0; v < TINY_BINDINGS; v++)
+      {
+         pcKey = psKeys->ppcKeys[u * TINY_BINDINGS + v];
+         uGood += (size_t)SymTable_put(poTables[u], pcKey, pcKey);
+      }
+   adSeconds[TINY_PUT] = Bench_now() - dStart;
+   if (puFilled != NULL)
+      *puFilled = heapInUse() - uHeap;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+      for (v = 0; v < TINY_BINDINGS; v++)
+      {
+         pcKey = psKeys->ppcKeys[u * TINY_BINDINGS + v];
+         uGood += SymTable_get(poTables[u], pcKey) == pcKey;
+      }
+   adSeconds[TINY_GET] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+      SymTable_free(poTables[u]);
+   adSeconds[TINY_FREE] = Bench_now() - dStart;
+   return uGood == uCount * (1 + 2 * TINY_BINDINGS);
+}
+
+/* the context of the trials of the tiny workload */
+struct TinyTrial
+{
+   /* the keys */
+   const struct BenchKeys *psKeys;
+
+   /* room for the uCount tables */
+   SymTable_T *poTables;
+
+   /* the number of tables */
+   size_t uCount;
+
+   /* where the first trial stores the heap bytes of the empty and of
+      the filled tables */
+   size_t *puEmpty;
+   size_t *puFilled;
+};
+
+/* Run one tiny trial with the struct TinyTrial pvTrial, measuring the
+   heap only in the first trial: a TrialFunction. */
+
+static int tinyTrial(void *pvTrial, size_t uTrial,
+   double adSeconds[MAX_PHASE_COUNT])
+{
+   struct TinyTrial *psTrial = (struct TinyTrial*)pvTrial;
+   return runTinyTrial(psTrial->psKeys, psTrial->poTables,
+      psTrial->uCount, adSeconds, uTrial == 0 ? psTrial->puEmpty : NULL,
+      uTrial == 0 ? psTrial->puFilled : NULL);
+}
+
+/* Benchmark the tiny workload with uCount tables over uTrials
+   trials. Return 1 (TRUE) on success and 0 (FALSE) on failure. */
+
+static int benchTinyWorkload(size_t uCount, size_t uTrials,
+   uint64_t uSeed)
+{
+   struct BenchKeys sKeys;
+   struct BenchSummary sSummary;
+   struct TinyTrial sTrial;
+   double *pdSeconds;
+   SymTable_T *poTables;
+   size_t uEmpty = 0;
+   size_t uFilled = 0;
+   int iPhase;
+   int iSuccessful = 1;
+
+   if (! Bench_makeKeys(&sKeys, BENCH_RANDOM, uCount * TINY_BINDINGS,
+         uSeed))
+      return 0;
+   pdSeconds = (double*)
+      malloc(TINY_PHASE_COUNT * uTrials * sizeof(double));
+   poTables = (SymTable_T*)malloc(uCount * sizeof(SymTable_T));
+   if (pdSeconds == NULL || poTables == NULL)
+   {
+      free(pdSeconds);
+      free(poTables);
+      Bench_freeKeys(&sKeys);
+      return 0;
+   }
+
+   sTrial.psKeys = &sKeys;
+   sTrial.poTables = poTables;
+   sTrial.uCount = uCount;
+   sTrial.puEmpty = &uEmpty;
+   sTrial.puFilled = &uFilled;
+   iSuccessful = runTrials(tinyTrial, &sTrial, TINY_PHASE_COUNT,
+      uTrials, pdSeconds);
+
+   if (iSuccessful)
+   {
+      for (iPhase = 0; iPhase < TINY_PHASE_COUNT; iPhase++)
+      {
+         Bench_summarize(pdSeconds + iPhase * uTrials, uTrials,
+            &sSummary);
+         Bench_writeRow(stdout, "hash", "tiny",
+            apcTinyPhaseNames[iPhase], uCount,
+            iPhase == TINY_PUT || iPhase == TINY_GET ?
+               uCount * TINY_BINDINGS : uCount,
+            uTrials, &sSummary, -1.0);
+      }
+      /* mallinfo2 reads 0 under the address sanitizer */
+      if (uFilled != 0)
+         fprintf(stderr, "hash: tiny: %.1f heap bytes per empty table, "
+            "%.1f per table of %d bindings\n",
+            (double)uEmpty / (double)uCount,
+            (double)uFilled / (double)uCount, TINY_BINDINGS);
+   }
+   else
+      fprintf(stderr, "hash: wrong result for workload tiny\n");
+
+   free(poTables);
+   free(pdSeconds);
+   Bench_freeKeys(&sKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The sharded workload fills a table with uCount random keys and then
+   runs SHARDED_OPS_PER_BINDING * uCount operations split evenly over
+   1, 2, 4, ... SHARDED_MAX_THREADS threads. Each operation picks one
+   of 2 * uCount keys at random; 8 in 10 are gets, 1 in 10 puts and
+   1 in 10 removes, so the table keeps about uCount bindings. The
+   table is either SymTable_newSharded(1), a single lock around one
+   hash table ("global"), or SymTable_newSharded(SHARDED_SHARDS)
+   ("sharded"). A phase is named after the table and the number of
+   threads, and its time is the wall-clock time of all its threads. */
+
+enum {SHARDED_OPS_PER_BINDING = 10, SHARDED_MAX_THREADS = 64,
+   SHARDED_SHARDS = 64};
+
+/* the tables of the sharded workload */
+enum ShardedTable {SHARDED_GLOBAL, SHARDED_SHARDED, SHARDED_TABLE_COUNT};
+
+static const char *apcShardedTableNames[SHARDED_TABLE_COUNT] = {
+   "global", "sharded"
+};
+
+/* thread structure which describes one thread of the sharded
+   workload */
+struct MixedThread
+{
+   pthread_t iThread;
+   SymTable_T oSymTable;
+   const struct BenchKeys *psKeys;
+   size_t uOps;
+   uint64_t uState;
+   size_t uBad;
+};
+
+/* Make the operations of thread pvThread, a struct MixedThread, and
+   count in its uBad the gets whose value is not their key. Return
+   NULL. */
+
+static void *runMixedThread(void *pvThread)
+{
+   struct MixedThread *psThread = (struct MixedThread*)pvThread;
+   const char *pcKey;
+   const char *pcValue;
+   uint64_t uRandom;
+   size_t u;
+
+   for (u = 0; u < psThread->uOps; u++)
+   {
+      uRandom = Bench_random(&psThread->uState);
+      pcKey = psThread->psKeys->ppcKeys[(uRandom >> 8) %
+         (2 * psThread->psKeys->uCount)];
+      switch (uRandom % 10)
+      {
+         case 0:
+            (void)SymTable_put(psThread->oSymTable, pcKey, pcKey);
+            break;
+         case 1:
+            (void)SymTable_remove(psThread->oSymTable, pcKey);
+            break;
+         default:
+            pcValue = (const char*)SymTable_get(psThread->oSymTable,
+               pcKey);
+            psThread->uBad += pcValue != NULL && pcValue != pcKey;
+            break;
+      }
+   }
+   return NULL;
+}
+
+/* Run the operations of the sharded workload over psKeys with
+   uThreads threads on a table of kind eTable, seeded from uSeed.
+   Store the seconds consumed in *pdSeconds. Return 1 (TRUE) if every
+   operation produced an expected result, and 0 (FALSE) otherwise. */
+
+static int runShardedTrial(const struct BenchKeys *psKeys,
+   enum ShardedTable eTable, size_t uThreads, uint64_t uSeed,
+   double *pdSeconds)
+{
+   struct MixedThread asThreads[SHARDED_MAX_THREADS];
+   SymTable_T oSymTable;
+   size_t uOps = SHARDED_OPS_PER_BINDING * psKeys->uCount;
+   size_t uStarted;
+   size_t uBad = 0;
+   size_t u;
+   double dStart;
+
+   oSymTable = SymTable_newSharded(eTable == SHARDED_GLOBAL ? 1 :
+      SHARDED_SHARDS);
+   if (oSymTable == NULL)
+      return 0;
+   for (u = 0; u < psKeys->uCount; u++)
+      uBad += ! SymTable_put(oSymTable, psKeys->ppcKeys[u],
+         psKeys->ppcKeys[u]);
+
+   dStart = Bench_now();
+   for (uStarted = 0; uStarted < uThreads; uStarted++)
+   {
+      asThreads[uStarted].oSymTable = oSymTable;
+      asThreads[uStarted].psKeys = psKeys;
+      asThreads[uStarted].uOps = uOps / uThreads;
+      asThreads[uStarted].uState = uSeed + uStarted;
+      asThreads[uStarted].uBad = 0;
+      if (pthread_create(&asThreads[uStarted].iThread, NULL,
+            runMixedThread, &asThreads[uStarted]) != 0)
+         break;
+   }
+   for (u = 0; u < uStarted; u++)
+   {
+      pthread_join(asThreads[u].iThread, NULL);
+      uBad += asThreads[u].uBad;
+   }
+   *pdSeconds = Bench_now() - dStart;
+
+   SymTable_free(oSymTable);
+   return uStarted == uThreads && uBad == 0;
+}
+
+/* Benchmark the sharded workload with uCount random keys over uTrials
+   trials. Return 1 (TRUE) on success and 0 (FALSE) on failure. */
+
+static int benchShardedWorkload(size_t uCount, size_t uTrials,
+   uint64_t uSeed)
+{
+   struct BenchKeys sKeys;
+   struct BenchSummary sSummary;
+   char acPhase[32];
+   double *pdSeconds;
+   size_t uThreads;
+   size_t uTrial;
+   int iTable;
+   int iSuccessful = 1;
+
+   if (! Bench_makeKeys(&sKeys, BENCH_RANDOM, uCount, uSeed))
+      return 0;
+   pdSeconds = (double*)malloc(uTrials * sizeof(double));
+   if (pdSeconds == NULL)
+   {
+      Bench_freeKeys(&sKeys);
+      return 0;
+   }
+
+   for (uThreads = 1; uThreads <= SHARDED_MAX_THREADS && iSuccessful;
+         uThreads *= 2)
+      for (iTable = 0; iTable < SHARDED_TABLE_COUNT && iSuccessful;
+            iTable++)
+      {
+         for (uTrial = 0; uTrial < uTrials && iSuccessful; uTrial++)
+            iSuccessful = runShardedTrial(&sKeys, (enum ShardedTable)iTable,
+               uThreads, uSeed + uTrial * SHARDED_MAX_THREADS,
+               &pdSeconds[uTrial]);
+         if (! iSuccessful)
+            break;
+         Bench_summarize(pdSeconds, uTrials, &sSummary);
+         sprintf(acPhase, "%s-%lu", apcShardedTableNames[iTable],
+            (unsigned long)uThreads);
+         Bench_writeRow(stdout, "hash", "sharded", acPhase, uCount,
+            SHARDED_OPS_PER_BINDING * uCount / uThreads * uThreads,
+            uTrials, &sSummary, -1.0);
+      }
+   if (! iSuccessful)
+      fprintf(stderr, "hash: wrong result for workload sharded\n");
+
+   free(pdSeconds);
+   Bench_freeKeys(&sKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The writers workload splits uCount random keys evenly over 1, 2, 4,
+   ... SHARDED_MAX_THREADS threads, which share one table of
+   SHARDED_SHARDS shards. Each thread puts its keys and then removes
+   them, and after every put and remove reads the length of the table:
+   not at all ("none"), with SymTable_getLength ("cached"), or with
+   SymTable_getExactLength ("exact"). A phase is named after the read
+   and the number of threads; its operations are the puts and
+   removes, and its time is the wall-clock time of all its threads. */
+
+/* the ways the writers workload reads the length */
+enum LengthRead {LENGTH_NONE, LENGTH_CACHED, LENGTH_EXACT, LENGTH_COUNT};
+
+static const char *apcLengthReadNames[LENGTH_COUNT] = {
+   "none", "cached", "exact"
+};
+
+/* thread structure which describes one thread of the writers
+   workload */
+struct WriterThread
+{
+   pthread_t iThread;
+   SymTable_T oSymTable;
+   const char *const *ppcKeys;
+   size_t uKeys;
+   enum LengthRead eRead;
+   size_t uLengths;
+   size_t uBad;
+};
+
+/* Read the length of oSymTable as eRead says. Return it, or 0 for
+   LENGTH_NONE. */
+
+static size_t readLength(SymTable_T oSymTable, enum LengthRead eRead)
+{
+   if (eRead == LENGTH_CACHED)
+      return SymTable_getLength(oSymTable);
+   if (eRead == LENGTH_EXACT)
+      return SymTable_getExactLength(oSymTable);
+   return 0;
+}
+
+/* Put and then remove the keys of thread pvThread, a struct
+   WriterThread, reading the length after each, and count in its uBad
+   the puts and removes that failed. Return NULL. */
+
+static void *runWriterThread(void *pvThread)
+{
+   struct WriterThread *psThread = (struct WriterThread*)pvThread;
+   size_t u;
+
+   for (u = 0; u < psThread->uKeys; u++)
+   {
+      psThread->uBad += ! SymTable_put(psThread->oSymTable,
+         psThread->ppcKeys[u], psThread->ppcKeys[u]);
+      psThread->uLengths += readLength(psThread->oSymTable,
+         psThread->eRead);
+   }
+   for (u = 0; u < psThread->uKeys; u++)
+   {
+      psThread->uBad += SymTable_remove(psThread->oSymTable,
+         psThread->ppcKeys[u]) != psThread->ppcKeys[u];
+      psThread->uLengths += readLength(psThread->oSymTable,
+         psThread->eRead);
+   }
+   return NULL;
+}
+
+/* Run the writers workload over psKeys with uThreads threads that
+   read the length as eRead says. Store the seconds consumed in
+   *pdSeconds. Return 1 (TRUE) if every operation produced an
+   expected result, and 0 (FALSE) otherwise. */
+
+static int runWritersTrial(const struct BenchKeys *psKeys,
+   enum LengthRead eRead, size_t uThreads, double *pdSeconds)
+{
+   struct WriterThread asThreads[SHARDED_MAX_THREADS];
+   SymTable_T oSymTable;
+   size_t uPerThread = psKeys->uCount / uThreads;
+   size_t uStarted;
+   size_t uBad = 0;
+   size_t u;
+   double dStart;
+
+   oSymTable = SymTable_newSharded(SHARDED_SHARDS);
+   if (oSymTable == NULL)
+      return 0;
+
+   dStart = Bench_now();
+   for (uStarted = 0; uStarted < uThreads; uStarted++)
+   {
+      asThreads[uStarted].oSymTable = oSymTable;
+      asThreads[uStarted].ppcKeys =
+         (const char *const *)psKeys->ppcKeys + uStarted * uPerThread;
+      asThreads[uStarted].uKeys = uPerThread;
+      asThreads[uStarted].eRead = eRead;
+      asThreads[uStarted].uLengths = 0;
+      asThreads[uStarted].uBad = 0;
+      if (pthread_create(&asThreads[uStarted].iThread, NULL,
+            runWriterThread, &asThreads[uStarted]) != 0)
+         break;
+   }
+   for (u = 0; u < uStarted; u++)
+   {
+      pthread_join(asThreads[u].iThread, NULL);
+      uBad += asThreads[u].uBad;
+   }
+   *pdSeconds = Bench_now() - dStart;
+
+   uBad += SymTable_getExactLength(oSymTable) != 0;
+   SymTable_free(oSymTable);
+   return uStarted == uThreads && uBad == 0;
+}
+
+/* Benchmark the writers workload with uCount random keys over uTrials
+   trials. Return 1 (TRUE) on success and 0 (FALSE) on failure. */
+
+static int benchWritersWorkload(size_t uCount, size_t uTrials,
+   uint64_t uSeed)
+{
+   struct BenchKeys sKeys;
+   struct BenchSummary sSummary;
+   char acPhase[32];
+   double *pdSeconds;
+   size_t uThreads;
+   size_t uTrial;
+   int iRead;
+   int iSuccessful = 1;
+
+   if (! Bench_makeKeys(&sKeys, BENCH_RANDOM, uCount, uSeed))
+      return 0;
+   pdSeconds = (double*)malloc(uTrials * sizeof(double));
+   if (pdSeconds == NULL)
+   {
+      Bench_freeKeys(&sKeys);
+      return 0;
+   }
+
+   for (uThreads = 1; uThreads <= SHARDED_MAX_THREADS && iSuccessful;
+         uThreads *= 2)
+      for (iRead = 0; iRead < LENGTH_COUNT && iSuccessful; iRead++)
+      {
+         for (uTrial = 0; uTrial < uTrials && iSuccessful; uTrial++)
+            iSuccessful = runWritersTrial(&sKeys, (enum LengthRead)iRead,
+               uThreads, &pdSeconds[uTrial]);
+         if (! iSuccessful)
+            break;
+         Bench_summarize(pdSeconds, uTrials, &sSummary);
+         sprintf(acPhase, "%s-%lu", apcLengthReadNames[iRead],
+            (unsigned long)uThreads);
+         Bench_writeRow(stdout, "hash", "writers", acPhase, uCount,
+            2 * (uCount / uThreads * uThreads), uTrials, &sSummary,
+            -1.0);
+      }
+   if (! iSuccessful)
+      fprintf(stderr, "hash: wrong result for workload writers\n");
+
+   free(pdSeconds);
+   Bench_freeKeys(&sKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The writer workload puts uCount random keys into a new table, one
+   SymTable_put at a time ("direct") or through a writer
+   (SymTable_writerBegin, SymTable_writerPut and SymTable_writerFlush,
+   "writer"), and then looks every key up in random order. The put
+   phases include creating the table, and the writer's flush. */
+
+enum WriterPhase {WRITER_PUT_DIRECT, WRITER_PUT_WRITER, WRITER_GET_DIRECT,
+   WRITER_GET_WRITER, WRITER_PHASE_COUNT};
+
+static const char *apcWriterPhaseNames[WRITER_PHASE_COUNT] = {
+   "put-direct", "put-writer", "get-direct", "get-writer"
+};
+
+/* Make the lookups of the writer workload in oSymTable, which holds
+   the inserted keys of psKeys. Add to *puGood the number of lookups
+   that found their value. Return the seconds consumed. */
+
+static double timeWriterLookups(SymTable_T oSymTable,
+   const struct BenchKeys *psKeys, size_t *puGood)
+{
+   const char *pcKey;
+   size_t u;
+   double dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < psKeys->uCount; u++)
+   {
+      pcKey = psKeys->ppcKeys[psKeys->puLookups[u]];
+      *puGood += SymTable_get(oSymTable, pcKey) == pcKey;
+   }
+   return Bench_now() - dStart;
+}
+
+/* Run one writer trial over psKeys, storing the seconds consumed by
+   each phase in adSeconds. Return 1 (TRUE) if every operation
+   produced the expected result, and 0 (FALSE) otherwise. */
+
+static int runWriterTrial(const struct BenchKeys *psKeys,
+   double adSeconds[WRITER_PHASE_COUNT])
+{
+   SymTable_T oDirect;
+   SymTable_T oWriter;
+   size_t uGood = 0;
+   size_t uAdded;
+   size_t u;
+   double dStart;
+
+   dStart = Bench_now();
+   oDirect = SymTable_new();
+   if (oDirect == NULL)
+      return 0;
+   for (u = 0; u < psKeys->uCount; u++)
+      uGood += (size_t)SymTable_put(oDirect, psKeys->ppcKeys[u],
+         psKeys->ppcKeys[u]);
+   adSeconds[WRITER_PUT_DIRECT] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   oWriter = SymTable_new();
+   if (oWriter == NULL || ! SymTable_writerBegin(oWriter))
+   {
+      if (oWriter != NULL)
+         SymTable_free(oWriter);
+      SymTable_free(oDirect);
+      return 0;
+   }
+   for (u = 0; u < psKeys->uCount; u++)
+      uGood += (size_t)SymTable_writerPut(oWriter, psKeys->ppcKeys[u],
+         psKeys->ppcKeys[u]);
+   if (SymTable_writerFlush(oWriter, &uAdded))
+      uGood += uAdded;
+   adSeconds[WRITER_PUT_WRITER] = Bench_now() - dStart;
+
+   adSeconds[WRITER_GET_DIRECT] = timeWriterLookups(oDirect, psKeys,
+      &uGood);
+   adSeconds[WRITER_GET_WRITER] = timeWriterLookups(oWriter, psKeys,
+      &uGood);
+
+   SymTable_free(oWriter);
+   SymTable_free(oDirect);
+   return uGood == 5 * psKeys->uCount;
+}
+
+/* Run one writer trial over the keys pvKeys: a TrialFunction. */
+
+static int writerTrial(void *pvKeys, size_t uTrial,
+   double adSeconds[MAX_PHASE_COUNT])
+{
+   (void)uTrial;
+   return runWriterTrial((const struct BenchKeys*)pvKeys, adSeconds);
+}
+
+/* Benchmark the writer workload with uCount random keys over uTrials
+   trials. Return 1 (TRUE) on success and 0 (FALSE) on failure. */
+
+static int benchWriterWorkload(size_t uCount, size_t uTrials,
+   uint64_t uSeed)
+{
+   struct BenchKeys sKeys;
+   struct BenchSummary sSummary;
+   double *pdSeconds;
+   int iPhase;
+   int iSuccessful = 1;
+
+   if (! Bench_makeKeys(&sKeys, BENCH_RANDOM, uCount, uSeed))
+      return 0;
+   pdSeconds = (double*)
+      malloc(WRITER_PHASE_COUNT * uTrials * sizeof(double));
+   if (pdSeconds == NULL)
+   {
+      Bench_freeKeys(&sKeys);
+      return 0;
+   }
+
+   iSuccessful = runTrials(writerTrial, &sKeys, WRITER_PHASE_COUNT, uTrials,
+      pdSeconds);
+
+   if (iSuccessful)
+      for (iPhase = 0; iPhase < WRITER_PHASE_COUNT; iPhase++)
+      {
+         Bench_summarize(pdSeconds + iPhase * uTrials, uTrials,
+            &sSummary);
+         Bench_writeRow(stdout, "hash", "writer",
+            apcWriterPhaseNames[iPhase], uCount, uCount, uTrials,
+            &sSummary, -1.0);
+      }
+   else
+      fprintf(stderr, "hash: wrong result for workload writer\n");
+
+   free(pdSeconds);
+   Bench_freeKeys(&sKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The build workload makes a table of uCount random keys, each bound
+   to itself, with SymTable_put ("put") or with SymTable_buildParallel
+   and 1, 2, 4, ... threads, up to the number of online processors and
+   at least BUILD_MIN_THREADS ("build-" and the number of threads). A
+   phase includes creating the table; its time is wall-clock time. */
+
+enum {BUILD_MIN_THREADS = 4};
+
+/* Run one build trial over psKeys with uThreads threads, or with
+   SymTable_put if uThreads is 0, and store the seconds consumed in
+   *pdSeconds. Return 1 (TRUE) if the table holds every key, and 0
+   (FALSE) otherwise. */
+
+static int runBuildTrial(const struct BenchKeys *psKeys, size_t uThreads,
+   double *pdSeconds)
+{
+   SymTable_T oSymTable;
+   size_t uCount = psKeys->uCount;
+   size_t uGood = 0;
+   size_t u;
+   double dStart;
+
+   dStart = Bench_now();
+   if (uThreads == 0)
+   {
+      oSymTable = SymTable_new();
+      for (u = 0; oSymTable != NULL && u < uCount; u++)
+         (void)SymTable_put(oSymTable, psKeys->ppcKeys[u],
+            psKeys->ppcKeys[u]);
+   }
+   else
+      oSymTable = SymTable_buildParallel(
+         (const char *const *)psKeys->ppcKeys,
+         (const void *const *)psKeys->ppcKeys, uCount, uThreads);
+   *pdSeconds = Bench_now() - dStart;
+   if (oSymTable == NULL)
+      return 0;
+
+   for (u = 0; u < uCount; u++)
+      uGood += SymTable_get(oSymTable, psKeys->ppcKeys[u]) ==
+         psKeys->ppcKeys[u];
+   uGood += SymTable_getLength(oSymTable) == uCount;
+   SymTable_free(oSymTable);
+   return uGood == uCount + 1;
+}
+
+/* Benchmark the build workload with uCount random keys over uTrials
+   trials. Return 1 (TRUE) on success and 0 (FALSE) on failure. */
+
+static int benchBuildWorkload(size_t uCount, size_t uTrials,
+   uint64_t uSeed)
+{
+   struct BenchKeys sKeys;
+   struct BenchSummary sSummary;
+   char acPhase[32];
+   double *pdSeconds;
+   size_t uMaxThreads = BUILD_MIN_THREADS;
+   size_t uThreads;
+   size_t uTrial;
+   long lProcessors;
+   int iSuccessful = 1;
+
+   lProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+   if (lProcessors > BUILD_MIN_THREADS)
+      uMaxThreads = (size_t)lProcessors;
+   if (! Bench_makeKeys(&sKeys, BENCH_RANDOM, uCount, uSeed))
+      return 0;
+   pdSeconds = (double*)malloc(uTrials * sizeof(double));
+   if (pdSeconds == NULL)
+   {
+      Bench_freeKeys(&sKeys);
+      return 0;
+   }
+
+   /* 0 threads stands for SymTable_put */
+   for (uThreads = 0; uThreads <= uMaxThreads && iSuccessful;
+         uThreads = uThreads == 0 ? 1 :
+            (2 * uThreads > uMaxThreads && uThreads < uMaxThreads ?
+               uMaxThreads : 2 * uThreads))
+   {
+      for (uTrial = 0; uTrial < uTrials && iSuccessful; uTrial++)
+         iSuccessful = runBuildTrial(&sKeys, uThreads, &pdSeconds[uTrial]);
+      if (! iSuccessful)
+         break;
+      Bench_summarize(pdSeconds, uTrials, &sSummary);
+      if (uThreads == 0)
+         strcpy(acPhase, "put");
+      else
+         sprintf(acPhase, "build-%lu", (unsigned long)uThreads);
+      Bench_writeRow(stdout, "hash", "build", acPhase, uCount, uCount,
+         uTrials, &sSummary, -1.0);
+   }
+   if (! iSuccessful)
+      fprintf(stderr, "hash: wrong result for workload build\n");
+
+   free(pdSeconds);
+   Bench_freeKeys(&sKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The text workload writes a table of uCount random keys, each bound
+   to itself, to a text file of lines "key\tvalue" and reads it back
+   into a new table. The file is written with fprintf once per
+   binding ("dump-fprintf") or with SymTableText_dump ("dump-text"),
+   and read with fgets, a copy of each value and SymTable_put
+   ("load-fgets") or with SymTableText_load ("load-text"). The load
+   phases include creating the table; the file stays in the page
+   cache, so the phases time the parsing and the puts rather than the
+   disk. Megabytes per second for each phase go to stderr. */
+
+enum TextPhase {TEXT_DUMP_FPRINTF, TEXT_DUMP_TEXT, TEXT_LOAD_FGETS,
+   TEXT_LOAD_TEXT, TEXT_PHASE_COUNT};
+
+static const char *apcTextPhaseNames[TEXT_PHASE_COUNT] = {
+   "dump-fprintf", "dump-text", "load-fgets", "load-text"
+};
+
+/* the file that holds the text of the text workload */
+static const char *pcTextPath = "benchhashext.txt";
+
+/* the longest line that load-fgets reads, including '\n' and '\0' */
+enum {TEXT_LINE_SIZE = 2 * KEY_SIZE + 2};
+
+/* Write the line of binding pcKey and pvValue, a string, to pvExtra, a
+   FILE. */
+
+static void printTextBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   fprintf((FILE*)pvExtra, "%s\t%s\n", pcKey, (const char*)pvValue);
+}
+
+/* Free pvValue. */
+
+static void freeTextValue(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvExtra;
+   free(pvValue);
+}
+
+/* Write oSymTable to the text file with fprintf if iBuffered is 0,
+   and with SymTableText_dump otherwise. Store the seconds consumed in
+   *pdSeconds. Return 1 (TRUE) on success and 0 (FALSE) on failure. */
+
+static int timeTextDump(SymTable_T oSymTable, int iBuffered,
+   double *pdSeconds)
+{
+   FILE *psFile;
+   double dStart;
+   int iSuccessful = 1;
+
+   dStart = Bench_now();
+   psFile = fopen(pcTextPath, "wb");
+   if (psFile == NULL)
+      return 0;
+   if (iBuffered)
+      iSuccessful = SymTableText_dump(oSymTable, psFile);
+   else
+      SymTable_map(oSymTable, printTextBinding, psFile);
+   iSuccessful &= ! ferror(psFile);
+   iSuccessful &= fclose(psFile) == 0;
+   *pdSeconds = Bench_now() - dStart;
+   return iSuccessful;
+}
+
+/* Read the text file into a new table with fgets, copying each value,
+   and store the seconds consumed in *pdSeconds. Return the number of
+   bindings put, or 0 on failure. */
+
+static size_t timeTextLoadFgets(double *pdSeconds)
+{
+   SymTable_T oSymTable;
+   FILE *psFile;
+   char acLine[TEXT_LINE_SIZE];
+   char *pcTab;
+   char *pcValue;
+   size_t uLength;
+   size_t uBound = 0;
+   double dStart;
+
+   dStart = Bench_now();
+   psFile = fopen(pcTextPath, "rb");
+   oSymTable = psFile == NULL ? NULL : SymTable_new();
+   if (oSymTable == NULL)
+   {
+      if (psFile != NULL)
+         fclose(psFile);
+      *pdSeconds = Bench_now() - dStart;
+      return 0;
+   }
+   while (fgets(acLine, sizeof(acLine), psFile) != NULL)
+   {
+      pcTab = strchr(acLine, '\t');
+      if (pcTab == NULL)
+         continue;
+      *pcTab = '\0';
+      uLength = strlen(pcTab + 1);
+      if (uLength > 0 && pcTab[uLength] == '\n')
+         pcTab[uLength--] = '\0';
+      pcValue = (char*)malloc(uLength + 1);
+      if (pcValue == NULL)
+         break;
+      memcpy(pcValue, pcTab + 1, uLength + 1);
+      if (SymTable_put(oSymTable, acLine, pcValue))
+         uBound++;
+      else
+         free(pcValue);
+   }
+   fclose(psFile);
+   *pdSeconds = Bench_now() - dStart;
+   SymTable_map(oSymTable, freeTextValue, NULL);
+   SymTable_free(oSymTable);
+   return uBound;
+}
+
+/* Read the text file into a new table with SymTableText_load and
+   store the seconds consumed in *pdSeconds. Return the number of
+   bindings put, or 0 on failure. */
+
+static size_t timeTextLoad(double *pdSeconds)
+{
+   SymTable_T oSymTable;
+   SymTableText_T oText;
+   size_t uBound;
+   double dStart;
+
+   dStart = Bench_now();
+   oSymTable = SymTable_new();
+   oText = oSymTable == NULL ? NULL :
+      SymTableText_load(oSymTable, pcTextPath);
+   *pdSeconds = Bench_now() - dStart;
+   if (oText == NULL)
+   {
+      if (oSymTable != NULL)
+         SymTable_free(oSymTable);
+      return 0;
+   }
+   uBound = SymTableText_getBound(oText);
+   SymTable_free(oSymTable);
+   SymTableText_free(oText);
+   return uBound;
+}
+
+/* Run one text trial over psKeys, storing the seconds consumed by
+   each phase in adSeconds and the size of the file in *puBytes.
+   Return 1 (TRUE) if every phase produced the expected result, and 0
+   (FALSE) otherwise. */
+
+static int runTextTrial(const struct BenchKeys *psKeys,
+   double adSeconds[TEXT_PHASE_COUNT], size_t *puBytes)
+{
+   SymTable_T oSymTable;
+   FILE *psFile;
+   size_t u;
+   int iSuccessful = 1;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return 0;
+   for (u = 0; u < psKeys->uCount; u++)
+      iSuccessful &= SymTable_put(oSymTable, psKeys->ppcKeys[u],
+         psKeys->ppcKeys[u]);
+
+   /* load-fgets reads the file of dump-fprintf, and load-text that of
+      dump-text, which holds the same lines in the same order; the
+      phases stop at the first that fails*/
+   iSuccessful = iSuccessful &&
+      timeTextDump(oSymTable, 0, &adSeconds[TEXT_DUMP_FPRINTF]) &&
+      timeTextLoadFgets(&adSeconds[TEXT_LOAD_FGETS]) == psKeys->uCount &&
+      timeTextDump(oSymTable, 1, &adSeconds[TEXT_DUMP_TEXT]) &&
+      timeTextLoad(&adSeconds[TEXT_LOAD_TEXT]) == psKeys->uCount;
+   SymTable_free(oSymTable);
+   if (! iSuccessful)
+      return 0;
+
+   psFile = fopen(pcTextPath, "rb");
+   if (psFile == NULL || fseek(psFile, 0, SEEK_END) != 0)
+      iSuccessful = 0;
+   else
+      *puBytes = (size_t)ftell(psFile);
+   if (psFile != NULL)
+      fclose(psFile);
+   return iSuccessful;
+}
+
+/* the context of the trials of the text workload */
+struct TextTrial
+{
+   /* the keys */
+   const struct BenchKeys *psKeys;
+
+   /* where to store the size of the text file */
+   size_t *puBytes;
+};
+
+/* Run one text trial with the struct TextTrial pvTrial: a
+   TrialFunction. */
+
+static int textTrial(void *pvTrial, size_t uTrial,
+   double adSeconds[MAX_PHASE_COUNT])
+{
+   struct TextTrial *psTrial = (struct TextTrial*)pvTrial;
+   (void)uTrial;
+   return runTextTrial(psTrial->psKeys, adSeconds, psTrial->puBytes);
+}
+
+/* Benchmark the text workload with uCount random keys over uTrials
+   trials. Return 1 (TRUE) on success and 0 (FALSE) on failure. */
+
+static int benchTextWorkload(size_t uCount, size_t uTrials,
+   uint64_t uSeed)
+{
+   struct BenchKeys sKeys;
+   struct BenchSummary sSummary;
+   struct TextTrial sTrial;
+   double *pdSeconds;
+   size_t uBytes = 0;
+   int iPhase;
+   int iSuccessful = 1;
+
+   if (! Bench_makeKeys(&sKeys, BENCH_RANDOM, uCount, uSeed))
+      return 0;
+   pdSeconds = (double*)
+      malloc(TEXT_PHASE_COUNT * uTrials * sizeof(double));
+   if (pdSeconds == NULL)
+   {
+      Bench_freeKeys(&sKeys);
+      return 0;
+   }
+
+   sTrial.psKeys = &sKeys;
+   sTrial.puBytes = &uBytes;
+   iSuccessful = runTrials(textTrial, &sTrial, TEXT_PHASE_COUNT, uTrials,
+      pdSeconds);
+   (void)remove(pcTextPath);
+
+   if (iSuccessful)
+      for (iPhase = 0; iPhase < TEXT_PHASE_COUNT; iPhase++)
+      {
+         Bench_summarize(pdSeconds + iPhase * uTrials, uTrials,
+            &sSummary);
+         Bench_writeRow(stdout, "hash", "text",
+            apcTextPhaseNames[iPhase], uCount, uCount, uTrials,
+            &sSummary, -1.0);
+         fprintf(stderr, "hash: text: %s %.1f MB/s over %lu bytes\n",
+            apcTextPhaseNames[iPhase],
+            (double)uBytes / sSummary.dMedian / 1e6,
+            (unsigned long)uBytes);
+      }
+   else
+      fprintf(stderr, "hash: wrong result for workload text\n");
+
+   free(pdSeconds);
+   Bench_freeKeys(&sKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The latency workload puts uCount random keys into a new table and
+   looks every key up in random order, in a table that is not traced
+   ("off"), one traced by SymTable_setTracing that times every
+   operation ("all"), and one that times one operation in
+   LATENCY_INTERVAL ("sampled"). The put phases include creating the
+   table. The first trial of each traced table writes the percentiles
+   of its histograms to stderr. */
+
+enum {LATENCY_INTERVAL = 100};
+
+enum LatencyTable {LATENCY_OFF, LATENCY_ALL, LATENCY_SAMPLED,
+   LATENCY_TABLE_COUNT};
+
+static const char *apcLatencyPhaseNames[2 * LATENCY_TABLE_COUNT] = {
+   "put-off", "put-all", "put-sampled", "get-off", "get-all",
+   "get-sampled"
+};
+
+/* the interval of each table of the latency workload, 0 for none */
+static const size_t auLatencyIntervals[LATENCY_TABLE_COUNT] = {
+   0, 1, LATENCY_INTERVAL
+};
+
+/* Write the percentiles of operation eOp of oSymTable, named
+   pcOperation, to stderr. */
+
+static void writePercentiles(SymTable_T oSymTable, enum SymTableOp eOp,
+   const char *pcOperation)
+{
+   struct SymTableLatency sLatency;
+
+   SymTable_getLatency(oSymTable, eOp, &sLatency);
+   fprintf(stderr, "hash: latency: %s p50 %lu ns, p99 %lu ns, "
+      "p99.9 %lu ns, max %lu ns over %lu operations\n", pcOperation,
+      (unsigned long)SymTable_latencyAt(&sLatency, 0.5),
+      (unsigned long)SymTable_latencyAt(&sLatency, 0.99),
+      (unsigned long)SymTable_latencyAt(&sLatency, 0.999),
+      (unsigned long)sLatency.uMax, (unsigned long)sLatency.uCount);
+}
+
+/* Run one latency trial over psKeys, tracing the table with interval
+   uInterval unless it is 0, and store the seconds consumed by its put
+   and get phases in *pdPut and *pdGet. Write the percentiles of the
+   table to stderr under the names pcPut and pcGet if they are not
+   NULL. Return 1 (TRUE) if every operation produced the expected
+   result, and 0 (FALSE) otherwise. */
+
+static int runLatencyTrial(const struct BenchKeys *psKeys,
+   size_t uInterval, const char *pcPut, const char *pcGet, double *pdPut,
+   double *pdGet)
+{
+   SymTable_T oSymTable;
+   const char *pcKey;
+   size_t uGood = 0;
+   size_t u;
+   double dStart;
+
+   dStart = Bench_now();
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return 0;
+   if (uInterval != 0 && ! SymTable_setTracing(oSymTable, uInterval))
+   {
+      SymTable_free(oSymTable);
+      return 0;
+   }
+   for (u = 0; u < psKeys->uCount; u++)
+      uGood += (size_t)SymTable_put(oSymTable, psKeys->ppcKeys[u],
+         psKeys->ppcKeys[u]);
+   *pdPut = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < psKeys->uCount; u++)
+   {
+      pcKey = psKeys->ppcKeys[psKeys->puLookups[u]];
+      uGood += SymTable_get(oSymTable, pcKey) == pcKey;
+   }
+   *pdGet = Bench_now() - dStart;
+
+   if (pcPut != NULL)
+   {
+      writePercentiles(oSymTable, SYMTABLE_OP_PUT, pcPut);
+      writePercentiles(oSymTable, SYMTABLE_OP_GET, pcGet);
+   }
+   SymTable_free(oSymTable);
+   return uGood == 2 * psKeys->uCount;
+}
+
+/* Benchmark the latency workload with uCount random keys over uTrials
+   trials. Return 1 (TRUE) on success and 0 (FALSE) on failure. */
+
+static int benchLatencyWorkload(size_t uCount, size_t uTrials,
+   uint64_t uSeed)
+{
+   struct BenchKeys sKeys;
+   struct BenchSummary sSummary;
+   double *pdSeconds;
+   size_t uTrial;
+   int iTable;
+   int iPhase;
+   int iSuccessful = 1;
+
+   if (! Bench_makeKeys(&sKeys, BENCH_RANDOM, uCount, uSeed))
+      return 0;
+   pdSeconds = (double*)
+      malloc(2 * LATENCY_TABLE_COUNT * uTrials * sizeof(double));
+   if (pdSeconds == NULL)
+   {
+      Bench_freeKeys(&sKeys);
+      return 0;
+   }
+
+   /* the tables alternate, so that all see the same noise */
+   for (uTrial = 0; uTrial < uTrials && iSuccessful; uTrial++)
+      for (iTable = 0; iTable < LATENCY_TABLE_COUNT && iSuccessful;
+            iTable++)
+         iSuccessful = runLatencyTrial(&sKeys, auLatencyIntervals[iTable],
+            uTrial == 0 && iTable != LATENCY_OFF ?
+               apcLatencyPhaseNames[iTable] : NULL,
+            apcLatencyPhaseNames[LATENCY_TABLE_COUNT + iTable],
+            &pdSeconds[iTable * uTrials + uTrial],
+            &pdSeconds[(LATENCY_TABLE_COUNT + iTable) * uTrials + uTrial]);
+
+   if (iSuccessful)
+      for (iPhase = 0; iPhase < 2 * LATENCY_TABLE_COUNT; iPhase++)
+      {
+         Bench_summarize(pdSeconds + iPhase * uTrials, uTrials,
+            &sSummary);
+         Bench_writeRow(stdout, "hash", "latency",
+            apcLatencyPhaseNames[iPhase], uCount, uCount, uTrials,
+            &sSummary, -1.0);
+      }
+   else
+      fprintf(stderr, "hash: wrong result for workload latency\n");
+
+   free(pdSeconds);
+   Bench_freeKeys(&sKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write a usage message for program pcProgram to stderr. */
+
+static void usage(const char *pcProgram)
+{
+   fprintf(stderr,
+      "Usage: %s [-n bindings] [-t trials] [-s seed] [-w workload,...]\n"
+      "workload is one of flood, image, freeze, snapshot, scope, "
+      "filter, typed, tiny, sharded, writers, writer, build, text,\n"
+      "latency (default: all)\n",
+      pcProgram);
+}
+
+/* Benchmark the hash table extensions. argv holds the options
+   described by usage. Exit with EXIT_FAILURE if the options are
+   malformed or a run fails. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int aiSelected[WORKLOAD_COUNT];
+   unsigned long ulBindings = 0;
+   unsigned long ulTrials = DEFAULT_TRIALS;
+   unsigned long ulSeed = DEFAULT_SEED;
+   unsigned long *pulOption;
+   size_t uCount;
+   int iAll = 1;
+   int iSuccessful = 1;
+   int i;
+
+   memset(aiSelected, 0, sizeof(aiSelected));
+   for (i = 1; i < argc; i += 2)
+   {
+      if (i + 1 >= argc)
+      {
+         usage(argv[0]);
+         exit(EXIT_FAILURE);
+      }
+      if (strcmp(argv[i], "-w") == 0)
+      {
+         char *pcName = strtok(argv[i + 1], ",");
+         iAll = 0;
+         for (; pcName != NULL; pcName = strtok(NULL, ","))
+         {
+            int iWorkload;
+            for (iWorkload = 0; iWorkload < WORKLOAD_COUNT; iWorkload++)
+               if (strcmp(pcName, apcWorkloadNames[iWorkload]) == 0)
+                  break;
+            if (iWorkload == WORKLOAD_COUNT)
+            {
+               usage(argv[0]);
+               exit(EXIT_FAILURE);
+            }
+            aiSelected[iWorkload] = 1;
+         }
+         continue;
+      }
+      if (strcmp(argv[i], "-n") == 0)
+         pulOption = &ulBindings;
+      else if (strcmp(argv[i], "-t") == 0)
+         pulOption = &ulTrials;
+      else if (strcmp(argv[i], "-s") == 0)
+         pulOption = &ulSeed;
+      else
+         pulOption = NULL;
+      if (pulOption == NULL ||
+            sscanf(argv[i + 1], "%lu", pulOption) != 1 || ulTrials == 0)
+      {
+         usage(argv[0]);
+         exit(EXIT_FAILURE);
+      }
+   }
+
+   Bench_writeHeader(stdout);
+   for (i = 0; i < WORKLOAD_COUNT && iSuccessful; i++)
+   {
+      if (! iAll && ! aiSelected[i])
+         continue;
+      uCount = ulBindings != 0 ? (size_t)ulBindings : auDefaultBindings[i];
+      switch (i)
+      {
+         case WORKLOAD_FLOOD:
+            iSuccessful = benchFloodWorkload(uCount, (size_t)ulTrials,
+               (uint64_t)ulSeed);
+            break;
+         case WORKLOAD_IMAGE:
+            iSuccessful = benchImageWorkload(uCount, (size_t)ulTrials,
+               (uint64_t)ulSeed);
+            break;
+         case WORKLOAD_FREEZE:
+            iSuccessful = benchFreezeWorkload(uCount, (size_t)ulTrials,
+               (uint64_t)ulSeed);
+            break;
+         case WORKLOAD_SNAPSHOT:
+            iSuccessful = benchSnapshotWorkload(uCount, (size_t)ulTrials,
+               (uint64_t)ulSeed);
+            break;
+         case WORKLOAD_SCOPE:
+            iSuccessful = benchScopeWorkload(uCount, (size_t)ulTrials,
+               (uint64_t)ulSeed);
+            break;
+         case WORKLOAD_FILTER:
+            iSuccessful = benchFilterWorkload(uCount, (size_t)ulTrials,
+               (uint64_t)ulSeed);
+            break;
+         case WORKLOAD_TYPED:
+            iSuccessful = benchTypedWorkload(uCount, (size_t)ulTrials,
+               (uint64_t)ulSeed);
+            break;
+         case WORKLOAD_TINY:
+            iSuccessful = benchTinyWorkload(uCount, (size_t)ulTrials,
+               (uint64_t)ulSeed);
+            break;
+         case WORKLOAD_SHARDED:
+            iSuccessful = benchShardedWorkload(uCount, (size_t)ulTrials,
+               (uint64_t)ulSeed);
+            break;
+         case WORKLOAD_WRITERS:
+            iSuccessful = benchWritersWorkload(uCount, (size_t)ulTrials,
+               (uint64_t)ulSeed);
+            break;
+         case WORKLOAD_WRITER:
+            iSuccessful = benchWriterWorkload(uCount, (size_t)ulTrials,
+               (uint64_t)ulSeed);
+            break;
+         case WORKLOAD_BUILD:
+            iSuccessful = benchBuildWorkload(uCount, (size_t)ulTrials,
+               (uint64_t)ulSeed);
+            break;
+         case WORKLOAD_TEXT:
+            iSuccessful = benchTextWorkload(uCount, (size_t)ulTrials,
+               (uint64_t)ulSeed);
+            break;
+         default:
+            iSuccessful = benchLatencyWorkload(uCount, (size_t)ulTrials,
+               (uint64_t)ulSeed);
+            break;
+      }
+   }
+   if (! iSuccessful)
+   {
+      fprintf(stderr, "%s: benchmark failed\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   return 0;
+}
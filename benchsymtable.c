@@ -0,0 +1,438 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtable.c                                                    */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* Benchmark any SymTable implementation through symtable.h. Unlike
+   testsymtable.c's testLargeTable, keys and values are built before
+   the clock starts, each phase is timed separately with a monotonic
+   clock, and every measurement is repeated and summarized. Results
+   are written to stdout as CSV. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "benchutil.h"
+
+/* the name of the implementation this program is linked with */
+#ifndef SYMTABLE_BACKEND
+#define SYMTABLE_BACKEND "unknown"
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* The separately timed phases of one trial, in the order they run. */
+
+enum Phase {PHASE_PUT, PHASE_GET, PHASE_MISS, PHASE_MAP, PHASE_CLONE,
+   PHASE_REMOVE, PHASE_FREE, PHASE_SCRATCH_NEW, PHASE_SCRATCH_CLEAR,
+   PHASE_TEARDOWN_MAP, PHASE_TEARDOWN_DESTRUCTOR, PHASE_COUNT};
+
+static const char *apcPhaseNames[PHASE_COUNT] = {
+   "put", "get", "miss", "map", "clone", "remove", "free", "scratch-new",
+   "scratch-clear", "teardown-map", "teardown-destructor"
+};
+
+/* The clone phase models taking a private copy of a full table to
+   try a few changes on: each of CLONE_CYCLES cycles clones the table,
+   puts CLONE_WRITES new keys into the clone and frees it. Its times
+   are per cycle. */
+enum {CLONE_CYCLES = 16, CLONE_WRITES = 8};
+
+/* The scratch phases model a server that fills a small table per
+   request and then discards it: scratch-new creates and frees a table
+   per request, scratch-clear reuses one table with SymTable_clear.
+   Each request puts SCRATCH_BINDINGS keys. */
+enum {SCRATCH_BINDINGS = 64};
+
+/* The teardown phases free a table whose values were allocated with
+   malloc, of VALUE_SIZE bytes each: teardown-map frees the values
+   with SymTable_map and then the table, teardown-destructor frees a
+   table made by SymTable_newWithDestructor. */
+enum {VALUE_SIZE = 16};
+
+enum {DEFAULT_BINDINGS = 50000, DEFAULT_TRIALS = 5,
+   DEFAULT_SEED = 217};
+
+/*--------------------------------------------------------------------*/
+
+/* Add the address pvValue to the running sum at pvExtra. pcKey is
+   unused. */
+
+static void sumBinding(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+   (void)pcKey;
+   *(size_t*)pvExtra += (size_t)pvValue;
+}
+
+/* Free the value pvValue. pcKey and pvExtra are unused. */
+
+static void freeBinding(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra == NULL);
+   (void)pcKey;
+   (void)pvExtra;
+   free(pvValue);
+}
+
+/* Fill oSymTable with the first uCount keys of psKeys, each bound to
+   a new value of VALUE_SIZE bytes. Return the number of bindings
+   made. */
+
+static size_t fillAllocated(SymTable_T oSymTable,
+   const struct BenchKeys *psKeys, size_t uCount)
+{
+   size_t uMade = 0;
+   size_t u;
+   void *pvValue;
+   for (u = 0; u < uCount; u++)
+   {
+      pvValue = malloc(VALUE_SIZE);
+      if (pvValue == NULL)
+         break;
+      if (SymTable_put(oSymTable, psKeys->ppcKeys[u], pvValue))
+         uMade++;
+      else
+         free(pvValue);
+   }
+   return uMade;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* the last-level cache miss counter, or -1 if there is none */
+static int iMissCounter = -1;
+
+/* the counter reading taken by the latest startPhase */
+static long long llPhaseMisses;
+
+/* Note the start of a phase, and return the current time. */
+
+static double startPhase(void)
+{
+   llPhaseMisses = Bench_readCounter(iMissCounter);
+   return Bench_now();
+}
+
+/* Store in adSeconds[iPhase] the seconds elapsed since dStart and in
+   adMisses[iPhase] the cache misses counted since the matching
+   startPhase, or -1 if they cannot be counted. */
+
+static void endPhase(int iPhase, double dStart,
+   double adSeconds[PHASE_COUNT], double adMisses[PHASE_COUNT])
+{
+   long long llMisses;
+   adSeconds[iPhase] = Bench_now() - dStart;
+   llMisses = Bench_readCounter(iMissCounter);
+   adMisses[iPhase] = (llMisses < 0 || llPhaseMisses < 0) ? -1.0 :
+      (double)(llMisses - llPhaseMisses);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run one trial over psKeys, storing the seconds consumed by each
+   phase in adSeconds and the cache misses it incurred in adMisses.
+   puRemoveOrder is the order in which bindings are removed. Return 1
+   (TRUE) if every operation produced the expected result, and 0
+   (FALSE) otherwise. */
+
+static int runTrial(const struct BenchKeys *psKeys,
+   const size_t *puRemoveOrder, double adSeconds[PHASE_COUNT],
+   double adMisses[PHASE_COUNT])
+{
+   SymTable_T oSymTable;
+   SymTable_T oClone;
+   size_t uCount = psKeys->uCount;
+   size_t u;
+   size_t uKey;
+   size_t uWrites;
+   size_t uGood = 0;
+   size_t uSum = 0;
+   size_t uExpectedSum = 0;
+   double dStart;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return 0;
+
+   /* Each binding's value is the address of its own key, so no
+      value needs to be allocated. */
+   dStart = startPhase();
+   for (u = 0; u < uCount; u++)
+      uGood += (size_t)SymTable_put(oSymTable, psKeys->ppcKeys[u],
+         psKeys->ppcKeys[u]);
+   endPhase(PHASE_PUT, dStart, adSeconds, adMisses);
+
+   dStart = startPhase();
+   for (u = 0; u < uCount; u++)
+   {
+      const char *pcKey = psKeys->ppcKeys[psKeys->puLookups[u]];
+      uGood += (SymTable_get(oSymTable, pcKey) == pcKey);
+   }
+   endPhase(PHASE_GET, dStart, adSeconds, adMisses);
+
+   dStart = startPhase();
+   for (u = 0; u < uCount; u++)
+      uGood += (SymTable_get(oSymTable,
+         psKeys->ppcKeys[uCount + u]) == NULL);
+   endPhase(PHASE_MISS, dStart, adSeconds, adMisses);
+
+   dStart = startPhase();
+   SymTable_map(oSymTable, sumBinding, &uSum);
+   endPhase(PHASE_MAP, dStart, adSeconds, adMisses);
+   for (u = 0; u < uCount; u++)
+      uExpectedSum += (size_t)psKeys->ppcKeys[u];
+
+   uWrites = uCount < CLONE_WRITES ? uCount : CLONE_WRITES;
+   dStart = startPhase();
+   for (u = 0; u < CLONE_CYCLES; u++)
+   {
+      oClone = SymTable_clone(oSymTable);
+      if (oClone == NULL)
+      {
+         SymTable_free(oSymTable);
+         return 0;
+      }
+      for (uKey = 0; uKey < uWrites; uKey++)
+         (void)SymTable_put(oClone, psKeys->ppcKeys[uCount + uKey],
+            psKeys->ppcKeys[uCount + uKey]);
+      uGood += (SymTable_getLength(oClone) == uCount + uWrites);
+      SymTable_free(oClone);
+   }
+   endPhase(PHASE_CLONE, dStart, adSeconds, adMisses);
+
+   dStart = startPhase();
+   for (u = 0; u < uCount; u++)
+   {
+      const char *pcKey = psKeys->ppcKeys[puRemoveOrder[u]];
+      uGood += (SymTable_remove(oSymTable, pcKey) == pcKey);
+   }
+   endPhase(PHASE_REMOVE, dStart, adSeconds, adMisses);
+
+   /* Refill the table so that the free phase has work to do. */
+   for (u = 0; u < uCount; u++)
+      (void)SymTable_put(oSymTable, psKeys->ppcKeys[u],
+         psKeys->ppcKeys[u]);
+
+   dStart = startPhase();
+   SymTable_free(oSymTable);
+   endPhase(PHASE_FREE, dStart, adSeconds, adMisses);
+
+   /* Both scratch phases put every key once, in requests of
+      SCRATCH_BINDINGS keys. */
+   dStart = startPhase();
+   for (u = 0; u < uCount; u += SCRATCH_BINDINGS)
+   {
+      oSymTable = SymTable_new();
+      if (oSymTable == NULL)
+         return 0;
+      for (uKey = u; uKey < uCount && uKey < u + SCRATCH_BINDINGS; uKey++)
+         uGood += (size_t)SymTable_put(oSymTable, psKeys->ppcKeys[uKey],
+            psKeys->ppcKeys[uKey]);
+      SymTable_free(oSymTable);
+   }
+   endPhase(PHASE_SCRATCH_NEW, dStart, adSeconds, adMisses);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return 0;
+   dStart = startPhase();
+   for (u = 0; u < uCount; u += SCRATCH_BINDINGS)
+   {
+      for (uKey = u; uKey < uCount && uKey < u + SCRATCH_BINDINGS; uKey++)
+         uGood += (size_t)SymTable_put(oSymTable, psKeys->ppcKeys[uKey],
+            psKeys->ppcKeys[uKey]);
+      SymTable_clear(oSymTable, NULL);
+   }
+   endPhase(PHASE_SCRATCH_CLEAR, dStart, adSeconds, adMisses);
+   SymTable_free(oSymTable);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return 0;
+   uGood += fillAllocated(oSymTable, psKeys, uCount);
+   dStart = startPhase();
+   SymTable_map(oSymTable, freeBinding, NULL);
+   SymTable_free(oSymTable);
+   endPhase(PHASE_TEARDOWN_MAP, dStart, adSeconds, adMisses);
+
+   oSymTable = SymTable_newWithDestructor(free);
+   if (oSymTable == NULL)
+      return 0;
+   uGood += fillAllocated(oSymTable, psKeys, uCount);
+   dStart = startPhase();
+   SymTable_free(oSymTable);
+   endPhase(PHASE_TEARDOWN_DESTRUCTOR, dStart, adSeconds, adMisses);
+
+   return uGood == 8 * uCount + CLONE_CYCLES && uSum == uExpectedSum;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Benchmark distribution eDist with uCount bindings over uTrials
+   trials, writing one CSV row per phase to stdout. Return 1 (TRUE)
+   on success and 0 (FALSE) on failure. */
+
+static int benchDist(enum BenchDist eDist, size_t uCount,
+   size_t uTrials, uint64_t uSeed)
+{
+   struct BenchKeys sKeys;
+   struct BenchSummary sSummary;
+   double *pdSeconds;
+   double *pdMisses;
+   double adTrial[PHASE_COUNT];
+   double adTrialMisses[PHASE_COUNT];
+   struct BenchSummary sMisses;
+   size_t *puRemoveOrder;
+   size_t uTrial;
+   size_t uOps;
+   size_t u;
+   int iPhase;
+   int iSuccessful = 1;
+
+   if (! Bench_makeKeys(&sKeys, eDist, uCount, uSeed))
+      return 0;
+   pdSeconds = (double*)malloc(PHASE_COUNT * uTrials * sizeof(double));
+   pdMisses = (double*)malloc(PHASE_COUNT * uTrials * sizeof(double));
+   puRemoveOrder = (size_t*)malloc((uCount + 1) * sizeof(size_t));
+   if (pdSeconds == NULL || pdMisses == NULL || puRemoveOrder == NULL)
+   {
+      free(pdSeconds);
+      free(pdMisses);
+      free(puRemoveOrder);
+      Bench_freeKeys(&sKeys);
+      return 0;
+   }
+   for (u = 0; u < uCount; u++)
+      puRemoveOrder[u] = u;
+   Bench_shuffle(puRemoveOrder, uCount, &uSeed);
+
+   for (uTrial = 0; uTrial < uTrials && iSuccessful; uTrial++)
+   {
+      iSuccessful = runTrial(&sKeys, puRemoveOrder, adTrial,
+         adTrialMisses);
+      /* a failed trial may not have timed every phase */
+      for (iPhase = 0; iSuccessful && iPhase < PHASE_COUNT; iPhase++)
+      {
+         pdSeconds[iPhase * uTrials + uTrial] = adTrial[iPhase];
+         pdMisses[iPhase * uTrials + uTrial] = adTrialMisses[iPhase];
+      }
+   }
+
+   if (iSuccessful)
+      for (iPhase = 0; iPhase < PHASE_COUNT; iPhase++)
+      {
+         Bench_summarize(pdSeconds + iPhase * uTrials, uTrials,
+            &sSummary);
+         Bench_summarize(pdMisses + iPhase * uTrials, uTrials,
+            &sMisses);
+         uOps = iPhase == PHASE_CLONE ? CLONE_CYCLES : uCount;
+         Bench_writeRow(stdout, SYMTABLE_BACKEND, Bench_distName(eDist),
+            apcPhaseNames[iPhase], uCount, uOps, uTrials, &sSummary,
+            sMisses.dMedian < 0.0 ? -1.0 :
+               sMisses.dMedian / (double)(uOps == 0 ? 1 : uOps));
+      }
+   else
+      fprintf(stderr, "%s: wrong result for distribution %s\n",
+         SYMTABLE_BACKEND, Bench_distName(eDist));
+
+   free(pdSeconds);
+   free(pdMisses);
+   free(puRemoveOrder);
+   Bench_freeKeys(&sKeys);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write a usage message for program pcProgram to stderr. */
+
+static void usage(const char *pcProgram)
+{
+   fprintf(stderr,
+      "Usage: %s [-n bindings] [-t trials] [-s seed] [-d dist,...]\n"
+      "dist is one of sequential, random, zipf, long, collide "
+      "(default: all)\n", pcProgram);
+}
+
+/* Benchmark the SymTable implementation this program is linked with.
+   argv holds the options described by usage. Exit with EXIT_FAILURE
+   if the options are malformed or a run fails. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int aiSelected[BENCH_DIST_COUNT];
+   unsigned long ulBindings = DEFAULT_BINDINGS;
+   unsigned long ulTrials = DEFAULT_TRIALS;
+   unsigned long ulSeed = DEFAULT_SEED;
+   int iAll = 1;
+   int i;
+
+   memset(aiSelected, 0, sizeof(aiSelected));
+   for (i = 1; i < argc; i++)
+   {
+      if (i + 1 >= argc)
+      {
+         usage(argv[0]);
+         exit(EXIT_FAILURE);
+      }
+      if (strcmp(argv[i], "-n") == 0)
+      {
+         if (sscanf(argv[++i], "%lu", &ulBindings) != 1)
+         {
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+         }
+      }
+      else if (strcmp(argv[i], "-t") == 0)
+      {
+         if (sscanf(argv[++i], "%lu", &ulTrials) != 1 || ulTrials == 0)
+         {
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+         }
+      }
+      else if (strcmp(argv[i], "-s") == 0)
+      {
+         if (sscanf(argv[++i], "%lu", &ulSeed) != 1)
+         {
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+         }
+      }
+      else if (strcmp(argv[i], "-d") == 0)
+      {
+         char *pcName = strtok(argv[++i], ",");
+         iAll = 0;
+         for (; pcName != NULL; pcName = strtok(NULL, ","))
+         {
+            enum BenchDist eDist = Bench_parseDist(pcName);
+            if (eDist == BENCH_DIST_COUNT)
+            {
+               usage(argv[0]);
+               exit(EXIT_FAILURE);
+            }
+            aiSelected[eDist] = 1;
+         }
+      }
+      else
+      {
+         usage(argv[0]);
+         exit(EXIT_FAILURE);
+      }
+   }
+
+   iMissCounter = Bench_openCacheMisses();
+   Bench_writeHeader(stdout);
+   for (i = 0; i < (int)BENCH_DIST_COUNT; i++)
+      if (iAll || aiSelected[i])
+         if (! benchDist((enum BenchDist)i, (size_t)ulBindings,
+               (size_t)ulTrials, (uint64_t)ulSeed))
+            exit(EXIT_FAILURE);
+   Bench_closeCounter(iMissCounter);
+   return 0;
+}
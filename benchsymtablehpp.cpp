@@ -0,0 +1,205 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtablehpp.cpp                                               */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* Benchmark the C++ wrapper of symtable.hpp against
+   std::unordered_map<std::string, void*>, with keys that a C++ client
+   holds as std::string_view. The wrapper passes the views to the
+   table as they are. The standard map of C++17 needs a std::string
+   for each put and each lookup, and so does a wrapper that calls
+   SymTable_get with c_str(), which the "get-string" phase measures.
+
+   Usage: benchsymtablehpp [-n bindings] [-t trials] [-s seed]
+
+   Results are written to stdout as CSV, in the format of
+   benchsymtable.c. */
+
+#include "symtable.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include "benchutil.h"
+}
+
+enum {DEFAULT_BINDINGS = 1000000, DEFAULT_TRIALS = 5, DEFAULT_SEED = 217};
+
+/* the phases of a trial, each run on the wrapper and on the standard
+   map except "get-string", which only the wrapper has */
+enum Phase {PHASE_PUT, PHASE_GET, PHASE_GET_STRING, PHASE_MISS,
+   PHASE_COUNT};
+
+static const char *apcPhaseNames[PHASE_COUNT] = {
+   "put", "get", "get-string", "miss"
+};
+
+/* the implementations of a trial */
+enum Subject {SUBJECT_WRAPPER, SUBJECT_UNORDERED, SUBJECT_COUNT};
+
+static const char *apcSubjectNames[SUBJECT_COUNT] = {
+   "hash", "unordered_map"
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Run one trial over the keys of psKeys, whose views are in oViews,
+   storing the seconds consumed by each phase of each subject in
+   adSeconds. Return true if every operation produced the expected
+   result, and false otherwise. */
+
+static bool runTrial(const struct BenchKeys *psKeys,
+   const std::vector<std::string_view> &oViews,
+   double adSeconds[SUBJECT_COUNT][PHASE_COUNT])
+{
+   symtable::Table<void> oTable;
+   std::unordered_map<std::string, void*> oMap;
+   std::size_t uCount = psKeys->uCount;
+   std::size_t uGood = 0;
+   std::size_t u;
+   double dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+      uGood += oTable.try_emplace(oViews[u], psKeys->ppcKeys[u]).second;
+   adSeconds[SUBJECT_WRAPPER][PHASE_PUT] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+      uGood += oMap.try_emplace(std::string(oViews[u]),
+         psKeys->ppcKeys[u]).second;
+   adSeconds[SUBJECT_UNORDERED][PHASE_PUT] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+   {
+      std::size_t uIndex = psKeys->puLookups[u];
+      uGood += oTable.find(oViews[uIndex]) == psKeys->ppcKeys[uIndex];
+   }
+   adSeconds[SUBJECT_WRAPPER][PHASE_GET] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+   {
+      std::size_t uIndex = psKeys->puLookups[u];
+      auto oFound = oMap.find(std::string(oViews[uIndex]));
+      uGood += oFound != oMap.end() &&
+         oFound->second == psKeys->ppcKeys[uIndex];
+   }
+   adSeconds[SUBJECT_UNORDERED][PHASE_GET] = Bench_now() - dStart;
+
+   /* the lookup of a wrapper that builds a string for c_str()*/
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+   {
+      std::size_t uIndex = psKeys->puLookups[u];
+      std::string sKey(oViews[uIndex]);
+      uGood += SymTable_get(oTable.get(), sKey.c_str()) ==
+         psKeys->ppcKeys[uIndex];
+   }
+   adSeconds[SUBJECT_WRAPPER][PHASE_GET_STRING] = Bench_now() - dStart;
+   adSeconds[SUBJECT_UNORDERED][PHASE_GET_STRING] = 0;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+      uGood += ! oTable.contains(oViews[uCount + psKeys->puLookups[u]]);
+   adSeconds[SUBJECT_WRAPPER][PHASE_MISS] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   for (u = 0; u < uCount; u++)
+      uGood += oMap.find(std::string(oViews[uCount +
+         psKeys->puLookups[u]])) == oMap.end();
+   adSeconds[SUBJECT_UNORDERED][PHASE_MISS] = Bench_now() - dStart;
+
+   return uGood == 7 * uCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Benchmark the wrapper and the standard map. argv holds the options
+   listed above. Exit with EXIT_FAILURE if the options are malformed
+   or a run fails. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   unsigned long ulBindings = DEFAULT_BINDINGS;
+   unsigned long ulTrials = DEFAULT_TRIALS;
+   unsigned long ulSeed = DEFAULT_SEED;
+   unsigned long *pulOption;
+   struct BenchKeys sKeys;
+   struct BenchSummary sSummary;
+   double adTrial[SUBJECT_COUNT][PHASE_COUNT];
+   std::vector<double> oSeconds;
+   std::vector<std::string_view> oViews;
+   std::size_t uTrials;
+   std::size_t uTrial;
+   std::size_t u;
+   bool iSuccessful = true;
+   int i;
+
+   for (i = 1; i < argc; i += 2)
+   {
+      if (std::strcmp(argv[i], "-n") == 0)
+         pulOption = &ulBindings;
+      else if (std::strcmp(argv[i], "-t") == 0)
+         pulOption = &ulTrials;
+      else if (std::strcmp(argv[i], "-s") == 0)
+         pulOption = &ulSeed;
+      else
+         pulOption = nullptr;
+      if (pulOption == nullptr || i + 1 >= argc ||
+            std::sscanf(argv[i + 1], "%lu", pulOption) != 1 ||
+            ulTrials == 0 || ulBindings == 0)
+      {
+         std::fprintf(stderr,
+            "Usage: %s [-n bindings] [-t trials] [-s seed]\n", argv[0]);
+         std::exit(EXIT_FAILURE);
+      }
+   }
+
+   if (! Bench_makeKeys(&sKeys, BENCH_RANDOM, (size_t)ulBindings,
+         (uint64_t)ulSeed))
+   {
+      std::fprintf(stderr, "%s: insufficient memory\n", argv[0]);
+      std::exit(EXIT_FAILURE);
+   }
+   /* a client holds its keys as views already, so the views are made
+      outside the timed phases*/
+   for (u = 0; u < 2 * sKeys.uCount; u++)
+      oViews.emplace_back(sKeys.ppcKeys[u]);
+   uTrials = (std::size_t)ulTrials;
+   oSeconds.resize(SUBJECT_COUNT * PHASE_COUNT * uTrials);
+
+   for (uTrial = 0; uTrial < uTrials && iSuccessful; uTrial++)
+   {
+      iSuccessful = runTrial(&sKeys, oViews, adTrial);
+      for (u = 0; u < SUBJECT_COUNT * PHASE_COUNT; u++)
+         oSeconds[u * uTrials + uTrial] =
+            adTrial[u / PHASE_COUNT][u % PHASE_COUNT];
+   }
+   if (! iSuccessful)
+   {
+      std::fprintf(stderr, "%s: wrong result\n", argv[0]);
+      Bench_freeKeys(&sKeys);
+      std::exit(EXIT_FAILURE);
+   }
+
+   Bench_writeHeader(stdout);
+   for (u = 0; u < SUBJECT_COUNT * PHASE_COUNT; u++)
+   {
+      if (u / PHASE_COUNT == SUBJECT_UNORDERED &&
+            u % PHASE_COUNT == PHASE_GET_STRING)
+         continue;
+      Bench_summarize(&oSeconds[u * uTrials], uTrials, &sSummary);
+      Bench_writeRow(stdout, apcSubjectNames[u / PHASE_COUNT], "cpp",
+         apcPhaseNames[u % PHASE_COUNT], sKeys.uCount, sKeys.uCount,
+         uTrials, &sSummary, -1.0);
+   }
+   Bench_freeKeys(&sKeys);
+   return 0;
+}
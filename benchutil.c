@@ -0,0 +1,368 @@
+/*--------------------------------------------------------------------*/
+/* benchutil.c                                                        */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+#include "benchutil.h"
+
+/*--------------------------------------------------------------------*/
+
+/* the names of the distributions, indexed by enum BenchDist */
+static const char *apcDistNames[BENCH_DIST_COUNT] = {
+   "sequential", "random", "zipf", "long", "collide"
+};
+
+/* the bucket count and target bucket of BENCH_COLLIDE keys */
+enum {COLLIDE_BUCKET_COUNT = 509, COLLIDE_BUCKET = 123};
+
+/* the longest key any distribution produces, including '\0' */
+enum {MAX_KEY_SIZE = BENCH_LONG_KEY_LENGTH + 1};
+
+/*--------------------------------------------------------------------*/
+
+const char *Bench_distName(enum BenchDist eDist)
+{
+   assert(eDist < BENCH_DIST_COUNT);
+   return apcDistNames[eDist];
+}
+
+enum BenchDist Bench_parseDist(const char *pcName)
+{
+   int i;
+   assert(pcName != NULL);
+   for (i = 0; i < (int)BENCH_DIST_COUNT; i++)
+      if (strcmp(apcDistNames[i], pcName) == 0)
+         return (enum BenchDist)i;
+   return BENCH_DIST_COUNT;
+}
+
+/*--------------------------------------------------------------------*/
+
+uint64_t Bench_random(uint64_t *puState)
+{
+   uint64_t u;
+   assert(puState != NULL);
+   u = (*puState += 0x9e3779b97f4a7c15u);
+   u = (u ^ (u >> 30)) * 0xbf58476d1ce4e5b9u;
+   u = (u ^ (u >> 27)) * 0x94d049bb133111ebu;
+   return u ^ (u >> 31);
+}
+
+void Bench_shuffle(size_t *puArray, size_t uCount, uint64_t *puState)
+{
+   size_t u;
+   size_t uOther;
+   size_t uTemp;
+   assert(puArray != NULL || uCount == 0);
+   for (u = uCount; u > 1; u--)
+   {
+      uOther = (size_t)(Bench_random(puState) % u);
+      uTemp = puArray[u - 1];
+      puArray[u - 1] = puArray[uOther];
+      puArray[uOther] = uTemp;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+double Bench_now(void)
+{
+   struct timespec sTime;
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (double)sTime.tv_sec + (double)sTime.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Bench_openCacheMisses(void)
+{
+#ifdef __linux__
+   struct perf_event_attr sAttr;
+   memset(&sAttr, 0, sizeof(sAttr));
+   sAttr.size = sizeof(sAttr);
+   sAttr.type = PERF_TYPE_HARDWARE;
+   sAttr.config = PERF_COUNT_HW_CACHE_MISSES;
+   sAttr.exclude_kernel = 1;
+   sAttr.exclude_hv = 1;
+   return (int)syscall(SYS_perf_event_open, &sAttr, 0, -1, -1, 0);
+#else
+   return -1;
+#endif
+}
+
+long long Bench_readCounter(int iCounter)
+{
+   long long llValue;
+   if (iCounter < 0)
+      return -1;
+   if (read(iCounter, &llValue, sizeof(llValue)) != sizeof(llValue))
+      return -1;
+   return llValue;
+}
+
+void Bench_closeCounter(int iCounter)
+{
+   if (iCounter >= 0)
+      close(iCounter);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the bucket that pcKey occupies under the hash function from
+   the assignment specification with COLLIDE_BUCKET_COUNT buckets. */
+
+static size_t Bench_assignmentBucket(const char *pcKey)
+{
+   const size_t HASH_MULTIPLIER = 65599;
+   size_t u;
+   size_t uHash = 0;
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+   return uHash % COLLIDE_BUCKET_COUNT;
+}
+
+/* Write the uIndex-th key of distribution eDist into acKey, which
+   has room for MAX_KEY_SIZE characters. *puNext is the generator
+   state of BENCH_COLLIDE, which has to search for its keys. */
+
+static void Bench_makeKey(char *acKey, enum BenchDist eDist,
+   size_t uIndex, uint64_t uSeed, unsigned long *pulNext)
+{
+   uint64_t uState;
+   switch (eDist)
+   {
+      case BENCH_RANDOM:
+         uState = uSeed ^ ((uint64_t)uIndex * 0x2545f4914f6cdd1du);
+         sprintf(acKey, "%016llx",
+            (unsigned long long)Bench_random(&uState));
+         /* the index suffix keeps keys distinct */
+         sprintf(acKey + 16, "%lx", (unsigned long)uIndex);
+         break;
+      case BENCH_LONG:
+         memset(acKey, 'k', BENCH_LONG_KEY_LENGTH);
+         sprintf(acKey + BENCH_LONG_KEY_LENGTH - 12, "%012lu",
+            (unsigned long)uIndex);
+         break;
+      case BENCH_COLLIDE:
+         do
+            sprintf(acKey, "%lu", (*pulNext)++);
+         while (Bench_assignmentBucket(acKey) != COLLIDE_BUCKET);
+         break;
+      case BENCH_SEQUENTIAL:
+      case BENCH_ZIPF:
+      default:
+         sprintf(acKey, "%lu", (unsigned long)uIndex);
+         break;
+   }
+}
+
+/* Fill puLookups with uCount indices below uCount that follow a
+   Zipf distribution with exponent 1 over a random ranking of the
+   keys. Return 1 (TRUE) on success, 0 (FALSE) on lack of memory. */
+
+static int Bench_makeZipf(size_t *puLookups, size_t uCount,
+   uint64_t *puState)
+{
+   double *pdCdf;
+   size_t *puRank;
+   double dTotal = 0.0;
+   double dTarget;
+   size_t u;
+   size_t uLow;
+   size_t uHigh;
+
+   pdCdf = (double*)malloc(uCount * sizeof(double));
+   puRank = (size_t*)malloc(uCount * sizeof(size_t));
+   if (pdCdf == NULL || puRank == NULL)
+   {
+      free(pdCdf);
+      free(puRank);
+      return 0;
+   }
+
+   for (u = 0; u < uCount; u++)
+   {
+      dTotal += 1.0 / (double)(u + 1);
+      pdCdf[u] = dTotal;
+      puRank[u] = u;
+   }
+   Bench_shuffle(puRank, uCount, puState);
+
+   for (u = 0; u < uCount; u++)
+   {
+      dTarget = dTotal * (double)(Bench_random(puState) >> 11)
+         / 9007199254740992.0;
+      uLow = 0;
+      uHigh = uCount - 1;
+      while (uLow < uHigh)
+      {
+         size_t uMid = uLow + (uHigh - uLow) / 2;
+         if (pdCdf[uMid] < dTarget)
+            uLow = uMid + 1;
+         else
+            uHigh = uMid;
+      }
+      puLookups[u] = puRank[uLow];
+   }
+
+   free(pdCdf);
+   free(puRank);
+   return 1;
+}
+
+int Bench_makeKeys(struct BenchKeys *psKeys, enum BenchDist eDist,
+   size_t uCount, uint64_t uSeed)
+{
+   char acKey[MAX_KEY_SIZE + 32];
+   size_t u;
+   size_t uTotal = 2 * uCount;
+   size_t uHeapSize = 0;
+   size_t uHeapUsed = 0;
+   unsigned long ulNext = 0;
+   uint64_t uState = uSeed;
+   char *pcHeap;
+
+   assert(psKeys != NULL);
+   assert(eDist < BENCH_DIST_COUNT);
+
+   psKeys->eDist = eDist;
+   psKeys->uCount = uCount;
+   psKeys->ppcKeys = (char**)malloc((uTotal + 1) * sizeof(char*));
+   psKeys->puLookups = (size_t*)malloc((uCount + 1) * sizeof(size_t));
+   psKeys->pcHeap = NULL;
+   if (psKeys->ppcKeys == NULL || psKeys->puLookups == NULL)
+   {
+      Bench_freeKeys(psKeys);
+      return 0;
+   }
+
+   /* Generate every key twice: once to size the heap, once to fill
+      it. Regenerating is cheaper than a growing buffer. */
+   for (u = 0; u < uTotal; u++)
+   {
+      Bench_makeKey(acKey, eDist, u, uSeed, &ulNext);
+      uHeapSize += strlen(acKey) + 1;
+   }
+   pcHeap = (char*)malloc(uHeapSize + 1);
+   if (pcHeap == NULL)
+   {
+      Bench_freeKeys(psKeys);
+      return 0;
+   }
+   psKeys->pcHeap = pcHeap;
+   ulNext = 0;
+   for (u = 0; u < uTotal; u++)
+   {
+      Bench_makeKey(acKey, eDist, u, uSeed, &ulNext);
+      psKeys->ppcKeys[u] = strcpy(pcHeap + uHeapUsed, acKey);
+      uHeapUsed += strlen(acKey) + 1;
+   }
+
+   if (eDist == BENCH_ZIPF)
+   {
+      if (! Bench_makeZipf(psKeys->puLookups, uCount, &uState))
+      {
+         Bench_freeKeys(psKeys);
+         return 0;
+      }
+   }
+   else
+   {
+      for (u = 0; u < uCount; u++)
+         psKeys->puLookups[u] = u;
+      Bench_shuffle(psKeys->puLookups, uCount, &uState);
+   }
+   return 1;
+}
+
+void Bench_freeKeys(struct BenchKeys *psKeys)
+{
+   assert(psKeys != NULL);
+   free(psKeys->ppcKeys);
+   free(psKeys->puLookups);
+   free(psKeys->pcHeap);
+   psKeys->ppcKeys = NULL;
+   psKeys->puLookups = NULL;
+   psKeys->pcHeap = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the doubles at pvOne and pvTwo for qsort. */
+
+static int Bench_compareDoubles(const void *pvOne, const void *pvTwo)
+{
+   double dOne = *(const double*)pvOne;
+   double dTwo = *(const double*)pvTwo;
+   return (dOne > dTwo) - (dOne < dTwo);
+}
+
+/* Return the dFraction quantile of the uCount sorted samples
+   pdSamples, by the nearest-rank method. */
+
+static double Bench_quantile(const double *pdSamples, size_t uCount,
+   double dFraction)
+{
+   size_t uRank = (size_t)(dFraction * (double)(uCount - 1) + 0.5);
+   return pdSamples[uRank];
+}
+
+void Bench_summarize(double *pdSamples, size_t uCount,
+   struct BenchSummary *psSummary)
+{
+   assert(pdSamples != NULL);
+   assert(uCount > 0);
+   assert(psSummary != NULL);
+
+   qsort(pdSamples, uCount, sizeof(double), Bench_compareDoubles);
+   psSummary->dMin = pdSamples[0];
+   psSummary->dP10 = Bench_quantile(pdSamples, uCount, 0.10);
+   psSummary->dMedian = Bench_quantile(pdSamples, uCount, 0.50);
+   psSummary->dP90 = Bench_quantile(pdSamples, uCount, 0.90);
+   psSummary->dMax = pdSamples[uCount - 1];
+}
+
+/*--------------------------------------------------------------------*/
+
+void Bench_writeHeader(FILE *psFile)
+{
+   assert(psFile != NULL);
+   fprintf(psFile, "backend,workload,phase,bindings,ops,trials,"
+      "min_ns_per_op,p10_ns_per_op,median_ns_per_op,p90_ns_per_op,"
+      "max_ns_per_op,median_llc_misses_per_op\n");
+}
+
+void Bench_writeRow(FILE *psFile, const char *pcBackend,
+   const char *pcWorkload, const char *pcPhase, size_t uBindings,
+   size_t uOps, size_t uTrials, const struct BenchSummary *psSummary,
+   double dMissesPerOp)
+{
+   double dScale;
+   assert(psFile != NULL);
+   assert(psSummary != NULL);
+
+   dScale = 1e9 / (double)(uOps == 0 ? 1 : uOps);
+   fprintf(psFile, "%s,%s,%s,%lu,%lu,%lu,%.2f,%.2f,%.2f,%.2f,%.2f,",
+      pcBackend, pcWorkload, pcPhase, (unsigned long)uBindings,
+      (unsigned long)uOps, (unsigned long)uTrials,
+      psSummary->dMin * dScale, psSummary->dP10 * dScale,
+      psSummary->dMedian * dScale, psSummary->dP90 * dScale,
+      psSummary->dMax * dScale);
+   if (dMissesPerOp < 0.0)
+      fprintf(psFile, "NA\n");
+   else
+      fprintf(psFile, "%.3f\n", dMissesPerOp);
+   fflush(psFile);
+}
@@ -0,0 +1,136 @@
+/*--------------------------------------------------------------------*/
+/* benchutil.h                                                        */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* Helpers shared by the SymTable benchmark programs: a monotonic
+   clock, key sets with several distributions, trial summaries and
+   CSV output. None of these helpers run inside a timed region. */
+
+#ifndef BENCHUTIL_INCLUDED
+#define BENCHUTIL_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The key distributions a benchmark can draw its keys from. */
+
+enum BenchDist {
+   /* "0", "1", "2", ... as testsymtable.c's testLargeTable uses */
+   BENCH_SEQUENTIAL,
+   /* hexadecimal renderings of 64-bit pseudo-random numbers */
+   BENCH_RANDOM,
+   /* sequential keys, but lookups follow a Zipf(1) popularity */
+   BENCH_ZIPF,
+   /* BENCH_LONG_KEY_LENGTH-character keys sharing a long prefix */
+   BENCH_LONG,
+   /* decimal keys that all land in one bucket of the original
+      509-bucket hash function from the assignment specification */
+   BENCH_COLLIDE,
+   BENCH_DIST_COUNT
+};
+
+enum {BENCH_LONG_KEY_LENGTH = 128};
+
+/*--------------------------------------------------------------------*/
+
+/* A BenchKeys holds 2 * uCount distinct keys of one distribution.
+   ppcKeys[0..uCount-1] are the keys to insert; ppcKeys[uCount..]
+   are keys that are never inserted and so produce misses.
+   puLookups holds uCount indices into the inserted half, in the
+   order lookups should visit them. */
+
+struct BenchKeys {
+   enum BenchDist eDist;
+   size_t uCount;
+   char **ppcKeys;
+   size_t *puLookups;
+   /* one allocation holding every key's characters */
+   char *pcHeap;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* return the name of eDist, as accepted by Bench_parseDist. */
+const char *Bench_distName(enum BenchDist eDist);
+
+/* return the distribution named pcName, or BENCH_DIST_COUNT if
+   pcName names none. */
+enum BenchDist Bench_parseDist(const char *pcName);
+
+/*--------------------------------------------------------------------*/
+
+/* return the next number of the pseudo-random sequence whose state
+   is *puState (splitmix64). */
+uint64_t Bench_random(uint64_t *puState);
+
+/* shuffle the uCount elements of puArray using *puState. */
+void Bench_shuffle(size_t *puArray, size_t uCount, uint64_t *puState);
+
+/*--------------------------------------------------------------------*/
+
+/* return the current time of a monotonic clock, in seconds. */
+double Bench_now(void);
+
+/*--------------------------------------------------------------------*/
+
+/* return a handle to a hardware counter of last-level cache misses
+   incurred by the calling thread in user mode, or -1 if the platform
+   does not provide one (no PMU, or perf_event_paranoid forbids it). */
+int Bench_openCacheMisses(void);
+
+/* return the current value of the counter iCounter returned by
+   Bench_openCacheMisses, or -1 if iCounter is -1 or unreadable. */
+long long Bench_readCounter(int iCounter);
+
+/* close the counter iCounter, if it is not -1. */
+void Bench_closeCounter(int iCounter);
+
+/*--------------------------------------------------------------------*/
+
+/* fill *psKeys with 2 * uCount keys of distribution eDist generated
+   from uSeed. Return 1 (TRUE) on success or 0 (FALSE) if
+   insufficient memory is available. */
+int Bench_makeKeys(struct BenchKeys *psKeys, enum BenchDist eDist,
+   size_t uCount, uint64_t uSeed);
+
+/* free the memory held by *psKeys. */
+void Bench_freeKeys(struct BenchKeys *psKeys);
+
+/*--------------------------------------------------------------------*/
+
+/* A BenchSummary describes a set of trial results. */
+
+struct BenchSummary {
+   double dMin;
+   double dP10;
+   double dMedian;
+   double dP90;
+   double dMax;
+};
+
+/* sort the uCount samples of pdSamples and summarize them in
+   *psSummary. */
+void Bench_summarize(double *pdSamples, size_t uCount,
+   struct BenchSummary *psSummary);
+
+/*--------------------------------------------------------------------*/
+
+/* write the CSV header line used by Bench_writeRow to psFile. */
+void Bench_writeHeader(FILE *psFile);
+
+/* write one CSV row to psFile: implementation pcBackend ran phase
+   pcPhase of workload pcWorkload over uBindings bindings, uOps
+   operations per trial, with per-trial seconds summarized by
+   *psSummary and a median of dMissesPerOp last-level cache misses per
+   operation. Times are written as nanoseconds per operation; a
+   negative dMissesPerOp is written as NA. */
+void Bench_writeRow(FILE *psFile, const char *pcBackend,
+   const char *pcWorkload, const char *pcPhase, size_t uBindings,
+   size_t uOps, size_t uTrials, const struct BenchSummary *psSummary,
+   double dMissesPerOp);
+
+#endif
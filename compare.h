@@ -0,0 +1,42 @@
+/*--------------------------------------------------------------------*/
+/* compare.h                                                          */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* The interface through which benchcompare.c drives one structure.
+   Each subject of the comparison implements it in its own file:
+   comparesymtable.c over any SymTable implementation, comparehsearch.c
+   over glibc's hsearch_r, comparetsearch.c over tsearch and
+   compareunordered.cpp over std::unordered_map. Every subject copies
+   the keys it is given, as SymTable_put does, so that the memory
+   figures are comparable. */
+
+#ifndef COMPARE_INCLUDED
+#define COMPARE_INCLUDED
+
+#include <stddef.h>
+
+/* A Compare_T is one table of the subject. */
+
+typedef struct Compare *Compare_T;
+
+/* the name of the subject, as written in the output */
+extern const char Compare_name[];
+
+/* return a new table that will receive at most uCapacity bindings, or
+   NULL if insufficient memory is available. Only subjects that cannot
+   grow, such as hsearch_r, use uCapacity. */
+Compare_T Compare_new(size_t uCapacity);
+
+/* free oCompare and its copies of the keys. */
+void Compare_free(Compare_T oCompare);
+
+/* bind a copy of pcKey to pvValue unless pcKey is bound. return 1
+   (TRUE) if the binding was made, and 0 (FALSE) otherwise. */
+int Compare_put(Compare_T oCompare, const char *pcKey,
+   const void *pvValue);
+
+/* return the value bound to pcKey, or NULL if there is none. */
+void *Compare_get(Compare_T oCompare, const char *pcKey);
+
+#endif
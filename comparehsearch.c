@@ -0,0 +1,104 @@
+/*--------------------------------------------------------------------*/
+/* comparehsearch.c                                                   */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* The compare.h subject for glibc's hsearch_r. The table has a fixed
+   size, chosen at creation as twice the capacity so that it is at
+   most half full. hdestroy_r does not free the keys, so the table
+   also keeps an array of its copies. */
+
+#define _GNU_SOURCE
+#include <assert.h>
+#include <search.h>
+#include <stdlib.h>
+#include <string.h>
+#include "compare.h"
+
+const char Compare_name[] = "hsearch";
+
+struct Compare {
+   struct hsearch_data sTable;
+   /* the copies of the keys, in the order they were put */
+   char **ppcKeys;
+   size_t uCount;
+   size_t uCapacity;
+};
+
+Compare_T Compare_new(size_t uCapacity)
+{
+   Compare_T oCompare = (Compare_T)calloc(1, sizeof(struct Compare));
+   if (oCompare == NULL)
+      return NULL;
+   oCompare->uCapacity = uCapacity;
+   oCompare->ppcKeys = (char**)malloc((uCapacity + 1) * sizeof(char*));
+   if (oCompare->ppcKeys == NULL ||
+         ! hcreate_r(2 * uCapacity + 1, &oCompare->sTable))
+   {
+      free(oCompare->ppcKeys);
+      free(oCompare);
+      return NULL;
+   }
+   return oCompare;
+}
+
+void Compare_free(Compare_T oCompare)
+{
+   size_t u;
+   assert(oCompare != NULL);
+   hdestroy_r(&oCompare->sTable);
+   for (u = 0; u < oCompare->uCount; u++)
+      free(oCompare->ppcKeys[u]);
+   free(oCompare->ppcKeys);
+   free(oCompare);
+}
+
+int Compare_put(Compare_T oCompare, const char *pcKey,
+   const void *pvValue)
+{
+   ENTRY sItem;
+   ENTRY *psFound;
+   size_t uLength;
+   char *pcCopy;
+
+   assert(oCompare != NULL);
+   assert(pcKey != NULL);
+
+   /* ENTER returns the existing entry for a bound key, so the key is
+      looked up first to leave its value unchanged */
+   sItem.key = (char*)pcKey;
+   sItem.data = NULL;
+   if (hsearch_r(sItem, FIND, &psFound, &oCompare->sTable) ||
+         oCompare->uCount == oCompare->uCapacity)
+      return 0;
+
+   uLength = strlen(pcKey) + 1;
+   pcCopy = (char*)malloc(uLength);
+   if (pcCopy == NULL)
+      return 0;
+   memcpy(pcCopy, pcKey, uLength);
+   sItem.key = pcCopy;
+   sItem.data = (void*)pvValue;
+   if (! hsearch_r(sItem, ENTER, &psFound, &oCompare->sTable))
+   {
+      free(pcCopy);
+      return 0;
+   }
+   oCompare->ppcKeys[oCompare->uCount++] = pcCopy;
+   return 1;
+}
+
+void *Compare_get(Compare_T oCompare, const char *pcKey)
+{
+   ENTRY sItem;
+   ENTRY *psFound;
+
+   assert(oCompare != NULL);
+   assert(pcKey != NULL);
+
+   sItem.key = (char*)pcKey;
+   sItem.data = NULL;
+   if (! hsearch_r(sItem, FIND, &psFound, &oCompare->sTable))
+      return NULL;
+   return psFound->data;
+}
@@ -0,0 +1,39 @@
+/*--------------------------------------------------------------------*/
+/* comparesymtable.c                                                  */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* The compare.h subject for the SymTable implementation the program
+   is linked with. */
+
+#include "compare.h"
+#include "symtable.h"
+
+/* the name of the implementation this program is linked with */
+#ifndef SYMTABLE_BACKEND
+#define SYMTABLE_BACKEND "unknown"
+#endif
+
+const char Compare_name[] = SYMTABLE_BACKEND;
+
+Compare_T Compare_new(size_t uCapacity)
+{
+   (void)uCapacity;
+   return (Compare_T)SymTable_new();
+}
+
+void Compare_free(Compare_T oCompare)
+{
+   SymTable_free((SymTable_T)oCompare);
+}
+
+int Compare_put(Compare_T oCompare, const char *pcKey,
+   const void *pvValue)
+{
+   return SymTable_put((SymTable_T)oCompare, pcKey, pvValue);
+}
+
+void *Compare_get(Compare_T oCompare, const char *pcKey)
+{
+   return SymTable_get((SymTable_T)oCompare, pcKey);
+}
@@ -0,0 +1,90 @@
+#----------------------------------------------------------------------
+# comparetable.awk
+# Author: Devanna Ritchie
+#----------------------------------------------------------------------
+
+# Rewrite the generated table of the readme from the CSV rows of the
+# benchcompare programs:
+#
+#   awk -f comparetable.awk compare_output.txt readme > readme.new
+#
+# The first file holds the rows; the second is copied to stdout with
+# the lines between the markers BEGIN_MARK and END_MARK replaced by
+# one block per measure, a row per subject and a column per binding
+# count. Subjects and counts keep the order of their first row. A count
+# a subject did not run is shown as "-".
+
+BEGIN {
+   FS = ","
+   BEGIN_MARK = "[table generated by make readme-table; do not edit]"
+   END_MARK = "[end of generated table]"
+   split("put_ns get_ns miss_ns bytes_per_binding peak_rss_kib",
+      aMeasures, " ")
+   aTitles["put_ns"] = "put, ns per operation"
+   aTitles["get_ns"] = "get (hit), ns per operation"
+   aTitles["miss_ns"] = "get (miss), ns per operation"
+   aTitles["bytes_per_binding"] = "heap bytes per binding"
+   aTitles["peak_rss_kib"] = "peak RSS, MiB"
+}
+
+# the CSV rows
+FNR == NR {
+   if ($1 == "backend") {
+      for (i = 1; i <= NF; i++)
+         aColumns[$i] = i
+      next
+   }
+   if (! ($1 in aSubjectSeen)) {
+      aSubjectSeen[$1] = 1
+      aSubjects[++iSubjects] = $1
+   }
+   if (! ($2 in aCountSeen)) {
+      aCountSeen[$2] = 1
+      aCounts[++iCounts] = $2
+   }
+   for (m in aTitles)
+      aValues[$1, $2, m] = $(aColumns[m])
+   next
+}
+
+$0 == BEGIN_MARK {
+   print
+   writeTable()
+   iSkipping = 1
+   next
+}
+
+$0 == END_MARK {
+   iSkipping = 0
+}
+
+! iSkipping {
+   print
+}
+
+# Write the blocks of the table.
+
+function writeTable(    m, c, s, sValue) {
+   for (m = 1; m in aMeasures; m++) {
+      printf "\n%s\n%-16s", aTitles[aMeasures[m]], ""
+      for (c = 1; c <= iCounts; c++)
+         printf " %8s", aCounts[c]
+      printf "\n"
+      for (s = 1; s <= iSubjects; s++) {
+         printf "-- %-13s", aSubjects[s]
+         for (c = 1; c <= iCounts; c++) {
+            if (! ((aSubjects[s], aCounts[c], aMeasures[m]) in aValues))
+               sValue = "-"
+            else if (aMeasures[m] == "peak_rss_kib")
+               sValue = sprintf("%.1f",
+                  aValues[aSubjects[s], aCounts[c], aMeasures[m]] / 1024)
+            else
+               sValue = sprintf("%.1f",
+                  aValues[aSubjects[s], aCounts[c], aMeasures[m]])
+            printf " %8s", sValue
+         }
+         printf "\n"
+      }
+   }
+   printf "\n"
+}
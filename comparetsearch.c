@@ -0,0 +1,101 @@
+/*--------------------------------------------------------------------*/
+/* comparetsearch.c                                                   */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* The compare.h subject for tsearch, the balanced binary tree of
+   search.h (a red-black tree in glibc). Each tree node points to a
+   binding that holds the value and, after it, the copy of the key. */
+
+#define _GNU_SOURCE
+#include <assert.h>
+#include <search.h>
+#include <stdlib.h>
+#include <string.h>
+#include "compare.h"
+
+const char Compare_name[] = "tsearch";
+
+struct Compare {
+   /* the root of the tree */
+   void *pvRoot;
+};
+
+/* A binding of the tree: the value, then the key's characters. */
+
+struct Binding {
+   const void *pvValue;
+   char acKey[1];
+};
+
+/* Compare the bindings pvFirst and pvSecond by key, as strcmp. */
+
+static int Compare_compareBindings(const void *pvFirst,
+   const void *pvSecond)
+{
+   return strcmp(((const struct Binding*)pvFirst)->acKey,
+      ((const struct Binding*)pvSecond)->acKey);
+}
+
+/* Compare the string pvKey with the key of the binding pvBinding. A
+   lookup passes the caller's key itself, cast to a binding, and
+   tfind passes it as the first argument. */
+
+static int Compare_compareKey(const void *pvKey, const void *pvBinding)
+{
+   return strcmp((const char*)pvKey,
+      ((const struct Binding*)pvBinding)->acKey);
+}
+
+Compare_T Compare_new(size_t uCapacity)
+{
+   (void)uCapacity;
+   return (Compare_T)calloc(1, sizeof(struct Compare));
+}
+
+void Compare_free(Compare_T oCompare)
+{
+   assert(oCompare != NULL);
+   tdestroy(oCompare->pvRoot, free);
+   free(oCompare);
+}
+
+int Compare_put(Compare_T oCompare, const char *pcKey,
+   const void *pvValue)
+{
+   struct Binding *psBinding;
+   void *pvNode;
+   size_t uLength;
+
+   assert(oCompare != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey) + 1;
+   psBinding = (struct Binding*)malloc(offsetof(struct Binding, acKey) +
+      uLength);
+   if (psBinding == NULL)
+      return 0;
+   psBinding->pvValue = pvValue;
+   memcpy(psBinding->acKey, pcKey, uLength);
+
+   pvNode = tsearch(psBinding, &oCompare->pvRoot, Compare_compareBindings);
+   if (pvNode == NULL || *(struct Binding**)pvNode != psBinding)
+   {
+      free(psBinding);
+      return 0;
+   }
+   return 1;
+}
+
+void *Compare_get(Compare_T oCompare, const char *pcKey)
+{
+   void *pvNode;
+
+   assert(oCompare != NULL);
+   assert(pcKey != NULL);
+
+   pvNode = tfind(pcKey, &oCompare->pvRoot, Compare_compareKey);
+   if (pvNode == NULL)
+      return NULL;
+   return (void*)(*(struct Binding**)pvNode)->pvValue;
+}
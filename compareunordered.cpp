@@ -0,0 +1,50 @@
+/*--------------------------------------------------------------------*/
+/* compareunordered.cpp                                               */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* The compare.h subject for std::unordered_map<std::string, void*>,
+   with the default hash and load factor. */
+
+#include <new>
+#include <string>
+#include <unordered_map>
+
+extern "C" {
+#include "compare.h"
+}
+
+extern "C" const char Compare_name[] = "unordered_map";
+
+struct Compare {
+   std::unordered_map<std::string, void*> oMap;
+};
+
+extern "C" Compare_T Compare_new(std::size_t uCapacity)
+{
+   (void)uCapacity;
+   return new (std::nothrow) Compare();
+}
+
+extern "C" void Compare_free(Compare_T oCompare)
+{
+   delete oCompare;
+}
+
+extern "C" int Compare_put(Compare_T oCompare, const char *pcKey,
+   const void *pvValue)
+{
+   try {
+      return oCompare->oMap.try_emplace(pcKey,
+         const_cast<void*>(pvValue)).second;
+   } catch (const std::bad_alloc &) {
+      return 0;
+   }
+}
+
+extern "C" void *Compare_get(Compare_T oCompare, const char *pcKey)
+{
+   /* the lookup builds a std::string, as a C++17 client must */
+   auto oFound = oCompare->oMap.find(pcKey);
+   return oFound == oCompare->oMap.end() ? nullptr : oFound->second;
+}
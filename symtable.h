@@ -18,9 +18,22 @@ typedef struct SymTable *SymTable_T;
 
  SymTable_T SymTable_new(void);
 
+/*--------------------------------------------------------------------*/
+
+/* return a new SymTable object that contains no bindings and owns
+   their values, or NULL if insufficient memory is available. The
+   object calls *pfFreeValue on a value when SymTable_free,
+   SymTable_clear or SymTable_delete discards its binding, in the same
+   pass that frees the binding. SymTable_remove and SymTable_replace
+   still hand the value they take out back to the caller. Clones do
+   not own the values they share, so they have no destructor. */
+
+  SymTable_T SymTable_newWithDestructor(void (*pfFreeValue)(void *pvValue));
+
  /*--------------------------------------------------------------------*/
 
- /* free all memory occupied by oSymTable.*/
+ /* free all memory occupied by oSymTable, and its values if it has a
+ destructor.*/
 
   void SymTable_free(SymTable_T oSymTable);
 
@@ -64,11 +77,94 @@ Otherwise it must leave oSymTable unchanged and return NULL.*/
 
 /*--------------------------------------------------------------------*/
 
+/* If oSymTable contains a binding with key pcKey, remove that binding,
+   call the destructor of oSymTable on its value if oSymTable has one,
+   and return 1 (TRUE). Otherwise leave oSymTable unchanged and return
+   0 (FALSE). */
+  int SymTable_delete(SymTable_T oSymTable, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+
 /* apply function *pfApply to each binding in oSymTable, passing pvExtra as an extra parameter. */
   void SymTable_map(SymTable_T oSymTable,
      void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
      const void *pvExtra);
 /*--------------------------------------------------------------------*/
 
+/* remove every binding from oSymTable, first calling *pfFreeValue on
+   each binding's value, or the destructor of oSymTable if pfFreeValue
+   is NULL and oSymTable has one. oSymTable keeps whatever memory the
+   implementation can reuse, so refilling a cleared table costs less
+   than freeing it and creating a new one. */
+  void SymTable_clear(SymTable_T oSymTable,
+     void (*pfFreeValue)(void *pvValue));
+/*--------------------------------------------------------------------*/
+
+/* return a new SymTable object with the bindings of oSymTable, or
+   NULL if insufficient memory is available. The two objects change
+   independently afterwards but share the values. The list, hash
+   table and array implementations copy every binding; the trie
+   implementation (symtablehamt.c) shares its nodes and copies only
+   those a later change touches. */
+  SymTable_T SymTable_clone(SymTable_T oSymTable);
+/*--------------------------------------------------------------------*/
+
+/* behave as SymTable_put, SymTable_replace, SymTable_contains,
+   SymTable_get and SymTable_remove, with the key made of the uLength
+   characters at pcKey instead of a string. The characters need not be
+   followed by '\0', so a key can be a slice of a larger buffer, but
+   must not contain '\0'. A key stored by SymTable_putN is the same as
+   the string of its characters to the other functions. */
+  int SymTable_putN(SymTable_T oSymTable, const char *pcKey,
+     size_t uLength, const void *pvValue);
+  void *SymTable_replaceN(SymTable_T oSymTable, const char *pcKey,
+     size_t uLength, const void *pvValue);
+  int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+     size_t uLength);
+  void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+     size_t uLength);
+  void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+     size_t uLength);
+/*--------------------------------------------------------------------*/
+
+/* A SymTableStats holds the hot-path counters of a SymTable object.
+   The counters are maintained only when the implementation is compiled
+   with SYMTABLE_STATS defined; otherwise every field reads as 0. */
+
+struct SymTableStats {
+   /* calls to SymTable_put, SymTable_get, SymTable_remove,
+      SymTable_contains and SymTable_replace */
+   size_t uPuts;
+   size_t uGets;
+   size_t uRemoves;
+   size_t uContains;
+   size_t uReplaces;
+
+   /* lookups that found, or did not find, their key */
+   size_t uHits;
+   size_t uMisses;
+
+   /* nodes visited while searching for a key */
+   size_t uProbes;
+
+   /* full key comparisons (strcmp calls) */
+   size_t uKeyCompares;
+
+   /* malloc and free calls made on behalf of bindings */
+   size_t uAllocs;
+   size_t uFrees;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* copy the counters of oSymTable into *psStats. */
+  void SymTable_getStats(SymTable_T oSymTable,
+     struct SymTableStats *psStats);
+/*--------------------------------------------------------------------*/
+
+/* reset every counter of oSymTable to 0. */
+  void SymTable_resetStats(SymTable_T oSymTable);
+/*--------------------------------------------------------------------*/
+
 #endif
 
@@ -0,0 +1,182 @@
+/*--------------------------------------------------------------------*/
+/* symtable.hpp                                                       */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* A C++17 wrapper around SymTable_T. A symtable::Table<T> owns one
+   SymTable object, which it frees when it is destroyed; it can be
+   moved, and copying it clones the table (SymTable_clone). Keys are
+   std::string_view: lookups pass the view's characters and length to
+   the SymTable_...N functions, so no std::string is built and no '\0'
+   is needed after the key; an empty view, even a default one with no
+   characters, is the empty key. Values are T*, and the table does
+   not own them. The wrapper works with any implementation; link it
+   with one of symtablelist.o, symtablehash.o, symtablehamt.o or
+   symtablearray.o. */
+
+#ifndef SYMTABLE_HPP_INCLUDED
+#define SYMTABLE_HPP_INCLUDED
+
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include "symtable.h"
+}
+
+namespace symtable {
+
+template <typename T>
+class Table {
+public:
+   /* a binding, as the iteration over a table yields it: the key is
+      the table's own copy, valid while the binding is */
+   struct Binding {
+      std::string_view key;
+      T *value;
+   };
+
+   /* a table with no bindings; throws std::bad_alloc if insufficient
+      memory is available */
+   Table() : oSymTable(SymTable_new()) {
+      if (oSymTable == nullptr)
+         throw std::bad_alloc();
+   }
+
+   /* a table with the bindings of oOther, sharing its values */
+   Table(const Table &oOther)
+      : oSymTable(SymTable_clone(oOther.oSymTable)) {
+      if (oSymTable == nullptr)
+         throw std::bad_alloc();
+   }
+
+   /* takes the table of oOther, which is left empty and can only be
+      assigned to or destroyed */
+   Table(Table &&oOther) noexcept
+      : oSymTable(std::exchange(oOther.oSymTable, nullptr)) {}
+
+   Table &operator=(Table oOther) noexcept {
+      std::swap(oSymTable, oOther.oSymTable);
+      return *this;
+   }
+
+   ~Table() {
+      if (oSymTable != nullptr)
+         SymTable_free(oSymTable);
+   }
+
+   std::size_t size() const { return SymTable_getLength(oSymTable); }
+   bool empty() const { return size() == 0; }
+
+   /* return the value bound to key, or nullptr if there is none */
+   T *find(std::string_view key) const {
+      return static_cast<T*>(SymTable_getN(oSymTable, charsOf(key),
+         key.size()));
+   }
+
+   bool contains(std::string_view key) const {
+      return SymTable_containsN(oSymTable, charsOf(key), key.size()) != 0;
+   }
+
+   /* bind key to pValue unless key is bound already. return the value
+      bound to key afterwards, and whether the binding is new. Throws
+      std::bad_alloc if insufficient memory is available. */
+   std::pair<T*, bool> try_emplace(std::string_view key, T *pValue) {
+      if (SymTable_putN(oSymTable, charsOf(key), key.size(), pValue))
+         return {pValue, true};
+      /* the put failed either because the key is bound or for lack of
+         memory, and only a bound key can be found */
+      if (! contains(key))
+         throw std::bad_alloc();
+      return {find(key), false};
+   }
+
+   /* bind key to pValue if key is bound, and return the value it was
+      bound to, or nullptr if key is not bound */
+   T *replace(std::string_view key, T *pValue) {
+      return static_cast<T*>(SymTable_replaceN(oSymTable, charsOf(key),
+         key.size(), pValue));
+   }
+
+   /* remove the binding of key, and return its value, or nullptr if
+      key is not bound */
+   T *remove(std::string_view key) {
+      return static_cast<T*>(SymTable_removeN(oSymTable, charsOf(key),
+         key.size()));
+   }
+
+   void clear() { SymTable_clear(oSymTable, nullptr); }
+
+   /* call fApply(key, value) for each binding, without allocating.
+      If fApply throws, it is not called again, and the exception is
+      rethrown once SymTable_map has returned, since it must not
+      propagate through the C code. */
+   template <typename F>
+   void forEach(F &&fApply) const {
+      Apply<std::remove_reference_t<F>> sApply{&fApply, nullptr};
+      SymTable_map(oSymTable, applyTo<std::remove_reference_t<F>>,
+         &sApply);
+      if (sApply.oException != nullptr)
+         std::rethrow_exception(sApply.oException);
+   }
+
+   /* return the bindings, in the order SymTable_map visits them. The
+      vector is built when called, so iterating costs one pass over
+      the table and one allocation. */
+   std::vector<Binding> bindings() const {
+      std::vector<Binding> oBindings;
+      oBindings.reserve(size());
+      forEach([&oBindings](std::string_view key, T *pValue) {
+         oBindings.push_back(Binding{key, pValue});
+      });
+      return oBindings;
+   }
+
+   /* the wrapped table, for the functions of symtable.h that the
+      wrapper does not cover */
+   SymTable_T get() const { return oSymTable; }
+
+private:
+   /* the characters of key for the SymTable_...N functions, which
+      need them even when there are none: the data of a default view
+      is nullptr */
+   static const char *charsOf(std::string_view key) {
+      return key.data() != nullptr ? key.data() : "";
+   }
+
+   /* the state of one forEach: the callable, and the exception it
+      threw, if any */
+   template <typename F>
+   struct Apply {
+      F *pfApply;
+      std::exception_ptr oException;
+   };
+
+   /* the function SymTable_map calls for forEach: pass the binding to
+      the callable of the Apply at pvExtra, unless it has thrown, and
+      keep what it throws */
+   template <typename F>
+   static void applyTo(const char *pcKey, void *pvValue, void *pvExtra) {
+      Apply<F> *psApply = static_cast<Apply<F>*>(pvExtra);
+      if (psApply->oException != nullptr)
+         return;
+      try {
+         (*psApply->pfApply)(std::string_view(pcKey),
+            static_cast<T*>(pvValue));
+      }
+      catch (...) {
+         psApply->oException = std::current_exception();
+      }
+   }
+
+   SymTable_T oSymTable;
+};
+
+}
+
+#endif
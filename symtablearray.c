@@ -0,0 +1,612 @@
+/*--------------------------------------------------------------------*/
+/* symtablearray.c                                                    */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+#define _DEFAULT_SOURCE
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtablesip.h"
+#include "symtablestats.h"
+
+/* A table for the many small tables a client makes: the bindings are
+   kept in one contiguous array. While a table has at most
+   ARRAY_SMALL_LIMIT bindings, the array is sorted by the keyed hash
+   code of the keys and searched by bisection, so a table needs no
+   bucket array and a lookup reads a few adjacent cache lines. A table
+   that grows past ARRAY_SMALL_LIMIT promotes itself to a hash table:
+   it builds an index, an open addressing table with linear probing
+   that holds the position of each binding in the array, and stops
+   keeping the array sorted. A table that shrinks below
+   ARRAY_DEMOTE_LIMIT sorts the array again and frees the index. */
+
+/* the largest table kept sorted, and the length at which a promoted
+   table returns to being sorted; the gap keeps a table that grows and
+   shrinks around the limit from rebuilding its index each time */
+enum {ARRAY_SMALL_LIMIT = 32, ARRAY_DEMOTE_LIMIT = ARRAY_SMALL_LIMIT / 2};
+
+/* the number of bindings the array first has room for */
+enum {ARRAY_INITIAL_CAPACITY = 4};
+
+/* binding structure which holds one binding of the array*/
+struct binding {
+    /* the full hash code of the key, and its length*/
+    uint64_t hash;
+    size_t keyLength;
+    /* pointer to the client's value*/
+    const void *value;
+    /* the defensive copy of the key, keyLength + 1 characters*/
+    char *key;
+};
+
+/* SymTable structure that contains the array of bindings and, once
+the table is promoted, its index*/
+struct SymTable {
+    /* room for capacity bindings, of which the first length are used*/
+    struct binding *bindings;
+    size_t length;
+    size_t capacity;
+
+    /* the index of a promoted table, or NULL while the table is
+       sorted: indexMask + 1 slots, each 0 for an empty slot or 1 plus
+       the position of a binding*/
+    size_t *index;
+    size_t indexMask;
+
+    /* the key of the keyed hash function, shared with clones*/
+    uint64_t seed[2];
+
+    /* the function that frees a value the table discards, or NULL*/
+    void (*freeValue)(void *pvValue);
+
+#ifdef SYMTABLE_STATS
+    /* hot-path counters, see SymTable_getStats */
+    struct SymTableStats sStats;
+#endif
+};
+
+/* lookup structure which describes one key being searched for, so
+that its hash code and length are computed once per operation*/
+struct lookup {
+    const char *pcKey;
+    size_t uLength;
+    uint64_t uHash;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Fill *psLookup with the key made of the uLength characters at pcKey
+   and its hash code under the key of oSymTable. */
+
+static void SymTable_initLookup(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, struct lookup *psLookup) {
+    psLookup->pcKey = pcKey;
+    psLookup->uLength = uLength;
+    psLookup->uHash = SymTable_sipHash(oSymTable->seed, pcKey, uLength);
+}
+
+/* Return 1 (TRUE) if psBinding holds the key of psLookup, and 0
+   (FALSE) otherwise. The hash code and the length are compared before
+   any characters. */
+
+static int SymTable_matches(SymTable_T oSymTable,
+   const struct binding *psBinding, const struct lookup *psLookup) {
+    SYMTABLE_COUNT(oSymTable, uProbes);
+    if (psBinding->hash != psLookup->uHash ||
+            psBinding->keyLength != psLookup->uLength)
+        return 0;
+    SYMTABLE_COUNT(oSymTable, uKeyCompares);
+    return memcmp(psBinding->key, psLookup->pcKey, psLookup->uLength) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the position of the first binding of the sorted table
+   oSymTable whose hash code is not less than uHash. The bisection
+   halves the range without a branch on the comparison, which a
+   lookup of an unpredictable key would mispredict half of the time. */
+
+static size_t SymTable_lowerBound(SymTable_T oSymTable, uint64_t uHash) {
+    const struct binding *psBindings = oSymTable->bindings;
+    size_t uBase = 0;
+    size_t uCount = oSymTable->length;
+    size_t uHalf;
+    if (uCount == 0)
+        return 0;
+    while (uCount > 1) {
+        uHalf = uCount / 2;
+        uBase = psBindings[uBase + uHalf].hash < uHash ? uBase + uHalf :
+            uBase;
+        uCount -= uHalf;
+    }
+    return uBase + (psBindings[uBase].hash < uHash);
+}
+
+/* Return the slot of the index of oSymTable that holds the binding
+   with the key of psLookup, or the empty slot at which the search for
+   it ended. */
+
+static size_t SymTable_findSlot(SymTable_T oSymTable,
+   const struct lookup *psLookup) {
+    size_t uSlot = (size_t)psLookup->uHash & oSymTable->indexMask;
+    size_t uEntry;
+    while ((uEntry = oSymTable->index[uSlot]) != 0) {
+        if (SymTable_matches(oSymTable,
+                &oSymTable->bindings[uEntry - 1], psLookup))
+            break;
+        uSlot = (uSlot + 1) & oSymTable->indexMask;
+    }
+    return uSlot;
+}
+
+/* Return the position of the binding of oSymTable with the key of
+   psLookup, or oSymTable->length if there is none. */
+
+static size_t SymTable_find(SymTable_T oSymTable,
+   const struct lookup *psLookup) {
+    size_t uPosition;
+    if (oSymTable->index != NULL) {
+        uPosition = oSymTable->index[SymTable_findSlot(oSymTable,
+            psLookup)];
+        uPosition = uPosition == 0 ? oSymTable->length : uPosition - 1;
+    }
+    else {
+        /* bindings whose hash codes are equal are adjacent*/
+        uPosition = SymTable_lowerBound(oSymTable, psLookup->uHash);
+        while (uPosition < oSymTable->length &&
+                oSymTable->bindings[uPosition].hash == psLookup->uHash &&
+                ! SymTable_matches(oSymTable,
+                    &oSymTable->bindings[uPosition], psLookup))
+            uPosition++;
+        if (uPosition < oSymTable->length &&
+                oSymTable->bindings[uPosition].hash != psLookup->uHash)
+            uPosition = oSymTable->length;
+    }
+    if (uPosition == oSymTable->length)
+        SYMTABLE_COUNT(oSymTable, uMisses);
+    else
+        SYMTABLE_COUNT(oSymTable, uHits);
+    return uPosition;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store 1 plus uPosition in the first empty slot of the probe
+   sequence of uHash in the index puIndex, whose mask is uMask. */
+
+static void SymTable_placeEntry(size_t *puIndex, size_t uMask,
+   uint64_t uHash, size_t uPosition) {
+    size_t uSlot = (size_t)uHash & uMask;
+    while (puIndex[uSlot] != 0)
+        uSlot = (uSlot + 1) & uMask;
+    puIndex[uSlot] = uPosition + 1;
+}
+
+/* Replace the index of oSymTable with one that has room for uCount
+   bindings at a load factor of at most one half. Return 1 (TRUE) on
+   success, or 0 (FALSE), leaving oSymTable unchanged, if insufficient
+   memory is available. */
+
+static int SymTable_buildIndex(SymTable_T oSymTable, size_t uCount) {
+    size_t *puIndex;
+    size_t uSlots = 2 * ARRAY_SMALL_LIMIT;
+    size_t u;
+    while (uSlots < 2 * uCount)
+        uSlots *= 2;
+    puIndex = (size_t*) calloc(uSlots, sizeof(size_t));
+    if (puIndex == NULL)
+        return 0;
+    for (u = 0; u < oSymTable->length; u++)
+        SymTable_placeEntry(puIndex, uSlots - 1,
+            oSymTable->bindings[u].hash, u);
+    free(oSymTable->index);
+    oSymTable->index = puIndex;
+    oSymTable->indexMask = uSlots - 1;
+    return 1;
+}
+
+/* Empty slot uSlot of the index of oSymTable, moving the entries after
+   it back so that every probe sequence stays unbroken (backward shift
+   deletion). */
+
+static void SymTable_emptySlot(SymTable_T oSymTable, size_t uSlot) {
+    size_t uMask = oSymTable->indexMask;
+    size_t uNext = uSlot;
+    size_t uHome;
+    for (;;) {
+        uNext = (uNext + 1) & uMask;
+        if (oSymTable->index[uNext] == 0)
+            break;
+        uHome = (size_t)oSymTable->bindings[oSymTable->index[uNext] - 1]
+            .hash & uMask;
+        /* the entry may move back only if its home slot does not lie
+           between the hole and the entry*/
+        if (((uNext - uHome) & uMask) >= ((uNext - uSlot) & uMask)) {
+            oSymTable->index[uSlot] = oSymTable->index[uNext];
+            uSlot = uNext;
+        }
+    }
+    oSymTable->index[uSlot] = 0;
+}
+
+/* Return the slot of the index of oSymTable that holds uPosition. */
+
+static size_t SymTable_slotOf(SymTable_T oSymTable, size_t uPosition) {
+    size_t uSlot = (size_t)oSymTable->bindings[uPosition].hash &
+        oSymTable->indexMask;
+    while (oSymTable->index[uSlot] != uPosition + 1)
+        uSlot = (uSlot + 1) & oSymTable->indexMask;
+    return uSlot;
+}
+
+/* Compare the bindings pvFirst and pvSecond by hash code, for qsort. */
+
+static int SymTable_compareBindings(const void *pvFirst,
+   const void *pvSecond) {
+    uint64_t uFirst = ((const struct binding*)pvFirst)->hash;
+    uint64_t uSecond = ((const struct binding*)pvSecond)->hash;
+    return (uFirst > uSecond) - (uFirst < uSecond);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make room in oSymTable for one more binding. Return 1 (TRUE) on
+   success, or 0 (FALSE), leaving oSymTable unchanged, if insufficient
+   memory is available. */
+
+static int SymTable_reserve(SymTable_T oSymTable) {
+    struct binding *psBindings;
+    size_t uCapacity;
+    if (oSymTable->length < oSymTable->capacity)
+        return 1;
+    uCapacity = oSymTable->capacity == 0 ? ARRAY_INITIAL_CAPACITY :
+        2 * oSymTable->capacity;
+    psBindings = (struct binding*) realloc(oSymTable->bindings,
+        uCapacity * sizeof(struct binding));
+    if (psBindings == NULL)
+        return 0;
+    oSymTable->bindings = psBindings;
+    oSymTable->capacity = uCapacity;
+    return 1;
+}
+
+/* Free the keys of every binding of oSymTable, calling *pfFreeValue on
+   each value if pfFreeValue is not NULL, and leave the table sorted
+   and empty. */
+
+static void SymTable_freeBindings(SymTable_T oSymTable,
+   void (*pfFreeValue)(void *pvValue)) {
+    size_t u;
+    for (u = 0; u < oSymTable->length; u++) {
+        if (pfFreeValue != NULL)
+            (*pfFreeValue)((void*) oSymTable->bindings[u].value);
+        free(oSymTable->bindings[u].key);
+        SYMTABLE_COUNT(oSymTable, uFrees);
+    }
+    oSymTable->length = 0;
+    free(oSymTable->index);
+    oSymTable->index = NULL;
+    oSymTable->indexMask = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void) {
+    SymTable_T oSymTable;
+
+    /* the array is allocated by the first put, so an empty table is
+       only this structure*/
+    oSymTable = (SymTable_T) malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+    oSymTable->bindings = NULL;
+    oSymTable->length = 0;
+    oSymTable->capacity = 0;
+    oSymTable->index = NULL;
+    oSymTable->indexMask = 0;
+    SymTable_randomSeed(oSymTable->seed);
+    oSymTable->freeValue = NULL;
+#ifdef SYMTABLE_STATS
+    memset(&oSymTable->sStats, 0, sizeof(oSymTable->sStats));
+#endif
+    return oSymTable;
+}
+
+SymTable_T SymTable_newWithDestructor(void (*pfFreeValue)(void *pvValue)) {
+    SymTable_T oSymTable;
+    assert(pfFreeValue != NULL);
+    oSymTable = SymTable_new();
+    if (oSymTable != NULL)
+        oSymTable->freeValue = pfFreeValue;
+    return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    SymTable_freeBindings(oSymTable, oSymTable->freeValue);
+    free(oSymTable->bindings);
+    free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->length;
+}
+
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+   const void *pvValue) {
+    struct lookup sLookup;
+    struct binding *psBinding;
+    size_t uPosition;
+    char *pcCopy;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+    SYMTABLE_COUNT(oSymTable, uPuts);
+    if (SymTable_find(oSymTable, &sLookup) != oSymTable->length)
+        return 0;
+
+    /* every allocation comes first, so a failure changes nothing*/
+    if (! SymTable_reserve(oSymTable))
+        return 0;
+    if (oSymTable->index != NULL ?
+            2 * (oSymTable->length + 1) > oSymTable->indexMask + 1 :
+            oSymTable->length == ARRAY_SMALL_LIMIT)
+        if (! SymTable_buildIndex(oSymTable, oSymTable->length + 1))
+            return 0;
+    pcCopy = (char*) malloc(uLength + 1);
+    if (pcCopy == NULL)
+        return 0;
+    SYMTABLE_COUNT(oSymTable, uAllocs);
+    memcpy(pcCopy, pcKey, uLength);
+    pcCopy[uLength] = '\0';
+
+    if (oSymTable->index != NULL) {
+        uPosition = oSymTable->length;
+        SymTable_placeEntry(oSymTable->index, oSymTable->indexMask,
+            sLookup.uHash, uPosition);
+    }
+    else {
+        uPosition = SymTable_lowerBound(oSymTable, sLookup.uHash);
+        memmove(&oSymTable->bindings[uPosition + 1],
+            &oSymTable->bindings[uPosition],
+            (oSymTable->length - uPosition) * sizeof(struct binding));
+    }
+    psBinding = &oSymTable->bindings[uPosition];
+    psBinding->hash = sLookup.uHash;
+    psBinding->keyLength = uLength;
+    psBinding->value = pvValue;
+    psBinding->key = pcCopy;
+    oSymTable->length++;
+    return 1;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    assert(pcKey != NULL);
+    return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+void *SymTable_replaceN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, const void *pvValue) {
+    struct lookup sLookup;
+    size_t uPosition;
+    const void *oldValue;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+    SYMTABLE_COUNT(oSymTable, uReplaces);
+    uPosition = SymTable_find(oSymTable, &sLookup);
+    if (uPosition == oSymTable->length)
+        return NULL;
+    oldValue = oSymTable->bindings[uPosition].value;
+    oSymTable->bindings[uPosition].value = pvValue;
+    return (void*) oldValue;
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    assert(pcKey != NULL);
+    return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength) {
+    struct lookup sLookup;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+    SYMTABLE_COUNT(oSymTable, uContains);
+    return SymTable_find(oSymTable, &sLookup) != oSymTable->length;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    assert(pcKey != NULL);
+    return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength) {
+    struct lookup sLookup;
+    size_t uPosition;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+    SYMTABLE_COUNT(oSymTable, uGets);
+    uPosition = SymTable_find(oSymTable, &sLookup);
+    if (uPosition == oSymTable->length)
+        return NULL;
+    return (void*) oSymTable->bindings[uPosition].value;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    assert(pcKey != NULL);
+    return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/* Remove the binding of oSymTable whose key is the uLength characters
+   at pcKey, store its value in *ppvValue and return 1 (TRUE). Return 0
+   (FALSE) if there is no such binding. */
+
+static int SymTable_unbind(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, const void **ppvValue) {
+    struct lookup sLookup;
+    size_t uPosition;
+    size_t uLast;
+    SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+    SYMTABLE_COUNT(oSymTable, uRemoves);
+
+    uPosition = SymTable_find(oSymTable, &sLookup);
+    if (uPosition == oSymTable->length)
+        return 0;
+    *ppvValue = oSymTable->bindings[uPosition].value;
+    free(oSymTable->bindings[uPosition].key);
+    SYMTABLE_COUNT(oSymTable, uFrees);
+    uLast = oSymTable->length - 1;
+
+    if (oSymTable->index != NULL) {
+        /* the last binding fills the hole, and its entry follows it*/
+        SymTable_emptySlot(oSymTable, SymTable_slotOf(oSymTable,
+            uPosition));
+        if (uPosition != uLast) {
+            oSymTable->index[SymTable_slotOf(oSymTable, uLast)] =
+                uPosition + 1;
+            oSymTable->bindings[uPosition] = oSymTable->bindings[uLast];
+        }
+        oSymTable->length--;
+        if (oSymTable->length < ARRAY_DEMOTE_LIMIT) {
+            qsort(oSymTable->bindings, oSymTable->length,
+                sizeof(struct binding), SymTable_compareBindings);
+            free(oSymTable->index);
+            oSymTable->index = NULL;
+            oSymTable->indexMask = 0;
+        }
+    }
+    else {
+        memmove(&oSymTable->bindings[uPosition],
+            &oSymTable->bindings[uPosition + 1],
+            (uLast - uPosition) * sizeof(struct binding));
+        oSymTable->length--;
+    }
+    return 1;
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength) {
+    const void *oldValue;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    if (! SymTable_unbind(oSymTable, pcKey, uLength, &oldValue))
+        return NULL;
+    return (void*) oldValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    assert(pcKey != NULL);
+    return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_delete(SymTable_T oSymTable, const char *pcKey) {
+    const void *oldValue;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    if (! SymTable_unbind(oSymTable, pcKey, strlen(pcKey), &oldValue))
+        return 0;
+    if (oSymTable->freeValue != NULL)
+        (*oSymTable->freeValue)((void*) oldValue);
+    return 1;
+}
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    size_t u;
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+    for (u = 0; u < oSymTable->length; u++)
+        (*pfApply)(oSymTable->bindings[u].key,
+            (void*) oSymTable->bindings[u].value, (void*) pvExtra);
+}
+
+void SymTable_clear(SymTable_T oSymTable,
+   void (*pfFreeValue)(void *pvValue)) {
+    assert(oSymTable != NULL);
+    if (pfFreeValue == NULL)
+        pfFreeValue = oSymTable->freeValue;
+
+    /* keeps the array for the bindings that will refill the table*/
+    SymTable_freeBindings(oSymTable, pfFreeValue);
+}
+
+SymTable_T SymTable_clone(SymTable_T oSymTable) {
+    SymTable_T oClone;
+    size_t uLength;
+    size_t u;
+    assert(oSymTable != NULL);
+
+    oClone = SymTable_new();
+    if (oClone == NULL)
+        return NULL;
+    oClone->seed[0] = oSymTable->seed[0];
+    oClone->seed[1] = oSymTable->seed[1];
+    if (oSymTable->length == 0)
+        return oClone;
+
+    oClone->bindings = (struct binding*) malloc(oSymTable->length *
+        sizeof(struct binding));
+    if (oClone->bindings == NULL) {
+        SymTable_free(oClone);
+        return NULL;
+    }
+    oClone->capacity = oSymTable->length;
+    if (oSymTable->index != NULL) {
+        oClone->index = (size_t*) malloc((oSymTable->indexMask + 1) *
+            sizeof(size_t));
+        if (oClone->index == NULL) {
+            SymTable_free(oClone);
+            return NULL;
+        }
+        memcpy(oClone->index, oSymTable->index,
+            (oSymTable->indexMask + 1) * sizeof(size_t));
+        oClone->indexMask = oSymTable->indexMask;
+    }
+    for (u = 0; u < oSymTable->length; u++) {
+        uLength = oSymTable->bindings[u].keyLength;
+        oClone->bindings[u] = oSymTable->bindings[u];
+        oClone->bindings[u].key = (char*) malloc(uLength + 1);
+        if (oClone->bindings[u].key == NULL) {
+            /* the clone owns only the keys copied so far*/
+            oClone->length = u;
+            SymTable_free(oClone);
+            return NULL;
+        }
+        SYMTABLE_COUNT(oClone, uAllocs);
+        memcpy(oClone->bindings[u].key, oSymTable->bindings[u].key,
+            uLength + 1);
+    }
+    oClone->length = oSymTable->length;
+    return oClone;
+}
+
+void SymTable_getStats(SymTable_T oSymTable,
+   struct SymTableStats *psStats) {
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+#ifdef SYMTABLE_STATS
+    *psStats = oSymTable->sStats;
+#else
+    (void)oSymTable;
+    memset(psStats, 0, sizeof(*psStats));
+#endif
+}
+
+void SymTable_resetStats(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+#ifdef SYMTABLE_STATS
+    memset(&oSymTable->sStats, 0, sizeof(oSymTable->sStats));
+#else
+    (void)oSymTable;
+#endif
+}
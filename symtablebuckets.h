@@ -0,0 +1,34 @@
+/*--------------------------------------------------------------------*/
+/* symtablebuckets.h                                                  */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* Private sizing policy shared by the chained hash tables: the hash
+   table implementation (symtablehash.c) and the typed tables that
+   symtablegen.h generates. */
+
+#ifndef SYMTABLEBUCKETS_INCLUDED
+#define SYMTABLEBUCKETS_INCLUDED
+
+#include <stddef.h>
+
+/* the bucket counts a table moves through as it grows and shrinks:
+   primes just below successive powers of 2, starting from the 509
+   buckets of a new table */
+static const size_t auBucketCounts[] = {
+   509, 1021, 2039, 4093, 8191, 16381, 32749, 65521, 131071, 262139,
+   524287, 1048573, 2097143, 4194301, 8388593, 16777213, 33554393,
+   67108859, 134217689, 268435399, 536870909, 1073741789
+};
+
+/* the number of entries of auBucketCounts */
+enum {BUCKET_COUNT_STEPS =
+   sizeof(auBucketCounts) / sizeof(auBucketCounts[0])};
+
+/* a table shrinks when fewer than 1 in SHRINK_DIVISOR buckets would
+   hold a binding on average. Growth happens at 1 binding per bucket
+   and a shrink halves the bucket count, so a table that has just
+   grown or shrunk is a factor of 4 away from the opposite move. */
+enum {SHRINK_DIVISOR = 8};
+
+#endif
@@ -0,0 +1,332 @@
+/*--------------------------------------------------------------------*/
+/* symtablegen.h                                                      */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* Generate a hash table specialized for one key type and one value
+   type. The SymTable_T interface takes string keys and pointer values,
+   so a client with integer keys has to format each key into a string,
+   and a client with small values has to allocate each one. A
+   generated table stores keys and values in its nodes as they are,
+   and hashes and compares keys with functions of the client's
+   choosing. It uses the bucket counts, growth and shrinking of the
+   hash table implementation (symtablebuckets.h).
+
+   Define the parameters below and include this header, once per
+   table type:
+
+      #define SYMTABLE_GEN_NAME IntTable
+      #define SYMTABLE_GEN_KEY long
+      #define SYMTABLE_GEN_VALUE double
+      #define SYMTABLE_GEN_HASH(key) SymTableGen_hashInteger(key)
+      #include "symtablegen.h"
+
+   SYMTABLE_GEN_NAME   prefix of the generated type and functions
+   SYMTABLE_GEN_KEY    key type, copied by assignment
+   SYMTABLE_GEN_VALUE  value type, copied by assignment
+   SYMTABLE_GEN_HASH   hash(key): a size_t hash code of key, of which
+                       keys that are equal must have the same
+   SYMTABLE_GEN_EQUAL  equal(key1, key2): nonzero if the keys are
+                       equal; optional, (key1) == (key2) by default
+
+   This generates, for SYMTABLE_GEN_NAME IntTable, the type IntTable_T
+   and these functions, which behave as their SymTable_ counterparts
+   except where noted:
+
+      IntTable_T IntTable_new(void);
+      void IntTable_free(IntTable_T oTable);
+      size_t IntTable_getLength(IntTable_T oTable);
+      int IntTable_put(IntTable_T oTable, long key, double value);
+      double *IntTable_get(IntTable_T oTable, long key);
+      int IntTable_contains(IntTable_T oTable, long key);
+      int IntTable_remove(IntTable_T oTable, long key, double *pValue);
+      void IntTable_map(IntTable_T oTable,
+         void (*pfApply)(long key, double *pValue, void *pvExtra),
+         const void *pvExtra);
+      void IntTable_clear(IntTable_T oTable);
+
+   IntTable_get returns the address of the value inside the table, or
+   NULL if no binding has the key; the address stays valid until the
+   next IntTable_put, IntTable_remove or IntTable_clear. IntTable_remove
+   returns 1 (TRUE) and stores the value in *pValue unless pValue is
+   NULL if it removed a binding, and 0 (FALSE) otherwise.
+
+   The functions are static inline, so each translation unit that
+   includes this header gets its own copy, and the compiler can
+   specialize them to the hash and equality functions. Hash codes are
+   not keyed as the hash table's are, so a table that holds keys an
+   attacker chooses should use a hash function with a secret. */
+
+#ifndef SYMTABLEGEN_INCLUDED
+#define SYMTABLEGEN_INCLUDED
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "symtablebuckets.h"
+
+/* Return a well-mixed hash code of the integer u (the splitmix64
+   finalizer), for integer keys. */
+
+static inline size_t SymTableGen_hashInteger(uint64_t u) {
+   u = (u ^ (u >> 30)) * 0xbf58476d1ce4e5b9u;
+   u = (u ^ (u >> 27)) * 0x94d049bb133111ebu;
+   return (size_t)(u ^ (u >> 31));
+}
+
+/* Return the identifier made of prefix SYMTABLE_GEN_NAME and
+   suffix. */
+#define SYMTABLE_GEN_JOIN(prefix, suffix) prefix##suffix
+#define SYMTABLE_GEN_CAT(prefix, suffix) SYMTABLE_GEN_JOIN(prefix, suffix)
+#define SYMTABLE_GEN_ID(suffix) SYMTABLE_GEN_CAT(SYMTABLE_GEN_NAME, suffix)
+
+#endif
+
+#if ! defined(SYMTABLE_GEN_NAME) || ! defined(SYMTABLE_GEN_KEY) || \
+   ! defined(SYMTABLE_GEN_VALUE) || ! defined(SYMTABLE_GEN_HASH)
+#error "symtablegen.h needs SYMTABLE_GEN_NAME, _KEY, _VALUE and _HASH"
+#endif
+
+#ifndef SYMTABLE_GEN_EQUAL
+#define SYMTABLE_GEN_EQUAL(key1, key2) ((key1) == (key2))
+#endif
+
+/*--------------------------------------------------------------------*/
+
+typedef struct SYMTABLE_GEN_NAME *SYMTABLE_GEN_ID(_T);
+
+/* node structure which holds one binding*/
+struct SYMTABLE_GEN_ID(_node) {
+    /* the next node of the bucket*/
+    struct SYMTABLE_GEN_ID(_node) *nextNode;
+    /* the hash code of the key, compared before the keys*/
+    size_t hash;
+    SYMTABLE_GEN_KEY key;
+    SYMTABLE_GEN_VALUE value;
+};
+
+/* table structure that contains the buckets*/
+struct SYMTABLE_GEN_NAME {
+  /* the first node of each bucket, or NULL*/
+  struct SYMTABLE_GEN_ID(_node) **firstNodes;
+
+  /* the number of buckets, and its index in auBucketCounts*/
+  size_t numOfcells;
+  size_t bucketStep;
+
+  /* the number of bindings*/
+  size_t length;
+
+  /* nodes removed from the table, kept for the next puts, linked
+     through nextNode*/
+  struct SYMTABLE_GEN_ID(_node) *freeNodes;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Move every binding of oTable into auBucketCounts[uStep] new
+   buckets. Return 1 (TRUE) on success, or 0 (FALSE) if insufficient
+   memory is available, in which case oTable is unchanged. */
+
+static inline int SYMTABLE_GEN_ID(_rehash)(SYMTABLE_GEN_ID(_T) oTable,
+   size_t uStep) {
+    size_t uCount = auBucketCounts[uStep];
+    struct SYMTABLE_GEN_ID(_node) **ppsBuckets;
+    struct SYMTABLE_GEN_ID(_node) *currentNode;
+    struct SYMTABLE_GEN_ID(_node) *nextNode;
+    size_t u;
+
+    ppsBuckets = (struct SYMTABLE_GEN_ID(_node)**)
+        calloc(uCount, sizeof(*ppsBuckets));
+    if (ppsBuckets == NULL)
+        return 0;
+    for (u = 0; u < oTable->numOfcells; u++)
+        for (currentNode = oTable->firstNodes[u]; currentNode != NULL;
+                currentNode = nextNode) {
+            nextNode = currentNode->nextNode;
+            currentNode->nextNode = ppsBuckets[currentNode->hash % uCount];
+            ppsBuckets[currentNode->hash % uCount] = currentNode;
+        }
+    free(oTable->firstNodes);
+    oTable->firstNodes = ppsBuckets;
+    oTable->numOfcells = uCount;
+    oTable->bucketStep = uStep;
+    return 1;
+}
+
+/* Return the link that points to the node of oTable whose key is key
+   and whose hash code is uHash, or to the NULL that ends its bucket if
+   there is none. */
+
+static inline struct SYMTABLE_GEN_ID(_node) **SYMTABLE_GEN_ID(_find)(
+   SYMTABLE_GEN_ID(_T) oTable, SYMTABLE_GEN_KEY key, size_t uHash) {
+    struct SYMTABLE_GEN_ID(_node) **ppLink =
+        &oTable->firstNodes[uHash % oTable->numOfcells];
+    for (; *ppLink != NULL; ppLink = &(*ppLink)->nextNode)
+        if ((*ppLink)->hash == uHash &&
+                SYMTABLE_GEN_EQUAL((*ppLink)->key, key))
+            break;
+    return ppLink;
+}
+
+/*--------------------------------------------------------------------*/
+
+static inline SYMTABLE_GEN_ID(_T) SYMTABLE_GEN_ID(_new)(void) {
+    SYMTABLE_GEN_ID(_T) oTable;
+
+    oTable = (SYMTABLE_GEN_ID(_T)) malloc(sizeof(struct SYMTABLE_GEN_NAME));
+    if (oTable == NULL)
+        return NULL;
+    oTable->firstNodes = (struct SYMTABLE_GEN_ID(_node)**)
+        calloc(auBucketCounts[0], sizeof(*oTable->firstNodes));
+    if (oTable->firstNodes == NULL) {
+        free(oTable);
+        return NULL;
+    }
+    oTable->numOfcells = auBucketCounts[0];
+    oTable->bucketStep = 0;
+    oTable->length = 0;
+    oTable->freeNodes = NULL;
+    return oTable;
+}
+
+static inline void SYMTABLE_GEN_ID(_clear)(SYMTABLE_GEN_ID(_T) oTable) {
+    struct SYMTABLE_GEN_ID(_node) *currentNode;
+    struct SYMTABLE_GEN_ID(_node) *nextNode;
+    size_t u;
+    assert(oTable != NULL);
+
+    /* keeps the nodes for the puts that refill the table*/
+    for (u = 0; u < oTable->numOfcells; u++) {
+        for (currentNode = oTable->firstNodes[u]; currentNode != NULL;
+                currentNode = nextNode) {
+            nextNode = currentNode->nextNode;
+            currentNode->nextNode = oTable->freeNodes;
+            oTable->freeNodes = currentNode;
+        }
+        oTable->firstNodes[u] = NULL;
+    }
+    oTable->length = 0;
+}
+
+static inline void SYMTABLE_GEN_ID(_free)(SYMTABLE_GEN_ID(_T) oTable) {
+    struct SYMTABLE_GEN_ID(_node) *currentNode;
+    struct SYMTABLE_GEN_ID(_node) *nextNode;
+
+    if (oTable == NULL)
+        return;
+    SYMTABLE_GEN_ID(_clear)(oTable);
+    for (currentNode = oTable->freeNodes; currentNode != NULL;
+            currentNode = nextNode) {
+        nextNode = currentNode->nextNode;
+        free(currentNode);
+    }
+    free(oTable->firstNodes);
+    free(oTable);
+}
+
+static inline size_t SYMTABLE_GEN_ID(_getLength)(
+   SYMTABLE_GEN_ID(_T) oTable) {
+    assert(oTable != NULL);
+    return oTable->length;
+}
+
+static inline int SYMTABLE_GEN_ID(_put)(SYMTABLE_GEN_ID(_T) oTable,
+   SYMTABLE_GEN_KEY key, SYMTABLE_GEN_VALUE value) {
+    struct SYMTABLE_GEN_ID(_node) **ppLink;
+    struct SYMTABLE_GEN_ID(_node) *newNode;
+    size_t uHash;
+    assert(oTable != NULL);
+
+    uHash = (size_t)(SYMTABLE_GEN_HASH(key));
+    ppLink = SYMTABLE_GEN_ID(_find)(oTable, key, uHash);
+    if (*ppLink != NULL)
+        return 0;
+    newNode = oTable->freeNodes;
+    if (newNode != NULL)
+        oTable->freeNodes = newNode->nextNode;
+    else {
+        newNode = (struct SYMTABLE_GEN_ID(_node)*)
+            malloc(sizeof(struct SYMTABLE_GEN_ID(_node)));
+        if (newNode == NULL)
+            return 0;
+    }
+    newNode->hash = uHash;
+    newNode->key = key;
+    newNode->value = value;
+    /* links the node at the end of its bucket, where the search
+       stopped*/
+    newNode->nextNode = NULL;
+    *ppLink = newNode;
+    oTable->length++;
+    /* grows the table once the average bucket holds a binding; if
+       that fails the table keeps working with longer buckets*/
+    if (oTable->length > oTable->numOfcells &&
+            oTable->bucketStep + 1 < BUCKET_COUNT_STEPS)
+        (void)SYMTABLE_GEN_ID(_rehash)(oTable, oTable->bucketStep + 1);
+    return 1;
+}
+
+static inline SYMTABLE_GEN_VALUE *SYMTABLE_GEN_ID(_get)(
+   SYMTABLE_GEN_ID(_T) oTable, SYMTABLE_GEN_KEY key) {
+    struct SYMTABLE_GEN_ID(_node) *currentNode;
+    assert(oTable != NULL);
+
+    currentNode = *SYMTABLE_GEN_ID(_find)(oTable, key,
+        (size_t)(SYMTABLE_GEN_HASH(key)));
+    return currentNode == NULL ? NULL : &currentNode->value;
+}
+
+static inline int SYMTABLE_GEN_ID(_contains)(SYMTABLE_GEN_ID(_T) oTable,
+   SYMTABLE_GEN_KEY key) {
+    return SYMTABLE_GEN_ID(_get)(oTable, key) != NULL;
+}
+
+static inline int SYMTABLE_GEN_ID(_remove)(SYMTABLE_GEN_ID(_T) oTable,
+   SYMTABLE_GEN_KEY key, SYMTABLE_GEN_VALUE *pValue) {
+    struct SYMTABLE_GEN_ID(_node) **ppLink;
+    struct SYMTABLE_GEN_ID(_node) *currentNode;
+    assert(oTable != NULL);
+
+    ppLink = SYMTABLE_GEN_ID(_find)(oTable, key,
+        (size_t)(SYMTABLE_GEN_HASH(key)));
+    currentNode = *ppLink;
+    if (currentNode == NULL)
+        return 0;
+    if (pValue != NULL)
+        *pValue = currentNode->value;
+    *ppLink = currentNode->nextNode;
+    currentNode->nextNode = oTable->freeNodes;
+    oTable->freeNodes = currentNode;
+    oTable->length--;
+    /* shrinks the table once it is mostly empty buckets*/
+    if (oTable->bucketStep > 0 &&
+            oTable->length < oTable->numOfcells / SHRINK_DIVISOR)
+        (void)SYMTABLE_GEN_ID(_rehash)(oTable, oTable->bucketStep - 1);
+    return 1;
+}
+
+static inline void SYMTABLE_GEN_ID(_map)(SYMTABLE_GEN_ID(_T) oTable,
+   void (*pfApply)(SYMTABLE_GEN_KEY key, SYMTABLE_GEN_VALUE *pValue,
+      void *pvExtra),
+   const void *pvExtra) {
+    struct SYMTABLE_GEN_ID(_node) *currentNode;
+    size_t u;
+    assert(oTable != NULL);
+    assert(pfApply != NULL);
+
+    for (u = 0; u < oTable->numOfcells; u++)
+        for (currentNode = oTable->firstNodes[u]; currentNode != NULL;
+                currentNode = currentNode->nextNode)
+            (*pfApply)(currentNode->key, &currentNode->value,
+                (void*)pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+#undef SYMTABLE_GEN_NAME
+#undef SYMTABLE_GEN_KEY
+#undef SYMTABLE_GEN_VALUE
+#undef SYMTABLE_GEN_HASH
+#undef SYMTABLE_GEN_EQUAL
@@ -0,0 +1,845 @@
+/*--------------------------------------------------------------------*/
+/* symtablehamt.c                                                     */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+#define _DEFAULT_SOURCE
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtablesip.h"
+#include "symtablestats.h"
+
+/* A hash array mapped trie: each level of the trie is indexed by the
+   next HAMT_BITS bits of a key's keyed hash code, and a trie node
+   stores only the children it has, found through a bitmap and a
+   population count. Trie nodes and leaves are reference counted and
+   never changed while shared, so SymTable_clone shares the whole trie
+   and a change copies only the nodes on the path to the binding it
+   changes (path copying). A node that only one table can reach is
+   changed in place. */
+
+/* the number of hash code bits each level of the trie consumes, and
+   the number of children a trie node can have */
+enum {HAMT_BITS = 5, HAMT_WIDTH = 1 << HAMT_BITS};
+
+/* the number of bits in a hash code, and the number of trie levels
+   they index; keys whose codes agree on every bit share one chain of
+   leaves at the deepest level */
+enum {HAMT_HASH_BITS = 64,
+   HAMT_LEVELS = (HAMT_HASH_BITS + HAMT_BITS - 1) / HAMT_BITS};
+
+/* leaf structure which holds one binding. Leaves whose keys have the
+same full hash code are chained through nextLeaf, which counts as a
+reference to the next leaf.*/
+struct leaf {
+    /* the trie node slots and leaves that point to this leaf*/
+    size_t refCount;
+    /* the next leaf with the same hash code, or NULL*/
+    struct leaf *nextLeaf;
+    /* the full hash code of the key, and its length*/
+    uint64_t hash;
+    size_t keyLength;
+    /* pointer to the client's value*/
+    const void *value;
+    /* the defensive copy of the key, keyLength + 1 characters*/
+    char key[];
+};
+
+/* slot union which holds one child of a trie node*/
+union slot {
+    struct leaf *leaf;
+    struct trieNode *node;
+};
+
+/* trie node structure which holds the children of one prefix of hash
+codes. Bit b of leafMap or nodeMap is set if the child for the next
+HAMT_BITS bits b is a leaf chain or a trie node; the children are
+stored in slots in the order of their bits. A trie node other than
+the root holds at least two leaf chains, or a trie node.*/
+struct trieNode {
+    /* the tables and trie node slots that point to this node*/
+    size_t refCount;
+    uint32_t leafMap;
+    uint32_t nodeMap;
+    union slot slots[];
+};
+
+/* SymTable structure that contains the root of the trie and the
+length of the symbol table*/
+struct SymTable {
+  /* the root of the trie, or NULL if the table is empty*/
+  struct trieNode *root;
+
+  /* how many bindings inside the symbol table*/
+  size_t length;
+
+  /* the key of the keyed hash function, shared with clones*/
+  uint64_t seed[2];
+
+  /* the function that frees a value the table discards, or NULL*/
+  void (*freeValue)(void *pvValue);
+
+#ifdef SYMTABLE_STATS
+  /* hot-path counters, see SymTable_getStats */
+  struct SymTableStats sStats;
+#endif
+};
+
+/* lookup structure which describes one key being searched for, so
+that its hash code and length are computed once per operation*/
+struct lookup {
+    const char *pcKey;
+    size_t uLength;
+    uint64_t uHash;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bits set in u. */
+
+static size_t SymTable_popcount(uint32_t u) {
+#ifdef __GNUC__
+    return (size_t)__builtin_popcount(u);
+#else
+    u = u - ((u >> 1) & 0x55555555u);
+    u = (u & 0x33333333u) + ((u >> 2) & 0x33333333u);
+    return (size_t)((((u + (u >> 4)) & 0x0f0f0f0fu) * 0x01010101u) >> 24);
+#endif
+}
+
+/* Return the bit that stands for hash code uHash in a trie node at
+   level uShift / HAMT_BITS. */
+
+static uint32_t SymTable_bit(uint64_t uHash, unsigned uShift) {
+    return (uint32_t)1 << ((uHash >> uShift) & (HAMT_WIDTH - 1));
+}
+
+/* Return the index in the slots of psNode of the child for uBit. */
+
+static size_t SymTable_slotIndex(const struct trieNode *psNode,
+   uint32_t uBit) {
+    return SymTable_popcount((psNode->leafMap | psNode->nodeMap) &
+        (uBit - 1));
+}
+
+/* Return the number of children of psNode. */
+
+static size_t SymTable_slotCount(const struct trieNode *psNode) {
+    return SymTable_popcount(psNode->leafMap | psNode->nodeMap);
+}
+
+/* Return the number of bytes of a trie node with uSlots children. */
+
+static size_t SymTable_nodeSize(size_t uSlots) {
+    return offsetof(struct trieNode, slots) + uSlots * sizeof(union slot);
+}
+
+/* Return the number of bytes of a leaf whose key has uLength
+   characters. */
+
+static size_t SymTable_leafSize(size_t uLength) {
+    return offsetof(struct leaf, key) + uLength + 1;
+}
+
+/* Fill *psLookup with the key made of the uLength characters at pcKey
+   and its hash code under the key of oSymTable. */
+
+static void SymTable_initLookup(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, struct lookup *psLookup) {
+    psLookup->pcKey = pcKey;
+    psLookup->uLength = uLength;
+    psLookup->uHash = SymTable_sipHash(oSymTable->seed, pcKey,
+        psLookup->uLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply pfApply to every binding of the subtrie psNode, passing
+   pvExtra. */
+
+static void SymTable_mapNode(const struct trieNode *psNode,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   void *pvExtra) {
+    const struct leaf *psLeaf;
+    uint32_t uMap;
+    uint32_t uBit;
+    size_t u = 0;
+    for (uMap = psNode->leafMap | psNode->nodeMap; uMap != 0;
+            uMap &= uMap - 1, u++) {
+        uBit = uMap & (0u - uMap);
+        if (psNode->leafMap & uBit)
+            for (psLeaf = psNode->slots[u].leaf; psLeaf != NULL;
+                    psLeaf = psLeaf->nextLeaf)
+                (*pfApply)(psLeaf->key, (void*)psLeaf->value, pvExtra);
+        else
+            SymTable_mapNode(psNode->slots[u].node, pfApply, pvExtra);
+    }
+}
+
+/* Call *pfFreeValue on the value passed as pvValue. pcKey is unused;
+   pvExtra is the address of pfFreeValue. */
+
+static void SymTable_freeValue(const char *pcKey, void *pvValue,
+   void *pvExtra) {
+    void (**ppfFreeValue)(void *pvValue) =
+        (void (**)(void *pvValue))pvExtra;
+    assert(pcKey != NULL);
+    (void)pcKey;
+    (**ppfFreeValue)(pvValue);
+}
+
+/* Drop one reference to the leaf chain psLeaf, freeing every leaf
+   that no longer has any. Call *pfFreeValue on the value of every
+   leaf of the chain, freed or not, unless pfFreeValue is NULL. */
+
+static void SymTable_releaseLeaf(SymTable_T oSymTable,
+   struct leaf *psLeaf, void (*pfFreeValue)(void *pvValue)) {
+    struct leaf *psNext;
+    int iReleasing = 1;
+    for (; psLeaf != NULL; psLeaf = psNext) {
+        psNext = psLeaf->nextLeaf;
+        if (pfFreeValue != NULL)
+            (*pfFreeValue)((void*)psLeaf->value);
+        if (iReleasing && --psLeaf->refCount == 0) {
+            free(psLeaf);
+            SYMTABLE_COUNT(oSymTable, uFrees);
+        }
+        else if (pfFreeValue == NULL)
+            return;
+        else
+            iReleasing = 0;
+    }
+}
+
+/* Drop one reference to the trie node psNode, freeing it and
+   releasing its children if it no longer has any. Call *pfFreeValue
+   on every value of the subtrie psNode, in the same walk, unless
+   pfFreeValue is NULL. */
+
+static void SymTable_releaseNode(SymTable_T oSymTable,
+   struct trieNode *psNode, void (*pfFreeValue)(void *pvValue)) {
+    uint32_t uMap;
+    uint32_t uBit;
+    size_t u = 0;
+    if (psNode == NULL)
+        return;
+    if (--psNode->refCount != 0) {
+        /* a clone still holds the subtrie, but not its values*/
+        if (pfFreeValue != NULL)
+            SymTable_mapNode(psNode, SymTable_freeValue,
+                (void*)&pfFreeValue);
+        return;
+    }
+    for (uMap = psNode->leafMap | psNode->nodeMap; uMap != 0;
+            uMap &= uMap - 1, u++) {
+        uBit = uMap & (0u - uMap);
+        if (psNode->leafMap & uBit)
+            SymTable_releaseLeaf(oSymTable, psNode->slots[u].leaf,
+                pfFreeValue);
+        else
+            SymTable_releaseNode(oSymTable, psNode->slots[u].node,
+                pfFreeValue);
+    }
+    free(psNode);
+    SYMTABLE_COUNT(oSymTable, uFrees);
+}
+
+/* Make the trie node at *ppsNode reachable only through the caller:
+   leave it if nothing else refers to it, and otherwise store in
+   *ppsNode a copy, which takes over the caller's reference. Return
+   the node, or NULL if insufficient memory is available, in which
+   case *ppsNode is unchanged. */
+
+static struct trieNode *SymTable_ownNode(SymTable_T oSymTable,
+   struct trieNode **ppsNode) {
+    struct trieNode *psNode = *ppsNode;
+    struct trieNode *psCopy;
+    uint32_t uMap;
+    uint32_t uBit;
+    size_t u = 0;
+    if (psNode->refCount == 1)
+        return psNode;
+    psCopy = (struct trieNode*)
+        malloc(SymTable_nodeSize(SymTable_slotCount(psNode)));
+    if (psCopy == NULL)
+        return NULL;
+    SYMTABLE_COUNT(oSymTable, uAllocs);
+    memcpy(psCopy, psNode, SymTable_nodeSize(SymTable_slotCount(psNode)));
+    psCopy->refCount = 1;
+    /* the copy refers to every child of the original*/
+    for (uMap = psCopy->leafMap | psCopy->nodeMap; uMap != 0;
+            uMap &= uMap - 1, u++) {
+        uBit = uMap & (0u - uMap);
+        if (psCopy->leafMap & uBit)
+            psCopy->slots[u].leaf->refCount++;
+        else
+            psCopy->slots[u].node->refCount++;
+    }
+    psNode->refCount--;
+    *ppsNode = psCopy;
+    return psCopy;
+}
+
+/* Make the leaf at *ppsLeaf reachable only through the caller, as
+   SymTable_ownNode does for trie nodes. Return the leaf, or NULL if
+   insufficient memory is available. */
+
+static struct leaf *SymTable_ownLeaf(SymTable_T oSymTable,
+   struct leaf **ppsLeaf) {
+    struct leaf *psLeaf = *ppsLeaf;
+    struct leaf *psCopy;
+    if (psLeaf->refCount == 1)
+        return psLeaf;
+    psCopy = (struct leaf*) malloc(SymTable_leafSize(psLeaf->keyLength));
+    if (psCopy == NULL)
+        return NULL;
+    SYMTABLE_COUNT(oSymTable, uAllocs);
+    memcpy(psCopy, psLeaf, SymTable_leafSize(psLeaf->keyLength));
+    psCopy->refCount = 1;
+    if (psCopy->nextLeaf != NULL)
+        psCopy->nextLeaf->refCount++;
+    psLeaf->refCount--;
+    *ppsLeaf = psCopy;
+    return psCopy;
+}
+
+/* Make every leaf of the chain at *ppsLeaf that comes before psTarget
+   reachable only through the caller. Return the link that points to
+   psTarget, or NULL if insufficient memory is available. */
+
+static struct leaf **SymTable_ownChain(SymTable_T oSymTable,
+   struct leaf **ppsLeaf, const struct leaf *psTarget) {
+    struct leaf *psLeaf;
+    while (*ppsLeaf != psTarget) {
+        psLeaf = SymTable_ownLeaf(oSymTable, ppsLeaf);
+        if (psLeaf == NULL)
+            return NULL;
+        ppsLeaf = &psLeaf->nextLeaf;
+    }
+    return ppsLeaf;
+}
+
+/* Walk the trie of oSymTable, which must not be empty, from the root
+   towards the key described by psLookup, making every trie node on
+   the way reachable only from oSymTable, until reaching the node
+   whose child for the key is a leaf chain or missing. Store the links
+   that point to the nodes visited in appsPath, the root's first.
+   Return the number of nodes visited, or 0 if insufficient memory is
+   available. */
+
+static size_t SymTable_ownPath(SymTable_T oSymTable,
+   const struct lookup *psLookup, struct trieNode **appsPath[]) {
+    struct trieNode **ppsLink = &oSymTable->root;
+    struct trieNode *psNode;
+    uint32_t uBit;
+    size_t uDepth = 0;
+    for (;;) {
+        psNode = SymTable_ownNode(oSymTable, ppsLink);
+        if (psNode == NULL)
+            return 0;
+        appsPath[uDepth++] = ppsLink;
+        uBit = SymTable_bit(psLookup->uHash,
+            (unsigned)(uDepth - 1) * HAMT_BITS);
+        if (! (psNode->nodeMap & uBit))
+            return uDepth;
+        ppsLink = &psNode->slots[SymTable_slotIndex(psNode, uBit)].node;
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the leaf of oSymTable whose key is described by psLookup, or
+   NULL if there is none. */
+
+static struct leaf *SymTable_find(SymTable_T oSymTable,
+   const struct lookup *psLookup) {
+    const struct trieNode *psNode = oSymTable->root;
+    struct leaf *psLeaf;
+    unsigned uShift = 0;
+    uint32_t uBit;
+
+    while (psNode != NULL) {
+        SYMTABLE_COUNT(oSymTable, uProbes);
+        uBit = SymTable_bit(psLookup->uHash, uShift);
+        if (psNode->nodeMap & uBit) {
+            psNode = psNode->slots[SymTable_slotIndex(psNode, uBit)].node;
+            uShift += HAMT_BITS;
+            continue;
+        }
+        if (! (psNode->leafMap & uBit))
+            break;
+        /* compares characters only when hash codes and lengths match*/
+        for (psLeaf = psNode->slots[SymTable_slotIndex(psNode, uBit)].leaf;
+                psLeaf != NULL; psLeaf = psLeaf->nextLeaf)
+            if (psLeaf->hash == psLookup->uHash &&
+                    psLeaf->keyLength == psLookup->uLength) {
+                SYMTABLE_COUNT(oSymTable, uKeyCompares);
+                if (memcmp(psLeaf->key, psLookup->pcKey,
+                        psLookup->uLength) == 0) {
+                    SYMTABLE_COUNT(oSymTable, uHits);
+                    return psLeaf;
+                }
+            }
+        break;
+    }
+    SYMTABLE_COUNT(oSymTable, uMisses);
+    return NULL;
+}
+
+/* Free the trie nodes of psNode, a chain of nodes built by
+   SymTable_pair, without releasing the leaves they hold. */
+
+static void SymTable_freePair(SymTable_T oSymTable,
+   struct trieNode *psNode) {
+    struct trieNode *psChild;
+    for (; psNode != NULL; psNode = psChild) {
+        psChild = psNode->nodeMap != 0 ? psNode->slots[0].node : NULL;
+        free(psNode);
+        SYMTABLE_COUNT(oSymTable, uFrees);
+    }
+}
+
+/* Return a new subtrie at level uShift / HAMT_BITS that holds the
+   leaf chains psFirst and psSecond, whose hash codes differ, taking
+   over one reference to each, or NULL if insufficient memory is
+   available. */
+
+static struct trieNode *SymTable_pair(SymTable_T oSymTable,
+   struct leaf *psFirst, struct leaf *psSecond, unsigned uShift) {
+    uint32_t uFirstBit = SymTable_bit(psFirst->hash, uShift);
+    uint32_t uSecondBit = SymTable_bit(psSecond->hash, uShift);
+    struct trieNode *psChild = NULL;
+    struct trieNode *psNode;
+
+    /* keys that agree on these bits meet one level down*/
+    if (uFirstBit == uSecondBit) {
+        psChild = SymTable_pair(oSymTable, psFirst, psSecond,
+            uShift + HAMT_BITS);
+        if (psChild == NULL)
+            return NULL;
+    }
+    psNode = (struct trieNode*)
+        malloc(SymTable_nodeSize(psChild != NULL ? 1 : 2));
+    if (psNode == NULL) {
+        SymTable_freePair(oSymTable, psChild);
+        return NULL;
+    }
+    SYMTABLE_COUNT(oSymTable, uAllocs);
+    psNode->refCount = 1;
+    if (psChild != NULL) {
+        psNode->leafMap = 0;
+        psNode->nodeMap = uFirstBit;
+        psNode->slots[0].node = psChild;
+    }
+    else {
+        psNode->leafMap = uFirstBit | uSecondBit;
+        psNode->nodeMap = 0;
+        psNode->slots[uFirstBit < uSecondBit ? 0 : 1].leaf = psFirst;
+        psNode->slots[uFirstBit < uSecondBit ? 1 : 0].leaf = psSecond;
+    }
+    return psNode;
+}
+
+/* Insert psLeaf, whose key is described by psLookup and is not in
+   oSymTable, into oSymTable. Return 1 (TRUE) on success, or 0 (FALSE)
+   if insufficient memory is available, in which case oSymTable holds
+   the same bindings as before. */
+
+static int SymTable_insert(SymTable_T oSymTable, struct leaf *psLeaf,
+   const struct lookup *psLookup) {
+    struct trieNode **appsPath[HAMT_LEVELS];
+    struct trieNode *psNode;
+    struct trieNode *psPair;
+    struct leaf *psOld;
+    size_t uDepth;
+    size_t uSlots;
+    size_t uIndex;
+    uint32_t uBit;
+
+    if (oSymTable->root == NULL) {
+        psNode = (struct trieNode*) malloc(SymTable_nodeSize(1));
+        if (psNode == NULL)
+            return 0;
+        SYMTABLE_COUNT(oSymTable, uAllocs);
+        psNode->refCount = 1;
+        psNode->leafMap = SymTable_bit(psLookup->uHash, 0);
+        psNode->nodeMap = 0;
+        psNode->slots[0].leaf = psLeaf;
+        oSymTable->root = psNode;
+        return 1;
+    }
+
+    uDepth = SymTable_ownPath(oSymTable, psLookup, appsPath);
+    if (uDepth == 0)
+        return 0;
+    psNode = *appsPath[uDepth - 1];
+    uBit = SymTable_bit(psLookup->uHash, (unsigned)(uDepth - 1) * HAMT_BITS);
+    uIndex = SymTable_slotIndex(psNode, uBit);
+
+    if (! (psNode->leafMap & uBit)) {
+        /* adds a slot for the leaf*/
+        uSlots = SymTable_slotCount(psNode);
+        psNode = (struct trieNode*)
+            realloc(psNode, SymTable_nodeSize(uSlots + 1));
+        if (psNode == NULL)
+            return 0;
+        SYMTABLE_COUNT(oSymTable, uAllocs);
+        memmove(&psNode->slots[uIndex + 1], &psNode->slots[uIndex],
+            (uSlots - uIndex) * sizeof(union slot));
+        psNode->slots[uIndex].leaf = psLeaf;
+        psNode->leafMap |= uBit;
+        *appsPath[uDepth - 1] = psNode;
+        return 1;
+    }
+
+    psOld = psNode->slots[uIndex].leaf;
+    if (psOld->hash == psLookup->uHash) {
+        /* the new leaf takes over the slot's reference to the chain*/
+        psLeaf->nextLeaf = psOld;
+        psNode->slots[uIndex].leaf = psLeaf;
+        return 1;
+    }
+    /* moves the leaf chain in the slot and the new leaf into a
+       subtrie of their own*/
+    psPair = SymTable_pair(oSymTable, psOld, psLeaf,
+        (unsigned)uDepth * HAMT_BITS);
+    if (psPair == NULL)
+        return 0;
+    psNode->leafMap &= ~uBit;
+    psNode->nodeMap |= uBit;
+    psNode->slots[uIndex].node = psPair;
+    return 1;
+}
+
+/* Restore, after a child was removed from the node at
+   *appsPath[uDepth - 1], the rule that a trie node other than the
+   root holds at least two leaf chains or a trie node: move a lone
+   leaf chain up into the parent, level by level, and free a root left
+   without children. uHash is the hash code of the removed key. */
+
+static void SymTable_collapse(SymTable_T oSymTable,
+   struct trieNode **appsPath[], size_t uDepth, uint64_t uHash) {
+    struct trieNode *psNode;
+    struct trieNode *psParent;
+    uint32_t uBit;
+
+    for (; uDepth > 1; uDepth--) {
+        psNode = *appsPath[uDepth - 1];
+        if (psNode->nodeMap != 0 || SymTable_slotCount(psNode) != 1)
+            return;
+        /* the parent takes over the node's reference to the chain*/
+        psParent = *appsPath[uDepth - 2];
+        uBit = SymTable_bit(uHash, (unsigned)(uDepth - 2) * HAMT_BITS);
+        psParent->nodeMap &= ~uBit;
+        psParent->leafMap |= uBit;
+        psParent->slots[SymTable_slotIndex(psParent, uBit)].leaf =
+            psNode->slots[0].leaf;
+        free(psNode);
+        SYMTABLE_COUNT(oSymTable, uFrees);
+    }
+    if (SymTable_slotCount(oSymTable->root) == 0) {
+        free(oSymTable->root);
+        SYMTABLE_COUNT(oSymTable, uFrees);
+        oSymTable->root = NULL;
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void) {
+    SymTable_T oSymTable;
+
+/* allocate space for the managing structure */
+   oSymTable = (SymTable_T) malloc(sizeof(struct SymTable));
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->root = NULL;
+   oSymTable->length = 0;
+   SymTable_randomSeed(oSymTable->seed);
+   oSymTable->freeValue = NULL;
+#ifdef SYMTABLE_STATS
+   memset(&oSymTable->sStats, 0, sizeof(oSymTable->sStats));
+#endif
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithDestructor(void (*pfFreeValue)(void *pvValue)) {
+    SymTable_T oSymTable;
+    assert(pfFreeValue != NULL);
+    oSymTable = SymTable_new();
+    if (oSymTable != NULL)
+        oSymTable->freeValue = pfFreeValue;
+    return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable) {
+   assert(oSymTable != NULL);
+   SymTable_releaseNode(oSymTable, oSymTable->root, oSymTable->freeValue);
+   free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+   return oSymTable->length;
+}
+
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+   const void *pvValue) {
+    struct leaf *psLeaf;
+    struct lookup sLookup;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+    SYMTABLE_COUNT(oSymTable, uPuts);
+    if (SymTable_find(oSymTable, &sLookup) != NULL)
+        return 0;
+    /*new key found*/
+    psLeaf = (struct leaf*) malloc(SymTable_leafSize(sLookup.uLength));
+    if (psLeaf == NULL)
+        return 0;
+    SYMTABLE_COUNT(oSymTable, uAllocs);
+    psLeaf->refCount = 1;
+    psLeaf->nextLeaf = NULL;
+    psLeaf->hash = sLookup.uHash;
+    psLeaf->keyLength = sLookup.uLength;
+    psLeaf->value = pvValue;
+    memcpy(psLeaf->key, pcKey, uLength);
+    psLeaf->key[uLength] = '\0';
+    if (! SymTable_insert(oSymTable, psLeaf, &sLookup)) {
+        free(psLeaf);
+        SYMTABLE_COUNT(oSymTable, uFrees);
+        return 0;
+    }
+    oSymTable->length++;
+    return 1;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    assert(pcKey != NULL);
+    return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+void *SymTable_replaceN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, const void *pvValue) {
+    struct trieNode **appsPath[HAMT_LEVELS];
+    struct trieNode *psNode;
+    struct leaf **ppsLeaf;
+    struct leaf *psLeaf;
+    const void *oldValue;
+    struct lookup sLookup;
+    size_t uDepth;
+    uint32_t uBit;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+    SYMTABLE_COUNT(oSymTable, uReplaces);
+
+    psLeaf = SymTable_find(oSymTable, &sLookup);
+    if (psLeaf == NULL)
+        return NULL;
+    oldValue = psLeaf->value;
+    /* copies the shared nodes and leaves on the way to the binding*/
+    uDepth = SymTable_ownPath(oSymTable, &sLookup, appsPath);
+    if (uDepth == 0)
+        return NULL;
+    psNode = *appsPath[uDepth - 1];
+    uBit = SymTable_bit(sLookup.uHash, (unsigned)(uDepth - 1) * HAMT_BITS);
+    ppsLeaf = SymTable_ownChain(oSymTable,
+        &psNode->slots[SymTable_slotIndex(psNode, uBit)].leaf, psLeaf);
+    if (ppsLeaf == NULL)
+        return NULL;
+    psLeaf = SymTable_ownLeaf(oSymTable, ppsLeaf);
+    if (psLeaf == NULL)
+        return NULL;
+    psLeaf->value = pvValue;
+    return (void*) oldValue;
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    assert(pcKey != NULL);
+    return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength) {
+    struct lookup sLookup;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+    SYMTABLE_COUNT(oSymTable, uContains);
+    return SymTable_find(oSymTable, &sLookup) != NULL;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    assert(pcKey != NULL);
+    return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength) {
+    struct leaf *psLeaf;
+    struct lookup sLookup;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+    SYMTABLE_COUNT(oSymTable, uGets);
+    psLeaf = SymTable_find(oSymTable, &sLookup);
+    if (psLeaf == NULL)
+        return NULL;
+    return (void*) psLeaf->value;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    assert(pcKey != NULL);
+    return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/* Remove the binding of oSymTable whose key is the uLength characters
+   at pcKey, store its value in *ppvValue and return 1 (TRUE). Return 0 (FALSE) if there is no such
+   binding, or if insufficient memory is available to copy the shared
+   nodes on the way to it. */
+
+static int SymTable_unbind(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, const void **ppvValue) {
+    struct trieNode **appsPath[HAMT_LEVELS];
+    struct trieNode *psNode;
+    struct leaf **ppsLeaf;
+    struct leaf *psLeaf;
+    struct lookup sLookup;
+    size_t uDepth;
+    size_t uSlots;
+    size_t uIndex;
+    uint32_t uBit;
+    SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+    SYMTABLE_COUNT(oSymTable, uRemoves);
+
+    psLeaf = SymTable_find(oSymTable, &sLookup);
+    if (psLeaf == NULL)
+        return 0;
+    *ppvValue = psLeaf->value;
+    uDepth = SymTable_ownPath(oSymTable, &sLookup, appsPath);
+    if (uDepth == 0)
+        return 0;
+    psNode = *appsPath[uDepth - 1];
+    uBit = SymTable_bit(sLookup.uHash, (unsigned)(uDepth - 1) * HAMT_BITS);
+    uIndex = SymTable_slotIndex(psNode, uBit);
+
+    if (psNode->slots[uIndex].leaf == psLeaf && psLeaf->nextLeaf == NULL) {
+        /* removes the slot, and any node left holding a lone leaf*/
+        SymTable_releaseLeaf(oSymTable, psLeaf, NULL);
+        uSlots = SymTable_slotCount(psNode);
+        memmove(&psNode->slots[uIndex], &psNode->slots[uIndex + 1],
+            (uSlots - uIndex - 1) * sizeof(union slot));
+        psNode->leafMap &= ~uBit;
+        SymTable_collapse(oSymTable, appsPath, uDepth, sLookup.uHash);
+    }
+    else {
+        /* unlinks the leaf from a chain of leaves with its hash code*/
+        ppsLeaf = SymTable_ownChain(oSymTable, &psNode->slots[uIndex].leaf,
+            psLeaf);
+        if (ppsLeaf == NULL)
+            return 0;
+        *ppsLeaf = psLeaf->nextLeaf;
+        if (psLeaf->nextLeaf != NULL)
+            psLeaf->nextLeaf->refCount++;
+        SymTable_releaseLeaf(oSymTable, psLeaf, NULL);
+    }
+    oSymTable->length--;
+    return 1;
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength) {
+    const void *oldValue;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    if (! SymTable_unbind(oSymTable, pcKey, uLength, &oldValue))
+        return NULL;
+    return (void*) oldValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    assert(pcKey != NULL);
+    return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_delete(SymTable_T oSymTable, const char *pcKey) {
+    const void *oldValue;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    if (! SymTable_unbind(oSymTable, pcKey, strlen(pcKey), &oldValue))
+        return 0;
+    if (oSymTable->freeValue != NULL)
+        (*oSymTable->freeValue)((void*) oldValue);
+    return 1;
+}
+
+ void SymTable_map(SymTable_T oSymTable,
+     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+     const void *pvExtra) {
+        assert(oSymTable != NULL);
+        assert(pfApply != NULL);
+
+        if (oSymTable->root != NULL)
+           SymTable_mapNode(oSymTable->root, pfApply, (void*)pvExtra);
+     }
+
+void SymTable_clear(SymTable_T oSymTable,
+   void (*pfFreeValue)(void *pvValue)) {
+    assert(oSymTable != NULL);
+    if (pfFreeValue == NULL)
+        pfFreeValue = oSymTable->freeValue;
+
+    /* a clone may still share the trie, so only this table's
+       reference to it is dropped*/
+    SymTable_releaseNode(oSymTable, oSymTable->root, pfFreeValue);
+    oSymTable->root = NULL;
+    oSymTable->length = 0;
+}
+
+SymTable_T SymTable_clone(SymTable_T oSymTable) {
+    SymTable_T oClone;
+    assert(oSymTable != NULL);
+
+    /* shares the whole trie; either table copies what it changes*/
+    oClone = (SymTable_T) malloc(sizeof(struct SymTable));
+    if (oClone == NULL)
+        return NULL;
+    oClone->root = oSymTable->root;
+    if (oClone->root != NULL)
+        oClone->root->refCount++;
+    oClone->length = oSymTable->length;
+    oClone->seed[0] = oSymTable->seed[0];
+    oClone->seed[1] = oSymTable->seed[1];
+    oClone->freeValue = NULL;
+#ifdef SYMTABLE_STATS
+    memset(&oClone->sStats, 0, sizeof(oClone->sStats));
+#endif
+    return oClone;
+}
+
+void SymTable_getStats(SymTable_T oSymTable,
+   struct SymTableStats *psStats) {
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+#ifdef SYMTABLE_STATS
+    *psStats = oSymTable->sStats;
+#else
+    (void)oSymTable;
+    memset(psStats, 0, sizeof(*psStats));
+#endif
+}
+
+void SymTable_resetStats(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+#ifdef SYMTABLE_STATS
+    memset(&oSymTable->sStats, 0, sizeof(oSymTable->sStats));
+#else
+    (void)oSymTable;
+#endif
+}
@@ -2,224 +2,4055 @@
 /* symtablehash.c                                                     */
 /* Author: Devanna Ritchie                                            */
 /*--------------------------------------------------------------------*/
+#define _DEFAULT_SOURCE
 #include <assert.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "symtable.h"
+#include <time.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "symtablehash.h"
+#include "symtablebuckets.h"
+#include "symtablesip.h"
+#include "symtablestats.h"
 
+/* SymTable_clear keeps the nodes of keys shorter than
+   POOL_CLASSES * POOL_GRANULE characters for reuse, in one list per
+   multiple of POOL_GRANULE. Such nodes are allocated with room for
+   the longest key of their class, so any node of a class fits any
+   key of that class. */
+enum {POOL_GRANULE = 16, POOL_CLASSES = 8};
 
+/* the bucket length at which new tables convert a bucket into a tree */
+enum {TREE_THRESHOLD = 8};
 
-/* Return a hash code for pcKey that is between 0 and uBucketCount-1,
-   inclusive. */
+/* the number of consecutive buckets a snapshot preserves at once */
+enum {SNAPSHOT_PAGE = 16};
 
-static size_t SymTable_hash(const char *pcKey, size_t uBucketCount) {
-   const size_t HASH_MULTIPLIER = 65599;
-   size_t u;
-   size_t uHash = 0;
-
-   assert(pcKey != NULL);
+/* A new table keeps up to SMALL_SLOTS bindings in slots inside its
+   struct SymTable, with their hash codes beside them, and allocates
+   its bucket array only when it outgrows them, so that an empty or
+   tiny table costs one malloc instead of two and a few hundred bytes
+   instead of a few kilobytes. */
+enum {SMALL_SLOTS = 8};
 
-   for (u = 0; pcKey[u] != '\0'; u++)
-      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+/* The filter SymTable_setFilter enables is a split block Bloom
+   filter: a key's hash code picks one block of FILTER_WORDS 32-bit
+   words, which fits in a cache line, and sets one bit in every word
+   of it, chosen by multiplying the code by the word's salt. The
+   filter has FILTER_BITS bits per bucket. */
+enum {FILTER_WORDS = 8, FILTER_BITS = 8};
 
-   return uHash % uBucketCount;
-}
+static const uint32_t auFilterSalts[FILTER_WORDS] = {
+   0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+   0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u
+};
 
-/* node structure which contains pointer to the defensive copy of the key,
-the pointer to the client's value, and the pointer to the next node in the list*/
+/* node structure which holds one binding. The fields a lookup reads
+on every node it visits (the link, the full hash code and the key
+length) come first; the client's value and the defensive copy of the
+key follow, and are touched only when the hash code and length match.
+The key lives in the same allocation as the node, so a binding costs
+one malloc and a match costs no extra pointer chase.*/
 struct node {
-    /* pointer to the defensive copy of the key*/
-    const char *key; 
+    /* pointer to the next node in the bucket*/
+    struct node *nextNode;
+    /* the full hash code of the key*/
+    size_t hash;
+    /* the length of the key*/
+    size_t keyLength;
     /* pointer to the client's value*/
     const void *value;
-    /* pointer to the next node*/
-    struct node *nextNode;
+    /* the defensive copy of the key; the node is allocated with room
+       for keyLength + 1 characters*/
+    char key[];
+};
+
+/* tree node structure which holds one binding of a bucket that has
+been converted into a tree. The tree is a treap: it is a search tree
+ordered by (hash code, key length, key characters) and a max-heap on
+priority, which is derived from the keyed hash code and so cannot be
+chosen by whoever picks the keys.*/
+struct treeNode {
+    /* the subtrees of smaller and of larger keys*/
+    struct treeNode *leftNode;
+    struct treeNode *rightNode;
+    /* the heap priority of the node*/
+    size_t priority;
+    /* the binding itself; its nextNode is unused*/
+    struct node *node;
+};
+
+/* the ways a SymTable can hold its bindings: in nodes that can be
+changed, in a read-only image mapped from a file written by
+SymTable_save, in a read-only perfect hash table built by
+SymTable_freeze, or as a read-only snapshot of a live table taken by
+SymTable_snapshot. A retired table is a live table its client has
+freed whose buckets are kept for the snapshots that still read them.
+A sharded table made by SymTable_newSharded holds no bindings itself
+but passes every operation on to one of its shards.*/
+enum TableMode {MODE_LIVE, MODE_MAPPED, MODE_FROZEN, MODE_SNAPSHOT,
+    MODE_RETIRED, MODE_SHARDED};
+
+/* the largest number of shards SymTable_newSharded accepts */
+enum {MAX_SHARDS = 65536};
+
+/* the size of a cache line, to which the shards and the length
+stripes of a sharded table are aligned and padded*/
+enum {CACHE_LINE = 64};
+
+/* the size of the whole cache lines that uSize bytes take up */
+#define CACHE_ROUND(uSize) \
+    (((uSize) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE)
+
+/* shard structure which holds one shard of a sharded table: a live
+table and the lock that every operation on it holds.*/
+struct shard {
+    pthread_mutex_t lock;
+    SymTable_T table;
+};
+
+/* a shard padded to whole cache lines, so threads on different shards
+never write to the same line*/
+union shardLine {
+    struct shard shard;
+    char line[CACHE_ROUND(sizeof(struct shard))];
+};
+
+/* the number of stripes of the length counter of a sharded table */
+enum {LENGTH_STRIPES = 16};
+
+/* stripe structure which holds one stripe of the length counter of a
+sharded table: the bindings that the threads counting in it have
+added and removed. Both counts only grow, and each is changed
+atomically by a put, remove or clear while it holds the lock of the
+shard it changed.*/
+struct stripe {
+    size_t added;
+    size_t removed;
+};
+
+/* a stripe padded to whole cache lines, so threads counting in
+different stripes never write to the same line*/
+union stripeLine {
+    struct stripe stripe;
+    char line[CACHE_ROUND(sizeof(struct stripe))];
+};
+
+/* the stripe of the length counters of sharded tables that the
+calling thread counts in, plus 1, or 0 until it first changes a
+sharded table; and the number of threads that have picked a stripe,
+which deals the stripes out in turn*/
+static __thread size_t uThreadStripe;
+static size_t uStripeThreads;
+
+/* the most times SymTable_getExactLength reads the stripes without
+locking before it locks every shard*/
+enum {EXACT_ATTEMPTS = 8};
+
+/* A writer (SymTable_writerBegin) logs up to WRITER_LOG_MAX puts
+   before it applies them; the log starts with room for
+   WRITER_LOG_MIN puts and WRITER_LOG_MIN * POOL_GRANULE key
+   characters and doubles as it fills. */
+enum {WRITER_LOG_MIN = 1024, WRITER_LOG_MAX = 1048576};
+
+/* a writer groups its log by the top GROUP_BITS bits of the bucket
+   indexes */
+enum {GROUP_BITS = 11};
+
+/* log entry structure which holds one put logged by a writer: the
+hash code and length of its key, where the copy of the key starts in
+the writer's key characters, its value, and, while the log is being
+applied, the index of its bucket.*/
+struct logEntry {
+    size_t hash;
+    size_t keyLength;
+    size_t keyOffset;
+    const void *value;
+    size_t bucket;
+};
+
+/* The latency histograms of SymTable_setTracing split each power of 2
+   above LATENCY_SUB_BUCKETS nanoseconds into LATENCY_SUB_BUCKETS
+   buckets, and stop at LATENCY_LIMIT_BITS bits. */
+enum {LATENCY_SUB_BITS = 4, LATENCY_SUB_BUCKETS = 1 << LATENCY_SUB_BITS,
+   LATENCY_LIMIT_BITS = 36};
+
+/* trace structure which holds the state of a traced table: one
+operation in how many is timed, and how many operations remain until
+the next one that is; whether the current operation is timed, its
+clock reading at the start and the bucket count at the start; the
+slow-operation hook, its thresholds and its extra argument, or NULL;
+and the latency histograms, one per kind of operation. The fields
+every operation reads come first and share a cache line.*/
+struct trace {
+    size_t interval;
+    size_t countdown;
+    int timed;
+    uint64_t start;
+    size_t startBuckets;
+    void (*slow)(const struct SymTableSlowOp *psOp, void *pvExtra);
+    uint64_t slowNanoseconds;
+    size_t slowDepth;
+    const void *slowExtra;
+    struct SymTableLatency latencies[SYMTABLE_OP_COUNT];
+};
+
+/* snapshot page structure which holds a snapshot's own copy of
+SNAPSHOT_PAGE consecutive buckets of its live table, made just before
+the live table first changed one of them. The copy has the chains and
+trees of the buckets at the time the snapshot was taken.*/
+struct snapshotPage {
+    struct node *firstNodes[SNAPSHOT_PAGE];
+    struct treeNode *treeRoots[SNAPSHOT_PAGE];
+};
+
+/* deferred value structure which holds a value a live table let go
+of while a snapshot that may still return it existed, and the
+function that destroys it once no such snapshot is left.*/
+struct deferredValue {
+    void *value;
+    void (*freeValue)(void *pvValue);
+};
+
+/* image header structure which starts every image. All offsets are
+from the start of the image, so the image can be mapped at any
+address. Bucket b of an image holds entries starts[b] up to
+starts[b + 1] of the entry array, which is sorted by bucket.*/
+struct imageHeader {
+    /* IMAGE_MAGIC, IMAGE_BYTE_ORDER as written by the saving machine,
+       and IMAGE_VERSION*/
+    char magic[8];
+    uint64_t byteOrder;
+    uint64_t version;
+    /* the number of bindings and of buckets*/
+    uint64_t length;
+    uint64_t bucketCount;
+    /* the key of the hash function that placed the bindings*/
+    uint64_t seed[2];
+    /* where the bucketCount + 1 bucket starts and the length entries
+       are, and the size of the whole image*/
+    uint64_t startsOffset;
+    uint64_t entriesOffset;
+    uint64_t imageSize;
+};
+
+/* image entry structure which holds one binding of an image. The key
+characters, with their '\0', and the encoded value live in the key and
+value heaps that follow the entry array.*/
+struct imageEntry {
+    uint64_t hash;
+    uint64_t keyLength;
+    uint64_t keyOffset;
+    uint64_t valueOffset;
+};
+
+/* frozen entry structure which holds one slot of a frozen table.
+An empty slot has a NULL key.*/
+struct frozenEntry {
+    size_t hash;
+    size_t keyLength;
+    const char *key;
+    const void *value;
+};
+
+/* displacement structure which holds the pair of displacements that
+places the keys of one bucket of a frozen table in distinct free
+slots: a key with slot functions f1 and f2 goes to slot
+(f1 + d0 * f2 + d1) % the number of slots.*/
+struct displacement {
+    uint32_t d0;
+    uint32_t d1;
+};
+
+/* mapped structure which holds the state of a mapped table: its
+image, the image's size, and its bucket starts and entries*/
+struct mapped {
+    const unsigned char *image;
+    size_t size;
+    const uint64_t *starts;
+    const struct imageEntry *entries;
+};
+
+/* frozen structure which holds the state of a frozen table: its slots
+and bucket displacements, the number of slots, and the heap holding
+its keys. numOfcells is its number of buckets.*/
+struct frozen {
+    struct frozenEntry *entries;
+    struct displacement *displacements;
+    size_t slots;
+    char *keys;
 };
 
-/* SymTable structure that contains the pointer to the first node of the list 
+/* sharded structure which holds the state of a sharded table: its
+shards, their number, a power of 2, and its base-2 logarithm, the
+number of top bits of a hash code that pick a shard; and the
+LENGTH_STRIPES stripes of its length*/
+struct sharded {
+    union shardLine *shards;
+    size_t count;
+    size_t bits;
+    union stripeLine *stripes;
+};
+
+/* snapshot structure which holds the snapshot state of a table.
+A snapshot has one from the time it is taken, and a live table from
+its first snapshot until its last one is freed.*/
+struct snapshot {
+    /* for a snapshot: the live table whose buckets it reads where it
+       has no page of its own, or NULL once it has every page; its
+       pages, indexed by bucket / SNAPSHOT_PAGE, or NULL until the
+       first page is preserved; the next snapshot of the same live
+       table; and the live table it was taken of, which it keeps alive
+       after detaching too, since it shares that table's values*/
+    SymTable_T source;
+    struct snapshotPage **pages;
+    SymTable_T next;
+    SymTable_T owner;
+
+    /* for a live table: its first snapshot that still reads its
+       buckets, or NULL; the number of its snapshots, detached ones
+       included; and the values it let go of while they existed, their
+       number and the room for them, which the last snapshot to be
+       freed destroys*/
+    SymTable_T first;
+    size_t count;
+    struct deferredValue *deferred;
+    size_t deferredCount;
+    size_t deferredRoom;
+};
+
+/* writer structure which holds the writer of a live table: the puts
+logged and not yet applied, their number and the room for them; the
+characters of their keys, their number and the room for them; the
+number of logged puts that bound their key since SymTable_writerBegin;
+and whether any was dropped for lack of memory since then.*/
+struct writer {
+    struct logEntry *entries;
+    size_t count;
+    size_t room;
+    char *keys;
+    size_t keySize;
+    size_t keyRoom;
+    size_t added;
+    int dropped;
+};
+
+/* SymTable structure that contains the array of buckets
 and the length of the symbol table*/
 struct SymTable {
 
-/* a pointer to an array of pointers to the first nodes*/
-  struct node **firstNodes[509];
+  /* the mode of the table; the node fields below are unused by a
+     mapped table*/
+  enum TableMode mode;
+
+  /* the state of a mapped, frozen or sharded table, or NULL for a
+     table of another mode*/
+  struct mapped *mapped;
+  struct frozen *frozen;
+  struct sharded *sharded;
+
+/* an array of pointers to the first node of each bucket, or NULL
+   while a live table is small*/
+  struct node **firstNodes;
+
+/* an array holding the root of each bucket that has been converted
+   into a tree, whose chain in firstNodes is then empty, or NULL if no
+   bucket has been converted*/
+  struct treeNode **treeRoots;
+
+  /* for a small live table: its first length bindings, in no
+     particular order, and their hash codes, which a lookup compares
+     without visiting the nodes*/
+  struct node *smallNodes[SMALL_SLOTS];
+  size_t smallHashes[SMALL_SLOTS];
+
+  /* the snapshot state of a snapshot, or of a live table that has
+     snapshots, or NULL*/
+  struct snapshot *snapshot;
 
   /* how many nodes inside the symbol table*/
   size_t length;
 
 /* how many cells are in the array of pointers to the first nodes*/
   size_t numOfcells;
-  
+
+  /* the index of numOfcells in auBucketCounts*/
+  size_t bucketStep;
+
+  /* the bucket length at which a bucket becomes a tree, or 0*/
+  size_t treeThreshold;
+
+  /* the key of the keyed hash function*/
+  uint64_t seed[2];
+
+  /* the function that frees a value the table discards, or NULL*/
+  void (*freeValue)(void *pvValue);
+
+  /* the blocks of the filter of a live table, or NULL if it has none;
+     their number; and the removes made since the filter was built,
+     whose keys may still have bits set*/
+  uint32_t (*filterBlocks)[FILTER_WORDS];
+  size_t filterBlockCount;
+  size_t filterRemoves;
+
+  /* nodes released by SymTable_clear for reuse by SymTable_put, one
+     list per size class, linked through nextNode*/
+  struct node *freeNodes[POOL_CLASSES];
+
+  /* the writer of a live table, or NULL if it has none*/
+  struct writer *writer;
+
+  /* the histograms and slow-operation hook of a traced live table, or
+     NULL if it is not traced*/
+  struct trace *trace;
+
+#ifdef SYMTABLE_STATS
+  /* hot-path counters, see SymTable_getStats */
+  struct SymTableStats sStats;
+#endif
 };
 
+/* lookup structure which describes one key being searched for, so
+that its hash code and length are computed once per operation*/
+struct lookup {
+    /* the key, its length and its full hash code*/
+    const char *pcKey;
+    size_t uLength;
+    size_t uHash;
+    /* the index of the bucket the key belongs to*/
+    size_t uBucket;
+    /* set by SymTable_find for chain buckets: the link that points
+       to the node found, or the slot that holds it in a small table,
+       and the number of nodes visited*/
+    struct node **ppLink;
+    size_t uDepth;
+};
 
-SymTable_T SymTable_new(void) {
-    SymTable_T oSymTable;
-    
-/* allocate space for the managing structure */
-   oSymTable = (SymTable_T) malloc(sizeof(struct SymTable));
-   if (oSymTable == NULL)
-      return NULL;
+/*--------------------------------------------------------------------*/
 
-   oSymTable->firstNodes[0] = NULL;
-   oSymTable->length = 0;
-   return oSymTable;
+/* Return the hash code of the uLength characters at pcKey under the
+   key of oSymTable (see SymTable_sipHash). The caller reduces the
+   code to a bucket index. */
+
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength) {
+   return (size_t)SymTable_sipHash(oSymTable->seed, pcKey, uLength);
 }
 
-void SymTable_free(SymTable_T oSymTable) {
-    
-   struct node *currentNode;
-   struct node *nextNode;
-   assert(oSymTable != NULL);
+/* Fill *psLookup with the key made of the uLength characters at
+   pcKey, its hash code under the key of oSymTable and the index of its
+   bucket. */
 
+static void SymTable_initLookup(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, struct lookup *psLookup) {
+    psLookup->pcKey = pcKey;
+    psLookup->uLength = uLength;
+    psLookup->uHash = SymTable_hash(oSymTable, pcKey, psLookup->uLength);
+    psLookup->uBucket = psLookup->uHash % oSymTable->numOfcells;
+    psLookup->ppLink = NULL;
+    psLookup->uDepth = 0;
+}
 
-   for (currentNode = (struct node*) oSymTable->firstNodes[0];
-        currentNode != NULL;
-        currentNode = nextNode)
-   {
-      nextNode = currentNode->nextNode;
-      free((char*) currentNode->key);
-      free(currentNode);
-   }
+/*--------------------------------------------------------------------*/
 
-   free(oSymTable);
+/* Return the number of bytes allocated for a node whose key has
+   uLength characters. */
+
+static size_t SymTable_nodeSize(size_t uLength) {
+    if (uLength / POOL_GRANULE < POOL_CLASSES)
+        uLength = (uLength / POOL_GRANULE + 1) * POOL_GRANULE - 1;
+    return offsetof(struct node, key) + uLength + 1;
 }
 
-size_t SymTable_getLength(SymTable_T oSymTable) {
-    assert(oSymTable != NULL);
-   return oSymTable->length;
+/* Return a node of oSymTable with room for a key of uLength
+   characters, taken from the pool if one is available, or NULL if
+   insufficient memory is available. */
+
+static struct node *SymTable_allocNode(SymTable_T oSymTable,
+   size_t uLength) {
+    size_t uClass = uLength / POOL_GRANULE;
+    struct node *psNode;
+    if (uClass < POOL_CLASSES && oSymTable->freeNodes[uClass] != NULL) {
+        psNode = oSymTable->freeNodes[uClass];
+        oSymTable->freeNodes[uClass] = psNode->nextNode;
+        return psNode;
+    }
+    psNode = (struct node*) malloc(SymTable_nodeSize(uLength));
+    if (psNode != NULL)
+        SYMTABLE_COUNT(oSymTable, uAllocs);
+    return psNode;
 }
 
-int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+/* Give psNode, which no longer holds a binding of oSymTable, to the
+   pool of oSymTable, or free it if its class is not pooled. */
+
+static void SymTable_releaseNode(SymTable_T oSymTable,
+   struct node *psNode) {
+    size_t uClass = psNode->keyLength / POOL_GRANULE;
+    if (uClass < POOL_CLASSES) {
+        psNode->nextNode = oSymTable->freeNodes[uClass];
+        oSymTable->freeNodes[uClass] = psNode;
+    }
+    else {
+        free(psNode);
+        SYMTABLE_COUNT(oSymTable, uFrees);
+    }
+}
+
+/* Free every node in the pool of oSymTable. */
+
+static void SymTable_freePool(SymTable_T oSymTable) {
     struct node *currentNode;
-    size_t hashIndex = SymTable_hash(pcKey, 509);
-    assert(oSymTable != NULL);
-    assert(pcKey != NULL);
-    /* loops through all the nodes in search for pcKey*/
-    for (currentNode = (struct node*) oSymTable->firstNodes[hashIndex]; currentNode != NULL; 
-            currentNode = currentNode -> nextNode) {
-        if (strcmp(currentNode->key, pcKey) == 0) {
-            return 0;
-        } 
+    struct node *nextNode;
+    size_t uClass;
+    for (uClass = 0; uClass < POOL_CLASSES; uClass++) {
+        for (currentNode = oSymTable->freeNodes[uClass];
+                currentNode != NULL; currentNode = nextNode) {
+            nextNode = currentNode->nextNode;
+            free(currentNode);
+            SYMTABLE_COUNT(oSymTable, uFrees);
+        }
+        oSymTable->freeNodes[uClass] = NULL;
     }
-    /*new key found*/
-    /* allocating enough space for new node*/
-    currentNode = (struct node*) malloc(sizeof(struct node));
+}
 
-    if (currentNode == NULL) {
-        return 0;
+/*--------------------------------------------------------------------*/
+
+/* Return a negative number, 0, or a positive number as the key with
+   hash code uHash, length uLength and characters pcKey orders before,
+   equal to, or after the key of psNode in a tree bucket. */
+
+static int SymTable_compare(size_t uHash, size_t uLength,
+   const char *pcKey, const struct node *psNode) {
+    if (uHash != psNode->hash)
+        return uHash < psNode->hash ? -1 : 1;
+    if (uLength != psNode->keyLength)
+        return uLength < psNode->keyLength ? -1 : 1;
+    return memcmp(pcKey, psNode->key, uLength);
+}
+
+/* Return the tree whose root was the left child of psRoot after
+   rotating it above psRoot. */
+
+static struct treeNode *SymTable_rotateRight(struct treeNode *psRoot) {
+    struct treeNode *psLeft = psRoot->leftNode;
+    psRoot->leftNode = psLeft->rightNode;
+    psLeft->rightNode = psRoot;
+    return psLeft;
+}
+
+/* Return the tree whose root was the right child of psRoot after
+   rotating it above psRoot. */
+
+static struct treeNode *SymTable_rotateLeft(struct treeNode *psRoot) {
+    struct treeNode *psRight = psRoot->rightNode;
+    psRoot->rightNode = psRight->leftNode;
+    psRight->leftNode = psRoot;
+    return psRight;
+}
+
+/* Insert psNew, whose key is not in the tree psRoot, into psRoot and
+   return the root of the resulting tree. */
+
+static struct treeNode *SymTable_treeInsert(struct treeNode *psRoot,
+   struct treeNode *psNew) {
+    const struct node *psNode = psNew->node;
+    if (psRoot == NULL)
+        return psNew;
+    if (SymTable_compare(psNode->hash, psNode->keyLength, psNode->key,
+            psRoot->node) < 0) {
+        psRoot->leftNode = SymTable_treeInsert(psRoot->leftNode, psNew);
+        if (psRoot->leftNode->priority > psRoot->priority)
+            psRoot = SymTable_rotateRight(psRoot);
     }
-    currentNode->key = (char*) malloc(strlen(pcKey) + 1);
-    if (currentNode->key == NULL) {
-        free(currentNode);
-        return 0;
+    else {
+        psRoot->rightNode = SymTable_treeInsert(psRoot->rightNode, psNew);
+        if (psRoot->rightNode->priority > psRoot->priority)
+            psRoot = SymTable_rotateLeft(psRoot);
     }
-    /*ready to fill the node*/
-    currentNode->key = strcpy((char*) currentNode->key, pcKey);
-    currentNode->value = pvValue;
-    /* adds p to the beginning of the list*/
-    currentNode->nextNode = (struct node*) oSymTable->firstNodes[0];
-    oSymTable->firstNodes[0] = (struct node**) currentNode;
-    oSymTable->length++;
+    return psRoot;
+}
+
+/* Return the root of the tree holding the nodes of psLeft and of
+   psRight, every key of which orders before every key of psRight. */
+
+static struct treeNode *SymTable_treeJoin(struct treeNode *psLeft,
+   struct treeNode *psRight) {
+    if (psLeft == NULL)
+        return psRight;
+    if (psRight == NULL)
+        return psLeft;
+    if (psLeft->priority > psRight->priority) {
+        psLeft->rightNode = SymTable_treeJoin(psLeft->rightNode, psRight);
+        return psLeft;
+    }
+    psRight->leftNode = SymTable_treeJoin(psLeft, psRight->leftNode);
+    return psRight;
+}
+
+/* Unlink the tree node whose key is described by psLookup from the
+   tree psRoot, store it in *ppsRemoved, and return the root of the
+   resulting tree. Leave *ppsRemoved unchanged if there is no such
+   node. */
+
+static struct treeNode *SymTable_treeRemove(struct treeNode *psRoot,
+   const struct lookup *psLookup, struct treeNode **ppsRemoved) {
+    int iCompare;
+    if (psRoot == NULL)
+        return NULL;
+    iCompare = SymTable_compare(psLookup->uHash, psLookup->uLength,
+        psLookup->pcKey, psRoot->node);
+    if (iCompare < 0)
+        psRoot->leftNode = SymTable_treeRemove(psRoot->leftNode, psLookup,
+            ppsRemoved);
+    else if (iCompare > 0)
+        psRoot->rightNode = SymTable_treeRemove(psRoot->rightNode,
+            psLookup, ppsRemoved);
+    else {
+        *ppsRemoved = psRoot;
+        return SymTable_treeJoin(psRoot->leftNode, psRoot->rightNode);
+    }
+    return psRoot;
+}
+
+/* Apply pfApply to every binding of the tree psRoot, passing pvExtra,
+   in key order. */
+
+static void SymTable_treeMap(const struct treeNode *psRoot,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   void *pvExtra) {
+    while (psRoot != NULL) {
+        SymTable_treeMap(psRoot->leftNode, pfApply, pvExtra);
+        (*pfApply)(psRoot->node->key, (void*)psRoot->node->value,
+            pvExtra);
+        psRoot = psRoot->rightNode;
+    }
+}
+
+/* Make room among the deferred values of live table oSymTable, which
+   has snapshots, for uCount more. Return 1 (TRUE) on success, or 0
+   (FALSE) if insufficient memory is available. */
+
+static int SymTable_reserveDeferred(SymTable_T oSymTable, size_t uCount) {
+    struct snapshot *psSnapshot = oSymTable->snapshot;
+    struct deferredValue *psGrown;
+    size_t uRoom;
+    if (uCount <= psSnapshot->deferredRoom - psSnapshot->deferredCount)
+        return 1;
+    uRoom = 2 * psSnapshot->deferredRoom + uCount;
+    psGrown = (struct deferredValue*) realloc(psSnapshot->deferred,
+        uRoom * sizeof(struct deferredValue));
+    if (psGrown == NULL)
+        return 0;
+    SYMTABLE_COUNT(oSymTable, uAllocs);
+    psSnapshot->deferred = psGrown;
+    psSnapshot->deferredRoom = uRoom;
     return 1;
 }
 
-void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
-    /* traveling node*/
-    struct node *currentNode;
-    const void* oldValue;
-    size_t hashIndex = SymTable_hash(pcKey, 509);
-    assert(oSymTable != NULL);
-    assert(pcKey != NULL);
+/* Call *pfFreeValue on pvValue, a value live table oSymTable lets go
+   of, unless pfFreeValue is NULL. While a snapshot of oSymTable
+   exists, which may still return pvValue, keep pvValue among the
+   deferred values of oSymTable instead, for which there must be
+   room. */
 
-/* loops through all the nodes in search for pcKey*/
-for (currentNode = (struct node*) oSymTable->firstNodes[hashIndex]; currentNode != NULL; 
-        currentNode = currentNode -> nextNode) {
-        if (strcmp(currentNode->key, pcKey) == 0) {
-            oldValue = currentNode->value;
-            currentNode->value = pvValue;
-            return (void*) oldValue;
-        } 
+static void SymTable_discard(SymTable_T oSymTable,
+   void (*pfFreeValue)(void *pvValue), const void *pvValue) {
+    struct snapshot *psSnapshot = oSymTable->snapshot;
+    struct deferredValue *psDeferred;
+    if (pfFreeValue == NULL)
+        return;
+    if (psSnapshot == NULL) {
+        (*pfFreeValue)((void*)pvValue);
+        return;
     }
-    return NULL;
+    assert(psSnapshot->deferredCount < psSnapshot->deferredRoom);
+    psDeferred = &psSnapshot->deferred[psSnapshot->deferredCount++];
+    psDeferred->value = (void*)pvValue;
+    psDeferred->freeValue = pfFreeValue;
+}
+
+/* Call the destructor of every deferred value of live or retired table
+   oSymTable, which has no snapshot left, on it, and free their array
+   and the snapshot state of oSymTable, if it has any. */
 
+static void SymTable_destroyDeferred(SymTable_T oSymTable) {
+    struct snapshot *psSnapshot = oSymTable->snapshot;
+    size_t u;
+    if (psSnapshot == NULL)
+        return;
+    for (u = 0; u < psSnapshot->deferredCount; u++)
+        (*psSnapshot->deferred[u].freeValue)(psSnapshot->deferred[u].value);
+    free(psSnapshot->deferred);
+    free(psSnapshot);
+    oSymTable->snapshot = NULL;
 }
 
-int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+/* Call *pfFreeValue on the value of every binding of the tree psRoot
+   unless pfFreeValue is NULL, as SymTable_discard does, give every
+   node to the pool of oSymTable and free every tree node. */
+
+static void SymTable_treeClear(SymTable_T oSymTable,
+   struct treeNode *psRoot, void (*pfFreeValue)(void *pvValue)) {
+    struct treeNode *psRight;
+    while (psRoot != NULL) {
+        SymTable_treeClear(oSymTable, psRoot->leftNode, pfFreeValue);
+        psRight = psRoot->rightNode;
+        SymTable_discard(oSymTable, pfFreeValue, psRoot->node->value);
+        SymTable_releaseNode(oSymTable, psRoot->node);
+        free(psRoot);
+        psRoot = psRight;
+    }
+}
+
+/* Free every node and tree node of the tree psRoot, first calling
+   *pfFreeValue on each value unless pfFreeValue is NULL. */
+
+static void SymTable_treeFree(struct treeNode *psRoot,
+   void (*pfFreeValue)(void *pvValue)) {
+    struct treeNode *psRight;
+    while (psRoot != NULL) {
+        SymTable_treeFree(psRoot->leftNode, pfFreeValue);
+        psRight = psRoot->rightNode;
+        if (pfFreeValue != NULL)
+            (*pfFreeValue)((void*)psRoot->node->value);
+        free(psRoot->node);
+        free(psRoot);
+        psRoot = psRight;
+    }
+}
+
+/* Return a new tree node holding psNode, or NULL if insufficient
+   memory is available. */
+
+static struct treeNode *SymTable_newTreeNode(struct node *psNode) {
+    struct treeNode *psTreeNode;
+    psTreeNode = (struct treeNode*) malloc(sizeof(struct treeNode));
+    if (psTreeNode == NULL)
+        return NULL;
+    psTreeNode->leftNode = NULL;
+    psTreeNode->rightNode = NULL;
+    psTreeNode->priority = (size_t)SymTable_mix((uint64_t)psNode->hash);
+    psTreeNode->node = psNode;
+    return psTreeNode;
+}
+
+/* Convert bucket uBucket of oSymTable from a chain into a tree. If
+   insufficient memory is available, leave the bucket a chain. */
+
+static void SymTable_treeify(SymTable_T oSymTable, size_t uBucket) {
+    struct treeNode *psRoot = NULL;
+    struct treeNode *psTreeNode;
     struct node *currentNode;
-    size_t hashIndex = SymTable_hash(pcKey, 509);
-    assert(oSymTable != NULL);
-    assert(pcKey != NULL);
+    struct node *nextNode;
+    size_t u;
 
-    for (currentNode = (struct node*) oSymTable->firstNodes[hashIndex]; currentNode != NULL; 
-            currentNode = currentNode -> nextNode) {
-        if (strcmp(currentNode->key, pcKey) == 0) {
-            return 1;
+    if (oSymTable->treeRoots == NULL) {
+        oSymTable->treeRoots = (struct treeNode**)
+            malloc(oSymTable->numOfcells * sizeof(struct treeNode*));
+        if (oSymTable->treeRoots == NULL)
+            return;
+        for (u = 0; u < oSymTable->numOfcells; u++)
+            oSymTable->treeRoots[u] = NULL;
+    }
+
+    for (currentNode = oSymTable->firstNodes[uBucket];
+            currentNode != NULL; currentNode = nextNode) {
+        nextNode = currentNode->nextNode;
+        psTreeNode = SymTable_newTreeNode(currentNode);
+        if (psTreeNode == NULL) {
+            /* give the converted nodes back to the chain */
+            oSymTable->firstNodes[uBucket] = currentNode;
+            while (psRoot != NULL) {
+                struct treeNode *psFirst = psRoot;
+                psRoot = SymTable_treeJoin(psRoot->leftNode,
+                    psRoot->rightNode);
+                psFirst->node->nextNode = oSymTable->firstNodes[uBucket];
+                oSymTable->firstNodes[uBucket] = psFirst->node;
+                free(psFirst);
+            }
+            return;
         }
+        psRoot = SymTable_treeInsert(psRoot, psTreeNode);
     }
-    return 0;
+    oSymTable->firstNodes[uBucket] = NULL;
+    oSymTable->treeRoots[uBucket] = psRoot;
 }
 
-void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
-    struct node *currentNode;
-    size_t hashIndex = SymTable_hash(pcKey, 509);
-    assert(oSymTable != NULL);
-    assert(pcKey != NULL);
+/* Move every node of the tree psRoot to the head of its bucket in
+   ppsBuckets, an array of uCount chains, and free the tree nodes. */
 
-    /* loops through all the nodes in search for pcKey*/
-    for (currentNode = (struct node*) oSymTable->firstNodes[hashIndex]; currentNode != NULL; 
-            currentNode = currentNode -> nextNode) {
-        if (strcmp(currentNode->key, pcKey) == 0) {
-            return (void*) currentNode->value;
-        } 
+static void SymTable_treeUnravel(struct treeNode *psRoot,
+   struct node **ppsBuckets, size_t uCount) {
+    struct treeNode *psRight;
+    struct node *psNode;
+    while (psRoot != NULL) {
+        SymTable_treeUnravel(psRoot->leftNode, ppsBuckets, uCount);
+        psRight = psRoot->rightNode;
+        psNode = psRoot->node;
+        psNode->nextNode = ppsBuckets[psNode->hash % uCount];
+        ppsBuckets[psNode->hash % uCount] = psNode;
+        free(psRoot);
+        psRoot = psRight;
     }
-    return NULL;
 }
 
-void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
-    /*traveling node*/
+/* Return the number of pages of a snapshot of a table with uBuckets
+   buckets. */
+
+static size_t SymTable_pageCount(size_t uBuckets) {
+    return (uBuckets + SNAPSHOT_PAGE - 1) / SNAPSHOT_PAGE;
+}
+
+/* Return a copy of psNode made with malloc, counted in the statistics
+   of oSymTable, or NULL if insufficient memory is available. */
+
+static struct node *SymTable_copyNode(SymTable_T oSymTable,
+   const struct node *psNode) {
+    size_t uSize = offsetof(struct node, key) + psNode->keyLength + 1;
+    struct node *psCopy;
+    /* a full node size, so that a clone may pool the copy*/
+    psCopy = (struct node*) malloc(SymTable_nodeSize(psNode->keyLength));
+    if (psCopy != NULL) {
+        SYMTABLE_COUNT(oSymTable, uAllocs);
+        memcpy(psCopy, psNode, uSize);
+    }
+    return psCopy;
+}
+
+/* Return a copy of the tree psRoot and of its nodes, counted in the
+   statistics of oSymTable. If insufficient memory is available, or
+   *piSuccessful is already 0 (FALSE), set *piSuccessful to 0 and
+   return NULL. */
+
+static struct treeNode *SymTable_treeCopy(SymTable_T oSymTable,
+   const struct treeNode *psRoot, int *piSuccessful) {
+    struct treeNode *psCopy;
+    if (psRoot == NULL || ! *piSuccessful)
+        return NULL;
+    psCopy = (struct treeNode*) malloc(sizeof(struct treeNode));
+    if (psCopy == NULL) {
+        *piSuccessful = 0;
+        return NULL;
+    }
+    SYMTABLE_COUNT(oSymTable, uAllocs);
+    psCopy->priority = psRoot->priority;
+    psCopy->node = SymTable_copyNode(oSymTable, psRoot->node);
+    *piSuccessful = psCopy->node != NULL;
+    psCopy->leftNode = SymTable_treeCopy(oSymTable, psRoot->leftNode,
+        piSuccessful);
+    psCopy->rightNode = SymTable_treeCopy(oSymTable, psRoot->rightNode,
+        piSuccessful);
+    if (! *piSuccessful) {
+        SymTable_treeFree(psCopy, NULL);
+        return NULL;
+    }
+    return psCopy;
+}
+
+/* Free psPage with every node and tree node it holds, counting in the
+   statistics of oSnapshot. */
+
+static void SymTable_freePage(SymTable_T oSnapshot,
+   struct snapshotPage *psPage) {
     struct node *currentNode;
-    struct node *prevNode = NULL;
-    size_t hashIndex = SymTable_hash(pcKey, 509);
-    assert(oSymTable != NULL);
-    assert(pcKey != NULL);
-    
-     /* loops through all the nodes in search for pcKey*/
-    for (currentNode = (struct node*) oSymTable->firstNodes[hashIndex]; currentNode != NULL; 
-            currentNode = currentNode -> nextNode) {
-        if (strcmp(currentNode->key, pcKey) == 0) {
-            const void* oldValue;
-            /*save the currentNode's value*/
-            oldValue = currentNode->value;
-            /* relink the list*/
-            /*if prevNode is at the beginning of the list*/
-            if (prevNode == NULL) {
-                oSymTable->firstNodes[hashIndex] = (struct node**) currentNode->nextNode;
-            }
-            else {
-                prevNode->nextNode = currentNode->nextNode;
-            }
-            free((char*) currentNode->key);
+    struct node *nextNode;
+    size_t u;
+    for (u = 0; u < SNAPSHOT_PAGE; u++) {
+        for (currentNode = psPage->firstNodes[u]; currentNode != NULL;
+                currentNode = nextNode) {
+            nextNode = currentNode->nextNode;
             free(currentNode);
-            oSymTable->length--;
+            SYMTABLE_COUNT(oSnapshot, uFrees);
+        }
+        SymTable_treeFree(psPage->treeRoots[u], NULL);
+    }
+    free(psPage);
+    SYMTABLE_COUNT(oSnapshot, uFrees);
+}
+
+/* Give snapshot oSnapshot its own copy of page uPage of its live
+   table unless it has one already. Return 1 (TRUE) on success, or
+   0 (FALSE) if insufficient memory is available. */
+
+static int SymTable_preservePage(SymTable_T oSnapshot, size_t uPage) {
+    struct snapshot *psSnapshot = oSnapshot->snapshot;
+    SymTable_T oSource = psSnapshot->source;
+    struct snapshotPage *psPage;
+    struct node **ppsLink;
+    const struct node *currentNode;
+    size_t uPages = SymTable_pageCount(oSnapshot->numOfcells);
+    size_t uBucket;
+    size_t u;
+    int iSuccessful = 1;
+
+    if (psSnapshot->pages == NULL) {
+        psSnapshot->pages = (struct snapshotPage**)
+            malloc(uPages * sizeof(struct snapshotPage*));
+        if (psSnapshot->pages == NULL)
+            return 0;
+        SYMTABLE_COUNT(oSource, uAllocs);
+        for (u = 0; u < uPages; u++)
+            psSnapshot->pages[u] = NULL;
+    }
+    if (psSnapshot->pages[uPage] != NULL)
+        return 1;
 
-            return (void*) oldValue;
-        } 
-        prevNode = currentNode;
+    psPage = (struct snapshotPage*) malloc(sizeof(struct snapshotPage));
+    if (psPage == NULL)
+        return 0;
+    SYMTABLE_COUNT(oSource, uAllocs);
+    for (u = 0; u < SNAPSHOT_PAGE; u++) {
+        psPage->firstNodes[u] = NULL;
+        psPage->treeRoots[u] = NULL;
     }
-    return NULL;
- 
+    /* copies each chain in order, and each tree with its shape*/
+    for (u = 0; u < SNAPSHOT_PAGE && iSuccessful; u++) {
+        uBucket = uPage * SNAPSHOT_PAGE + u;
+        if (uBucket >= oSnapshot->numOfcells)
+            break;
+        ppsLink = &psPage->firstNodes[u];
+        for (currentNode = oSource->firstNodes[uBucket];
+                currentNode != NULL && iSuccessful;
+                currentNode = currentNode->nextNode) {
+            *ppsLink = SymTable_copyNode(oSource, currentNode);
+            iSuccessful = *ppsLink != NULL;
+            if (iSuccessful) {
+                (*ppsLink)->nextNode = NULL;
+                ppsLink = &(*ppsLink)->nextNode;
+            }
+        }
+        if (oSource->treeRoots != NULL)
+            psPage->treeRoots[u] = SymTable_treeCopy(oSource,
+                oSource->treeRoots[uBucket], &iSuccessful);
+    }
+    if (! iSuccessful) {
+        SymTable_freePage(oSnapshot, psPage);
+        return 0;
     }
+    psSnapshot->pages[uPage] = psPage;
+    return 1;
+}
 
- void SymTable_map(SymTable_T oSymTable,
-     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
-     const void *pvExtra) {
-        /* traveling node*/
-        struct node *currentNode;
-        assert(oSymTable != NULL);
-        assert(pfApply != NULL);
+/* Give every snapshot of live table oSymTable, which has snapshots,
+   its own copy of the page holding bucket uBucket, which is about to
+   change. Return
+   1 (TRUE) on success, or 0 (FALSE) if insufficient memory is
+   available. */
+
+static int SymTable_preserve(SymTable_T oSymTable, size_t uBucket) {
+    SymTable_T oSnapshot;
+    for (oSnapshot = oSymTable->snapshot->first; oSnapshot != NULL;
+            oSnapshot = oSnapshot->snapshot->next)
+        if (! SymTable_preservePage(oSnapshot, uBucket / SNAPSHOT_PAGE))
+            return 0;
+    return 1;
+}
+
+/* Give every snapshot of live table oSymTable its own copy of every
+   page, so that none reads the buckets of oSymTable any more, before
+   all of them change at once. Return 1 (TRUE) on success, or
+   0 (FALSE) if insufficient memory is available, in which case the
+   snapshots not yet detached still read oSymTable. */
+
+static int SymTable_detachSnapshots(SymTable_T oSymTable) {
+    struct snapshot *psLive = oSymTable->snapshot;
+    SymTable_T oSnapshot;
+    size_t uPages = SymTable_pageCount(oSymTable->numOfcells);
+    size_t u;
+    while (psLive != NULL && psLive->first != NULL) {
+        oSnapshot = psLive->first;
+        for (u = 0; u < uPages; u++)
+            if (! SymTable_preservePage(oSnapshot, u))
+                return 0;
+        oSnapshot->snapshot->source = NULL;
+        psLive->first = oSnapshot->snapshot->next;
+        oSnapshot->snapshot->next = NULL;
+    }
+    return 1;
+}
+
+/* Apply pfApply to every binding of the bucket whose chain is
+   psFirst and whose tree is psRoot, passing pvExtra. */
+
+static void SymTable_mapBucket(const struct node *psFirst,
+   const struct treeNode *psRoot,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   void *pvExtra) {
+    for (; psFirst != NULL; psFirst = psFirst->nextNode)
+        (*pfApply)(psFirst->key, (void*)psFirst->value, pvExtra);
+    SymTable_treeMap(psRoot, pfApply, pvExtra);
+}
+
+/* Return the 32 bits of hash code uHash that pick a block of a
+   filter. The bits set in the block come from the low 32 bits of the
+   code, so a 64-bit code picks the block with its high half; a 32-bit
+   code has no other bits, and picks it with a multiple of itself
+   whose high bits differ from those of every salted multiple.*/
+
+static uint32_t SymTable_filterSelector(size_t uHash) {
+#if SIZE_MAX > 0xffffffffu
+    return (uint32_t)((uint64_t)uHash >> 32);
+#else
+    return (uint32_t)uHash * (uint32_t)0x9e3779b1u;
+#endif
+}
+
+/* Return the block of the filter of oSymTable that hash code uHash
+   sets bits in. */
+
+static uint32_t *SymTable_filterBlock(SymTable_T oSymTable, size_t uHash) {
+    return oSymTable->filterBlocks[(size_t)(
+        ((uint64_t)SymTable_filterSelector(uHash) *
+        (uint64_t)oSymTable->filterBlockCount) >> 32)];
+}
+
+/* Set the bits of hash code uHash in the filter of oSymTable. */
+
+static void SymTable_filterAdd(SymTable_T oSymTable, size_t uHash) {
+    uint32_t *puBlock = SymTable_filterBlock(oSymTable, uHash);
+    size_t u;
+    for (u = 0; u < FILTER_WORDS; u++)
+        puBlock[u] |= (uint32_t)1 <<
+            (((uint32_t)uHash * auFilterSalts[u]) >> 27);
+}
+
+/* Return 0 (FALSE) if no key of oSymTable has hash code uHash, going
+   by its filter, and 1 (TRUE) if one may have. */
+
+static int SymTable_filterMayHold(SymTable_T oSymTable, size_t uHash) {
+    const uint32_t *puBlock = SymTable_filterBlock(oSymTable, uHash);
+    uint32_t uMissing = 0;
+    size_t u;
+    /* tests every word without branching, since whether a word rules
+       the key out cannot be predicted*/
+    for (u = 0; u < FILTER_WORDS; u++)
+        uMissing |= ~puBlock[u] & ((uint32_t)1 <<
+            (((uint32_t)uHash * auFilterSalts[u]) >> 27));
+    return uMissing == 0;
+}
+
+/* Set the bits of every key of the tree psRoot in the filter of
+   oSymTable. */
+
+static void SymTable_treeFilter(SymTable_T oSymTable,
+   const struct treeNode *psRoot) {
+    for (; psRoot != NULL; psRoot = psRoot->rightNode) {
+        SymTable_treeFilter(oSymTable, psRoot->leftNode);
+        SymTable_filterAdd(oSymTable, psRoot->node->hash);
+    }
+}
+
+/* Give live table oSymTable an empty filter sized for its bucket
+   count, replacing the one it has. Return 1 (TRUE) on success, or 0
+   (FALSE) if insufficient memory is available, in which case
+   oSymTable keeps its filter. */
+
+static int SymTable_emptyFilter(SymTable_T oSymTable) {
+    uint32_t (*pauBlocks)[FILTER_WORDS];
+    size_t uBlocks = oSymTable->numOfcells * FILTER_BITS /
+        (FILTER_WORDS * 32) + 1;
+
+    pauBlocks = (uint32_t (*)[FILTER_WORDS])
+        malloc(uBlocks * sizeof(*pauBlocks));
+    if (pauBlocks == NULL)
+        return 0;
+    SYMTABLE_COUNT(oSymTable, uAllocs);
+    memset(pauBlocks, 0, uBlocks * sizeof(*pauBlocks));
+    if (oSymTable->filterBlocks != NULL) {
+        free(oSymTable->filterBlocks);
+        SYMTABLE_COUNT(oSymTable, uFrees);
+    }
+    oSymTable->filterBlocks = pauBlocks;
+    oSymTable->filterBlockCount = uBlocks;
+    oSymTable->filterRemoves = 0;
+    return 1;
+}
+
+/* Give live table oSymTable a filter sized for its bucket count that
+   holds exactly its keys, replacing the one it has. Return 1 (TRUE)
+   on success, or 0 (FALSE) if insufficient memory is available, in
+   which case oSymTable keeps its filter, which still holds every key
+   it has. */
+
+static int SymTable_buildFilter(SymTable_T oSymTable) {
+    const struct node *currentNode;
+    size_t u;
 
-        for (currentNode = (struct node*) oSymTable->firstNodes[0]; 
-               currentNode != NULL; currentNode = currentNode->nextNode)
-      (*pfApply)(currentNode->key, (void*)currentNode->value, (void*)pvExtra);
-     }
\ No newline at end of file
+    if (! SymTable_emptyFilter(oSymTable))
+        return 0;
+    for (u = 0; u < oSymTable->numOfcells; u++) {
+        for (currentNode = oSymTable->firstNodes[u]; currentNode != NULL;
+                currentNode = currentNode->nextNode)
+            SymTable_filterAdd(oSymTable, currentNode->hash);
+        if (oSymTable->treeRoots != NULL)
+            SymTable_treeFilter(oSymTable, oSymTable->treeRoots[u]);
+    }
+    return 1;
+}
+
+/* Move every binding of oSymTable into auBucketCounts[uStep] new
+   buckets. Nodes keep their full hash codes, so no key is hashed
+   again. Tree buckets are turned back into chains, and any new bucket
+   that reaches the tree threshold is converted again. Return 1 (TRUE)
+   on success, or 0 (FALSE) if insufficient memory is available, in
+   which case oSymTable is unchanged. */
+
+static int SymTable_rehash(SymTable_T oSymTable, size_t uStep) {
+    size_t uCount = auBucketCounts[uStep];
+    struct node **ppsBuckets;
+    struct node *currentNode;
+    struct node *nextNode;
+    size_t uLength;
+    size_t u;
+    int iFilter;
+
+    /* every bucket moves, so snapshots stop reading them first*/
+    if (! SymTable_detachSnapshots(oSymTable))
+        return 0;
+    ppsBuckets = (struct node**) malloc(uCount * sizeof(struct node*));
+    if (ppsBuckets == NULL)
+        return 0;
+    SYMTABLE_COUNT(oSymTable, uAllocs);
+    for (u = 0; u < uCount; u++)
+        ppsBuckets[u] = NULL;
+
+    for (u = 0; u < oSymTable->numOfcells; u++) {
+        for (currentNode = oSymTable->firstNodes[u]; currentNode != NULL;
+                currentNode = nextNode) {
+            nextNode = currentNode->nextNode;
+            currentNode->nextNode = ppsBuckets[currentNode->hash % uCount];
+            ppsBuckets[currentNode->hash % uCount] = currentNode;
+        }
+        if (oSymTable->treeRoots != NULL)
+            SymTable_treeUnravel(oSymTable->treeRoots[u], ppsBuckets,
+                uCount);
+    }
+
+    free(oSymTable->firstNodes);
+    free(oSymTable->treeRoots);
+    SYMTABLE_COUNT(oSymTable, uFrees);
+    oSymTable->firstNodes = ppsBuckets;
+    oSymTable->treeRoots = NULL;
+    oSymTable->numOfcells = uCount;
+    oSymTable->bucketStep = uStep;
+
+    /* resizes the filter with the table, filling it in the pass that
+       looks for chains to treeify; if there is no memory for it the
+       old one still holds every key*/
+    iFilter = oSymTable->filterBlocks != NULL &&
+        SymTable_emptyFilter(oSymTable);
+    if (oSymTable->treeThreshold != 0 || iFilter)
+        for (u = 0; u < uCount; u++) {
+            uLength = 0;
+            for (currentNode = ppsBuckets[u]; currentNode != NULL;
+                    currentNode = currentNode->nextNode) {
+                if (iFilter)
+                    SymTable_filterAdd(oSymTable, currentNode->hash);
+                uLength++;
+            }
+            if (oSymTable->treeThreshold != 0 &&
+                    uLength >= oSymTable->treeThreshold)
+                SymTable_treeify(oSymTable, u);
+        }
+    return 1;
+}
+
+/* Give small live table oSymTable its bucket array and move its
+   bindings from their slots into the buckets, converting any bucket
+   that reaches the tree threshold. Return 1 (TRUE) on success or if
+   oSymTable has its buckets already, and 0 (FALSE) if insufficient
+   memory is available, in which case oSymTable stays small. */
+
+static int SymTable_spill(SymTable_T oSymTable) {
+    struct node **ppsBuckets;
+    struct node *currentNode;
+    size_t uBucket;
+    size_t uLength;
+    size_t u;
+
+    if (oSymTable->firstNodes != NULL)
+        return 1;
+    ppsBuckets = (struct node**)
+        malloc(oSymTable->numOfcells * sizeof(struct node*));
+    if (ppsBuckets == NULL)
+        return 0;
+    SYMTABLE_COUNT(oSymTable, uAllocs);
+    for (u = 0; u < oSymTable->numOfcells; u++)
+        ppsBuckets[u] = NULL;
+    for (u = 0; u < oSymTable->length; u++) {
+        currentNode = oSymTable->smallNodes[u];
+        uBucket = oSymTable->smallHashes[u] % oSymTable->numOfcells;
+        currentNode->nextNode = ppsBuckets[uBucket];
+        ppsBuckets[uBucket] = currentNode;
+    }
+    oSymTable->firstNodes = ppsBuckets;
+
+    if (oSymTable->treeThreshold != 0)
+        for (u = 0; u < oSymTable->length; u++) {
+            uBucket = oSymTable->smallHashes[u] % oSymTable->numOfcells;
+            uLength = 0;
+            for (currentNode = ppsBuckets[uBucket]; currentNode != NULL;
+                    currentNode = currentNode->nextNode)
+                uLength++;
+            if (uLength >= oSymTable->treeThreshold)
+                SymTable_treeify(oSymTable, uBucket);
+        }
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the node whose key is described by psLookup in the bucket
+   whose chain starts at *ppsFirst and whose tree is psRoot, or NULL if
+   there is none, counting in the statistics of oSymTable. For a chain
+   bucket, set psLookup->ppLink to the link that points to the node
+   found and psLookup->uDepth to the number of nodes visited. */
+
+static struct node *SymTable_findIn(SymTable_T oSymTable,
+   struct node **ppsFirst, const struct treeNode *psRoot,
+   struct lookup *psLookup) {
+    struct node **ppLink;
+    struct node *currentNode;
+    const struct treeNode *psTreeNode;
+    int iCompare;
+
+    if (psRoot != NULL) {
+        psTreeNode = psRoot;
+        while (psTreeNode != NULL) {
+            SYMTABLE_COUNT(oSymTable, uProbes);
+            iCompare = SymTable_compare(psLookup->uHash,
+                psLookup->uLength, psLookup->pcKey, psTreeNode->node);
+            if (iCompare == 0) {
+                SYMTABLE_COUNT(oSymTable, uKeyCompares);
+                SYMTABLE_COUNT(oSymTable, uHits);
+                return psTreeNode->node;
+            }
+            psTreeNode = iCompare < 0 ? psTreeNode->leftNode :
+                psTreeNode->rightNode;
+        }
+        SYMTABLE_COUNT(oSymTable, uMisses);
+        return NULL;
+    }
+
+    ppLink = ppsFirst;
+    /* loops through the bucket comparing hash codes and lengths, and
+       compares characters only when both match*/
+    for (currentNode = *ppLink; currentNode != NULL;
+            ppLink = &currentNode->nextNode,
+            currentNode = currentNode->nextNode) {
+        SYMTABLE_COUNT(oSymTable, uProbes);
+        psLookup->uDepth++;
+        if (currentNode->hash == psLookup->uHash &&
+                currentNode->keyLength == psLookup->uLength) {
+            SYMTABLE_COUNT(oSymTable, uKeyCompares);
+            if (memcmp(currentNode->key, psLookup->pcKey,
+                    psLookup->uLength) == 0) {
+                SYMTABLE_COUNT(oSymTable, uHits);
+                psLookup->ppLink = ppLink;
+                return currentNode;
+            }
+        }
+    }
+    SYMTABLE_COUNT(oSymTable, uMisses);
+    return NULL;
+}
+
+/* Return the node of small live table oSymTable whose key is
+   described by psLookup, or NULL if there is none, counting in the
+   statistics of oSymTable. Set psLookup->ppLink to the slot that holds
+   the node found. */
+
+static struct node *SymTable_findSmall(SymTable_T oSymTable,
+   struct lookup *psLookup) {
+    struct node *currentNode;
+    size_t u;
+
+    /* compares the hash codes in the table itself, and visits a node
+       only when its code matches*/
+    for (u = 0; u < oSymTable->length; u++) {
+        SYMTABLE_COUNT(oSymTable, uProbes);
+        if (oSymTable->smallHashes[u] != psLookup->uHash)
+            continue;
+        currentNode = oSymTable->smallNodes[u];
+        if (currentNode->keyLength == psLookup->uLength) {
+            SYMTABLE_COUNT(oSymTable, uKeyCompares);
+            if (memcmp(currentNode->key, psLookup->pcKey,
+                    psLookup->uLength) == 0) {
+                SYMTABLE_COUNT(oSymTable, uHits);
+                psLookup->ppLink = &oSymTable->smallNodes[u];
+                return currentNode;
+            }
+        }
+    }
+    SYMTABLE_COUNT(oSymTable, uMisses);
+    return NULL;
+}
+
+/* Return the node of live table oSymTable whose key is described by
+   psLookup, or NULL if there is none, as SymTable_findIn does. */
+
+static struct node *SymTable_find(SymTable_T oSymTable,
+   struct lookup *psLookup) {
+    if (oSymTable->firstNodes == NULL)
+        return SymTable_findSmall(oSymTable, psLookup);
+    if (oSymTable->filterBlocks != NULL &&
+            ! SymTable_filterMayHold(oSymTable, psLookup->uHash)) {
+        SYMTABLE_COUNT(oSymTable, uMisses);
+        return NULL;
+    }
+    return SymTable_findIn(oSymTable,
+        &oSymTable->firstNodes[psLookup->uBucket],
+        oSymTable->treeRoots == NULL ? NULL :
+            oSymTable->treeRoots[psLookup->uBucket],
+        psLookup);
+}
+
+/* Return the node of snapshot oSnapshot whose key is described by
+   psLookup, or NULL if there is none: from the snapshot's page for
+   the key's bucket if it has one, and from its live table's bucket,
+   which has not changed since the snapshot was taken, otherwise. */
+
+static struct node *SymTable_findSnapshot(SymTable_T oSnapshot,
+   struct lookup *psLookup) {
+    SymTable_T oSource = oSnapshot->snapshot->source;
+    struct snapshotPage *psPage = NULL;
+    size_t uBucket = psLookup->uBucket;
+    if (oSnapshot->snapshot->pages != NULL)
+        psPage = oSnapshot->snapshot->pages[uBucket / SNAPSHOT_PAGE];
+    if (psPage != NULL)
+        return SymTable_findIn(oSnapshot,
+            &psPage->firstNodes[uBucket % SNAPSHOT_PAGE],
+            psPage->treeRoots[uBucket % SNAPSHOT_PAGE], psLookup);
+    return SymTable_findIn(oSnapshot, &oSource->firstNodes[uBucket],
+        oSource->treeRoots == NULL ? NULL : oSource->treeRoots[uBucket],
+        psLookup);
+}
+
+/* Lock the shard of sharded table oSymTable that holds the key
+   described by psLookup, point psLookup->uBucket at the key's bucket
+   in it, and return the shard. The top bits of the hash code pick the
+   shard, and the bucket counts, which are prime, use all of them. */
+
+static struct shard *SymTable_lockShard(SymTable_T oSymTable,
+   struct lookup *psLookup) {
+    struct sharded *psSharded = oSymTable->sharded;
+    struct shard *psShard = &psSharded->shards[0].shard;
+    if (psSharded->bits != 0)
+        psShard = &psSharded->shards[psLookup->uHash >>
+            (sizeof(size_t) * CHAR_BIT - psSharded->bits)].shard;
+    pthread_mutex_lock(&psShard->lock);
+    /* the shard resizes on its own, so its bucket is found under its
+       lock*/
+    psLookup->uBucket = psLookup->uHash % psShard->table->numOfcells;
+    return psShard;
+}
+
+/* Count the change of the length of the table of psShard, a shard
+   of sharded table oSymTable whose lock the caller holds, from
+   uLength in the stripe of the calling thread, and unlock the shard.
+   The count is made under the lock, so no other thread sees the
+   change before it is counted. */
+
+static void SymTable_unlockCounted(SymTable_T oSymTable,
+   struct shard *psShard, size_t uLength) {
+    struct stripe *psStripe;
+    if (uThreadStripe == 0)
+        uThreadStripe = __atomic_fetch_add(&uStripeThreads, 1,
+            __ATOMIC_RELAXED) % LENGTH_STRIPES + 1;
+    psStripe = &oSymTable->sharded->stripes[uThreadStripe - 1].stripe;
+    if (psShard->table->length > uLength)
+        __atomic_fetch_add(&psStripe->added,
+            psShard->table->length - uLength, __ATOMIC_SEQ_CST);
+    else if (psShard->table->length < uLength)
+        __atomic_fetch_add(&psStripe->removed,
+            uLength - psShard->table->length, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&psShard->lock);
+}
+
+/* Store in *puAdded and *puRemoved the bindings the stripes of sharded
+   table oSymTable have counted as added and removed. The removes are
+   read before the adds, so every binding counted as removed is also
+   counted as added. */
+
+static void SymTable_readStripes(SymTable_T oSymTable, size_t *puAdded,
+   size_t *puRemoved) {
+    union stripeLine *psStripes = oSymTable->sharded->stripes;
+    size_t u;
+    *puAdded = 0;
+    *puRemoved = 0;
+    for (u = 0; u < LENGTH_STRIPES; u++)
+        *puRemoved += __atomic_load_n(&psStripes[u].stripe.removed,
+            __ATOMIC_SEQ_CST);
+    for (u = 0; u < LENGTH_STRIPES; u++)
+        *puAdded += __atomic_load_n(&psStripes[u].stripe.added,
+            __ATOMIC_SEQ_CST);
+}
+
+/* Return the entry of mapped table oSymTable whose key is described
+   by psLookup, or NULL if there is none. */
+
+static const struct imageEntry *SymTable_findEntry(SymTable_T oSymTable,
+   const struct lookup *psLookup) {
+    const struct imageEntry *psEntry;
+    const struct imageEntry *psEnd;
+
+    psEntry = oSymTable->mapped->entries +
+        oSymTable->mapped->starts[psLookup->uBucket];
+    psEnd = oSymTable->mapped->entries +
+        oSymTable->mapped->starts[psLookup->uBucket + 1];
+    /* the entries of a bucket are adjacent, so a probe walks an array
+       instead of following links*/
+    for (; psEntry != psEnd; psEntry++) {
+        SYMTABLE_COUNT(oSymTable, uProbes);
+        if (psEntry->hash == (uint64_t)psLookup->uHash &&
+                psEntry->keyLength == (uint64_t)psLookup->uLength) {
+            SYMTABLE_COUNT(oSymTable, uKeyCompares);
+            if (memcmp(oSymTable->mapped->image + psEntry->keyOffset,
+                    psLookup->pcKey, psLookup->uLength) == 0) {
+                SYMTABLE_COUNT(oSymTable, uHits);
+                return psEntry;
+            }
+        }
+    }
+    SYMTABLE_COUNT(oSymTable, uMisses);
+    return NULL;
+}
+
+/* the constant that derives the two slot functions of a frozen table
+   from a key's hash code */
+#define FROZEN_SALT ((uint64_t)0x8ebc6af09c88c6e3u)
+
+/* Return the product of the 32-bit number uBits and uRange, shifted
+   down 32 bits: a number below uRange, obtained without a division.
+   uRange must be below 2^32. */
+
+static uint64_t SymTable_scale(uint64_t uBits, uint64_t uRange) {
+    return ((uBits & 0xffffffffu) * uRange) >> 32;
+}
+
+/* Return the bucket of a frozen table with uBuckets buckets that a key
+   with hash code uHash belongs to. */
+
+static size_t SymTable_frozenBucket(size_t uHash, size_t uBuckets) {
+    return (size_t)SymTable_scale((uint64_t)uHash, (uint64_t)uBuckets);
+}
+
+/* Store in *puF1 and *puF2 the two slot functions of a key with hash
+   code uHash in a frozen table with uSlots slots. */
+
+static void SymTable_frozenFunctions(size_t uHash, uint64_t uSlots,
+   uint64_t *puF1, uint64_t *puF2) {
+    uint64_t uMixed = SymTable_mix((uint64_t)uHash ^ FROZEN_SALT);
+    *puF1 = SymTable_scale(uMixed >> 32, uSlots);
+    *puF2 = SymTable_scale(uMixed, uSlots);
+}
+
+/* Return the slot of frozen table oSymTable that the key with hash
+   code uHash occupies if it is in the table. */
+
+static size_t SymTable_frozenSlot(SymTable_T oSymTable, size_t uHash) {
+    const struct displacement *psDisplacement;
+    uint64_t uSlots = (uint64_t)oSymTable->frozen->slots;
+    uint64_t uF1;
+    uint64_t uF2;
+    SymTable_frozenFunctions(uHash, uSlots, &uF1, &uF2);
+    psDisplacement = &oSymTable->frozen->displacements[
+        SymTable_frozenBucket(uHash, oSymTable->numOfcells)];
+    return (size_t)((uF1 + psDisplacement->d0 * uF2 + psDisplacement->d1)
+        % uSlots);
+}
+
+/* Return the slot of frozen table oSymTable whose key is described by
+   psLookup, or NULL if there is none. Exactly one slot is examined. */
+
+static const struct frozenEntry *SymTable_findFrozen(SymTable_T oSymTable,
+   const struct lookup *psLookup) {
+    const struct frozenEntry *psEntry;
+    psEntry = &oSymTable->frozen->entries[
+        SymTable_frozenSlot(oSymTable, psLookup->uHash)];
+    SYMTABLE_COUNT(oSymTable, uProbes);
+    if (psEntry->key != NULL && psEntry->hash == psLookup->uHash &&
+            psEntry->keyLength == psLookup->uLength) {
+        SYMTABLE_COUNT(oSymTable, uKeyCompares);
+        if (memcmp(psEntry->key, psLookup->pcKey, psLookup->uLength) == 0) {
+            SYMTABLE_COUNT(oSymTable, uHits);
+            return psEntry;
+        }
+    }
+    SYMTABLE_COUNT(oSymTable, uMisses);
+    return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set every field of oSymTable for a table of mode eMode, hashed
+   under the key uSeed0 and uSeed1, that is empty, small, untraced and
+   without a destructor, and has no state of another mode. */
+
+static void SymTable_initFields(SymTable_T oSymTable, enum TableMode eMode,
+   uint64_t uSeed0, uint64_t uSeed1) {
+    size_t u;
+
+    oSymTable->mode = eMode;
+    oSymTable->mapped = NULL;
+    oSymTable->frozen = NULL;
+    oSymTable->sharded = NULL;
+    oSymTable->firstNodes = NULL;
+    oSymTable->treeRoots = NULL;
+    oSymTable->snapshot = NULL;
+    oSymTable->length = 0;
+    oSymTable->numOfcells = auBucketCounts[0];
+    oSymTable->bucketStep = 0;
+    oSymTable->treeThreshold = 0;
+    oSymTable->seed[0] = uSeed0;
+    oSymTable->seed[1] = uSeed1;
+    oSymTable->freeValue = NULL;
+    oSymTable->filterBlocks = NULL;
+    oSymTable->filterBlockCount = 0;
+    oSymTable->filterRemoves = 0;
+    for (u = 0; u < POOL_CLASSES; u++)
+        oSymTable->freeNodes[u] = NULL;
+    oSymTable->writer = NULL;
+    oSymTable->trace = NULL;
+#ifdef SYMTABLE_STATS
+    memset(&oSymTable->sStats, 0, sizeof(oSymTable->sStats));
+#endif
+}
+
+SymTable_T SymTable_newSeeded(uint64_t uSeed0, uint64_t uSeed1) {
+    SymTable_T oSymTable;
+
+/* allocate space for the managing structure */
+   oSymTable = (SymTable_T) malloc(sizeof(struct SymTable));
+   if (oSymTable == NULL)
+      return NULL;
+
+   /* the table starts small; its buckets come with its first binding
+      beyond SMALL_SLOTS*/
+   SymTable_initFields(oSymTable, MODE_LIVE, uSeed0, uSeed1);
+   oSymTable->treeThreshold = TREE_THRESHOLD;
+   return oSymTable;
+}
+
+SymTable_T SymTable_new(void) {
+    uint64_t auSeed[2];
+    SymTable_randomSeed(auSeed);
+    return SymTable_newSeeded(auSeed[0], auSeed[1]);
+}
+
+SymTable_T SymTable_newWithDestructor(void (*pfFreeValue)(void *pvValue)) {
+    SymTable_T oSymTable;
+    assert(pfFreeValue != NULL);
+    oSymTable = SymTable_new();
+    if (oSymTable != NULL)
+        oSymTable->freeValue = pfFreeValue;
+    return oSymTable;
+}
+
+/* Free sharded table oSymTable with its shards. */
+
+static void SymTable_freeSharded(SymTable_T oSymTable) {
+   struct sharded *psSharded = oSymTable->sharded;
+   size_t u;
+   for (u = 0; u < psSharded->count; u++) {
+      pthread_mutex_destroy(&psSharded->shards[u].shard.lock);
+      SymTable_free(psSharded->shards[u].shard.table);
+   }
+   free(psSharded->shards);
+   free(psSharded->stripes);
+   free(psSharded);
+   free(oSymTable);
+}
+
+SymTable_T SymTable_newSharded(size_t uShards) {
+    SymTable_T oSymTable;
+    struct sharded *psSharded;
+    struct shard *psShard;
+    size_t uBits = 0;
+
+    if (uShards == 0 || uShards > MAX_SHARDS)
+        return NULL;
+    while (((size_t)1 << uBits) < uShards)
+        uBits++;
+    /* the shards hash with the key of the front, so a key is hashed
+       once per operation*/
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL)
+        return NULL;
+    psSharded = (struct sharded*)malloc(sizeof(struct sharded));
+    if (psSharded == NULL) {
+        SymTable_free(oSymTable);
+        return NULL;
+    }
+    psSharded->count = 0;
+    psSharded->bits = uBits;
+    psSharded->stripes = NULL;
+    if (posix_memalign((void**)&psSharded->shards, CACHE_LINE,
+            ((size_t)1 << uBits) * sizeof(union shardLine)) != 0) {
+        free(psSharded);
+        SymTable_free(oSymTable);
+        return NULL;
+    }
+    oSymTable->mode = MODE_SHARDED;
+    oSymTable->sharded = psSharded;
+    if (posix_memalign((void**)&psSharded->stripes, CACHE_LINE,
+            LENGTH_STRIPES * sizeof(union stripeLine)) != 0) {
+        psSharded->stripes = NULL;
+        SymTable_freeSharded(oSymTable);
+        return NULL;
+    }
+    memset(psSharded->stripes, 0, LENGTH_STRIPES * sizeof(union stripeLine));
+    for (; psSharded->count < ((size_t)1 << uBits); psSharded->count++) {
+        psShard = &psSharded->shards[psSharded->count].shard;
+        psShard->table = SymTable_newSeeded(oSymTable->seed[0],
+            oSymTable->seed[1]);
+        if (psShard->table == NULL)
+            break;
+        if (pthread_mutex_init(&psShard->lock, NULL) != 0) {
+            SymTable_free(psShard->table);
+            break;
+        }
+    }
+    if (psSharded->count < ((size_t)1 << uBits)) {
+        SymTable_freeSharded(oSymTable);
+        return NULL;
+    }
+    return oSymTable;
+}
+
+/* Free live or retired table oSymTable with all of its nodes, and
+   its values and deferred values if it has a destructor. */
+
+static void SymTable_freeLive(SymTable_T oSymTable) {
+   struct node *currentNode;
+   struct node *nextNode;
+   size_t u;
+
+   SymTable_destroyDeferred(oSymTable);
+
+   for (u = 0; oSymTable->firstNodes == NULL && u < oSymTable->length;
+         u++)
+   {
+      if (oSymTable->freeValue != NULL)
+         (*oSymTable->freeValue)((void*)oSymTable->smallNodes[u]->value);
+      free(oSymTable->smallNodes[u]);
+   }
+   for (u = 0; oSymTable->firstNodes != NULL && u < oSymTable->numOfcells;
+         u++)
+   {
+      for (currentNode = oSymTable->firstNodes[u];
+           currentNode != NULL;
+           currentNode = nextNode)
+      {
+         nextNode = currentNode->nextNode;
+         if (oSymTable->freeValue != NULL)
+            (*oSymTable->freeValue)((void*)currentNode->value);
+         free(currentNode);
+      }
+      if (oSymTable->treeRoots != NULL)
+         SymTable_treeFree(oSymTable->treeRoots[u], oSymTable->freeValue);
+   }
+
+   SymTable_freePool(oSymTable);
+   free(oSymTable->trace);
+   free(oSymTable->filterBlocks);
+   free(oSymTable->treeRoots);
+   free(oSymTable->firstNodes);
+   free(oSymTable);
+}
+
+/* Free the writer of live table oSymTable, if it has one, with the
+   puts still in its log. */
+
+static void SymTable_freeWriter(SymTable_T oSymTable) {
+   if (oSymTable->writer == NULL)
+      return;
+   free(oSymTable->writer->entries);
+   free(oSymTable->writer->keys);
+   free(oSymTable->writer);
+   oSymTable->writer = NULL;
+}
+
+/* Free frozen table oSymTable with its slots and keys, or a table
+   that SymTable_freeze has not finished freezing. */
+
+static void SymTable_freeFrozen(SymTable_T oSymTable) {
+   if (oSymTable->frozen != NULL) {
+      free(oSymTable->frozen->entries);
+      free(oSymTable->frozen->displacements);
+      free(oSymTable->frozen->keys);
+      free(oSymTable->frozen);
+   }
+   free(oSymTable);
+}
+
+/* Free snapshot oSnapshot with its pages, and unlink it from its live
+   table if it still reads that table's buckets. If oSnapshot was the
+   last snapshot of its live table, free the live table too if it is
+   retired, and destroy its deferred values otherwise. */
+
+static void SymTable_freeSnapshot(SymTable_T oSnapshot) {
+   struct snapshot *psSnapshot = oSnapshot->snapshot;
+   SymTable_T oSource = psSnapshot->source;
+   SymTable_T oOwner = psSnapshot->owner;
+   SymTable_T *poLink;
+   size_t u;
+
+   if (oSource != NULL) {
+      for (poLink = &oSource->snapshot->first; *poLink != oSnapshot;
+            poLink = &(*poLink)->snapshot->next)
+         ;
+      *poLink = psSnapshot->next;
+   }
+   if (psSnapshot->pages != NULL) {
+      for (u = 0; u < SymTable_pageCount(oSnapshot->numOfcells); u++)
+         if (psSnapshot->pages[u] != NULL)
+            SymTable_freePage(oSnapshot, psSnapshot->pages[u]);
+      free(psSnapshot->pages);
+   }
+   free(psSnapshot);
+   free(oSnapshot);
+
+   /* detached snapshots count too: they still return the values*/
+   if (--oOwner->snapshot->count != 0)
+      return;
+   if (oOwner->mode == MODE_RETIRED)
+      SymTable_freeLive(oOwner);
+   else
+      SymTable_destroyDeferred(oOwner);
+}
+
+void SymTable_free(SymTable_T oSymTable) {
+   assert(oSymTable != NULL);
+   assert(oSymTable->mode != MODE_RETIRED);
+
+   if (oSymTable->mode == MODE_MAPPED) {
+      munmap((void*)oSymTable->mapped->image, oSymTable->mapped->size);
+      free(oSymTable->mapped);
+      free(oSymTable);
+      return;
+   }
+   if (oSymTable->mode == MODE_FROZEN) {
+      SymTable_freeFrozen(oSymTable);
+      return;
+   }
+   if (oSymTable->mode == MODE_SNAPSHOT) {
+      SymTable_freeSnapshot(oSymTable);
+      return;
+   }
+   if (oSymTable->mode == MODE_SHARDED) {
+      SymTable_freeSharded(oSymTable);
+      return;
+   }
+   /* a table with a destructor makes the puts still in the log of a
+      writer, which binds or destroys their values; others discard
+      them, since their client owns the values and nothing can read
+      the bindings any more*/
+   if (oSymTable->freeValue != NULL && oSymTable->writer != NULL)
+      (void)SymTable_writerFlush(oSymTable, NULL);
+   SymTable_freeWriter(oSymTable);
+   if (oSymTable->snapshot != NULL) {
+      /* the snapshots still read the buckets or share the values; the
+         last one to be freed frees them*/
+      SymTable_freePool(oSymTable);
+      oSymTable->mode = MODE_RETIRED;
+      return;
+   }
+   SymTable_freeLive(oSymTable);
+}
+
+/* Bind the key described by psLookup to pvValue in live table
+   oSymTable unless it is bound already, as SymTable_putN does. */
+
+static int SymTable_insert(SymTable_T oSymTable, struct lookup *psLookup,
+   const void *pvValue) {
+    struct node *currentNode;
+    struct treeNode *psTreeNode;
+    if (oSymTable->firstNodes == NULL) {
+        if (SymTable_findSmall(oSymTable, psLookup) != NULL)
+            return 0;
+        /* a small table with every slot taken moves into buckets, and
+           the new node goes into its bucket as if it had been walked*/
+        if (oSymTable->length == SMALL_SLOTS) {
+            if (! SymTable_spill(oSymTable))
+                return 0;
+            for (currentNode = oSymTable->firstNodes[psLookup->uBucket];
+                    currentNode != NULL;
+                    currentNode = currentNode->nextNode)
+                psLookup->uDepth++;
+        }
+    }
+    /* walks the chain even when the filter rules the key out, since
+       the chain's length decides whether it becomes a tree*/
+    else if (SymTable_findIn(oSymTable,
+            &oSymTable->firstNodes[psLookup->uBucket],
+            oSymTable->treeRoots == NULL ? NULL :
+                oSymTable->treeRoots[psLookup->uBucket], psLookup) != NULL)
+        return 0;
+    if (oSymTable->snapshot != NULL &&
+            oSymTable->snapshot->first != NULL &&
+            ! SymTable_preserve(oSymTable, psLookup->uBucket))
+        return 0;
+    /*new key found*/
+    /* allocating enough space for new node and its key*/
+    currentNode = SymTable_allocNode(oSymTable, psLookup->uLength);
+    if (currentNode == NULL) {
+        return 0;
+    }
+    /*ready to fill the node*/
+    memcpy(currentNode->key, psLookup->pcKey, psLookup->uLength);
+    currentNode->key[psLookup->uLength] = '\0';
+    currentNode->hash = psLookup->uHash;
+    currentNode->keyLength = psLookup->uLength;
+    currentNode->value = pvValue;
+
+    if (oSymTable->firstNodes == NULL) {
+        /* adds the node to the first free slot*/
+        currentNode->nextNode = NULL;
+        oSymTable->smallNodes[oSymTable->length] = currentNode;
+        oSymTable->smallHashes[oSymTable->length] = psLookup->uHash;
+        oSymTable->length++;
+        return 1;
+    }
+    if (oSymTable->treeRoots != NULL &&
+            oSymTable->treeRoots[psLookup->uBucket] != NULL) {
+        /* adds the node to its tree bucket*/
+        psTreeNode = SymTable_newTreeNode(currentNode);
+        if (psTreeNode == NULL) {
+            free(currentNode);
+            SYMTABLE_COUNT(oSymTable, uFrees);
+            return 0;
+        }
+        SYMTABLE_COUNT(oSymTable, uAllocs);
+        currentNode->nextNode = NULL;
+        oSymTable->treeRoots[psLookup->uBucket] = SymTable_treeInsert(
+            oSymTable->treeRoots[psLookup->uBucket], psTreeNode);
+    }
+    else {
+        /* adds the node to the beginning of its bucket*/
+        currentNode->nextNode = oSymTable->firstNodes[psLookup->uBucket];
+        oSymTable->firstNodes[psLookup->uBucket] = currentNode;
+        if (oSymTable->treeThreshold != 0 &&
+                psLookup->uDepth + 1 >= oSymTable->treeThreshold)
+            SymTable_treeify(oSymTable, psLookup->uBucket);
+    }
+    oSymTable->length++;
+    if (oSymTable->filterBlocks != NULL)
+        SymTable_filterAdd(oSymTable, psLookup->uHash);
+    /* grows the table once the average bucket holds a binding; if
+       that fails the table keeps working with longer buckets*/
+    if (oSymTable->length > oSymTable->numOfcells &&
+            oSymTable->bucketStep + 1 < BUCKET_COUNT_STEPS)
+        (void)SymTable_rehash(oSymTable, oSymTable->bucketStep + 1);
+    return 1;
+}
+
+/* Group the uCount log entries at psEntries by bucket into
+   psGrouped: stably, by the top GROUP_BITS bits of their bucket
+   indexes, which are below uBuckets, so that each group's buckets
+   span a small part of the bucket array and the entries of one bucket
+   keep the order they were logged in. */
+
+static void SymTable_groupLogged(const struct logEntry *psEntries,
+   struct logEntry *psGrouped, size_t uCount, size_t uBuckets) {
+    size_t auStarts[1 << GROUP_BITS];
+    size_t uShift = 0;
+    size_t uGroup;
+    size_t uSum;
+    size_t u;
+
+    while ((uBuckets - 1) >> uShift >= ((size_t)1 << GROUP_BITS))
+        uShift++;
+    for (u = 0; u < ((size_t)1 << GROUP_BITS); u++)
+        auStarts[u] = 0;
+    for (u = 0; u < uCount; u++)
+        auStarts[psEntries[u].bucket >> uShift]++;
+    for (u = 0, uSum = 0; u < ((size_t)1 << GROUP_BITS); u++) {
+        uGroup = auStarts[u];
+        auStarts[u] = uSum;
+        uSum += uGroup;
+    }
+    for (u = 0; u < uCount; u++)
+        psGrouped[auStarts[psEntries[u].bucket >> uShift]++] = psEntries[u];
+}
+
+/* Apply the puts logged by the writer of live table oSymTable, as
+   SymTable_putN would have in the order they were logged, and empty
+   the log. The table first grows to the size the puts would leave it
+   at, so that no put resizes it, and the puts are made group by group
+   of nearby buckets, so the buckets are visited in address order and
+   the nodes of one bucket are allocated close together. A put that
+   fails for lack of memory is dropped. Return 1 (TRUE) if every put
+   was made or found its key bound, or 0 (FALSE) if any was dropped,
+   which the writer then records. */
+
+static int SymTable_applyLog(SymTable_T oSymTable) {
+    struct writer *psWriter = oSymTable->writer;
+    struct logEntry *psEntry;
+    struct logEntry *psScratch;
+    struct node *currentNode;
+    struct lookup sLookup;
+    size_t uTotal = oSymTable->length + psWriter->count;
+    size_t uStep = oSymTable->bucketStep;
+    size_t u;
+    int iSuccessful = 1;
+
+    while (uStep + 1 < BUCKET_COUNT_STEPS && auBucketCounts[uStep] < uTotal)
+        uStep++;
+    /* grows the table once to its final size; without the memory to
+       spill or grow it now, the puts spill and grow it as they go, and
+       those that still find no memory are dropped below*/
+    if ((uTotal <= SMALL_SLOTS || SymTable_spill(oSymTable)) &&
+            oSymTable->firstNodes != NULL && uStep > oSymTable->bucketStep)
+        (void)SymTable_rehash(oSymTable, uStep);
+
+    for (u = 0; u < psWriter->count; u++) {
+        psEntry = &psWriter->entries[u];
+        psEntry->bucket = psEntry->hash % oSymTable->numOfcells;
+    }
+    /* without memory to group in, the puts are made in log order*/
+    psScratch = (struct logEntry*)
+        malloc(psWriter->room * sizeof(struct logEntry));
+    if (psScratch != NULL) {
+        SymTable_groupLogged(psWriter->entries, psScratch, psWriter->count,
+            oSymTable->numOfcells);
+        free(psWriter->entries);
+        psWriter->entries = psScratch;
+    }
+
+    for (u = 0; u < psWriter->count; u++) {
+        psEntry = &psWriter->entries[u];
+        sLookup.pcKey = psWriter->keys + psEntry->keyOffset;
+        sLookup.uLength = psEntry->keyLength;
+        sLookup.uHash = psEntry->hash;
+        /* a put that grew the table moved the buckets*/
+        sLookup.uBucket = psEntry->hash % oSymTable->numOfcells;
+        sLookup.ppLink = NULL;
+        sLookup.uDepth = 0;
+        SYMTABLE_COUNT(oSymTable, uPuts);
+        if (SymTable_insert(oSymTable, &sLookup, psEntry->value)) {
+            psWriter->added++;
+            continue;
+        }
+        /* a put that bound nothing with its key unbound was dropped*/
+        sLookup.uBucket = psEntry->hash % oSymTable->numOfcells;
+        sLookup.ppLink = NULL;
+        sLookup.uDepth = 0;
+        currentNode = SymTable_find(oSymTable, &sLookup);
+        if (currentNode == NULL)
+            iSuccessful = 0;
+        /* a table with a destructor owns the value of a logged put, so
+           it destroys one that bound nothing, unless the key is bound
+           to that very value*/
+        if (oSymTable->freeValue != NULL &&
+                (currentNode == NULL || currentNode->value != psEntry->value))
+            (*oSymTable->freeValue)((void*)psEntry->value);
+    }
+    psWriter->count = 0;
+    psWriter->keySize = 0;
+    if (! iSuccessful)
+        psWriter->dropped = 1;
+    return iSuccessful;
+}
+
+/* Apply the puts logged by the writer of oSymTable, if any, so that
+   the table holds every binding its client has put. Every function
+   that reads or changes a live table calls this first; a put dropped
+   for lack of memory is reported by SymTable_writerFlush. */
+
+static void SymTable_settle(SymTable_T oSymTable) {
+    if (oSymTable->writer != NULL && oSymTable->writer->count != 0)
+        (void)SymTable_applyLog(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the reading of the monotonic clock, in nanoseconds. */
+
+static uint64_t SymTable_nanoseconds(void) {
+    struct timespec sTime;
+    clock_gettime(CLOCK_MONOTONIC, &sTime);
+    return (uint64_t)sTime.tv_sec * 1000000000u + (uint64_t)sTime.tv_nsec;
+}
+
+/* Return the index of the latency histogram bucket that counts a
+   latency of uNanoseconds. */
+
+static size_t SymTable_latencyBucket(uint64_t uNanoseconds) {
+    unsigned uShift;
+    if (uNanoseconds < LATENCY_SUB_BUCKETS)
+        return (size_t)uNanoseconds;
+    if (uNanoseconds >> LATENCY_LIMIT_BITS != 0)
+        return SYMTABLE_LATENCY_BUCKETS - 1;
+    /* the bits below the top LATENCY_SUB_BITS + 1 are dropped*/
+    uShift = (unsigned)(63 - __builtin_clzll(uNanoseconds)) -
+        LATENCY_SUB_BITS;
+    return (size_t)(uShift + 1) * LATENCY_SUB_BUCKETS +
+        (size_t)(uNanoseconds >> uShift) - LATENCY_SUB_BUCKETS;
+}
+
+/* Start an operation of traced table oSymTable, and time it if it is
+   the one its interval picks. */
+
+static void SymTable_traceBegin(SymTable_T oSymTable) {
+    struct trace *psTrace = oSymTable->trace;
+    psTrace->startBuckets = oSymTable->numOfcells;
+    psTrace->timed = --psTrace->countdown == 0;
+    if (psTrace->timed) {
+        psTrace->countdown = psTrace->interval;
+        psTrace->start = SymTable_nanoseconds();
+    }
+}
+
+/* Finish operation eOp of traced table oSymTable on the key that
+   psLookup describes: add its latency to its histogram if it is
+   timed, and call the slow-operation hook if the operation is slow. */
+
+static void SymTable_traceEnd(SymTable_T oSymTable, enum SymTableOp eOp,
+   const struct lookup *psLookup) {
+    struct trace *psTrace = oSymTable->trace;
+    struct SymTableLatency *psLatency = &psTrace->latencies[eOp];
+    struct SymTableSlowOp sOp;
+    uint64_t uNanoseconds = 0;
+
+    if (psTrace->timed) {
+        uNanoseconds = SymTable_nanoseconds() - psTrace->start;
+        psLatency->uCount++;
+        psLatency->auBuckets[SymTable_latencyBucket(uNanoseconds)]++;
+        if (uNanoseconds > psLatency->uMax)
+            psLatency->uMax = uNanoseconds;
+    }
+    if (psTrace->slow == NULL)
+        return;
+    if ((psTrace->slowNanoseconds == 0 || ! psTrace->timed ||
+                uNanoseconds < psTrace->slowNanoseconds) &&
+            (psTrace->slowDepth == 0 ||
+                psLookup->uDepth < psTrace->slowDepth) &&
+            oSymTable->numOfcells == psTrace->startBuckets)
+        return;
+    sOp.eOp = eOp;
+    sOp.pcKey = psLookup->pcKey;
+    sOp.uLength = psLookup->uLength;
+    sOp.uNanoseconds = uNanoseconds;
+    sOp.uDepth = psLookup->uDepth;
+    sOp.uBucketsBefore = psTrace->startBuckets;
+    sOp.uBucketsAfter = oSymTable->numOfcells;
+    (*psTrace->slow)(&sOp, (void*)psTrace->slowExtra);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    size_t uAdded;
+    size_t uRemoved;
+    assert(oSymTable != NULL);
+    SymTable_settle(oSymTable);
+    if (oSymTable->mode == MODE_SHARDED) {
+        SymTable_readStripes(oSymTable, &uAdded, &uRemoved);
+        return uAdded - uRemoved;
+    }
+   return oSymTable->length;
+}
+
+size_t SymTable_getExactLength(SymTable_T oSymTable) {
+    size_t uAdded;
+    size_t uRemoved;
+    size_t uAddedAgain;
+    size_t uRemovedAgain;
+    size_t u;
+    assert(oSymTable != NULL);
+    SymTable_settle(oSymTable);
+    if (oSymTable->mode != MODE_SHARDED)
+        return oSymTable->length;
+    /* the counts only grow, so two reads of the stripes that agree saw
+       counts that did not change between them, which give the length
+       at the moment between the reads*/
+    SymTable_readStripes(oSymTable, &uAdded, &uRemoved);
+    for (u = 0; u < EXACT_ATTEMPTS; u++) {
+        SymTable_readStripes(oSymTable, &uAddedAgain, &uRemovedAgain);
+        if (uAddedAgain == uAdded && uRemovedAgain == uRemoved)
+            return uAdded - uRemoved;
+        uAdded = uAddedAgain;
+        uRemoved = uRemovedAgain;
+    }
+    /* stops the changes, which are counted under the shard locks,
+       taking the locks in the order of the shards; an operation on a
+       key holds only one, so this cannot deadlock*/
+    for (u = 0; u < oSymTable->sharded->count; u++)
+        pthread_mutex_lock(&oSymTable->sharded->shards[u].shard.lock);
+    SymTable_readStripes(oSymTable, &uAdded, &uRemoved);
+    for (u = oSymTable->sharded->count; u > 0; u--)
+        pthread_mutex_unlock(&oSymTable->sharded->shards[u - 1].shard.lock);
+    return uAdded - uRemoved;
+}
+
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+   const void *pvValue) {
+    struct shard *psShard;
+    struct lookup sLookup;
+    size_t uBefore;
+    int iSuccessful;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(oSymTable->mode == MODE_LIVE || oSymTable->mode == MODE_SHARDED);
+    SymTable_settle(oSymTable);
+    if (oSymTable->mode == MODE_SHARDED) {
+        SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+        psShard = SymTable_lockShard(oSymTable, &sLookup);
+        SYMTABLE_COUNT(psShard->table, uPuts);
+        uBefore = psShard->table->length;
+        iSuccessful = SymTable_insert(psShard->table, &sLookup, pvValue);
+        SymTable_unlockCounted(oSymTable, psShard, uBefore);
+        return iSuccessful;
+    }
+    if (oSymTable->mode != MODE_LIVE)
+        return 0;
+    /* only live tables are traced*/
+    if (oSymTable->trace != NULL)
+        SymTable_traceBegin(oSymTable);
+    SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+    SYMTABLE_COUNT(oSymTable, uPuts);
+    if (oSymTable->trace == NULL)
+        return SymTable_insert(oSymTable, &sLookup, pvValue);
+    iSuccessful = SymTable_insert(oSymTable, &sLookup, pvValue);
+    SymTable_traceEnd(oSymTable, SYMTABLE_OP_PUT, &sLookup);
+    return iSuccessful;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    assert(pcKey != NULL);
+    return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+/* Bind the key described by psLookup to pvValue in live table
+   oSymTable if it is bound, as SymTable_replaceN does. */
+
+static void *SymTable_rebind(SymTable_T oSymTable, struct lookup *psLookup,
+   const void *pvValue) {
+    /* traveling node*/
+    struct node *currentNode;
+    const void* oldValue;
+
+    currentNode = SymTable_find(oSymTable, psLookup);
+    if (currentNode == NULL)
+        return NULL;
+    if (oSymTable->snapshot != NULL &&
+            oSymTable->snapshot->first != NULL &&
+            ! SymTable_preserve(oSymTable, psLookup->uBucket))
+        return NULL;
+    oldValue = currentNode->value;
+    currentNode->value = pvValue;
+    return (void*) oldValue;
+}
+
+void *SymTable_replaceN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, const void *pvValue) {
+    struct shard *psShard;
+    struct lookup sLookup;
+    void *pvOldValue;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(oSymTable->mode == MODE_LIVE || oSymTable->mode == MODE_SHARDED);
+    SymTable_settle(oSymTable);
+    SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+    if (oSymTable->mode == MODE_SHARDED) {
+        psShard = SymTable_lockShard(oSymTable, &sLookup);
+        SYMTABLE_COUNT(psShard->table, uReplaces);
+        pvOldValue = SymTable_rebind(psShard->table, &sLookup, pvValue);
+        pthread_mutex_unlock(&psShard->lock);
+        return pvOldValue;
+    }
+    if (oSymTable->mode != MODE_LIVE)
+        return NULL;
+    SYMTABLE_COUNT(oSymTable, uReplaces);
+    return SymTable_rebind(oSymTable, &sLookup, pvValue);
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    assert(pcKey != NULL);
+    return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength) {
+    struct shard *psShard;
+    struct lookup sLookup;
+    int iFound;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_settle(oSymTable);
+    if (oSymTable->mode == MODE_SHARDED) {
+        SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+        psShard = SymTable_lockShard(oSymTable, &sLookup);
+        SYMTABLE_COUNT(psShard->table, uContains);
+        iFound = SymTable_find(psShard->table, &sLookup) != NULL;
+        pthread_mutex_unlock(&psShard->lock);
+        return iFound;
+    }
+    if (oSymTable->trace != NULL)
+        SymTable_traceBegin(oSymTable);
+    SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+    SYMTABLE_COUNT(oSymTable, uContains);
+
+    if (oSymTable->mode == MODE_MAPPED)
+        return SymTable_findEntry(oSymTable, &sLookup) != NULL;
+    if (oSymTable->mode == MODE_FROZEN)
+        return SymTable_findFrozen(oSymTable, &sLookup) != NULL;
+    if (oSymTable->mode == MODE_SNAPSHOT)
+        return SymTable_findSnapshot(oSymTable, &sLookup) != NULL;
+    iFound = SymTable_find(oSymTable, &sLookup) != NULL;
+    if (oSymTable->trace != NULL)
+        SymTable_traceEnd(oSymTable, SYMTABLE_OP_GET, &sLookup);
+    return iFound;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    assert(pcKey != NULL);
+    return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength) {
+    struct node *currentNode;
+    const struct imageEntry *psEntry;
+    const struct frozenEntry *psFrozen;
+    struct shard *psShard;
+    struct lookup sLookup;
+    const void *pvValue = NULL;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_settle(oSymTable);
+    if (oSymTable->mode == MODE_SHARDED) {
+        /* reads the value before another thread can change it*/
+        SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+        psShard = SymTable_lockShard(oSymTable, &sLookup);
+        SYMTABLE_COUNT(psShard->table, uGets);
+        currentNode = SymTable_find(psShard->table, &sLookup);
+        if (currentNode != NULL)
+            pvValue = currentNode->value;
+        pthread_mutex_unlock(&psShard->lock);
+        return (void*) pvValue;
+    }
+    if (oSymTable->trace != NULL)
+        SymTable_traceBegin(oSymTable);
+    SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+    SYMTABLE_COUNT(oSymTable, uGets);
+
+    if (oSymTable->mode == MODE_MAPPED) {
+        psEntry = SymTable_findEntry(oSymTable, &sLookup);
+        if (psEntry == NULL)
+            return NULL;
+        return (void*)(oSymTable->mapped->image + psEntry->valueOffset);
+    }
+    if (oSymTable->mode == MODE_FROZEN) {
+        psFrozen = SymTable_findFrozen(oSymTable, &sLookup);
+        if (psFrozen == NULL)
+            return NULL;
+        return (void*)psFrozen->value;
+    }
+    if (oSymTable->mode == MODE_SNAPSHOT)
+        currentNode = SymTable_findSnapshot(oSymTable, &sLookup);
+    else
+        currentNode = SymTable_find(oSymTable, &sLookup);
+    if (oSymTable->trace != NULL)
+        SymTable_traceEnd(oSymTable, SYMTABLE_OP_GET, &sLookup);
+    if (currentNode == NULL)
+        return NULL;
+    return (void*) currentNode->value;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    assert(pcKey != NULL);
+    return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/* Remove the binding of live table oSymTable whose key is described
+   by psLookup, store its value in *ppvValue and return 1 (TRUE).
+   Return 0 (FALSE) if there is no such binding, or if insufficient
+   memory is available to preserve the snapshots of oSymTable. */
+
+static int SymTable_unlink(SymTable_T oSymTable, struct lookup *psLookup,
+   const void **ppvValue) {
+    /*traveling node*/
+    struct node *currentNode;
+    struct treeNode *psRemoved = NULL;
+    size_t u;
+
+    currentNode = SymTable_find(oSymTable, psLookup);
+    if (currentNode == NULL)
+        return 0;
+    if (oSymTable->snapshot != NULL &&
+            oSymTable->snapshot->first != NULL &&
+            ! SymTable_preserve(oSymTable, psLookup->uBucket))
+        return 0;
+    /*save the currentNode's value*/
+    *ppvValue = currentNode->value;
+    if (oSymTable->firstNodes == NULL) {
+        /* moves the last binding into the slot*/
+        u = (size_t)(psLookup->ppLink - oSymTable->smallNodes);
+        oSymTable->smallNodes[u] =
+            oSymTable->smallNodes[oSymTable->length - 1];
+        oSymTable->smallHashes[u] =
+            oSymTable->smallHashes[oSymTable->length - 1];
+    }
+    else if (psLookup->ppLink == NULL) {
+        /* unlink the node from its tree bucket*/
+        oSymTable->treeRoots[psLookup->uBucket] = SymTable_treeRemove(
+            oSymTable->treeRoots[psLookup->uBucket], psLookup, &psRemoved);
+        assert(psRemoved != NULL && psRemoved->node == currentNode);
+        free(psRemoved);
+        SYMTABLE_COUNT(oSymTable, uFrees);
+    }
+    else
+        /* relink the list*/
+        *psLookup->ppLink = currentNode->nextNode;
+    free(currentNode);
+    SYMTABLE_COUNT(oSymTable, uFrees);
+    oSymTable->length--;
+    /* shrinks the table once it has drained well below its size*/
+    if (oSymTable->bucketStep > 0 && oSymTable->length <
+            oSymTable->numOfcells / SHRINK_DIVISOR)
+        (void)SymTable_rehash(oSymTable, oSymTable->bucketStep - 1);
+    /* rebuilds the filter once most of the keys that set its bits may
+       be gone, and no sooner than after as many removes as the rebuild
+       walks buckets, which a nearly empty table would otherwise pay on
+       every remove*/
+    if (oSymTable->filterBlocks != NULL &&
+            ++oSymTable->filterRemoves > oSymTable->length &&
+            oSymTable->filterRemoves >= oSymTable->numOfcells)
+        (void)SymTable_buildFilter(oSymTable);
+
+    return 1;
+}
+
+/* Remove the binding of live or sharded table oSymTable whose key is
+   the uLength characters at pcKey, as SymTable_unlink does. */
+
+static int SymTable_unbind(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, const void **ppvValue) {
+    struct shard *psShard;
+    struct lookup sLookup;
+    size_t uBefore;
+    int iSuccessful;
+    SymTable_settle(oSymTable);
+    if (oSymTable->mode == MODE_SHARDED) {
+        SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+        psShard = SymTable_lockShard(oSymTable, &sLookup);
+        SYMTABLE_COUNT(psShard->table, uRemoves);
+        uBefore = psShard->table->length;
+        iSuccessful = SymTable_unlink(psShard->table, &sLookup, ppvValue);
+        SymTable_unlockCounted(oSymTable, psShard, uBefore);
+        return iSuccessful;
+    }
+    if (oSymTable->trace != NULL)
+        SymTable_traceBegin(oSymTable);
+    SymTable_initLookup(oSymTable, pcKey, uLength, &sLookup);
+    SYMTABLE_COUNT(oSymTable, uRemoves);
+    if (oSymTable->trace == NULL)
+        return SymTable_unlink(oSymTable, &sLookup, ppvValue);
+    iSuccessful = SymTable_unlink(oSymTable, &sLookup, ppvValue);
+    SymTable_traceEnd(oSymTable, SYMTABLE_OP_REMOVE, &sLookup);
+    return iSuccessful;
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength) {
+    const void *oldValue;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(oSymTable->mode == MODE_LIVE || oSymTable->mode == MODE_SHARDED);
+    if (oSymTable->mode != MODE_LIVE && oSymTable->mode != MODE_SHARDED)
+        return NULL;
+    if (! SymTable_unbind(oSymTable, pcKey, uLength, &oldValue))
+        return NULL;
+    return (void*) oldValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    assert(pcKey != NULL);
+    return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_delete(SymTable_T oSymTable, const char *pcKey) {
+    const void *oldValue;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(oSymTable->mode == MODE_LIVE || oSymTable->mode == MODE_SHARDED);
+    if (oSymTable->mode != MODE_LIVE && oSymTable->mode != MODE_SHARDED)
+        return 0;
+    /* a snapshot may still return the value*/
+    if (oSymTable->freeValue != NULL && oSymTable->snapshot != NULL &&
+            ! SymTable_reserveDeferred(oSymTable, 1))
+        return 0;
+    if (! SymTable_unbind(oSymTable, pcKey, strlen(pcKey), &oldValue))
+        return 0;
+    SymTable_discard(oSymTable, oSymTable->freeValue, oldValue);
+    return 1;
+}
+
+ void SymTable_map(SymTable_T oSymTable,
+     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+     const void *pvExtra) {
+        struct snapshotPage *const *ppsPages;
+        const struct snapshotPage *psPage;
+        SymTable_T oSource;
+        size_t u;
+        assert(oSymTable != NULL);
+        assert(pfApply != NULL);
+        SymTable_settle(oSymTable);
+
+        if (oSymTable->mode == MODE_MAPPED) {
+           for (u = 0; u < oSymTable->length; u++)
+              (*pfApply)((const char*)oSymTable->mapped->image +
+                 oSymTable->mapped->entries[u].keyOffset,
+                 (void*)(oSymTable->mapped->image +
+                    oSymTable->mapped->entries[u].valueOffset),
+                 (void*)pvExtra);
+           return;
+        }
+        if (oSymTable->mode == MODE_FROZEN) {
+           for (u = 0; u < oSymTable->frozen->slots; u++)
+              if (oSymTable->frozen->entries[u].key != NULL)
+                 (*pfApply)(oSymTable->frozen->entries[u].key,
+                    (void*)oSymTable->frozen->entries[u].value,
+                    (void*)pvExtra);
+           return;
+        }
+
+        if (oSymTable->mode == MODE_SHARDED) {
+           for (u = 0; u < oSymTable->sharded->count; u++) {
+              pthread_mutex_lock(&oSymTable->sharded->shards[u].shard.lock);
+              SymTable_map(oSymTable->sharded->shards[u].shard.table, pfApply,
+                  pvExtra);
+              pthread_mutex_unlock(&oSymTable->sharded->shards[u].shard.lock);
+           }
+           return;
+        }
+        if (oSymTable->mode == MODE_LIVE && oSymTable->firstNodes == NULL) {
+           for (u = 0; u < oSymTable->length; u++)
+              (*pfApply)(oSymTable->smallNodes[u]->key,
+                 (void*)oSymTable->smallNodes[u]->value, (void*)pvExtra);
+           return;
+        }
+
+        /* a snapshot visits its preserved buckets, and the unchanged
+           buckets of its live table, in bucket order*/
+        oSource = oSymTable;
+        ppsPages = NULL;
+        if (oSymTable->mode == MODE_SNAPSHOT) {
+           oSource = oSymTable->snapshot->source;
+           ppsPages = oSymTable->snapshot->pages;
+        }
+        for (u = 0; u < oSymTable->numOfcells; u++) {
+           psPage = NULL;
+           if (ppsPages != NULL)
+              psPage = ppsPages[u / SNAPSHOT_PAGE];
+           if (psPage != NULL)
+              SymTable_mapBucket(psPage->firstNodes[u % SNAPSHOT_PAGE],
+                 psPage->treeRoots[u % SNAPSHOT_PAGE], pfApply,
+                 (void*)pvExtra);
+           else
+              SymTable_mapBucket(oSource->firstNodes[u],
+                 oSource->treeRoots == NULL ? NULL :
+                    oSource->treeRoots[u], pfApply, (void*)pvExtra);
+        }
+     }
+
+void SymTable_clear(SymTable_T oSymTable,
+   void (*pfFreeValue)(void *pvValue)) {
+    struct node *currentNode;
+    struct node *nextNode;
+    struct shard *psShard;
+    size_t uBefore;
+    size_t u;
+    assert(oSymTable != NULL);
+    assert(oSymTable->mode == MODE_LIVE || oSymTable->mode == MODE_SHARDED);
+    SymTable_settle(oSymTable);
+    if (oSymTable->mode == MODE_SHARDED) {
+        for (u = 0; u < oSymTable->sharded->count; u++) {
+            psShard = &oSymTable->sharded->shards[u].shard;
+            pthread_mutex_lock(&psShard->lock);
+            uBefore = psShard->table->length;
+            SymTable_clear(psShard->table, pfFreeValue);
+            SymTable_unlockCounted(oSymTable, psShard, uBefore);
+        }
+        return;
+    }
+    if (oSymTable->mode != MODE_LIVE)
+        return;
+    if (pfFreeValue == NULL)
+        pfFreeValue = oSymTable->freeValue;
+    /* the snapshots may still return the values*/
+    if (pfFreeValue != NULL && oSymTable->snapshot != NULL &&
+            ! SymTable_reserveDeferred(oSymTable, oSymTable->length))
+        return;
+    if (! SymTable_detachSnapshots(oSymTable))
+        return;
+
+    /* keeps the bucket array at its current size and the nodes in the
+       pool, so refilling the table allocates nothing it had before*/
+    for (u = 0; oSymTable->firstNodes == NULL && u < oSymTable->length;
+            u++) {
+        SymTable_discard(oSymTable, pfFreeValue,
+            oSymTable->smallNodes[u]->value);
+        SymTable_releaseNode(oSymTable, oSymTable->smallNodes[u]);
+    }
+    for (u = 0; oSymTable->firstNodes != NULL && u < oSymTable->numOfcells;
+            u++) {
+        for (currentNode = oSymTable->firstNodes[u]; currentNode != NULL;
+                currentNode = nextNode) {
+            nextNode = currentNode->nextNode;
+            SymTable_discard(oSymTable, pfFreeValue, currentNode->value);
+            SymTable_releaseNode(oSymTable, currentNode);
+        }
+        oSymTable->firstNodes[u] = NULL;
+        if (oSymTable->treeRoots != NULL) {
+            SymTable_treeClear(oSymTable, oSymTable->treeRoots[u],
+                pfFreeValue);
+            oSymTable->treeRoots[u] = NULL;
+        }
+    }
+    if (oSymTable->filterBlocks != NULL)
+        memset(oSymTable->filterBlocks, 0, oSymTable->filterBlockCount *
+            sizeof(*oSymTable->filterBlocks));
+    oSymTable->filterRemoves = 0;
+    oSymTable->length = 0;
+}
+
+/* clone context structure which SymTable_cloneBinding fills*/
+struct cloneContext {
+    SymTable_T oClone;
+    int iSuccessful;
+};
+
+/* Put the binding of pcKey and pvValue into the table of pvExtra, a
+   struct cloneContext, clearing its iSuccessful on failure. */
+
+static void SymTable_cloneBinding(const char *pcKey, void *pvValue,
+   void *pvExtra) {
+    struct cloneContext *psContext = (struct cloneContext*)pvExtra;
+    if (psContext->iSuccessful)
+        psContext->iSuccessful =
+            SymTable_put(psContext->oClone, pcKey, pvValue);
+}
+
+SymTable_T SymTable_clone(SymTable_T oSymTable) {
+    SymTable_T oClone;
+    struct node **ppsBuckets;
+    struct node **ppsLink;
+    const struct node *currentNode;
+    struct cloneContext sContext;
+    size_t u;
+    int iSuccessful = 1;
+    assert(oSymTable != NULL);
+    assert(oSymTable->mode != MODE_RETIRED);
+    SymTable_settle(oSymTable);
+
+    /* a sharded table is cloned into one with as many shards*/
+    if (oSymTable->mode == MODE_SHARDED)
+        oClone = SymTable_newSharded(oSymTable->sharded->count);
+    else
+        oClone = SymTable_newSeeded(oSymTable->seed[0],
+            oSymTable->seed[1]);
+    if (oClone == NULL)
+        return NULL;
+    SymTable_setTreeThreshold(oClone, oSymTable->treeThreshold);
+
+    /* a read-only or sharded table is cloned binding by binding*/
+    if (oSymTable->mode != MODE_LIVE) {
+        sContext.oClone = oClone;
+        sContext.iSuccessful = 1;
+        SymTable_map(oSymTable, SymTable_cloneBinding, &sContext);
+        if (! sContext.iSuccessful) {
+            SymTable_free(oClone);
+            return NULL;
+        }
+        return oClone;
+    }
+
+    /* a small table is copied slot by slot*/
+    if (oSymTable->firstNodes == NULL) {
+        for (u = 0; u < oSymTable->length; u++) {
+            oClone->smallNodes[u] = SymTable_copyNode(oClone,
+                oSymTable->smallNodes[u]);
+            if (oClone->smallNodes[u] == NULL) {
+                SymTable_free(oClone);
+                return NULL;
+            }
+            oClone->smallHashes[u] = oSymTable->smallHashes[u];
+            oClone->length++;
+        }
+        return oClone;
+    }
+
+    /* a live table keeps its bucket count, so every chain and tree is
+       copied as it is, in order, without hashing a key again*/
+    ppsBuckets = (struct node**)
+        malloc(oSymTable->numOfcells * sizeof(struct node*));
+    if (ppsBuckets == NULL) {
+        SymTable_free(oClone);
+        return NULL;
+    }
+    oClone->firstNodes = ppsBuckets;
+    oClone->numOfcells = oSymTable->numOfcells;
+    oClone->bucketStep = oSymTable->bucketStep;
+    for (u = 0; u < oClone->numOfcells; u++)
+        oClone->firstNodes[u] = NULL;
+    if (oSymTable->treeRoots != NULL) {
+        oClone->treeRoots = (struct treeNode**)
+            malloc(oClone->numOfcells * sizeof(struct treeNode*));
+        if (oClone->treeRoots == NULL) {
+            SymTable_free(oClone);
+            return NULL;
+        }
+        for (u = 0; u < oClone->numOfcells; u++)
+            oClone->treeRoots[u] = NULL;
+    }
+    for (u = 0; u < oClone->numOfcells && iSuccessful; u++) {
+        ppsLink = &oClone->firstNodes[u];
+        for (currentNode = oSymTable->firstNodes[u];
+                currentNode != NULL && iSuccessful;
+                currentNode = currentNode->nextNode) {
+            *ppsLink = SymTable_copyNode(oClone, currentNode);
+            iSuccessful = *ppsLink != NULL;
+            if (iSuccessful) {
+                (*ppsLink)->nextNode = NULL;
+                ppsLink = &(*ppsLink)->nextNode;
+            }
+        }
+        if (oSymTable->treeRoots != NULL)
+            oClone->treeRoots[u] = SymTable_treeCopy(oClone,
+                oSymTable->treeRoots[u], &iSuccessful);
+    }
+    if (! iSuccessful) {
+        SymTable_free(oClone);
+        return NULL;
+    }
+    oClone->length = oSymTable->length;
+    /* without a filter if there is no memory for one; it only speeds
+       up misses*/
+    if (oSymTable->filterBlocks != NULL)
+        (void)SymTable_buildFilter(oClone);
+    return oClone;
+}
+
+/* Add every counter of *psStats to the same counter of *psSum. */
+
+static void SymTable_addStats(struct SymTableStats *psSum,
+   const struct SymTableStats *psStats) {
+    psSum->uPuts += psStats->uPuts;
+    psSum->uGets += psStats->uGets;
+    psSum->uRemoves += psStats->uRemoves;
+    psSum->uContains += psStats->uContains;
+    psSum->uReplaces += psStats->uReplaces;
+    psSum->uHits += psStats->uHits;
+    psSum->uMisses += psStats->uMisses;
+    psSum->uProbes += psStats->uProbes;
+    psSum->uKeyCompares += psStats->uKeyCompares;
+    psSum->uAllocs += psStats->uAllocs;
+    psSum->uFrees += psStats->uFrees;
+}
+
+void SymTable_getStats(SymTable_T oSymTable,
+   struct SymTableStats *psStats) {
+    struct SymTableStats sShardStats;
+    size_t u;
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+    SymTable_settle(oSymTable);
+    if (oSymTable->mode == MODE_SHARDED) {
+        /* the counters of a sharded table are those of its shards*/
+        memset(psStats, 0, sizeof(*psStats));
+        for (u = 0; u < oSymTable->sharded->count; u++) {
+            pthread_mutex_lock(&oSymTable->sharded->shards[u].shard.lock);
+            SymTable_getStats(oSymTable->sharded->shards[u].shard.table,
+                &sShardStats);
+            pthread_mutex_unlock(&oSymTable->sharded->shards[u].shard.lock);
+            SymTable_addStats(psStats, &sShardStats);
+        }
+        return;
+    }
+#ifdef SYMTABLE_STATS
+    *psStats = oSymTable->sStats;
+#else
+    memset(psStats, 0, sizeof(*psStats));
+#endif
+}
+
+void SymTable_resetStats(SymTable_T oSymTable) {
+    struct sharded *psSharded;
+    size_t u;
+    assert(oSymTable != NULL);
+    psSharded = oSymTable->sharded;
+    for (u = 0; psSharded != NULL && u < psSharded->count; u++) {
+        pthread_mutex_lock(&psSharded->shards[u].shard.lock);
+        SymTable_resetStats(psSharded->shards[u].shard.table);
+        pthread_mutex_unlock(&psSharded->shards[u].shard.lock);
+    }
+#ifdef SYMTABLE_STATS
+    memset(&oSymTable->sStats, 0, sizeof(oSymTable->sStats));
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_setTreeThreshold(SymTable_T oSymTable, size_t uThreshold) {
+    struct sharded *psSharded;
+    size_t u;
+    assert(oSymTable != NULL);
+    oSymTable->treeThreshold = uThreshold;
+    psSharded = oSymTable->sharded;
+    for (u = 0; psSharded != NULL && u < psSharded->count; u++) {
+        pthread_mutex_lock(&psSharded->shards[u].shard.lock);
+        SymTable_setTreeThreshold(psSharded->shards[u].shard.table,
+            uThreshold);
+        pthread_mutex_unlock(&psSharded->shards[u].shard.lock);
+    }
+}
+
+size_t SymTable_bucketOf(SymTable_T oSymTable, const char *pcKey) {
+    struct shard *psShard;
+    struct lookup sLookup;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_settle(oSymTable);
+    SymTable_initLookup(oSymTable, pcKey, strlen(pcKey), &sLookup);
+    if (oSymTable->mode == MODE_SHARDED) {
+        psShard = SymTable_lockShard(oSymTable, &sLookup);
+        pthread_mutex_unlock(&psShard->lock);
+    }
+    return sLookup.uBucket;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Perform one pass of SymTable_compact on the node at *ppsSlot, which
+   is the *puNext-th node visited, and add 1 to *puNext. In the first
+   pass (iCommit is 0) store a copy of the node in ppsCopies; in the
+   second, replace the node with its copy. Return 0 (FALSE) if the
+   first pass runs out of memory, and 1 (TRUE) otherwise. */
+
+static int SymTable_moveNode(struct node **ppsSlot, struct node **ppsCopies,
+   size_t *puNext, int iCommit) {
+    struct node *psNode = *ppsSlot;
+    size_t uSize = SymTable_nodeSize(psNode->keyLength);
+    struct node *psCopy;
+
+    if (! iCommit) {
+        psCopy = (struct node*) malloc(uSize);
+        if (psCopy == NULL)
+            return 0;
+        memcpy(psCopy, psNode, uSize);
+        ppsCopies[*puNext] = psCopy;
+    }
+    else {
+        psCopy = ppsCopies[*puNext];
+        psCopy->nextNode = psNode->nextNode;
+        free(psNode);
+        *ppsSlot = psCopy;
+    }
+    (*puNext)++;
+    return 1;
+}
+
+/* Perform one pass of SymTable_compact on the nodes of the tree
+   psRoot, in order. Return 0 (FALSE) if the first pass runs out of
+   memory, and 1 (TRUE) otherwise. */
+
+static int SymTable_treeCompact(struct treeNode *psRoot,
+   struct node **ppsCopies, size_t *puNext, int iCommit) {
+    for (; psRoot != NULL; psRoot = psRoot->rightNode)
+        if (! SymTable_treeCompact(psRoot->leftNode, ppsCopies, puNext,
+                iCommit) ||
+            ! SymTable_moveNode(&psRoot->node, ppsCopies, puNext, iCommit))
+            return 0;
+    return 1;
+}
+
+int SymTable_compact(SymTable_T oSymTable) {
+    struct node **ppsCopies;
+    struct node **ppsSlot;
+    size_t uNext;
+    size_t uStep = 0;
+    size_t u;
+    int iCommit;
+    int iSuccessful = 1;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->mode == MODE_LIVE);
+    SymTable_settle(oSymTable);
+    if (oSymTable->mode != MODE_LIVE)
+        return 0;
+    if (! SymTable_detachSnapshots(oSymTable))
+        return 0;
+
+    SymTable_freePool(oSymTable);
+
+    /* the smallest bucket count that keeps at most one binding per
+       bucket */
+    while (uStep + 1 < BUCKET_COUNT_STEPS &&
+            auBucketCounts[uStep] < oSymTable->length)
+        uStep++;
+    if (uStep != oSymTable->bucketStep &&
+            ! SymTable_rehash(oSymTable, uStep))
+        return 0;
+    /* drops the bits of removed keys, unless resizing just did*/
+    if (oSymTable->filterBlocks != NULL && oSymTable->filterRemoves != 0)
+        (void)SymTable_buildFilter(oSymTable);
+
+    /* Copy every node in the order SymTable_map visits them while the
+       originals are still allocated, so the allocator cannot hand the
+       copies the scattered chunks of the originals; then swap them
+       in. */
+    ppsCopies = (struct node**)
+        malloc((oSymTable->length + 1) * sizeof(struct node*));
+    if (ppsCopies == NULL)
+        return 0;
+    for (iCommit = 0; iCommit <= 1 && iSuccessful; iCommit++) {
+        uNext = 0;
+        for (u = 0; oSymTable->firstNodes == NULL &&
+                u < oSymTable->length && iSuccessful; u++)
+            iSuccessful = SymTable_moveNode(&oSymTable->smallNodes[u],
+                ppsCopies, &uNext, iCommit);
+        for (u = 0; oSymTable->firstNodes != NULL &&
+                u < oSymTable->numOfcells && iSuccessful; u++) {
+            for (ppsSlot = &oSymTable->firstNodes[u];
+                    *ppsSlot != NULL && iSuccessful;
+                    ppsSlot = &(*ppsSlot)->nextNode)
+                iSuccessful = SymTable_moveNode(ppsSlot, ppsCopies, &uNext,
+                    iCommit);
+            if (oSymTable->treeRoots != NULL && iSuccessful)
+                iSuccessful = SymTable_treeCompact(oSymTable->treeRoots[u],
+                    ppsCopies, &uNext, iCommit);
+        }
+    }
+    if (! iSuccessful)
+        for (u = 0; u < uNext; u++)
+            free(ppsCopies[u]);
+    free(ppsCopies);
+    return iSuccessful;
+}
+
+int SymTable_setFilter(SymTable_T oSymTable, int iEnabled) {
+    assert(oSymTable != NULL);
+    assert(oSymTable->mode == MODE_LIVE);
+    SymTable_settle(oSymTable);
+    if (oSymTable->mode != MODE_LIVE)
+        return 0;
+    if (! iEnabled) {
+        if (oSymTable->filterBlocks != NULL) {
+            free(oSymTable->filterBlocks);
+            SYMTABLE_COUNT(oSymTable, uFrees);
+        }
+        oSymTable->filterBlocks = NULL;
+        oSymTable->filterBlockCount = 0;
+        oSymTable->filterRemoves = 0;
+        return 1;
+    }
+    if (oSymTable->filterBlocks != NULL)
+        return 1;
+    /* the filter covers buckets; a small table compares hash codes
+       as cheaply as it would test them*/
+    if (! SymTable_spill(oSymTable))
+        return 0;
+    return SymTable_buildFilter(oSymTable);
+}
+
+size_t SymTable_getBucketCount(SymTable_T oSymTable) {
+    size_t uCount = 0;
+    size_t u;
+    assert(oSymTable != NULL);
+    SymTable_settle(oSymTable);
+    if (oSymTable->mode == MODE_SHARDED) {
+        for (u = 0; u < oSymTable->sharded->count; u++) {
+            pthread_mutex_lock(&oSymTable->sharded->shards[u].shard.lock);
+            uCount += oSymTable->sharded->shards[u].shard.table->numOfcells;
+            pthread_mutex_unlock(&oSymTable->sharded->shards[u].shard.lock);
+        }
+        return uCount;
+    }
+    return oSymTable->numOfcells;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_setTracing(SymTable_T oSymTable, size_t uInterval) {
+    assert(oSymTable != NULL);
+    assert(oSymTable->mode == MODE_LIVE);
+    if (oSymTable->mode != MODE_LIVE)
+        return 0;
+    if (uInterval == 0) {
+        free(oSymTable->trace);
+        oSymTable->trace = NULL;
+        return 1;
+    }
+    if (oSymTable->trace == NULL) {
+        oSymTable->trace = (struct trace*)malloc(sizeof(struct trace));
+        if (oSymTable->trace == NULL)
+            return 0;
+        memset(oSymTable->trace, 0, sizeof(struct trace));
+        oSymTable->trace->slow = NULL;
+        oSymTable->trace->slowExtra = NULL;
+    }
+    oSymTable->trace->interval = uInterval;
+    oSymTable->trace->countdown = uInterval;
+    return 1;
+}
+
+void SymTable_setSlowHook(SymTable_T oSymTable, uint64_t uNanoseconds,
+   size_t uDepth,
+   void (*pfSlow)(const struct SymTableSlowOp *psOp, void *pvExtra),
+   const void *pvExtra) {
+    assert(oSymTable != NULL);
+    assert(oSymTable->trace != NULL);
+    if (oSymTable->trace == NULL)
+        return;
+    oSymTable->trace->slow = pfSlow;
+    oSymTable->trace->slowNanoseconds = uNanoseconds;
+    oSymTable->trace->slowDepth = uDepth;
+    oSymTable->trace->slowExtra = pvExtra;
+}
+
+void SymTable_getLatency(SymTable_T oSymTable, enum SymTableOp eOp,
+   struct SymTableLatency *psLatency) {
+    assert(oSymTable != NULL);
+    assert(psLatency != NULL);
+    assert(eOp < SYMTABLE_OP_COUNT);
+    if (oSymTable->trace == NULL)
+        memset(psLatency, 0, sizeof(struct SymTableLatency));
+    else
+        *psLatency = oSymTable->trace->latencies[eOp];
+}
+
+void SymTable_resetLatency(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    if (oSymTable->trace != NULL)
+        memset(oSymTable->trace->latencies, 0,
+            sizeof(oSymTable->trace->latencies));
+}
+
+uint64_t SymTable_latencyAt(const struct SymTableLatency *psLatency,
+   double dFraction) {
+    uint64_t uRank;
+    uint64_t uSeen = 0;
+    uint64_t uUpper;
+    size_t u;
+    assert(psLatency != NULL);
+    if (psLatency->uCount == 0)
+        return 0;
+    /* the rank, from 1, of the operation at dFraction*/
+    uRank = (uint64_t)(dFraction * (double)psLatency->uCount + 0.5);
+    if (uRank < 1)
+        uRank = 1;
+    for (u = 0; u + 1 < SYMTABLE_LATENCY_BUCKETS; u++) {
+        uSeen += psLatency->auBuckets[u];
+        if (uSeen >= uRank)
+            break;
+    }
+    if (u < LATENCY_SUB_BUCKETS)
+        uUpper = u;
+    else if (u + 1 == SYMTABLE_LATENCY_BUCKETS)
+        uUpper = psLatency->uMax;
+    else
+        /* one less than the first latency of the next bucket*/
+        uUpper = ((uint64_t)(u % LATENCY_SUB_BUCKETS +
+            LATENCY_SUB_BUCKETS + 1) << (u / LATENCY_SUB_BUCKETS - 1)) - 1;
+    return uUpper < psLatency->uMax ? uUpper : psLatency->uMax;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* the first bytes of every image, the version of the layout that
+   struct imageHeader and struct imageEntry describe, and a marker
+   that reads back unchanged only on a machine with the byte order of
+   the machine that wrote it */
+static const char acImageMagic[8] = "SYMTABH";
+enum {IMAGE_VERSION = 1};
+#define IMAGE_BYTE_ORDER ((uint64_t)0x0102030405060708u)
+
+/* Return uOffset rounded up to a multiple of 8. */
+
+static uint64_t SymTable_align(uint64_t uOffset) {
+    return (uOffset + 7) & ~(uint64_t)7;
+}
+
+/* Store the nodes of the tree psRoot in ppsNodes from index *puNext
+   on, in order, advancing *puNext. */
+
+static void SymTable_treeCollect(const struct treeNode *psRoot,
+   struct node **ppsNodes, size_t *puNext) {
+    for (; psRoot != NULL; psRoot = psRoot->rightNode) {
+        SymTable_treeCollect(psRoot->leftNode, ppsNodes, puNext);
+        ppsNodes[(*puNext)++] = psRoot->node;
+    }
+}
+
+/* Store every node of live table oSymTable in ppsNodes, bucket by
+   bucket, and in puStarts[b] the index in ppsNodes of the first node
+   of bucket b, with puStarts[numOfcells] set to the number of nodes. */
+
+static void SymTable_collect(SymTable_T oSymTable, struct node **ppsNodes,
+   uint64_t *puStarts) {
+    struct node *currentNode;
+    size_t uNext = 0;
+    size_t u;
+    for (u = 0; u < oSymTable->numOfcells; u++) {
+        puStarts[u] = (uint64_t)uNext;
+        for (currentNode = oSymTable->firstNodes[u]; currentNode != NULL;
+                currentNode = currentNode->nextNode)
+            ppsNodes[uNext++] = currentNode;
+        if (oSymTable->treeRoots != NULL)
+            SymTable_treeCollect(oSymTable->treeRoots[u], ppsNodes, &uNext);
+    }
+    puStarts[oSymTable->numOfcells] = (uint64_t)uNext;
+}
+
+/* Write the uPadding zero bytes that align the image after a section
+   to psFile. Return 1 (TRUE) on success and 0 (FALSE) otherwise. */
+
+static int SymTable_writePadding(FILE *psFile, size_t uPadding) {
+    static const unsigned char aucZeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    return uPadding == 0 || fwrite(aucZeros, 1, uPadding, psFile) == uPadding;
+}
+
+/* Encode the values of the uCount nodes of ppsNodes with *pfEncode
+   into a heap that starts at image offset uValuesOffset, storing each
+   value's offset in psEntries. Return the heap, whose size is stored
+   in *puSize, or NULL if insufficient memory is available. */
+
+static unsigned char *SymTable_encodeValues(struct node **ppsNodes,
+   size_t uCount, struct imageEntry *psEntries, uint64_t uValuesOffset,
+   size_t (*pfEncode)(const void *pvValue, void *pvBuffer, size_t uSize),
+   size_t *puSize) {
+    enum {INITIAL_CAPACITY = 4096};
+    unsigned char *pucValues;
+    unsigned char *pucGrown;
+    size_t uCapacity = INITIAL_CAPACITY;
+    size_t uUsed = 0;
+    size_t uEncoded;
+    size_t u;
+
+    pucValues = (unsigned char*) malloc(uCapacity);
+    if (pucValues == NULL)
+        return NULL;
+    for (u = 0; u < uCount; u++) {
+        uEncoded = (*pfEncode)(ppsNodes[u]->value, pucValues + uUsed,
+            uCapacity - uUsed);
+        /* leaves room for the padding after the value*/
+        if (uEncoded + 8 > uCapacity - uUsed) {
+            uCapacity = 2 * uCapacity + uEncoded + 8;
+            pucGrown = (unsigned char*) realloc(pucValues, uCapacity);
+            if (pucGrown == NULL) {
+                free(pucValues);
+                return NULL;
+            }
+            pucValues = pucGrown;
+            uEncoded = (*pfEncode)(ppsNodes[u]->value, pucValues + uUsed,
+                uCapacity - uUsed);
+        }
+        psEntries[u].valueOffset = uValuesOffset + uUsed;
+        memset(pucValues + uUsed + uEncoded, 0,
+            (size_t)SymTable_align(uEncoded) - uEncoded);
+        uUsed += (size_t)SymTable_align(uEncoded);
+    }
+    *puSize = uUsed;
+    return pucValues;
+}
+
+int SymTable_save(SymTable_T oSymTable, FILE *psFile,
+   size_t (*pfEncode)(const void *pvValue, void *pvBuffer, size_t uSize)) {
+    struct imageHeader sHeader;
+    struct node **ppsNodes;
+    uint64_t *puStarts;
+    struct imageEntry *psEntries;
+    unsigned char *pucValues = NULL;
+    size_t uValuesSize = 0;
+    uint64_t uKeyOffset;
+    uint64_t uValuesOffset;
+    size_t uCount;
+    size_t uStarts;
+    size_t u;
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(psFile != NULL);
+    assert(pfEncode != NULL);
+    assert(oSymTable->mode == MODE_LIVE);
+    SymTable_settle(oSymTable);
+    if (oSymTable->mode != MODE_LIVE)
+        return 0;
+    /* the image holds the buckets*/
+    if (! SymTable_spill(oSymTable))
+        return 0;
+
+    uCount = oSymTable->length;
+    uStarts = oSymTable->numOfcells + 1;
+    ppsNodes = (struct node**) malloc((uCount + 1) * sizeof(struct node*));
+    puStarts = (uint64_t*) malloc(uStarts * sizeof(uint64_t));
+    psEntries = (struct imageEntry*)
+        malloc((uCount + 1) * sizeof(struct imageEntry));
+    if (ppsNodes == NULL || puStarts == NULL || psEntries == NULL) {
+        free(ppsNodes);
+        free(puStarts);
+        free(psEntries);
+        return 0;
+    }
+    SymTable_collect(oSymTable, ppsNodes, puStarts);
+
+    memset(&sHeader, 0, sizeof(sHeader));
+    memcpy(sHeader.magic, acImageMagic, sizeof(sHeader.magic));
+    sHeader.byteOrder = IMAGE_BYTE_ORDER;
+    sHeader.version = IMAGE_VERSION;
+    sHeader.length = (uint64_t)uCount;
+    sHeader.bucketCount = (uint64_t)oSymTable->numOfcells;
+    sHeader.seed[0] = oSymTable->seed[0];
+    sHeader.seed[1] = oSymTable->seed[1];
+    sHeader.startsOffset = SymTable_align(sizeof(sHeader));
+    sHeader.entriesOffset = sHeader.startsOffset +
+        uStarts * sizeof(uint64_t);
+
+    /* the key heap follows the entries, and the value heap follows the
+       key heap */
+    uKeyOffset = sHeader.entriesOffset + uCount * sizeof(struct imageEntry);
+    for (u = 0; u < uCount; u++) {
+        psEntries[u].hash = (uint64_t)ppsNodes[u]->hash;
+        psEntries[u].keyLength = (uint64_t)ppsNodes[u]->keyLength;
+        psEntries[u].keyOffset = uKeyOffset;
+        uKeyOffset += ppsNodes[u]->keyLength + 1;
+    }
+    uValuesOffset = SymTable_align(uKeyOffset);
+    pucValues = SymTable_encodeValues(ppsNodes, uCount, psEntries,
+        uValuesOffset, pfEncode, &uValuesSize);
+    sHeader.imageSize = uValuesOffset + uValuesSize;
+
+    iSuccessful = pucValues != NULL &&
+        fwrite(&sHeader, sizeof(sHeader), 1, psFile) == 1 &&
+        SymTable_writePadding(psFile,
+            (size_t)(sHeader.startsOffset - sizeof(sHeader))) &&
+        fwrite(puStarts, sizeof(uint64_t), uStarts, psFile) == uStarts &&
+        fwrite(psEntries, sizeof(struct imageEntry), uCount, psFile)
+            == uCount;
+    for (u = 0; u < uCount && iSuccessful; u++)
+        iSuccessful = fwrite(ppsNodes[u]->key, 1,
+            ppsNodes[u]->keyLength + 1, psFile) == ppsNodes[u]->keyLength + 1;
+    iSuccessful = iSuccessful &&
+        SymTable_writePadding(psFile, (size_t)(uValuesOffset - uKeyOffset))
+        && fwrite(pucValues, 1, uValuesSize, psFile) == uValuesSize &&
+        fflush(psFile) == 0;
+
+    free(ppsNodes);
+    free(puStarts);
+    free(psEntries);
+    free(pucValues);
+    return iSuccessful;
+}
+
+/* Return 1 (TRUE) if the header of the uSize bytes at psHeader is
+   that of an image written by SymTable_save on a machine like this
+   one, with bucket starts and entries inside the image, and 0 (FALSE)
+   otherwise. Each bound is checked without overflow, since the header
+   may hold any offsets. */
+
+static int SymTable_checkHeader(const struct imageHeader *psHeader,
+   size_t uSize) {
+    if (uSize < sizeof(struct imageHeader) ||
+            memcmp(psHeader->magic, acImageMagic, sizeof(acImageMagic)) != 0
+            || psHeader->byteOrder != IMAGE_BYTE_ORDER ||
+            psHeader->version != IMAGE_VERSION ||
+            psHeader->imageSize != (uint64_t)uSize ||
+            psHeader->bucketCount == 0 ||
+            psHeader->startsOffset % 8 != 0 ||
+            psHeader->entriesOffset % 8 != 0 ||
+            psHeader->startsOffset < sizeof(struct imageHeader) ||
+            psHeader->startsOffset > psHeader->entriesOffset ||
+            psHeader->entriesOffset > (uint64_t)uSize)
+        return 0;
+    /* the bucketCount + 1 starts end before the entries, and the
+       entries end inside the image*/
+    return psHeader->bucketCount < (psHeader->entriesOffset -
+            psHeader->startsOffset) / sizeof(uint64_t) &&
+        psHeader->length <= ((uint64_t)uSize - psHeader->entriesOffset) /
+            sizeof(struct imageEntry);
+}
+
+/* Return 1 (TRUE) if the bucket starts and entries of the uSize bytes
+   at psHeader, whose header SymTable_checkHeader accepted, describe
+   buckets and keys inside the image, and 0 (FALSE) otherwise: the
+   starts rise from 0 to the number of entries, each key ends with a
+   '\0' inside the image, and each value starts at an aligned offset
+   no further than the end of the image. The length of a value is its
+   encoding's business, so it cannot be checked here. */
+
+static int SymTable_checkEntries(const struct imageHeader *psHeader,
+   size_t uSize) {
+    const unsigned char *pucImage = (const unsigned char*)psHeader;
+    const uint64_t *puStarts;
+    const struct imageEntry *psEntries;
+    uint64_t u;
+
+    puStarts = (const uint64_t*)(pucImage + psHeader->startsOffset);
+    psEntries = (const struct imageEntry*)
+        (pucImage + psHeader->entriesOffset);
+    if (puStarts[0] != 0 || puStarts[psHeader->bucketCount] !=
+            psHeader->length)
+        return 0;
+    for (u = 0; u < psHeader->bucketCount; u++)
+        if (puStarts[u] > puStarts[u + 1])
+            return 0;
+    for (u = 0; u < psHeader->length; u++)
+        if (psEntries[u].keyOffset >= (uint64_t)uSize ||
+                psEntries[u].keyLength >=
+                    (uint64_t)uSize - psEntries[u].keyOffset ||
+                pucImage[psEntries[u].keyOffset + psEntries[u].keyLength]
+                    != '\0' ||
+                psEntries[u].valueOffset % 8 != 0 ||
+                psEntries[u].valueOffset > (uint64_t)uSize)
+            return 0;
+    return 1;
+}
+
+/* Return a read-only SymTable object whose bindings are those of the
+   image in file pcPath, or NULL if the file cannot be mapped, does not
+   hold an image, or, unless iTrusted, holds an image whose bucket
+   starts or entries do not lie inside it. */
+
+static SymTable_T SymTable_mapImage(const char *pcPath, int iTrusted) {
+    SymTable_T oSymTable;
+    struct mapped *psMapped;
+    const struct imageHeader *psHeader;
+    struct stat sStat;
+    void *pvImage;
+    size_t uSize;
+    int iFd;
+
+    assert(pcPath != NULL);
+
+    iFd = open(pcPath, O_RDONLY);
+    if (iFd < 0)
+        return NULL;
+    if (fstat(iFd, &sStat) != 0 || sStat.st_size <= 0) {
+        close(iFd);
+        return NULL;
+    }
+    uSize = (size_t)sStat.st_size;
+    pvImage = mmap(NULL, uSize, PROT_READ, MAP_PRIVATE, iFd, 0);
+    close(iFd);
+    if (pvImage == MAP_FAILED)
+        return NULL;
+    psHeader = (const struct imageHeader*)pvImage;
+    if (! SymTable_checkHeader(psHeader, uSize) ||
+            (! iTrusted && ! SymTable_checkEntries(psHeader, uSize))) {
+        munmap(pvImage, uSize);
+        return NULL;
+    }
+
+    oSymTable = (SymTable_T) malloc(sizeof(struct SymTable));
+    psMapped = (struct mapped*)malloc(sizeof(struct mapped));
+    if (oSymTable == NULL || psMapped == NULL) {
+        free(oSymTable);
+        free(psMapped);
+        munmap(pvImage, uSize);
+        return NULL;
+    }
+    SymTable_initFields(oSymTable, MODE_MAPPED, psHeader->seed[0],
+        psHeader->seed[1]);
+    psMapped->image = (const unsigned char*)pvImage;
+    psMapped->size = uSize;
+    psMapped->starts = (const uint64_t*)
+        (psMapped->image + psHeader->startsOffset);
+    psMapped->entries = (const struct imageEntry*)
+        (psMapped->image + psHeader->entriesOffset);
+    oSymTable->mapped = psMapped;
+    oSymTable->length = (size_t)psHeader->length;
+    oSymTable->numOfcells = (size_t)psHeader->bucketCount;
+    return oSymTable;
+}
+
+SymTable_T SymTable_openMapped(const char *pcPath) {
+    return SymTable_mapImage(pcPath, 0);
+}
+
+SymTable_T SymTable_openMappedTrusted(const char *pcPath) {
+    return SymTable_mapImage(pcPath, 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* the average number of keys per bucket of a frozen table, and the
+   number of slots per 100 keys */
+enum {FROZEN_BUCKET_SIZE = 4, FROZEN_SLOTS_PERCENT = 101};
+
+/* how many hash keys SymTable_freeze tries before it gives up, and
+   how many values of d0 it tries per bucket under one hash key */
+enum {FROZEN_ATTEMPTS = 8, FROZEN_MAX_D0 = 64};
+
+/* the number of keys a frozen table holds fewer than */
+#define FROZEN_MAX_KEYS ((size_t)0xfc000000u)
+
+/* Choose the displacements of every bucket of frozen table oFrozen so
+   that the uCount keys with hash codes puHashes land in distinct
+   slots, and store the slot of key i in puSlots[i]. Buckets are
+   placed largest first, while most slots are still free (the CHD
+   algorithm). Return 1 (TRUE) on success, or 0 (FALSE) if some
+   bucket cannot be placed or insufficient memory is available. */
+
+static int SymTable_placeKeys(SymTable_T oFrozen, const size_t *puHashes,
+   size_t uCount, size_t *puSlots) {
+    size_t uBuckets = oFrozen->numOfcells;
+    uint64_t uSlots = (uint64_t)oFrozen->frozen->slots;
+    size_t *puStarts;
+    size_t *puKeys;
+    size_t *puBySize;
+    size_t *puSizeStarts;
+    uint64_t *puF;
+    unsigned char *pucTaken;
+    size_t uMaxSize = 0;
+    size_t uBucket;
+    size_t uSize;
+    size_t u;
+    size_t k;
+    uint32_t d0;
+    uint64_t d1;
+    int iPlaced = 1;
+
+    puStarts = (size_t*) malloc((uBuckets + 1) * sizeof(size_t));
+    puKeys = (size_t*) malloc((uCount + 1) * sizeof(size_t));
+    puBySize = (size_t*) malloc(uBuckets * sizeof(size_t));
+    puSizeStarts = (size_t*) malloc((uCount + 2) * sizeof(size_t));
+    puF = (uint64_t*) malloc((2 * uCount + 1) * sizeof(uint64_t));
+    pucTaken = (unsigned char*) malloc((size_t)uSlots);
+    if (puStarts == NULL || puKeys == NULL || puBySize == NULL ||
+            puSizeStarts == NULL || puF == NULL || pucTaken == NULL)
+        iPlaced = 0;
+
+    if (iPlaced) {
+        /* sorts the keys by bucket*/
+        for (u = 0; u <= uBuckets; u++)
+            puStarts[u] = 0;
+        for (k = 0; k < uCount; k++) {
+            puStarts[SymTable_frozenBucket(puHashes[k], uBuckets) + 1]++;
+            SymTable_frozenFunctions(puHashes[k], uSlots, &puF[2 * k],
+                &puF[2 * k + 1]);
+        }
+        for (u = 0; u < uBuckets; u++) {
+            if (puStarts[u + 1] > uMaxSize)
+                uMaxSize = puStarts[u + 1];
+            puStarts[u + 1] += puStarts[u];
+        }
+        for (k = 0; k < uCount; k++)
+            puKeys[puStarts[SymTable_frozenBucket(puHashes[k],
+                uBuckets)]++] = k;
+        /* the loop above advanced each start to the next bucket's*/
+        for (u = uBuckets; u > 0; u--)
+            puStarts[u] = puStarts[u - 1];
+        puStarts[0] = 0;
+
+        /* sorts the buckets by decreasing size*/
+        for (u = 0; u <= uMaxSize + 1; u++)
+            puSizeStarts[u] = 0;
+        for (u = 0; u < uBuckets; u++)
+            puSizeStarts[uMaxSize - (puStarts[u + 1] - puStarts[u]) + 1]++;
+        for (u = 0; u <= uMaxSize; u++)
+            puSizeStarts[u + 1] += puSizeStarts[u];
+        for (u = 0; u < uBuckets; u++)
+            puBySize[puSizeStarts[uMaxSize -
+                (puStarts[u + 1] - puStarts[u])]++] = u;
+
+        memset(pucTaken, 0, (size_t)uSlots);
+    }
+
+    for (u = 0; u < uBuckets && iPlaced; u++) {
+        uBucket = puBySize[u];
+        uSize = puStarts[uBucket + 1] - puStarts[uBucket];
+        oFrozen->frozen->displacements[uBucket].d0 = 0;
+        oFrozen->frozen->displacements[uBucket].d1 = 0;
+        iPlaced = 0;
+        for (d0 = 0; d0 < FROZEN_MAX_D0 && ! iPlaced && uSize != 0; d0++)
+            for (d1 = 0; d1 < uSlots && ! iPlaced; d1++) {
+                /* claims slots tentatively (2), so two keys of the
+                   bucket cannot share one*/
+                for (k = 0; k < uSize; k++) {
+                    size_t uKey = puKeys[puStarts[uBucket] + k];
+                    size_t uSlot = (size_t)((puF[2 * uKey] +
+                        d0 * puF[2 * uKey + 1] + d1) % uSlots);
+                    if (pucTaken[uSlot] != 0)
+                        break;
+                    pucTaken[uSlot] = 2;
+                    puSlots[uKey] = uSlot;
+                }
+                iPlaced = k == uSize;
+                while (k > 0) {
+                    k--;
+                    pucTaken[puSlots[puKeys[puStarts[uBucket] + k]]] =
+                        (unsigned char)iPlaced;
+                }
+                if (iPlaced) {
+                    oFrozen->frozen->displacements[uBucket].d0 = d0;
+                    oFrozen->frozen->displacements[uBucket].d1 = (uint32_t)d1;
+                }
+            }
+        if (uSize == 0)
+            iPlaced = 1;
+    }
+
+    free(puStarts);
+    free(puKeys);
+    free(puBySize);
+    free(puSizeStarts);
+    free(puF);
+    free(pucTaken);
+    return iPlaced;
+}
+
+SymTable_T SymTable_freeze(SymTable_T oSymTable) {
+    SymTable_T oFrozen;
+    struct frozen *psFrozen;
+    struct node **ppsNodes;
+    uint64_t *puStarts;
+    size_t *puHashes;
+    size_t *puSlots;
+    char *pcKey;
+    size_t uCount;
+    size_t uHeapSize = 0;
+    size_t u;
+    int iAttempt;
+    int iPlaced = 0;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->mode == MODE_LIVE);
+    SymTable_settle(oSymTable);
+    if (oSymTable->mode != MODE_LIVE)
+        return NULL;
+    /* the keys are collected bucket by bucket*/
+    if (! SymTable_spill(oSymTable))
+        return NULL;
+
+    /* the slot functions scale 32-bit numbers to the slot count*/
+    uCount = oSymTable->length;
+    if (uCount >= FROZEN_MAX_KEYS)
+        return NULL;
+    oFrozen = SymTable_newSeeded(oSymTable->seed[0], oSymTable->seed[1]);
+    if (oFrozen == NULL)
+        return NULL;
+    psFrozen = (struct frozen*) malloc(sizeof(struct frozen));
+    if (psFrozen == NULL) {
+        SymTable_free(oFrozen);
+        return NULL;
+    }
+    oFrozen->mode = MODE_FROZEN;
+    oFrozen->frozen = psFrozen;
+    oFrozen->length = uCount;
+    oFrozen->numOfcells = uCount / FROZEN_BUCKET_SIZE + 1;
+    oFrozen->treeThreshold = 0;
+    psFrozen->slots = uCount / 100 * FROZEN_SLOTS_PERCENT + uCount % 100 + 1;
+    psFrozen->keys = NULL;
+
+    ppsNodes = (struct node**) malloc((uCount + 1) * sizeof(struct node*));
+    puStarts = (uint64_t*)
+        malloc((oSymTable->numOfcells + 1) * sizeof(uint64_t));
+    puHashes = (size_t*) malloc((uCount + 1) * sizeof(size_t));
+    puSlots = (size_t*) malloc((uCount + 1) * sizeof(size_t));
+    psFrozen->entries = (struct frozenEntry*)
+        malloc(psFrozen->slots * sizeof(struct frozenEntry));
+    psFrozen->displacements = (struct displacement*)
+        malloc(oFrozen->numOfcells * sizeof(struct displacement));
+    if (ppsNodes != NULL && puStarts != NULL) {
+        SymTable_collect(oSymTable, ppsNodes, puStarts);
+        for (u = 0; u < uCount; u++)
+            uHeapSize += ppsNodes[u]->keyLength + 1;
+        psFrozen->keys = (char*) malloc(uHeapSize + 1);
+    }
+
+    if (puHashes != NULL && puSlots != NULL &&
+            psFrozen->entries != NULL &&
+            psFrozen->displacements != NULL &&
+            psFrozen->keys != NULL) {
+        /* the first attempt reuses the hash codes of the live table;
+           later ones pick a new hash key and hash every key again*/
+        for (u = 0; u < uCount; u++)
+            puHashes[u] = ppsNodes[u]->hash;
+        for (iAttempt = 0; iAttempt < FROZEN_ATTEMPTS && ! iPlaced;
+                iAttempt++) {
+            if (iAttempt > 0) {
+                oFrozen->seed[0] = SymTable_mix(oFrozen->seed[0] +
+                    (uint64_t)iAttempt);
+                oFrozen->seed[1] = SymTable_mix(oFrozen->seed[1] ^
+                    oFrozen->seed[0]);
+                for (u = 0; u < uCount; u++)
+                    puHashes[u] = SymTable_hash(oFrozen, ppsNodes[u]->key,
+                        ppsNodes[u]->keyLength);
+            }
+            iPlaced = SymTable_placeKeys(oFrozen, puHashes, uCount,
+                puSlots);
+        }
+    }
+
+    if (iPlaced) {
+        for (u = 0; u < psFrozen->slots; u++)
+            psFrozen->entries[u].key = NULL;
+        pcKey = psFrozen->keys;
+        for (u = 0; u < uCount; u++) {
+            struct frozenEntry *psEntry = &psFrozen->entries[puSlots[u]];
+            memcpy(pcKey, ppsNodes[u]->key, ppsNodes[u]->keyLength + 1);
+            psEntry->hash = puHashes[u];
+            psEntry->keyLength = ppsNodes[u]->keyLength;
+            psEntry->key = pcKey;
+            psEntry->value = ppsNodes[u]->value;
+            pcKey += ppsNodes[u]->keyLength + 1;
+        }
+    }
+
+    free(ppsNodes);
+    free(puStarts);
+    free(puHashes);
+    free(puSlots);
+    if (! iPlaced) {
+        SymTable_free(oFrozen);
+        return NULL;
+    }
+    return oFrozen;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new snapshot structure with no snapshot, source, pages or
+   deferred values, or NULL if insufficient memory is available. */
+
+static struct snapshot *SymTable_newSnapshotState(void) {
+    struct snapshot *psSnapshot;
+    psSnapshot = (struct snapshot*)malloc(sizeof(struct snapshot));
+    if (psSnapshot == NULL)
+        return NULL;
+    psSnapshot->source = NULL;
+    psSnapshot->pages = NULL;
+    psSnapshot->next = NULL;
+    psSnapshot->owner = NULL;
+    psSnapshot->first = NULL;
+    psSnapshot->count = 0;
+    psSnapshot->deferred = NULL;
+    psSnapshot->deferredCount = 0;
+    psSnapshot->deferredRoom = 0;
+    return psSnapshot;
+}
+
+SymTable_T SymTable_snapshot(SymTable_T oSymTable) {
+    SymTable_T oSnapshot;
+    struct snapshot *psSnapshot;
+    struct snapshot *psLive;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->mode == MODE_LIVE);
+    SymTable_settle(oSymTable);
+    if (oSymTable->mode != MODE_LIVE)
+        return NULL;
+    /* a snapshot reads the buckets of its live table*/
+    if (! SymTable_spill(oSymTable))
+        return NULL;
+
+    /* shares every bucket with oSymTable until oSymTable changes it*/
+    oSnapshot = (SymTable_T) malloc(sizeof(struct SymTable));
+    psSnapshot = SymTable_newSnapshotState();
+    psLive = oSymTable->snapshot;
+    if (psLive == NULL)
+        psLive = SymTable_newSnapshotState();
+    if (oSnapshot == NULL || psSnapshot == NULL || psLive == NULL) {
+        if (psLive != oSymTable->snapshot)
+            free(psLive);
+        free(psSnapshot);
+        free(oSnapshot);
+        return NULL;
+    }
+    SymTable_initFields(oSnapshot, MODE_SNAPSHOT, oSymTable->seed[0],
+        oSymTable->seed[1]);
+    psSnapshot->source = oSymTable;
+    psSnapshot->next = psLive->first;
+    psSnapshot->owner = oSymTable;
+    oSnapshot->snapshot = psSnapshot;
+    oSnapshot->length = oSymTable->length;
+    oSnapshot->numOfcells = oSymTable->numOfcells;
+    oSnapshot->bucketStep = oSymTable->bucketStep;
+    psLive->first = oSnapshot;
+    psLive->count++;
+    oSymTable->snapshot = psLive;
+    return oSnapshot;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_writerBegin(SymTable_T oSymTable) {
+    struct writer *psWriter;
+    assert(oSymTable != NULL);
+    assert(oSymTable->mode == MODE_LIVE);
+    if (oSymTable->mode != MODE_LIVE)
+        return 0;
+    if (oSymTable->writer != NULL)
+        return 1;
+    psWriter = (struct writer*)malloc(sizeof(struct writer));
+    if (psWriter == NULL)
+        return 0;
+    psWriter->entries = (struct logEntry*)
+        malloc(WRITER_LOG_MIN * sizeof(struct logEntry));
+    psWriter->keys = (char*)malloc(WRITER_LOG_MIN * POOL_GRANULE);
+    if (psWriter->entries == NULL || psWriter->keys == NULL) {
+        free(psWriter->entries);
+        free(psWriter->keys);
+        free(psWriter);
+        return 0;
+    }
+    psWriter->count = 0;
+    psWriter->room = WRITER_LOG_MIN;
+    psWriter->keySize = 0;
+    psWriter->keyRoom = WRITER_LOG_MIN * POOL_GRANULE;
+    psWriter->added = 0;
+    psWriter->dropped = 0;
+    oSymTable->writer = psWriter;
+    return 1;
+}
+
+int SymTable_writerPutN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, const void *pvValue) {
+    struct writer *psWriter;
+    struct logEntry *psEntries;
+    struct logEntry *psEntry;
+    char *pcKeys;
+    size_t uRoom;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(oSymTable->writer != NULL);
+
+    /* a full log is applied, so the log never holds more than
+       WRITER_LOG_MAX puts; SymTable_writerFlush reports a drop*/
+    psWriter = oSymTable->writer;
+    if (psWriter->count == WRITER_LOG_MAX)
+        (void)SymTable_applyLog(oSymTable);
+    if (psWriter->count == psWriter->room) {
+        psEntries = (struct logEntry*)realloc(psWriter->entries,
+            2 * psWriter->room * sizeof(struct logEntry));
+        if (psEntries == NULL)
+            return 0;
+        psWriter->entries = psEntries;
+        psWriter->room *= 2;
+    }
+    if (uLength > psWriter->keyRoom - psWriter->keySize) {
+        for (uRoom = 2 * psWriter->keyRoom;
+                uLength > uRoom - psWriter->keySize; uRoom *= 2)
+            ;
+        pcKeys = (char*)realloc(psWriter->keys, uRoom);
+        if (pcKeys == NULL)
+            return 0;
+        psWriter->keys = pcKeys;
+        psWriter->keyRoom = uRoom;
+    }
+
+    psEntry = &psWriter->entries[psWriter->count];
+    psEntry->hash = SymTable_hash(oSymTable, pcKey, uLength);
+    psEntry->keyLength = uLength;
+    psEntry->keyOffset = psWriter->keySize;
+    psEntry->value = pvValue;
+    memcpy(psWriter->keys + psWriter->keySize, pcKey, uLength);
+    psWriter->keySize += uLength;
+    psWriter->count++;
+    return 1;
+}
+
+int SymTable_writerPut(SymTable_T oSymTable, const char *pcKey,
+   const void *pvValue) {
+    assert(pcKey != NULL);
+    return SymTable_writerPutN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+int SymTable_writerFlush(SymTable_T oSymTable, size_t *puAdded) {
+    int iSuccessful;
+    assert(oSymTable != NULL);
+    assert(oSymTable->writer != NULL);
+    SymTable_settle(oSymTable);
+    if (puAdded != NULL)
+        *puAdded = oSymTable->writer->added;
+    iSuccessful = ! oSymTable->writer->dropped;
+    SymTable_freeWriter(oSymTable);
+    return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* work range structure which holds the tasks of one worker of a
+parallel build that have not been taken: task first up to task
+last - 1. The worker takes tasks from the front and, once its own are
+gone, steals from the back of the other workers' ranges. Each range
+has cache lines of its own.*/
+struct workRange {
+    pthread_mutex_t lock;
+    size_t first;
+    size_t last;
+};
+
+/* a work range padded to whole cache lines*/
+union workLine {
+    struct workRange range;
+    char line[CACHE_ROUND(sizeof(struct workRange))];
+};
+
+/* build structure which describes a parallel build. The keys are cut
+into chunks of BUILD_CHUNK, and the buckets into partitions of
+partitionSize consecutive buckets. The first phase makes a node for
+every key, chunk by chunk, and stores the nodes of each chunk in its
+part of nodes ordered by partition, at offsets[c * (partitionCount +
+1) + p] for chunk c and partition p. The second phase links the nodes
+of each partition into its buckets, chunk by chunk, so the keys of a
+partition are linked in the order they came in.*/
+struct build {
+    SymTable_T table;
+    const char *const *keys;
+    const void *const *values;
+    size_t count;
+    size_t chunkCount;
+    size_t partitionCount;
+    size_t partitionSize;
+    struct node **nodes;
+    /* the nodes of each chunk in the order of its keys, before they
+       are stored in nodes*/
+    struct node **made;
+    size_t *offsets;
+    /* per partition: the bindings linked, and whether a bucket reached
+       the tree threshold*/
+    size_t *lengths;
+    unsigned char *longBuckets;
+    /* set by a task that finds insufficient memory*/
+    int failed;
+    /* the task run by the workers, and their ranges*/
+    void (*runTask)(struct build *psBuild, size_t uTask);
+    union workLine *ranges;
+    size_t workerCount;
+};
+
+/* the number of keys in a chunk of a parallel build, and the number
+   of partitions of the buckets per worker */
+enum {BUILD_CHUNK = 4096, BUILD_PARTITIONS = 16};
+
+/* Make the nodes of the keys of chunk uChunk of psBuild, and store
+   them in the chunk's part of psBuild->nodes ordered by partition, as
+   described for struct build. */
+
+static void SymTable_buildChunk(struct build *psBuild, size_t uChunk) {
+    struct node **apsNodes;
+    size_t *puOffsets = psBuild->offsets +
+        uChunk * (psBuild->partitionCount + 1);
+    size_t uFirst = uChunk * BUILD_CHUNK;
+    size_t uCount = psBuild->count - uFirst < BUILD_CHUNK ?
+        psBuild->count - uFirst : BUILD_CHUNK;
+    size_t uLength;
+    size_t uPartition;
+    size_t uSum;
+    size_t u;
+    struct node *psNode;
+
+    apsNodes = psBuild->made + uFirst;
+    for (u = 0; u <= psBuild->partitionCount; u++)
+        puOffsets[u] = 0;
+    for (u = 0; u < uCount; u++) {
+        uLength = strlen(psBuild->keys[uFirst + u]);
+        /* the pool of the table is not shared between threads*/
+        psNode = (struct node*)malloc(SymTable_nodeSize(uLength));
+        apsNodes[u] = psNode;
+        if (psNode == NULL) {
+            __atomic_store_n(&psBuild->failed, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        memcpy(psNode->key, psBuild->keys[uFirst + u], uLength + 1);
+        psNode->keyLength = uLength;
+        psNode->hash = SymTable_hash(psBuild->table, psNode->key, uLength);
+        psNode->value = psBuild->values[uFirst + u];
+        psNode->nextNode = NULL;
+        puOffsets[psNode->hash % psBuild->table->numOfcells /
+            psBuild->partitionSize + 1]++;
+    }
+    for (u = 0, uSum = 0; u <= psBuild->partitionCount; u++) {
+        uSum += puOffsets[u];
+        puOffsets[u] = uFirst + uSum;
+    }
+    /* a failed allocation leaves its slot at the end of the chunk*/
+    for (u = uFirst + uSum; u < uFirst + uCount; u++)
+        psBuild->nodes[u] = NULL;
+    for (u = 0; u < uCount; u++)
+        if (apsNodes[u] != NULL) {
+            uPartition = apsNodes[u]->hash %
+                psBuild->table->numOfcells / psBuild->partitionSize;
+            psBuild->nodes[puOffsets[uPartition]++] = apsNodes[u];
+        }
+    /* each offset moved to the start of the next partition*/
+    for (u = psBuild->partitionCount; u > 0; u--)
+        puOffsets[u] = puOffsets[u - 1];
+    puOffsets[0] = uFirst;
+}
+
+/* Link the nodes of partition uPartition of psBuild into their
+   buckets, freeing every node whose key an earlier node of the
+   partition has. */
+
+static void SymTable_buildPartition(struct build *psBuild,
+   size_t uPartition) {
+    struct node **ppsBuckets = psBuild->table->firstNodes;
+    struct node *psNode;
+    struct node *currentNode;
+    size_t uThreshold = psBuild->table->treeThreshold;
+    size_t uLength = 0;
+    size_t uBucket;
+    size_t uDepth;
+    size_t uChunk;
+    size_t u;
+    const size_t *puOffsets;
+
+    for (uChunk = 0; uChunk < psBuild->chunkCount; uChunk++) {
+        puOffsets = psBuild->offsets +
+            uChunk * (psBuild->partitionCount + 1);
+        for (u = puOffsets[uPartition]; u < puOffsets[uPartition + 1];
+                u++) {
+            psNode = psBuild->nodes[u];
+            uBucket = psNode->hash % psBuild->table->numOfcells;
+            uDepth = 0;
+            for (currentNode = ppsBuckets[uBucket]; currentNode != NULL;
+                    currentNode = currentNode->nextNode) {
+                if (currentNode->hash == psNode->hash &&
+                        currentNode->keyLength == psNode->keyLength &&
+                        memcmp(currentNode->key, psNode->key,
+                            psNode->keyLength) == 0)
+                    break;
+                uDepth++;
+            }
+            if (currentNode != NULL) {
+                free(psNode);
+                continue;
+            }
+            psNode->nextNode = ppsBuckets[uBucket];
+            ppsBuckets[uBucket] = psNode;
+            uLength++;
+            if (uThreshold != 0 && uDepth + 1 >= uThreshold)
+                psBuild->longBuckets[uPartition] = 1;
+        }
+    }
+    psBuild->lengths[uPartition] = uLength;
+}
+
+/* Take a task for worker uWorker of psBuild, its own first and
+   otherwise one stolen from another worker, and store it in *puTask.
+   Return 1 (TRUE), or 0 (FALSE) if no task is left. */
+
+static int SymTable_takeTask(struct build *psBuild, size_t uWorker,
+   size_t *puTask) {
+    struct workRange *psRange;
+    size_t u;
+    int iTaken;
+
+    for (u = 0; u < psBuild->workerCount; u++) {
+        psRange = &psBuild->ranges[(uWorker + u) %
+            psBuild->workerCount].range;
+        pthread_mutex_lock(&psRange->lock);
+        iTaken = psRange->first < psRange->last;
+        if (iTaken)
+            *puTask = u == 0 ? psRange->first++ : --psRange->last;
+        pthread_mutex_unlock(&psRange->lock);
+        if (iTaken)
+            return 1;
+    }
+    return 0;
+}
+
+/* worker structure which describes one worker thread of a parallel
+build*/
+struct worker {
+    pthread_t thread;
+    struct build *build;
+    size_t index;
+};
+
+/* Run tasks of the build of pvWorker, a struct worker, until none is
+   left. Return NULL. */
+
+static void *SymTable_runWorker(void *pvWorker) {
+    struct worker *psWorker = (struct worker*)pvWorker;
+    size_t uTask;
+    while (SymTable_takeTask(psWorker->build, psWorker->index, &uTask))
+        (*psWorker->build->runTask)(psWorker->build, uTask);
+    return NULL;
+}
+
+/* Run tasks 0 up to uTasks - 1 of psBuild with pfRunTask on its
+   workers, the calling thread being worker 0, and return when every
+   task has run. Each worker starts with an equal share of the tasks.
+   A worker whose thread cannot be created runs nothing, and the
+   others steal its tasks. */
+
+static void SymTable_runTasks(struct build *psBuild,
+   void (*pfRunTask)(struct build *psBuild, size_t uTask),
+   size_t uTasks, struct worker *psWorkers) {
+    size_t uStarted;
+    size_t u;
+
+    psBuild->runTask = pfRunTask;
+    for (u = 0; u < psBuild->workerCount; u++) {
+        psBuild->ranges[u].range.first = uTasks * u / psBuild->workerCount;
+        psBuild->ranges[u].range.last =
+            uTasks * (u + 1) / psBuild->workerCount;
+    }
+    for (uStarted = 1; uStarted < psBuild->workerCount; uStarted++) {
+        psWorkers[uStarted].build = psBuild;
+        psWorkers[uStarted].index = uStarted;
+        if (pthread_create(&psWorkers[uStarted].thread, NULL,
+                SymTable_runWorker, &psWorkers[uStarted]) != 0)
+            break;
+    }
+    psWorkers[0].build = psBuild;
+    psWorkers[0].index = 0;
+    (void)SymTable_runWorker(&psWorkers[0]);
+    for (u = 1; u < uStarted; u++)
+        pthread_join(psWorkers[u].thread, NULL);
+}
+
+/* Free the arrays of psBuild other than its table and workers. */
+
+static void SymTable_freeBuild(struct build *psBuild) {
+    free(psBuild->nodes);
+    free(psBuild->made);
+    free(psBuild->offsets);
+    free(psBuild->lengths);
+    free(psBuild->longBuckets);
+}
+
+/* Convert every chain bucket of oSymTable from uFirst up to uLast - 1
+   that has reached the tree threshold. */
+
+static void SymTable_treeifyRange(SymTable_T oSymTable, size_t uFirst,
+   size_t uLast) {
+    struct node *currentNode;
+    size_t uLength;
+    size_t u;
+    if (uLast > oSymTable->numOfcells)
+        uLast = oSymTable->numOfcells;
+    for (u = uFirst; u < uLast; u++) {
+        uLength = 0;
+        for (currentNode = oSymTable->firstNodes[u]; currentNode != NULL;
+                currentNode = currentNode->nextNode)
+            uLength++;
+        if (uLength >= oSymTable->treeThreshold)
+            SymTable_treeify(oSymTable, u);
+    }
+}
+
+SymTable_T SymTable_buildParallel(const char *const *ppcKeys,
+   const void *const *ppvValues, size_t uCount, size_t uThreads) {
+    struct build sBuild;
+    struct worker *psWorkers;
+    size_t uStep = 0;
+    size_t uLength = 0;
+    size_t u;
+    long lProcessors;
+
+    assert(uCount == 0 || (ppcKeys != NULL && ppvValues != NULL));
+    if (uThreads == 0) {
+        lProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+        uThreads = lProcessors > 0 ? (size_t)lProcessors : 1;
+    }
+    sBuild.table = SymTable_new();
+    if (sBuild.table == NULL)
+        return NULL;
+    /* a table that stays small, and a spill or resize that fails, are
+       left to SymTable_put, which fails only if it drops a key not yet
+       bound*/
+    while (uStep + 1 < BUCKET_COUNT_STEPS && auBucketCounts[uStep] < uCount)
+        uStep++;
+    if (uCount <= SMALL_SLOTS || ! SymTable_spill(sBuild.table) ||
+            (uStep > 0 && ! SymTable_rehash(sBuild.table, uStep))) {
+        for (u = 0; u < uCount; u++)
+            if (! SymTable_put(sBuild.table, ppcKeys[u], ppvValues[u]) &&
+                    ! SymTable_contains(sBuild.table, ppcKeys[u])) {
+                SymTable_free(sBuild.table);
+                return NULL;
+            }
+        return sBuild.table;
+    }
+
+    sBuild.keys = ppcKeys;
+    sBuild.values = ppvValues;
+    sBuild.count = uCount;
+    sBuild.chunkCount = (uCount + BUILD_CHUNK - 1) / BUILD_CHUNK;
+    sBuild.partitionCount = uThreads * BUILD_PARTITIONS;
+    if (sBuild.partitionCount > sBuild.table->numOfcells)
+        sBuild.partitionCount = sBuild.table->numOfcells;
+    sBuild.partitionSize = (sBuild.table->numOfcells +
+        sBuild.partitionCount - 1) / sBuild.partitionCount;
+    sBuild.failed = 0;
+    sBuild.workerCount = uThreads;
+    sBuild.nodes = (struct node**)malloc(uCount * sizeof(struct node*));
+    sBuild.made = (struct node**)malloc(uCount * sizeof(struct node*));
+    sBuild.offsets = (size_t*)malloc(sBuild.chunkCount *
+        (sBuild.partitionCount + 1) * sizeof(size_t));
+    sBuild.lengths = (size_t*)
+        calloc(sBuild.partitionCount, sizeof(size_t));
+    sBuild.longBuckets = (unsigned char*)calloc(sBuild.partitionCount, 1);
+    psWorkers = (struct worker*)malloc(uThreads * sizeof(struct worker));
+    if (posix_memalign((void**)&sBuild.ranges, CACHE_LINE,
+            uThreads * sizeof(union workLine)) != 0)
+        sBuild.ranges = NULL;
+    for (u = 0; sBuild.ranges != NULL && u < uThreads; u++)
+        if (pthread_mutex_init(&sBuild.ranges[u].range.lock, NULL) != 0)
+            break;
+    if (sBuild.nodes == NULL || sBuild.made == NULL ||
+            sBuild.offsets == NULL || sBuild.lengths == NULL ||
+            sBuild.longBuckets == NULL || psWorkers == NULL ||
+            sBuild.ranges == NULL || u < uThreads) {
+        while (sBuild.ranges != NULL && u > 0)
+            pthread_mutex_destroy(&sBuild.ranges[--u].range.lock);
+        free(sBuild.ranges);
+        free(psWorkers);
+        SymTable_freeBuild(&sBuild);
+        SymTable_free(sBuild.table);
+        return NULL;
+    }
+
+    SymTable_runTasks(&sBuild, SymTable_buildChunk, sBuild.chunkCount,
+        psWorkers);
+    free(sBuild.made);
+    sBuild.made = NULL;
+    if (sBuild.failed) {
+        /* every node made is in nodes, and the slots of the others are
+           NULL*/
+        for (u = 0; u < uCount; u++)
+            free(sBuild.nodes[u]);
+    }
+    else
+        SymTable_runTasks(&sBuild, SymTable_buildPartition,
+            sBuild.partitionCount, psWorkers);
+
+    for (u = 0; u < uThreads; u++)
+        pthread_mutex_destroy(&sBuild.ranges[u].range.lock);
+    free(sBuild.ranges);
+    free(psWorkers);
+    if (sBuild.failed) {
+        SymTable_freeBuild(&sBuild);
+        SymTable_free(sBuild.table);
+        return NULL;
+    }
+
+    /* converts the long buckets here, since the tree roots are shared
+       by every partition*/
+    for (u = 0; u < sBuild.partitionCount; u++) {
+        uLength += sBuild.lengths[u];
+        if (sBuild.longBuckets[u])
+            SymTable_treeifyRange(sBuild.table, u * sBuild.partitionSize,
+                (u + 1) * sBuild.partitionSize);
+    }
+    sBuild.table->length = uLength;
+#ifdef SYMTABLE_STATS
+    sBuild.table->sStats.uPuts += uCount;
+    sBuild.table->sStats.uAllocs += uCount;
+    sBuild.table->sStats.uFrees += uCount - uLength;
+#endif
+    SymTable_freeBuild(&sBuild);
+    return sBuild.table;
+}
@@ -0,0 +1,373 @@
+/*--------------------------------------------------------------------*/
+/* symtablehash.h                                                     */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* Extensions of the SymTable interface that only the hash table
+   implementation (symtablehash.c) provides. Every function declared
+   in symtable.h is available as well. */
+
+#ifndef SYMTABLEHASH_INCLUDED
+#define SYMTABLEHASH_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "symtable.h"
+
+/*--------------------------------------------------------------------*/
+
+/* return a new SymTable object that contains no bindings and hashes
+   its keys with the 128-bit key (uSeed0, uSeed1), or NULL if
+   insufficient memory is available. SymTable_new picks a fresh
+   unpredictable key for every table; use this function only when
+   bucket placement must be reproducible. */
+
+  SymTable_T SymTable_newSeeded(uint64_t uSeed0, uint64_t uSeed1);
+
+/*--------------------------------------------------------------------*/
+
+/* return a new SymTable object that contains no bindings and that
+   several threads may use at once, or NULL if uShards is 0 or above
+   65536 or insufficient memory is available. The table is split into
+   uShards shards, rounded up to a power of 2: independent hash tables,
+   each with its own lock, that grow and shrink on their own. The top
+   bits of a key's hash code pick its shard, so threads whose keys fall
+   in different shards never wait for each other or for a resize.
+   Each thread counts the bindings it adds and removes in one of 16
+   stripes of the table's length counter, each in a cache line of its
+   own. SymTable_getLength adds up the stripes without taking a lock:
+   it is exact when no put or remove runs at the same time, and
+   otherwise may count some of them and not others.
+
+   Every function of symtable.h may be called on the object from any
+   thread, except SymTable_free, which must not run while another
+   function runs on the table. SymTable_map and SymTable_clear lock one
+   shard at a time, so they see each shard as it is at some moment
+   during the call; pfApply must not call into the table. A clone is
+   sharded as well. Of the functions of this header,
+   SymTable_setTreeThreshold applies to every shard,
+   SymTable_getBucketCount returns the total of the shards, and
+   SymTable_bucketOf returns the index of a key's bucket within its
+   shard; SymTable_compact, SymTable_setFilter, SymTable_save,
+   SymTable_freeze and SymTable_snapshot fail an assertion. */
+
+  SymTable_T SymTable_newSharded(size_t uShards);
+
+/*--------------------------------------------------------------------*/
+
+/* return the number of bindings in oSymTable. For a sharded table
+   the number is the length of the table at one moment during the
+   call: this reads the stripes of the length counter until two reads
+   in a row agree, and only if puts and removes keep changing them
+   does it hold the locks of every shard at once, making every put and
+   remove wait; SymTable_getLength reads the stripes once and waits
+   for nothing. For any other table it returns what
+   SymTable_getLength does. */
+
+  size_t SymTable_getExactLength(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+
+/* make oSymTable convert any bucket that reaches uThreshold bindings
+   into a balanced search tree, so that a flood of colliding keys
+   costs O(log n) per operation instead of O(n). A uThreshold of 0
+   disables the conversion for buckets that have not been converted
+   yet. New tables use a threshold of 8. */
+
+  void SymTable_setTreeThreshold(SymTable_T oSymTable, size_t uThreshold);
+
+/*--------------------------------------------------------------------*/
+
+/* return the index of the bucket of oSymTable that a binding with key
+   pcKey occupies, or would occupy. */
+
+  size_t SymTable_bucketOf(SymTable_T oSymTable, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+
+/* return the number of buckets oSymTable currently has. A table
+   starts with 509, allocated when it first holds more than 8
+   bindings, grows when it holds more bindings than buckets and
+   shrinks when it holds fewer than one binding per 8 buckets. */
+
+  size_t SymTable_getBucketCount(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+
+/* resize oSymTable to the smallest bucket count that holds its
+   bindings, and move its bindings into fresh memory in the order
+   SymTable_map visits them. Call it after a burst of removals to
+   return memory and make traversals sequential. return 1 (TRUE) on
+   success, or 0 (FALSE) if insufficient memory is available for the
+   temporary second copy of the bindings, in which case oSymTable
+   holds the same bindings as before. */
+
+  int SymTable_compact(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+
+/* give oSymTable a Bloom filter of its keys if iEnabled is nonzero,
+   or drop its filter otherwise. A table starts without one. The
+   filter costs 1 byte per bucket and lets SymTable_get,
+   SymTable_contains, SymTable_replace and SymTable_remove rule out
+   most keys the table does not hold without visiting a bucket, which
+   pays off when most lookups miss. It grows with the table and is
+   rebuilt after SymTable_compact and after more removals than the
+   table holds bindings, but no fewer than it has buckets. return 1 (TRUE) on success, or 0 (FALSE) if
+   insufficient memory is available, in which case oSymTable is
+   unchanged. Only live tables, not snapshots, frozen or mapped
+   tables, may have a filter. */
+
+  int SymTable_setFilter(SymTable_T oSymTable, int iEnabled);
+
+/*--------------------------------------------------------------------*/
+
+/* The operations whose latencies a traced table records: puts
+   (SymTable_put), lookups (SymTable_get and SymTable_contains) and
+   removes (SymTable_remove and SymTable_delete), each with its N
+   variant. */
+
+enum SymTableOp {SYMTABLE_OP_PUT, SYMTABLE_OP_GET, SYMTABLE_OP_REMOVE,
+   SYMTABLE_OP_COUNT};
+
+/* A SymTableLatency is a log-linear histogram of the latencies of one
+   operation, in nanoseconds, in the manner of HdrHistogram. Bucket i
+   counts latencies of i ns up to 15 ns. Above that, each power of 2 is
+   split into 16 buckets of equal width, so a bucket is at most 1/16 of
+   its latencies wide. The last bucket also counts every latency of
+   2^36 ns (about 69 seconds) and more. */
+
+enum {SYMTABLE_LATENCY_BUCKETS = 528};
+
+struct SymTableLatency {
+   /* the operations timed, and the longest latency among them */
+   uint64_t uCount;
+   uint64_t uMax;
+
+   uint64_t auBuckets[SYMTABLE_LATENCY_BUCKETS];
+};
+
+/* A SymTableSlowOp describes an operation for which a traced table
+   calls its slow-operation hook. */
+
+struct SymTableSlowOp {
+   enum SymTableOp eOp;
+
+   /* the key of the operation, valid only during the call, and its
+      length */
+   const char *pcKey;
+   size_t uLength;
+
+   /* the latency of the operation, in nanoseconds, or 0 if it was not
+      timed */
+   uint64_t uNanoseconds;
+
+   /* the nodes of a chain bucket the operation visited */
+   size_t uDepth;
+
+   /* the bucket count before and after the operation, which differ if
+      the operation resized the table */
+   size_t uBucketsBefore;
+   size_t uBucketsAfter;
+};
+
+/* start tracing the operations of live table oSymTable, timing one
+   operation in every uInterval, or stop tracing them and drop their
+   histograms and the slow-operation hook if uInterval is 0. A table
+   starts untraced. A timed operation reads the monotonic clock twice
+   and adds its latency to the histogram of its kind. Reading the
+   clock keeps the processor from overlapping the operation with its
+   neighbors, so timing every operation slows a run of lookups that
+   miss the cache by up to half; an interval of 100 or so keeps the
+   percentiles and costs little. An untraced table pays one test of a
+   pointer per operation. return 1 (TRUE) on success, or 0 (FALSE) if
+   insufficient memory is available, in which case oSymTable is
+   unchanged. If oSymTable is traced already, change its interval and
+   keep its histograms. */
+
+  int SymTable_setTracing(SymTable_T oSymTable, size_t uInterval);
+
+/* make traced table oSymTable call pfSlow, with pvExtra, after every
+   operation that visited uDepth or more nodes of a chain bucket or
+   that resized the table, and after every timed operation that took
+   uNanoseconds or more. A threshold of 0 leaves out its condition.
+   The latency that pfSlow receives does not include pfSlow itself.
+   pfSlow must not call into oSymTable. A pfSlow of NULL removes the
+   hook. */
+
+  void SymTable_setSlowHook(SymTable_T oSymTable, uint64_t uNanoseconds,
+     size_t uDepth,
+     void (*pfSlow)(const struct SymTableSlowOp *psOp, void *pvExtra),
+     const void *pvExtra);
+
+/* copy the histogram of operation eOp of oSymTable into *psLatency.
+   Every count is 0 if oSymTable is not traced. */
+
+  void SymTable_getLatency(SymTable_T oSymTable, enum SymTableOp eOp,
+     struct SymTableLatency *psLatency);
+
+/* reset every histogram of oSymTable to 0. */
+
+  void SymTable_resetLatency(SymTable_T oSymTable);
+
+/* return the latency, in nanoseconds, below or at which the fraction
+   dFraction of the operations of *psLatency fell, such as 0.99 for
+   the 99th percentile. The value is the upper end of the bucket that
+   holds it, so it overstates the exact percentile by less than 1/16,
+   and it never exceeds psLatency->uMax. return 0 if *psLatency counts
+   no operation. */
+
+  uint64_t SymTable_latencyAt(const struct SymTableLatency *psLatency,
+     double dFraction);
+
+/*--------------------------------------------------------------------*/
+
+/* write an image of oSymTable to psFile and return 1 (TRUE), or
+   return 0 (FALSE) if insufficient memory is available or a write
+   fails. Each value is stored as the bytes *pfEncode produces for it:
+   pfEncode must write the encoding of pvValue into the uSize bytes at
+   pvBuffer if it fits, and return its size in bytes whether or not it
+   fits. The image holds the buckets, hash codes, keys and encoded
+   values at offsets relative to its start, so it can be mapped at
+   any address; it can only be read on a machine with the same byte
+   order. */
+
+  int SymTable_save(SymTable_T oSymTable, FILE *psFile,
+     size_t (*pfEncode)(const void *pvValue, void *pvBuffer,
+        size_t uSize));
+
+/*--------------------------------------------------------------------*/
+
+/* return a read-only SymTable object whose bindings are those of the
+   image in file pcPath, written by SymTable_save, or NULL if the file
+   cannot be mapped or does not hold such an image. The file is mapped
+   into memory rather than read, so lookups load only the pages they
+   touch, but opening reads every bucket start and entry once to check
+   that the buckets and keys lie inside the image, so a truncated or
+   corrupt file is refused rather than read out of bounds. The bytes
+   of the values are not checked: they are whatever the encoding gave.
+   SymTable_get returns the address of the value's encoding inside the
+   mapping, aligned to 8 bytes, which must not be written to. Only
+   SymTable_free and functions that do not change the table may be
+   called on the object; the others fail an assertion. */
+
+  SymTable_T SymTable_openMapped(const char *pcPath);
+
+/* return what SymTable_openMapped(pcPath) returns, but check only the
+   header of the image, so opening costs the same for any number of
+   bindings. The image must be trusted: one whose buckets or entries
+   were changed after SymTable_save wrote them makes lookups read
+   outside the mapping. */
+
+  SymTable_T SymTable_openMappedTrusted(const char *pcPath);
+
+/*--------------------------------------------------------------------*/
+
+/* return a new read-only SymTable object with the bindings of
+   oSymTable, or NULL if insufficient memory is available. The new
+   object is a perfect hash table: every key has a slot of its own, so
+   SymTable_get and SymTable_contains examine exactly one slot. It
+   holds its own copy of the keys, so oSymTable may be changed or
+   freed afterwards. Only SymTable_free and functions that do not
+   change the table may be called on the object; the others fail an
+   assertion. */
+
+  SymTable_T SymTable_freeze(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+
+/* return a read-only snapshot of oSymTable: a SymTable object whose
+   bindings are those oSymTable has now, however oSymTable changes
+   later, or NULL if insufficient memory is available. Taking a
+   snapshot copies nothing. Instead, the first change oSymTable makes
+   to one of every 16 adjacent buckets after the snapshot is taken
+   first copies those buckets into the snapshot; SymTable_clear,
+   SymTable_compact and resizing copy all of them. When insufficient
+   memory is available for such a copy, SymTable_put returns 0,
+   SymTable_replace and SymTable_remove return NULL, and the other
+   functions leave oSymTable unchanged. The snapshot shares the
+   values of oSymTable and may outlive it. While any snapshot of
+   oSymTable exists, SymTable_delete and SymTable_clear keep the values
+   they would destroy, and the last snapshot to be freed destroys them;
+   if oSymTable is freed first, the last snapshot frees it with its
+   values. Only SymTable_free and functions that do not change the
+   table may be called on the snapshot; the others fail an
+   assertion. */
+
+  SymTable_T SymTable_snapshot(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+
+/* start a writer on live table oSymTable and return 1 (TRUE), or
+   return 0 (FALSE) if insufficient memory is available. A writer
+   logs the puts of SymTable_writerPut instead of making them, and
+   makes them later in the order of their buckets rather than the
+   order they came in, with the table grown once to its final size.
+   The puts are made, as SymTable_put would have made them in the
+   order they were logged, before any other function of symtable.h or
+   of this header reads or changes oSymTable, and whenever the log
+   holds 1048576 puts, so every such function sees every binding that
+   has been put. A put that finds no memory when it is made is dropped,
+   and SymTable_writerFlush reports it. Freeing oSymTable while its log
+   holds puts discards them unmade if oSymTable has no destructor: the
+   client still owns their values, and must free them itself if
+   nothing else does. If oSymTable has a destructor, SymTable_free
+   makes the puts first, so every logged value is destroyed exactly
+   once, bound or not. If oSymTable has a writer already, return 1
+   (TRUE) and keep it. */
+
+  int SymTable_writerBegin(SymTable_T oSymTable);
+
+/* log a put of the binding of key pcKey and value pvValue to the
+   writer of oSymTable and return 1 (TRUE), or return 0 (FALSE),
+   leaving the log unchanged, if insufficient memory is available.
+   The key is copied into the log, so the caller may reuse pcKey at
+   once. oSymTable must have a writer. When the put is made it has no
+   effect if pcKey is bound by then, as with SymTable_put, and it is
+   dropped if insufficient memory is available. If oSymTable has a
+   destructor, it owns pvValue from now on: a put that binds nothing
+   calls the destructor on pvValue, unless pcKey is bound to pvValue
+   itself. */
+
+  int SymTable_writerPut(SymTable_T oSymTable, const char *pcKey,
+     const void *pvValue);
+
+/* log a put as SymTable_writerPut does, of a key made of the uLength
+   characters at pcKey, which need not be followed by '\0' but must
+   not contain '\0', as with SymTable_putN. */
+
+  int SymTable_writerPutN(SymTable_T oSymTable, const char *pcKey,
+     size_t uLength, const void *pvValue);
+
+/* make the puts still in the log of the writer of oSymTable, end the
+   writer, and store in *puAdded, unless puAdded is NULL, the number of
+   logged puts that bound their key since SymTable_writerBegin: the
+   number of times SymTable_put would have returned 1 (TRUE). return 1
+   (TRUE) if every logged put was made or found its key bound, or 0
+   (FALSE) if any was dropped for lack of memory since
+   SymTable_writerBegin. oSymTable must have a writer. */
+
+  int SymTable_writerFlush(SymTable_T oSymTable, size_t *puAdded);
+
+/*--------------------------------------------------------------------*/
+
+/* return a new SymTable object that binds each of the uCount keys at
+   ppcKeys to the value at the same index of ppvValues, or NULL if
+   insufficient memory is available. A key that occurs more than once
+   is bound to the value of its first occurrence, as if the keys had
+   been put in order, so SymTable_getLength tells how many distinct
+   keys there are. The table is built by uThreads threads, the calling
+   thread among them, or by one per online processor if uThreads is
+   0. The keys are cut into chunks that the threads hash and copy into
+   nodes, and the buckets into ranges that the threads fill; a thread
+   that runs out of chunks or ranges takes some from another. The
+   object is the same as one filled by SymTable_put, and belongs to
+   the calling thread when the function returns. */
+
+  SymTable_T SymTable_buildParallel(const char *const *ppcKeys,
+     const void *const *ppvValues, size_t uCount, size_t uThreads);
+
+/*--------------------------------------------------------------------*/
+
+#endif
@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "symtable.h"
+#include "symtablestats.h"
 
 
 /* node structure which contains pointer to the defensive copy of the key,
@@ -28,9 +29,25 @@ struct SymTable {
 
   /* how many nodes inside the symbol table*/
   size_t length;
-  
+
+  /* the function that frees a value the table discards, or NULL*/
+  void (*freeValue)(void *pvValue);
+
+#ifdef SYMTABLE_STATS
+  /* hot-path counters, see SymTable_getStats */
+  struct SymTableStats sStats;
+#endif
 };
 
+/* Return 1 (TRUE) if the key pcNodeKey of a node is the uLength
+   characters at pcKey, and 0 (FALSE) otherwise. */
+
+static int SymTable_keyEquals(const char *pcNodeKey, const char *pcKey,
+   size_t uLength) {
+    return strncmp(pcNodeKey, pcKey, uLength) == 0 &&
+        pcNodeKey[uLength] == '\0';
+}
+
 
 SymTable_T SymTable_new(void) {
     SymTable_T oSymTable;
@@ -42,9 +59,22 @@ SymTable_T SymTable_new(void) {
 
    oSymTable->first = NULL;
    oSymTable->length = 0;
+   oSymTable->freeValue = NULL;
+#ifdef SYMTABLE_STATS
+   memset(&oSymTable->sStats, 0, sizeof(oSymTable->sStats));
+#endif
    return oSymTable;
 }
 
+SymTable_T SymTable_newWithDestructor(void (*pfFreeValue)(void *pvValue)) {
+    SymTable_T oSymTable;
+    assert(pfFreeValue != NULL);
+    oSymTable = SymTable_new();
+    if (oSymTable != NULL)
+        oSymTable->freeValue = pfFreeValue;
+    return oSymTable;
+}
+
 void SymTable_free(SymTable_T oSymTable) {
     
    struct node *currentNode;
@@ -56,6 +86,8 @@ void SymTable_free(SymTable_T oSymTable) {
         currentNode = nextNode)
    {
       nextNode = currentNode->nextNode;
+      if (oSymTable->freeValue != NULL)
+         (*oSymTable->freeValue)((void*) currentNode->value);
       free((char*) currentNode->key);
       free(currentNode);
    }
@@ -68,17 +100,23 @@ size_t SymTable_getLength(SymTable_T oSymTable) {
    return oSymTable->length;
 }
 
-int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+   const void *pvValue) {
     struct node *currentNode;
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
+    SYMTABLE_COUNT(oSymTable, uPuts);
     /* loops through all the nodes in search for pcKey*/
     for (currentNode = oSymTable->first; currentNode != NULL; 
             currentNode = currentNode -> nextNode) {
-        if (strcmp(currentNode->key, pcKey) == 0) {
+        SYMTABLE_COUNT(oSymTable, uProbes);
+        SYMTABLE_COUNT(oSymTable, uKeyCompares);
+        if (SymTable_keyEquals(currentNode->key, pcKey, uLength)) {
+            SYMTABLE_COUNT(oSymTable, uHits);
             return 0;
         } 
     }
+    SYMTABLE_COUNT(oSymTable, uMisses);
     /*new key found*/
     /* allocating enough space for new node*/
     currentNode = (struct node*) malloc(sizeof(struct node));
@@ -86,13 +124,17 @@ int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
     if (currentNode == NULL) {
         return 0;
     }
-    currentNode->key = (char*) malloc(strlen(pcKey) + 1);
+    SYMTABLE_COUNT(oSymTable, uAllocs);
+    currentNode->key = (char*) malloc(uLength + 1);
     if (currentNode->key == NULL) {
         free(currentNode);
+        SYMTABLE_COUNT(oSymTable, uFrees);
         return 0;
     }
+    SYMTABLE_COUNT(oSymTable, uAllocs);
     /*ready to fill the node*/
-    currentNode->key = strcpy((char*) currentNode->key, pcKey);
+    memcpy((char*) currentNode->key, pcKey, uLength);
+    ((char*) currentNode->key)[uLength] = '\0';
     currentNode->value = pvValue;
     /* adds p to the beginning of the list*/
     currentNode->nextNode = oSymTable->first;
@@ -101,68 +143,114 @@ int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
     return 1;
 }
 
-void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    assert(pcKey != NULL);
+    return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+void *SymTable_replaceN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, const void *pvValue) {
     /* traveling node*/
     struct node *currentNode;
     const void* oldValue;
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
+    SYMTABLE_COUNT(oSymTable, uReplaces);
 
 /* loops through all the nodes in search for pcKey*/
 for (currentNode = oSymTable->first; currentNode != NULL; 
         currentNode = currentNode -> nextNode) {
-        if (strcmp(currentNode->key, pcKey) == 0) {
+        SYMTABLE_COUNT(oSymTable, uProbes);
+        SYMTABLE_COUNT(oSymTable, uKeyCompares);
+        if (SymTable_keyEquals(currentNode->key, pcKey, uLength)) {
+            SYMTABLE_COUNT(oSymTable, uHits);
             oldValue = currentNode->value;
             currentNode->value = pvValue;
             return (void*) oldValue;
         } 
     }
+    SYMTABLE_COUNT(oSymTable, uMisses);
     return NULL;
 
 }
 
-int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    assert(pcKey != NULL);
+    return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength) {
     struct node *currentNode;
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
+    SYMTABLE_COUNT(oSymTable, uContains);
 
     for (currentNode = oSymTable->first; currentNode != NULL; 
             currentNode = currentNode -> nextNode) {
-        if (strcmp(currentNode->key, pcKey) == 0) {
+        SYMTABLE_COUNT(oSymTable, uProbes);
+        SYMTABLE_COUNT(oSymTable, uKeyCompares);
+        if (SymTable_keyEquals(currentNode->key, pcKey, uLength)) {
+            SYMTABLE_COUNT(oSymTable, uHits);
             return 1;
         }
     }
+    SYMTABLE_COUNT(oSymTable, uMisses);
     return 0;
 }
 
-void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    assert(pcKey != NULL);
+    return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength) {
     struct node *currentNode;
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
+    SYMTABLE_COUNT(oSymTable, uGets);
 
     /* loops through all the nodes in search for pcKey*/
     for (currentNode = oSymTable->first; currentNode != NULL; 
             currentNode = currentNode -> nextNode) {
-        if (strcmp(currentNode->key, pcKey) == 0) {
+        SYMTABLE_COUNT(oSymTable, uProbes);
+        SYMTABLE_COUNT(oSymTable, uKeyCompares);
+        if (SymTable_keyEquals(currentNode->key, pcKey, uLength)) {
+            SYMTABLE_COUNT(oSymTable, uHits);
             return (void*) currentNode->value;
         } 
     }
+    SYMTABLE_COUNT(oSymTable, uMisses);
     return NULL;
 }
 
-void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    assert(pcKey != NULL);
+    return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/* Remove the binding of oSymTable whose key is the uLength characters
+   at pcKey, store its value in *ppvValue and return 1 (TRUE), or
+   return 0 (FALSE) if there is no such binding. */
+
+static int SymTable_unbind(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, const void **ppvValue) {
     /*traveling node*/
     struct node *currentNode;
     struct node *prevNode = NULL;
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
+    SYMTABLE_COUNT(oSymTable, uRemoves);
      /* loops through all the nodes in search for pcKey*/
     for (currentNode = oSymTable->first; currentNode != NULL; 
             currentNode = currentNode -> nextNode) {
-        if (strcmp(currentNode->key, pcKey) == 0) {
-            const void* oldValue;
+        SYMTABLE_COUNT(oSymTable, uProbes);
+        SYMTABLE_COUNT(oSymTable, uKeyCompares);
+        if (SymTable_keyEquals(currentNode->key, pcKey, uLength)) {
+            SYMTABLE_COUNT(oSymTable, uHits);
             /*save the currentNode's value*/
-            oldValue = currentNode->value;
+            *ppvValue = currentNode->value;
             /* relink the list*/
             /*if prevNode is at the beginning of the list*/
             if (prevNode == NULL) {
@@ -173,15 +261,40 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
             }
             free((char*) currentNode->key);
             free(currentNode);
+            SYMTABLE_COUNT(oSymTable, uFrees);
+            SYMTABLE_COUNT(oSymTable, uFrees);
             oSymTable->length--;
 
-            return (void*) oldValue;
+            return 1;
         } 
         prevNode = currentNode;
     }
-    return NULL;
- 
-    }
+    SYMTABLE_COUNT(oSymTable, uMisses);
+    return 0;
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength) {
+    const void *oldValue;
+    if (! SymTable_unbind(oSymTable, pcKey, uLength, &oldValue))
+        return NULL;
+    return (void*) oldValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    assert(pcKey != NULL);
+    return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_delete(SymTable_T oSymTable, const char *pcKey) {
+    const void *oldValue;
+    assert(pcKey != NULL);
+    if (! SymTable_unbind(oSymTable, pcKey, strlen(pcKey), &oldValue))
+        return 0;
+    if (oSymTable->freeValue != NULL)
+        (*oSymTable->freeValue)((void*) oldValue);
+    return 1;
+}
 
  void SymTable_map(SymTable_T oSymTable,
      void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
@@ -195,4 +308,86 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
         currentNode != NULL;
         currentNode = currentNode->nextNode)
       (*pfApply)(currentNode->key, (void*)currentNode->value, (void*)pvExtra);
-     }
\ No newline at end of file
+     }
+
+void SymTable_clear(SymTable_T oSymTable,
+   void (*pfFreeValue)(void *pvValue)) {
+    struct node *currentNode;
+    struct node *nextNode;
+    assert(oSymTable != NULL);
+    if (pfFreeValue == NULL)
+        pfFreeValue = oSymTable->freeValue;
+
+    /* a list has no bucket array to keep, and each node holds a
+       separately allocated key, so every node is freed*/
+    for (currentNode = oSymTable->first; currentNode != NULL;
+            currentNode = nextNode) {
+        nextNode = currentNode->nextNode;
+        if (pfFreeValue != NULL)
+            (*pfFreeValue)((void*)currentNode->value);
+        free((char*) currentNode->key);
+        free(currentNode);
+        SYMTABLE_COUNT(oSymTable, uFrees);
+        SYMTABLE_COUNT(oSymTable, uFrees);
+    }
+    oSymTable->first = NULL;
+    oSymTable->length = 0;
+}
+
+SymTable_T SymTable_clone(SymTable_T oSymTable) {
+    SymTable_T oClone;
+    struct node *currentNode;
+    struct node *copyNode;
+    /* the link that receives the next copy, so the order is kept*/
+    struct node **ppLink;
+    assert(oSymTable != NULL);
+
+    oClone = SymTable_new();
+    if (oClone == NULL)
+        return NULL;
+    ppLink = &oClone->first;
+    for (currentNode = oSymTable->first; currentNode != NULL;
+            currentNode = currentNode->nextNode) {
+        copyNode = (struct node*) malloc(sizeof(struct node));
+        if (copyNode == NULL) {
+            SymTable_free(oClone);
+            return NULL;
+        }
+        copyNode->key = (char*) malloc(strlen(currentNode->key) + 1);
+        if (copyNode->key == NULL) {
+            free(copyNode);
+            SymTable_free(oClone);
+            return NULL;
+        }
+        strcpy((char*) copyNode->key, currentNode->key);
+        copyNode->value = currentNode->value;
+        copyNode->nextNode = NULL;
+        *ppLink = copyNode;
+        ppLink = &copyNode->nextNode;
+        oClone->length++;
+        SYMTABLE_COUNT(oClone, uAllocs);
+        SYMTABLE_COUNT(oClone, uAllocs);
+    }
+    return oClone;
+}
+
+void SymTable_getStats(SymTable_T oSymTable,
+   struct SymTableStats *psStats) {
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+#ifdef SYMTABLE_STATS
+    *psStats = oSymTable->sStats;
+#else
+    (void)oSymTable;
+    memset(psStats, 0, sizeof(*psStats));
+#endif
+}
+
+void SymTable_resetStats(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+#ifdef SYMTABLE_STATS
+    memset(&oSymTable->sStats, 0, sizeof(oSymTable->sStats));
+#else
+    (void)oSymTable;
+#endif
+}
@@ -0,0 +1,232 @@
+/*--------------------------------------------------------------------*/
+/* symtablescope.c                                                    */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+#include <assert.h>
+#include <stdlib.h>
+#include "symtable.h"
+#include "symtablescope.h"
+
+/* The shared hash table maps each key to its name structure, which
+   stays in the table once created: a key that no open scope binds
+   any more keeps an empty stack, so closing a scope hashes no key and
+   declaring the key again costs no SymTable_put. */
+
+/* the number of scopes a new object has room for before its array of
+   scopes grows */
+enum {INITIAL_SCOPES = 16};
+
+struct name;
+
+/* binding structure which holds one binding of one scope*/
+struct binding {
+    /* pointer to the client's value*/
+    const void *value;
+    /* the depth of the scope the binding belongs to*/
+    size_t depth;
+    /* the binding of the same key it shadows, or NULL*/
+    struct binding *shadowed;
+    /* the binding the same scope made before this one, or NULL; links
+       the free bindings instead while the binding is unused*/
+    struct binding *previous;
+    /* the key's name structure*/
+    struct name *name;
+};
+
+/* name structure which the shared table binds each key to*/
+struct name {
+    /* the innermost binding of the key, or NULL*/
+    struct binding *top;
+};
+
+/* SymTableScope structure that contains the shared table and the
+stack of scopes*/
+struct SymTableScope {
+  /* the table that binds every key ever bound to its name*/
+  SymTable_T names;
+
+  /* the latest binding of each open scope, outermost first, or NULL
+     for a scope without bindings*/
+  struct binding **scopes;
+
+  /* the index of the innermost scope in scopes, and the number of
+     scopes it has room for*/
+  size_t depth;
+  size_t capacity;
+
+  /* bindings released by closed scopes for reuse by SymTableScope_put,
+     linked through previous*/
+  struct binding *freeBindings;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Free the name structure pvValue. pcKey and pvExtra are unused. */
+
+static void SymTableScope_freeName(const char *pcKey, void *pvValue,
+   void *pvExtra) {
+    assert(pcKey != NULL);
+    (void)pcKey;
+    (void)pvExtra;
+    free(pvValue);
+}
+
+/* Return an unused binding of oScope, taken from the free bindings if
+   there is one, or NULL if insufficient memory is available. */
+
+static struct binding *SymTableScope_allocBinding(SymTableScope_T oScope) {
+    struct binding *psBinding = oScope->freeBindings;
+    if (psBinding == NULL)
+        return (struct binding*) malloc(sizeof(struct binding));
+    oScope->freeBindings = psBinding->previous;
+    return psBinding;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTableScope_T SymTableScope_new(void) {
+    SymTableScope_T oScope;
+
+    oScope = (SymTableScope_T) malloc(sizeof(struct SymTableScope));
+    if (oScope == NULL)
+        return NULL;
+    oScope->names = SymTable_new();
+    oScope->scopes = (struct binding**)
+        malloc(INITIAL_SCOPES * sizeof(struct binding*));
+    if (oScope->names == NULL || oScope->scopes == NULL) {
+        if (oScope->names != NULL)
+            SymTable_free(oScope->names);
+        free(oScope->scopes);
+        free(oScope);
+        return NULL;
+    }
+    oScope->scopes[0] = NULL;
+    oScope->depth = 0;
+    oScope->capacity = INITIAL_SCOPES;
+    oScope->freeBindings = NULL;
+    return oScope;
+}
+
+void SymTableScope_free(SymTableScope_T oScope) {
+    struct binding *psBinding;
+    struct binding *psPrevious;
+    size_t u;
+    assert(oScope != NULL);
+
+    for (u = 0; u <= oScope->depth; u++)
+        for (psBinding = oScope->scopes[u]; psBinding != NULL;
+                psBinding = psPrevious) {
+            psPrevious = psBinding->previous;
+            free(psBinding);
+        }
+    for (psBinding = oScope->freeBindings; psBinding != NULL;
+            psBinding = psPrevious) {
+        psPrevious = psBinding->previous;
+        free(psBinding);
+    }
+    SymTable_map(oScope->names, SymTableScope_freeName, NULL);
+    SymTable_free(oScope->names);
+    free(oScope->scopes);
+    free(oScope);
+}
+
+int SymTableScope_push(SymTableScope_T oScope) {
+    struct binding **ppsScopes;
+    assert(oScope != NULL);
+
+    if (oScope->depth + 1 == oScope->capacity) {
+        ppsScopes = (struct binding**) realloc(oScope->scopes,
+            2 * oScope->capacity * sizeof(struct binding*));
+        if (ppsScopes == NULL)
+            return 0;
+        oScope->scopes = ppsScopes;
+        oScope->capacity *= 2;
+    }
+    oScope->depth++;
+    oScope->scopes[oScope->depth] = NULL;
+    return 1;
+}
+
+void SymTableScope_pop(SymTableScope_T oScope) {
+    struct binding *psBinding;
+    struct binding *psPrevious;
+    assert(oScope != NULL);
+    assert(oScope->depth > 0);
+    if (oScope->depth == 0)
+        return;
+
+    /* uncovers the shadowed bindings through the names the bindings
+       point to*/
+    for (psBinding = oScope->scopes[oScope->depth]; psBinding != NULL;
+            psBinding = psPrevious) {
+        psPrevious = psBinding->previous;
+        psBinding->name->top = psBinding->shadowed;
+        psBinding->previous = oScope->freeBindings;
+        oScope->freeBindings = psBinding;
+    }
+    oScope->depth--;
+}
+
+size_t SymTableScope_getDepth(SymTableScope_T oScope) {
+    assert(oScope != NULL);
+    return oScope->depth;
+}
+
+int SymTableScope_put(SymTableScope_T oScope, const char *pcKey,
+   const void *pvValue) {
+    struct name *psName;
+    struct binding *psBinding;
+    assert(oScope != NULL);
+    assert(pcKey != NULL);
+
+    psName = (struct name*) SymTable_get(oScope->names, pcKey);
+    if (psName != NULL && psName->top != NULL &&
+            psName->top->depth == oScope->depth)
+        return 0;
+    psBinding = SymTableScope_allocBinding(oScope);
+    if (psBinding == NULL)
+        return 0;
+    if (psName == NULL) {
+        /*new key found*/
+        psName = (struct name*) malloc(sizeof(struct name));
+        if (psName == NULL ||
+                ! SymTable_put(oScope->names, pcKey, psName)) {
+            free(psName);
+            psBinding->previous = oScope->freeBindings;
+            oScope->freeBindings = psBinding;
+            return 0;
+        }
+        psName->top = NULL;
+    }
+    psBinding->value = pvValue;
+    psBinding->depth = oScope->depth;
+    psBinding->name = psName;
+    psBinding->shadowed = psName->top;
+    psName->top = psBinding;
+    psBinding->previous = oScope->scopes[oScope->depth];
+    oScope->scopes[oScope->depth] = psBinding;
+    return 1;
+}
+
+void *SymTableScope_get(SymTableScope_T oScope, const char *pcKey,
+   size_t *puDepth) {
+    struct name *psName;
+    assert(oScope != NULL);
+    assert(pcKey != NULL);
+
+    psName = (struct name*) SymTable_get(oScope->names, pcKey);
+    if (psName == NULL || psName->top == NULL)
+        return NULL;
+    if (puDepth != NULL)
+        *puDepth = psName->top->depth;
+    return (void*) psName->top->value;
+}
+
+int SymTableScope_contains(SymTableScope_T oScope, const char *pcKey) {
+    struct name *psName;
+    assert(oScope != NULL);
+    assert(pcKey != NULL);
+
+    psName = (struct name*) SymTable_get(oScope->names, pcKey);
+    return psName != NULL && psName->top != NULL;
+}
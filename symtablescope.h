@@ -0,0 +1,87 @@
+/*--------------------------------------------------------------------*/
+/* symtablescope.h                                                    */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* A SymTableScope_T object is a stack of nested scopes, such as the
+   blocks of a program, each binding keys to values. A key resolves to
+   its binding in the innermost scope that declares it. All scopes
+   share one hash table (symtablehash.c) in which every key maps to
+   the stack of its bindings, innermost first, so resolving a key
+   hashes it once however deep the nesting is. */
+
+#ifndef SYMTABLESCOPE_INCLUDED
+#define SYMTABLESCOPE_INCLUDED
+
+#include <stddef.h>
+
+typedef struct SymTableScope *SymTableScope_T;
+
+/*--------------------------------------------------------------------*/
+
+/* return a new SymTableScope object with one scope, the outermost,
+   that contains no bindings, or NULL if insufficient memory is
+   available. */
+
+  SymTableScope_T SymTableScope_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* free all memory occupied by oScope and its scopes. The values are
+   not freed. */
+
+  void SymTableScope_free(SymTableScope_T oScope);
+
+/*--------------------------------------------------------------------*/
+
+/* open a new innermost scope in oScope. return 1 (TRUE) on success,
+   or 0 (FALSE) if insufficient memory is available. */
+
+  int SymTableScope_push(SymTableScope_T oScope);
+
+/*--------------------------------------------------------------------*/
+
+/* close the innermost scope of oScope, which must not be the
+   outermost, removing its bindings and uncovering the ones they
+   shadowed. Costs time in proportion to the bindings of the scope,
+   and hashes no key. */
+
+  void SymTableScope_pop(SymTableScope_T oScope);
+
+/*--------------------------------------------------------------------*/
+
+/* return the number of scopes of oScope opened by SymTableScope_push
+   and not yet closed: 0 when only the outermost scope is open. */
+
+  size_t SymTableScope_getDepth(SymTableScope_T oScope);
+
+/*--------------------------------------------------------------------*/
+
+/* bind pcKey to pvValue in the innermost scope of oScope, shadowing
+   any binding of pcKey in the enclosing scopes, and return 1 (TRUE).
+   return 0 (FALSE) and leave oScope unchanged if the innermost scope
+   already binds pcKey or insufficient memory is available. */
+
+  int SymTableScope_put(SymTableScope_T oScope, const char *pcKey,
+     const void *pvValue);
+
+/*--------------------------------------------------------------------*/
+
+/* return the value of the binding of pcKey in the innermost scope of
+   oScope that binds it, or NULL if no open scope binds pcKey. Store
+   the depth of that scope in *puDepth unless puDepth is NULL or no
+   scope binds pcKey. */
+
+  void *SymTableScope_get(SymTableScope_T oScope, const char *pcKey,
+     size_t *puDepth);
+
+/*--------------------------------------------------------------------*/
+
+/* return 1 (TRUE) if an open scope of oScope binds pcKey, or 0
+   (FALSE) otherwise. */
+
+  int SymTableScope_contains(SymTableScope_T oScope, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+
+#endif
@@ -0,0 +1,131 @@
+/*--------------------------------------------------------------------*/
+/* symtablesip.h                                                      */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* Private helpers shared by the SymTable implementations that hash
+   their keys: the per-table hash keys and the keyed hash function.
+   Every function is static, so each implementation gets its own copy
+   and its own process secret. An implementation that includes this
+   header must define _DEFAULT_SOURCE before its first #include. */
+
+#ifndef SYMTABLESIP_INCLUDED
+#define SYMTABLESIP_INCLUDED
+
+#include <assert.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/random.h>
+#endif
+
+/* a process-wide secret from which the key of every table created by
+   SymTable_new is derived, the control that reads it exactly once, and
+   how many keys have been derived from it. Several threads may create
+   tables at once: the secret is written only under sSecretOnce, and
+   the count is only changed atomically, so no two keys share it. */
+static uint64_t auSecret[2];
+static pthread_once_t sSecretOnce = PTHREAD_ONCE_INIT;
+static uint64_t uSeedsDerived = 0;
+
+/* Return a well-mixed function of u (the splitmix64 finalizer). */
+
+static uint64_t SymTable_mix(uint64_t u) {
+   u = (u ^ (u >> 30)) * 0xbf58476d1ce4e5b9u;
+   u = (u ^ (u >> 27)) * 0x94d049bb133111ebu;
+   return u ^ (u >> 31);
+}
+
+/* Read the process secret from the kernel into auSecret. */
+
+static void SymTable_readSecret(void) {
+   int iRead = 0;
+#ifdef __linux__
+   iRead = getrandom(auSecret, sizeof(auSecret), GRND_NONBLOCK)
+      == (ssize_t)sizeof(auSecret);
+#endif
+   if (! iRead) {
+      /* no entropy source: fall back on the clock and the address
+         space layout */
+      auSecret[0] = (uint64_t)time(NULL) ^ (uint64_t)(size_t)&iRead;
+      auSecret[1] = (uint64_t)clock() ^ (uint64_t)(size_t)auSecret;
+   }
+}
+
+/* Store a fresh, unpredictable hash key in auSeed. The secret is read
+   from the kernel once; later keys are derived from it with a
+   counter, so creating a table costs no system call. Safe to call
+   from several threads at once. */
+
+static void SymTable_randomSeed(uint64_t auSeed[2]) {
+   uint64_t uDerived;
+   pthread_once(&sSecretOnce, SymTable_readSecret);
+   uDerived = __atomic_add_fetch(&uSeedsDerived, 1, __ATOMIC_RELAXED);
+   auSeed[0] = SymTable_mix(auSecret[0] + uDerived * 0x9e3779b97f4a7c15u);
+   auSeed[1] = SymTable_mix(auSecret[1] ^ auSeed[0]);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Rotate the 64-bit value x left by b bits. */
+#define SIP_ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+/* One SipRound over the state v0..v3. */
+#define SIP_ROUND(v0, v1, v2, v3) \
+   do { \
+      v0 += v1; v1 = SIP_ROTL(v1, 13); v1 ^= v0; v0 = SIP_ROTL(v0, 32); \
+      v2 += v3; v3 = SIP_ROTL(v3, 16); v3 ^= v2; \
+      v0 += v3; v3 = SIP_ROTL(v3, 21); v3 ^= v0; \
+      v2 += v1; v1 = SIP_ROTL(v1, 17); v1 ^= v2; v2 = SIP_ROTL(v2, 32); \
+   } while (0)
+
+/* Return the hash code of the uLength characters at pcKey under the
+   128-bit key auKey: SipHash-1-3, the keyed hash function that
+   scripting language runtimes use against hash flooding. Unlike the
+   assignment's public hash function, colliding keys cannot be
+   computed without knowing the table's key. */
+
+static uint64_t SymTable_sipHash(const uint64_t auKey[2],
+   const char *pcKey, size_t uLength) {
+   const unsigned char *pucKey = (const unsigned char*)pcKey;
+   const unsigned char *pucEnd = pucKey + (uLength & ~(size_t)7);
+   uint64_t v0 = 0x736f6d6570736575u ^ auKey[0];
+   uint64_t v1 = 0x646f72616e646f6du ^ auKey[1];
+   uint64_t v2 = 0x6c7967656e657261u ^ auKey[0];
+   uint64_t v3 = 0x7465646279746573u ^ auKey[1];
+   uint64_t m;
+   uint64_t b = (uint64_t)uLength << 56;
+
+   assert(pcKey != NULL);
+
+   for (; pucKey != pucEnd; pucKey += 8) {
+      memcpy(&m, pucKey, sizeof(m));
+      v3 ^= m;
+      SIP_ROUND(v0, v1, v2, v3);
+      v0 ^= m;
+   }
+   switch (uLength & 7) {
+      case 7: b |= (uint64_t)pucKey[6] << 48; /* fall through */
+      case 6: b |= (uint64_t)pucKey[5] << 40; /* fall through */
+      case 5: b |= (uint64_t)pucKey[4] << 32; /* fall through */
+      case 4: b |= (uint64_t)pucKey[3] << 24; /* fall through */
+      case 3: b |= (uint64_t)pucKey[2] << 16; /* fall through */
+      case 2: b |= (uint64_t)pucKey[1] << 8;  /* fall through */
+      case 1: b |= (uint64_t)pucKey[0];       /* fall through */
+      default: break;
+   }
+   v3 ^= b;
+   SIP_ROUND(v0, v1, v2, v3);
+   v0 ^= b;
+   v2 ^= 0xff;
+   SIP_ROUND(v0, v1, v2, v3);
+   SIP_ROUND(v0, v1, v2, v3);
+   SIP_ROUND(v0, v1, v2, v3);
+   return v0 ^ v1 ^ v2 ^ v3;
+}
+
+#endif
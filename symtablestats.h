@@ -0,0 +1,27 @@
+/*--------------------------------------------------------------------*/
+/* symtablestats.h                                                    */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* Private helpers shared by the SymTable implementations for
+   maintaining the hot-path counters of struct SymTableStats. The
+   counters exist only when SYMTABLE_STATS is defined; otherwise every
+   SYMTABLE_COUNT evaluates only its table, which keeps a parameter
+   used for nothing but counting from being reported as unused, and
+   struct SymTable carries no counter fields. */
+
+#ifndef SYMTABLESTATS_INCLUDED
+#define SYMTABLESTATS_INCLUDED
+
+#ifdef SYMTABLE_STATS
+
+/* Increment counter field of oSymTable's statistics. */
+#define SYMTABLE_COUNT(oSymTable, field) ((oSymTable)->sStats.field++)
+
+#else
+
+#define SYMTABLE_COUNT(oSymTable, field) ((void)(oSymTable))
+
+#endif
+
+#endif
@@ -0,0 +1,256 @@
+/*--------------------------------------------------------------------*/
+/* symtabletext.c                                                     */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+#define _DEFAULT_SOURCE
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "symtable.h"
+#include "symtabletext.h"
+
+/* The loader finds the tabs and newlines with memchr, which the C
+   library scans a vector register at a time, and the dumper fills a
+   buffer of DUMP_BUFFER bytes with memcpy before each fwrite, so that
+   neither looks at the characters one by one in a loop of its own. */
+enum {DUMP_BUFFER = 65536};
+
+/* SymTableText structure that contains the values of a loaded file*/
+struct SymTableText {
+  /* the values of the lines bound, each ended by '\0', in the order of
+     their lines, and the number of bytes they take up*/
+  char *values;
+  size_t used;
+
+  /* the number of lines bound*/
+  size_t bound;
+};
+
+/* dump structure which holds the buffer of SymTableText_dump*/
+struct dump {
+  FILE *file;
+  char *buffer;
+  size_t used;
+  int failed;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Put the binding of the line that starts at pcLine and ends at pcEnd,
+   its newline or the end of the file, into oSymTable, the value
+   copied to the values of oText. Return 1 (TRUE) on success, if the
+   line has no tab or if oSymTable binds its key already, and 0
+   (FALSE) if insufficient memory is available. */
+
+static int SymTableText_putLine(SymTableText_T oText,
+   SymTable_T oSymTable, const char *pcLine, const char *pcEnd) {
+    const char *pcTab;
+    char *pcValue;
+    size_t uValueLength;
+
+    pcTab = (const char*)memchr(pcLine, '\t', (size_t)(pcEnd - pcLine));
+    if (pcTab == NULL)
+        return 1;
+    uValueLength = (size_t)(pcEnd - pcTab - 1);
+    pcValue = oText->values + oText->used;
+    memcpy(pcValue, pcTab + 1, uValueLength);
+    pcValue[uValueLength] = '\0';
+    if (SymTable_putN(oSymTable, pcLine, (size_t)(pcTab - pcLine),
+            pcValue)) {
+        oText->used += uValueLength + 1;
+        oText->bound++;
+        return 1;
+    }
+    /* SymTable_putN fails both for a key bound already and for want of
+       memory*/
+    return SymTable_containsN(oSymTable, pcLine, (size_t)(pcTab - pcLine));
+}
+
+/* Remove from oSymTable every binding that the lines of the file
+   from pcFirst up to pcStop put, so that none refers to the values of
+   oText any more. The values of the lines bound follow each other in
+   oText, so a line put its key if the key is bound to the next value
+   not yet passed. */
+
+static void SymTableText_unbindLines(SymTableText_T oText,
+   SymTable_T oSymTable, const char *pcFirst, const char *pcStop) {
+    const char *pcLine;
+    const char *pcEnd;
+    const char *pcTab;
+    const char *pcValue = oText->values;
+
+    for (pcLine = pcFirst; pcLine < pcStop; pcLine = pcEnd + 1) {
+        pcEnd = (const char*)memchr(pcLine, '\n',
+            (size_t)(pcStop - pcLine));
+        if (pcEnd == NULL)
+            pcEnd = pcStop;
+        pcTab = (const char*)memchr(pcLine, '\t',
+            (size_t)(pcEnd - pcLine));
+        if (pcTab != NULL && SymTable_getN(oSymTable, pcLine,
+                (size_t)(pcTab - pcLine)) == pcValue) {
+            (void)SymTable_removeN(oSymTable, pcLine,
+                (size_t)(pcTab - pcLine));
+            pcValue += strlen(pcValue) + 1;
+        }
+    }
+}
+
+SymTableText_T SymTableText_load(SymTable_T oSymTable,
+   const char *pcPath) {
+    SymTableText_T oText;
+    struct stat sStat;
+    const char *pcMapping;
+    const char *pcLine;
+    const char *pcNewline;
+    const char *pcEnd;
+    void *pvMapping;
+    size_t uSize;
+    int iFile;
+
+    assert(oSymTable != NULL);
+    assert(pcPath != NULL);
+
+    oText = (SymTableText_T)malloc(sizeof(struct SymTableText));
+    if (oText == NULL)
+        return NULL;
+    oText->values = NULL;
+    oText->used = 0;
+    oText->bound = 0;
+
+    iFile = open(pcPath, O_RDONLY);
+    if (iFile < 0) {
+        free(oText);
+        return NULL;
+    }
+    if (fstat(iFile, &sStat) != 0) {
+        close(iFile);
+        free(oText);
+        return NULL;
+    }
+    if (sStat.st_size == 0) {
+        close(iFile);
+        return oText;
+    }
+    uSize = (size_t)sStat.st_size;
+    /* the values with their '\0' take no more room than the lines with
+       their newlines, and a '\0' more if the last has none*/
+    oText->values = (char*)malloc(uSize + 1);
+    if (oText->values == NULL) {
+        close(iFile);
+        free(oText);
+        return NULL;
+    }
+    /* a read-only mapping, which the load never writes, so its pages
+       are shared with the page cache and never copied*/
+    pvMapping = mmap(NULL, uSize, PROT_READ, MAP_PRIVATE, iFile, 0);
+    close(iFile);
+    if (pvMapping == MAP_FAILED) {
+        SymTableText_free(oText);
+        return NULL;
+    }
+    pcMapping = (const char*)pvMapping;
+    (void)madvise(pvMapping, uSize, MADV_SEQUENTIAL);
+
+    pcEnd = pcMapping + uSize;
+    for (pcLine = pcMapping; pcLine < pcEnd; pcLine = pcNewline + 1) {
+        pcNewline = (const char*)memchr(pcLine, '\n',
+            (size_t)(pcEnd - pcLine));
+        if (pcNewline == NULL)
+            pcNewline = pcEnd;
+        if (! SymTableText_putLine(oText, oSymTable, pcLine, pcNewline)) {
+            SymTableText_unbindLines(oText, oSymTable, pcMapping, pcLine);
+            munmap(pvMapping, uSize);
+            SymTableText_free(oText);
+            return NULL;
+        }
+    }
+    munmap(pvMapping, uSize);
+    return oText;
+}
+
+size_t SymTableText_getBound(SymTableText_T oText) {
+    assert(oText != NULL);
+    return oText->bound;
+}
+
+void SymTableText_free(SymTableText_T oText) {
+    assert(oText != NULL);
+    free(oText->values);
+    free(oText);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the bytes gathered in the buffer of psDump to its file and
+   empty the buffer. */
+
+static void SymTableText_flush(struct dump *psDump) {
+    if (psDump->used != 0 && fwrite(psDump->buffer, 1, psDump->used,
+            psDump->file) != psDump->used)
+        psDump->failed = 1;
+    psDump->used = 0;
+}
+
+/* Add the uLength bytes at pcBytes to the buffer of psDump, writing
+   the buffer out first if they do not fit, and writing them directly
+   if they are larger than the buffer. */
+
+static void SymTableText_append(struct dump *psDump, const char *pcBytes,
+   size_t uLength) {
+    if (uLength > DUMP_BUFFER - psDump->used)
+        SymTableText_flush(psDump);
+    if (uLength > DUMP_BUFFER) {
+        if (fwrite(pcBytes, 1, uLength, psDump->file) != uLength)
+            psDump->failed = 1;
+        return;
+    }
+    memcpy(psDump->buffer + psDump->used, pcBytes, uLength);
+    psDump->used += uLength;
+}
+
+/* Add the line of the binding of pcKey and pvValue, a string, to the
+   buffer of pvExtra, a struct dump. */
+
+static void SymTableText_dumpBinding(const char *pcKey, void *pvValue,
+   void *pvExtra) {
+    struct dump *psDump = (struct dump*)pvExtra;
+    size_t uKeyLength = strlen(pcKey);
+    size_t uValueLength = strlen((const char*)pvValue);
+
+    /* a line that fits is copied in one go*/
+    if (uKeyLength + uValueLength + 2 <= DUMP_BUFFER - psDump->used) {
+        memcpy(psDump->buffer + psDump->used, pcKey, uKeyLength);
+        psDump->used += uKeyLength;
+        psDump->buffer[psDump->used++] = '\t';
+        memcpy(psDump->buffer + psDump->used, pvValue, uValueLength);
+        psDump->used += uValueLength;
+        psDump->buffer[psDump->used++] = '\n';
+        return;
+    }
+    SymTableText_append(psDump, pcKey, uKeyLength);
+    SymTableText_append(psDump, "\t", 1);
+    SymTableText_append(psDump, (const char*)pvValue, uValueLength);
+    SymTableText_append(psDump, "\n", 1);
+}
+
+int SymTableText_dump(SymTable_T oSymTable, FILE *psFile) {
+    struct dump sDump;
+
+    assert(oSymTable != NULL);
+    assert(psFile != NULL);
+
+    sDump.buffer = (char*)malloc(DUMP_BUFFER);
+    if (sDump.buffer == NULL)
+        return 0;
+    sDump.file = psFile;
+    sDump.used = 0;
+    sDump.failed = 0;
+    SymTable_map(oSymTable, SymTableText_dumpBinding, &sDump);
+    SymTableText_flush(&sDump);
+    free(sDump.buffer);
+    return ! sDump.failed;
+}
@@ -0,0 +1,67 @@
+/*--------------------------------------------------------------------*/
+/* symtabletext.h                                                     */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* Bindings as text: one binding per line, its key, a tab and its
+   value, which is a string, as printBindingSimple in testsymtable.c
+   prints them. SymTableText_load maps such a file into memory and
+   puts its lines into a SymTable object, copying only the values;
+   SymTableText_dump writes the bindings of a table in the same form
+   through a buffer of its own. Both work with every implementation of
+   symtable.h. */
+
+#ifndef SYMTABLETEXT_INCLUDED
+#define SYMTABLETEXT_INCLUDED
+
+#include <stddef.h>
+#include <stdio.h>
+#include "symtable.h"
+
+typedef struct SymTableText *SymTableText_T;
+
+/*--------------------------------------------------------------------*/
+
+/* put the bindings of the text file pcPath into oSymTable and return
+   a new SymTableText object that holds their values, or NULL if the
+   file cannot be read or insufficient memory is available, in which
+   case the bindings already put are removed again, leaving oSymTable
+   with the bindings it had before. The file is mapped read-only, each
+   key is put with SymTable_putN straight from the mapping, and each
+   value, the rest of its line, is copied with a '\0' after it into a
+   block the object holds, so the values stay valid until the object
+   is freed. A line without a tab, and a line whose key oSymTable
+   binds already, leave oSymTable unchanged; the last line need not
+   end with a newline. The file must not contain '\0'. */
+
+  SymTableText_T SymTableText_load(SymTable_T oSymTable,
+     const char *pcPath);
+
+/*--------------------------------------------------------------------*/
+
+/* return the number of lines of the file oText was loaded from that
+   SymTable_putN bound. */
+
+  size_t SymTableText_getBound(SymTableText_T oText);
+
+/*--------------------------------------------------------------------*/
+
+/* free oText and the values it holds. The values that SymTableText_load
+   put are no longer valid afterwards, so the table should be freed
+   or cleared first. */
+
+  void SymTableText_free(SymTableText_T oText);
+
+/*--------------------------------------------------------------------*/
+
+/* write every binding of oSymTable, whose values must all be
+   strings, to psFile as a line: the key, a tab, the value and a
+   newline. The lines are gathered in a buffer and written in large
+   blocks, in the order SymTable_map visits the bindings. return 1
+   (TRUE) on success, or 0 (FALSE) if a write fails. */
+
+  int SymTableText_dump(SymTable_T oSymTable, FILE *psFile);
+
+/*--------------------------------------------------------------------*/
+
+#endif
@@ -0,0 +1,2280 @@
+/*--------------------------------------------------------------------*/
+/* testhashext.c                                                      */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* Test the extensions that only the hash table implementation
+   provides (symtablehash.h), and the typed tables generated with its
+   sizing policy (symtablegen.h). testsymtable.c covers the interface
+   common to every implementation. */
+
+#include "symtablehash.h"
+#include "symtablescope.h"
+#include "symtabletext.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/* a table from integers to doubles, and one from strings the client
+   owns to integers, which hashes and compares the characters */
+
+#define SYMTABLE_GEN_NAME IntTable
+#define SYMTABLE_GEN_KEY long
+#define SYMTABLE_GEN_VALUE double
+#define SYMTABLE_GEN_HASH(key) SymTableGen_hashInteger((uint64_t)(key))
+#include "symtablegen.h"
+
+/* Return the hash code of string pcKey from the original assignment's
+   hash function. */
+
+static size_t hashString(const char *pcKey)
+{
+   size_t uHash = 0;
+   for (; *pcKey != '\0'; pcKey++)
+      uHash = uHash * 65599 + (size_t)(unsigned char)*pcKey;
+   return uHash;
+}
+
+#define SYMTABLE_GEN_NAME NameTable
+#define SYMTABLE_GEN_KEY const char *
+#define SYMTABLE_GEN_VALUE int
+#define SYMTABLE_GEN_HASH(key) hashString(key)
+#define SYMTABLE_GEN_EQUAL(key1, key2) (strcmp(key1, key2) == 0)
+#include "symtablegen.h"
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The Makefile links testhashext with malloc, calloc and realloc
+   wrapped, so that a test can make the allocations of the tables fail:
+   uAllocsLeft is the number of allocations that may still succeed, or
+   SIZE_MAX while every one may. Only the calls made by the object
+   files of testhashext are wrapped, not those inside the C library. */
+
+static size_t uAllocsLeft = SIZE_MAX;
+
+void *__real_malloc(size_t uSize);
+void *__real_calloc(size_t uCount, size_t uSize);
+void *__real_realloc(void *pvOld, size_t uSize);
+void *__wrap_malloc(size_t uSize);
+void *__wrap_calloc(size_t uCount, size_t uSize);
+void *__wrap_realloc(void *pvOld, size_t uSize);
+
+/* Return 1 (TRUE), counting one allocation, if uAllocsLeft lets it
+   succeed, or 0 (FALSE) if it must fail. The threads of
+   SymTable_buildParallel allocate at once, so the count changes
+   atomically. */
+
+static int allocAllowed(void)
+{
+   size_t uLeft = __atomic_load_n(&uAllocsLeft, __ATOMIC_RELAXED);
+   do
+   {
+      if (uLeft == SIZE_MAX)
+         return 1;
+      if (uLeft == 0)
+         return 0;
+   } while (! __atomic_compare_exchange_n(&uAllocsLeft, &uLeft,
+      uLeft - 1, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+   return 1;
+}
+
+void *__wrap_malloc(size_t uSize)
+{
+   return allocAllowed() ? __real_malloc(uSize) : NULL;
+}
+
+void *__wrap_calloc(size_t uCount, size_t uSize)
+{
+   return allocAllowed() ? __real_calloc(uCount, uSize) : NULL;
+}
+
+void *__wrap_realloc(void *pvOld, size_t uSize)
+{
+   return allocAllowed() ? __real_realloc(pvOld, uSize) : NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+enum {KEY_SIZE = 24};
+
+/* the seed of the tables whose bucket placement the tests rely on */
+enum {TEST_SEED0 = 217, TEST_SEED1 = 333};
+
+/* Fill acKeys with uCount distinct decimal keys that all land in the
+   same bucket of a table with the test seed once that table holds
+   uCount bindings, and so has grown to its final bucket count. */
+
+static void makeCollidingKeys(char acKeys[][KEY_SIZE], size_t uCount)
+{
+   SymTable_T oSymTable;
+   size_t uBucket;
+   size_t uFound = 0;
+   unsigned long ul;
+
+   oSymTable = SymTable_newSeeded(TEST_SEED0, TEST_SEED1);
+   assert(oSymTable != NULL);
+   for (ul = 0; ul < uCount; ul++)
+   {
+      sprintf(acKeys[0], "filler%lu", ul);
+      (void)SymTable_put(oSymTable, acKeys[0], NULL);
+   }
+   uBucket = SymTable_bucketOf(oSymTable, "0");
+   for (ul = 0; uFound < uCount; ul++)
+   {
+      sprintf(acKeys[uFound], "%lu", ul);
+      if (SymTable_bucketOf(oSymTable, acKeys[uFound]) == uBucket)
+         uFound++;
+   }
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add 1 to the count at pvExtra, and check that pvValue is the
+   address of pcKey's own characters in the caller's key array. */
+
+static void countBinding(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+   ASSURE(strcmp(pcKey, (const char*)pvValue) == 0);
+   (*(size_t*)pvExtra)++;
+}
+
+/* Add 1 to the count at pvExtra. pcKey and pvValue are unused. */
+
+static void countAny(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+   (void)pcKey;
+   (void)pvValue;
+   (*(size_t*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+enum {SEEDING_THREADS = 4, SEEDING_TABLES = 50, SEEDING_PROBES = 8};
+
+/* Fill pvTables, an array of SEEDING_TABLES SymTable_T, with new
+   tables. Return NULL. */
+
+static void *newTables(void *pvTables)
+{
+   SymTable_T *poTables = (SymTable_T*)pvTables;
+   int i;
+
+   for (i = 0; i < SEEDING_TABLES; i++)
+      poTables[i] = SymTable_new();
+   return NULL;
+}
+
+/* Return 1 (TRUE) if oSymTable1 and oSymTable2 place each of the
+   keys "key0" up to SEEDING_PROBES - 1 in the same bucket, and 0
+   (FALSE) otherwise. */
+
+static int samePlacement(SymTable_T oSymTable1, SymTable_T oSymTable2)
+{
+   char acKey[KEY_SIZE];
+   int iSame = 1;
+   int i;
+
+   for (i = 0; i < SEEDING_PROBES; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      iSame &= SymTable_bucketOf(oSymTable1, acKey) ==
+         SymTable_bucketOf(oSymTable2, acKey);
+   }
+   return iSame;
+}
+
+/* Test that tables with the same seed place keys identically and
+   that tables with different seeds, including the fresh seeds that
+   SymTable_new picks on several threads at once, do not. */
+
+static void testSeeding(void)
+{
+   static SymTable_T aoTables[SEEDING_THREADS * SEEDING_TABLES];
+   pthread_t aiThreads[SEEDING_THREADS];
+   int iDistinct = 1;
+   int j;
+   SymTable_T oSymTable1;
+   SymTable_T oSymTable2;
+   SymTable_T oSymTable3;
+   SymTable_T oSymTable4;
+   SymTable_T oSymTable5;
+   char acKey[KEY_SIZE];
+   int iSame = 1;
+   int iDiffersSeeded = 0;
+   int iDiffersNew = 0;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing seeded hashing.\n");
+   fflush(stdout);
+
+   oSymTable1 = SymTable_newSeeded(TEST_SEED0, TEST_SEED1);
+   oSymTable2 = SymTable_newSeeded(TEST_SEED0, TEST_SEED1);
+   oSymTable3 = SymTable_newSeeded(TEST_SEED0, TEST_SEED1 + 1);
+   oSymTable4 = SymTable_new();
+   oSymTable5 = SymTable_new();
+   ASSURE(oSymTable1 != NULL && oSymTable2 != NULL &&
+      oSymTable3 != NULL && oSymTable4 != NULL && oSymTable5 != NULL);
+
+   for (i = 0; i < 100; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      iSame &= SymTable_bucketOf(oSymTable1, acKey) ==
+         SymTable_bucketOf(oSymTable2, acKey);
+      iDiffersSeeded |= SymTable_bucketOf(oSymTable1, acKey) !=
+         SymTable_bucketOf(oSymTable3, acKey);
+      iDiffersNew |= SymTable_bucketOf(oSymTable4, acKey) !=
+         SymTable_bucketOf(oSymTable5, acKey);
+   }
+   ASSURE(iSame);
+   ASSURE(iDiffersSeeded);
+   ASSURE(iDiffersNew);
+
+   /* the seed changes placement, not bindings */
+   ASSURE(SymTable_put(oSymTable3, "key", "value"));
+   ASSURE(strcmp((char*)SymTable_get(oSymTable3, "key"), "value") == 0);
+
+   SymTable_free(oSymTable1);
+   SymTable_free(oSymTable2);
+   SymTable_free(oSymTable3);
+   SymTable_free(oSymTable4);
+   SymTable_free(oSymTable5);
+
+   /* tables created on several threads at once get keys of their
+      own */
+   for (i = 0; i < SEEDING_THREADS; i++)
+      ASSURE(pthread_create(&aiThreads[i], NULL, newTables,
+         &aoTables[i * SEEDING_TABLES]) == 0);
+   for (i = 0; i < SEEDING_THREADS; i++)
+      ASSURE(pthread_join(aiThreads[i], NULL) == 0);
+   for (i = 0; i < SEEDING_THREADS * SEEDING_TABLES; i++)
+      ASSURE(aoTables[i] != NULL);
+   for (i = 0; i < SEEDING_THREADS * SEEDING_TABLES; i++)
+      for (j = i + 1; j < SEEDING_THREADS * SEEDING_TABLES; j++)
+         iDistinct &= ! samePlacement(aoTables[i], aoTables[j]);
+   ASSURE(iDistinct);
+   for (i = 0; i < SEEDING_THREADS * SEEDING_TABLES; i++)
+      SymTable_free(aoTables[i]);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put uCount colliding keys into a seeded table with tree threshold
+   uThreshold and check every operation on them. */
+
+static void testFloodedBucket(size_t uThreshold, size_t uCount)
+{
+   SymTable_T oSymTable;
+   char (*acKeys)[KEY_SIZE];
+   char acMissing[KEY_SIZE];
+   char acValue[] = "value";
+   size_t u;
+   size_t uMapped = 0;
+   int iGood;
+
+   oSymTable = SymTable_newSeeded(TEST_SEED0, TEST_SEED1);
+   ASSURE(oSymTable != NULL);
+   SymTable_setTreeThreshold(oSymTable, uThreshold);
+   acKeys = malloc((uCount + 1) * sizeof(*acKeys));
+   ASSURE(acKeys != NULL);
+   makeCollidingKeys(acKeys, uCount + 1);
+   /* the last colliding key is never inserted */
+   strcpy(acMissing, acKeys[uCount]);
+
+   iGood = 1;
+   for (u = 0; u < uCount; u++)
+      iGood &= SymTable_put(oSymTable, acKeys[u], acKeys[u]);
+   ASSURE(iGood);
+   ASSURE(SymTable_getLength(oSymTable) == uCount);
+   ASSURE(! SymTable_put(oSymTable, acKeys[uCount / 2], "duplicate"));
+   ASSURE(SymTable_getLength(oSymTable) == uCount);
+
+   iGood = 1;
+   for (u = 0; u < uCount; u++)
+      iGood &= SymTable_get(oSymTable, acKeys[u]) == acKeys[u];
+   ASSURE(iGood);
+   ASSURE(! SymTable_contains(oSymTable, acMissing));
+   ASSURE(SymTable_get(oSymTable, acMissing) == NULL);
+   ASSURE(SymTable_replace(oSymTable, acMissing, "value") == NULL);
+   ASSURE(SymTable_remove(oSymTable, acMissing) == NULL);
+
+   ASSURE(SymTable_replace(oSymTable, acKeys[0], acValue) == acKeys[0]);
+   ASSURE(SymTable_replace(oSymTable, acKeys[0], acKeys[0]) == acValue);
+   ASSURE(SymTable_get(oSymTable, acKeys[0]) == acKeys[0]);
+
+   SymTable_map(oSymTable, countBinding, &uMapped);
+   ASSURE(uMapped == uCount);
+
+   /* remove every other key, then check both halves */
+   iGood = 1;
+   for (u = 0; u < uCount; u += 2)
+      iGood &= SymTable_remove(oSymTable, acKeys[u]) == acKeys[u];
+   ASSURE(iGood);
+   ASSURE(SymTable_getLength(oSymTable) == uCount / 2);
+   iGood = 1;
+   for (u = 0; u < uCount; u++)
+      iGood &= SymTable_contains(oSymTable, acKeys[u]) == (int)(u % 2);
+   ASSURE(iGood);
+
+   /* put the removed keys back; the rest are freed by SymTable_free */
+   iGood = 1;
+   for (u = 0; u < uCount; u += 2)
+      iGood &= SymTable_put(oSymTable, acKeys[u], acKeys[u]);
+   ASSURE(iGood);
+   ASSURE(SymTable_getLength(oSymTable) == uCount);
+
+   SymTable_free(oSymTable);
+   free(acKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test buckets that have been converted into trees, and the same
+   workload with the conversion disabled. */
+
+static void testTreeBuckets(void)
+{
+   SymTable_T oSymTable;
+   char acKey[KEY_SIZE];
+   int iGood = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing tree buckets.\n");
+   fflush(stdout);
+
+   testFloodedBucket(8, 300);
+   testFloodedBucket(0, 300);
+   testFloodedBucket(1, 50);
+   testFloodedBucket(8, 7);
+
+   /* with a threshold of 2, most buckets of a large table are trees */
+   oSymTable = SymTable_newSeeded(TEST_SEED0, TEST_SEED1);
+   ASSURE(oSymTable != NULL);
+   SymTable_setTreeThreshold(oSymTable, 2);
+   for (i = 0; i < 5000; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_put(oSymTable, acKey, (void*)(size_t)(i + 1));
+   }
+   for (i = 0; i < 5000; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_get(oSymTable, acKey) == (void*)(size_t)(i + 1);
+   }
+   for (i = 0; i < 5000; i += 3)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_remove(oSymTable, acKey) == (void*)(size_t)(i + 1);
+   }
+   ASSURE(iGood);
+   ASSURE(SymTable_getLength(oSymTable) == 5000 - 1667);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a lookup in a flooded bucket visits O(log n) nodes once
+   the bucket is a tree. Counting visits needs SYMTABLE_STATS. */
+
+static void testTreeDepth(void)
+{
+#ifdef SYMTABLE_STATS
+   enum {FLOOD_COUNT = 1000};
+   SymTable_T oSymTable;
+   char (*acKeys)[KEY_SIZE];
+   struct SymTableStats sStats;
+   size_t u;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing tree depth.\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newSeeded(TEST_SEED0, TEST_SEED1);
+   acKeys = malloc(FLOOD_COUNT * sizeof(*acKeys));
+   ASSURE(oSymTable != NULL && acKeys != NULL);
+   makeCollidingKeys(acKeys, FLOOD_COUNT);
+   for (u = 0; u < FLOOD_COUNT; u++)
+      (void)SymTable_put(oSymTable, acKeys[u], acKeys[u]);
+   /* the keys collide only once the table has grown to this size */
+   ASSURE(SymTable_getBucketCount(oSymTable) == 1021);
+   SymTable_resetStats(oSymTable);
+   for (u = 0; u < FLOOD_COUNT; u++)
+      (void)SymTable_get(oSymTable, acKeys[u]);
+   SymTable_getStats(oSymTable, &sStats);
+   /* a random treap of 1000 nodes has an expected depth near 2 ln n,
+      about 14; a chain would average 500 */
+   ASSURE(sStats.uProbes < FLOOD_COUNT * 40);
+   SymTable_free(oSymTable);
+   free(acKeys);
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a table grows as bindings are added, shrinks as they are
+   removed, and that SymTable_compact shrinks a table to fit and keeps
+   its bindings, for both chain and tree buckets. */
+
+static void testResize(void)
+{
+   SymTable_T oSymTable;
+   char acKey[KEY_SIZE];
+   size_t uThreshold;
+   size_t uMapped;
+   int iGood = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing resizing.\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getBucketCount(oSymTable) == 509);
+   for (i = 0; i < 50000; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_put(oSymTable, acKey, (void*)(size_t)(i + 1));
+   }
+   ASSURE(SymTable_getBucketCount(oSymTable) == 65521);
+   for (i = 0; i < 50000; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_get(oSymTable, acKey) == (void*)(size_t)(i + 1);
+   }
+   /* drain all but 100 bindings */
+   for (i = 100; i < 50000; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_remove(oSymTable, acKey) == (void*)(size_t)(i + 1);
+   }
+   ASSURE(SymTable_getBucketCount(oSymTable) == 509);
+   ASSURE(SymTable_getLength(oSymTable) == 100);
+   for (i = 0; i < 50000; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_contains(oSymTable, acKey) == (i < 100);
+   }
+   ASSURE(iGood);
+   SymTable_free(oSymTable);
+
+   /* a table left between the grow and shrink points keeps its size
+      until it is compacted */
+   for (uThreshold = 0; uThreshold <= 1; uThreshold++)
+   {
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      SymTable_setTreeThreshold(oSymTable, uThreshold);
+      for (i = 0; i < 2000; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iGood &= SymTable_put(oSymTable, acKey, (void*)(size_t)(i + 1));
+      }
+      for (i = 500; i < 2000; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iGood &= SymTable_remove(oSymTable, acKey) ==
+            (void*)(size_t)(i + 1);
+      }
+      ASSURE(SymTable_getBucketCount(oSymTable) == 2039);
+      ASSURE(SymTable_compact(oSymTable));
+      ASSURE(SymTable_getBucketCount(oSymTable) == 509);
+      ASSURE(SymTable_getLength(oSymTable) == 500);
+      for (i = 0; i < 500; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iGood &= SymTable_get(oSymTable, acKey) == (void*)(size_t)(i + 1);
+      }
+      uMapped = 0;
+      SymTable_map(oSymTable, countAny, &uMapped);
+      ASSURE(uMapped == 500);
+      /* compacting a compact table changes nothing */
+      ASSURE(SymTable_compact(oSymTable));
+      ASSURE(SymTable_getBucketCount(oSymTable) == 509);
+      ASSURE(iGood);
+      SymTable_free(oSymTable);
+   }
+
+   /* SymTable_clear keeps the bucket array, and a refill reuses the
+      pooled nodes */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < 5000; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_put(oSymTable, acKey, (void*)(size_t)(i + 1));
+   }
+   ASSURE(SymTable_getBucketCount(oSymTable) == 8191);
+   SymTable_clear(oSymTable, NULL);
+   ASSURE(SymTable_getBucketCount(oSymTable) == 8191);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   for (i = 0; i < 6000; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      iGood &= SymTable_put(oSymTable, acKey, (void*)(size_t)(i + 1));
+   }
+   for (i = 0; i < 6000; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      iGood &= SymTable_get(oSymTable, acKey) == (void*)(size_t)(i + 1);
+   }
+   ASSURE(iGood);
+   ASSURE(SymTable_compact(oSymTable));
+   ASSURE(SymTable_getLength(oSymTable) == 6000);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a new table keeps its first 8 bindings without a bucket
+   array, that clone, compact and clear keep it that way, and that it
+   moves its bindings into buckets when it outgrows its slots or when
+   a snapshot, a filter or a tree threshold of 1 needs buckets. */
+
+static void testSmallTable(void)
+{
+   enum {SMALL_COUNT = 8};
+   SymTable_T oSymTable;
+   SymTable_T oClone;
+   SymTable_T oSnapshot;
+   char acKey[KEY_SIZE];
+   struct SymTableStats sStats;
+   size_t uMapped;
+   int iGood = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing small tables.\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < SMALL_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_put(oSymTable, acKey, (void*)(size_t)(i + 1));
+      iGood &= ! SymTable_put(oSymTable, acKey, NULL);
+   }
+   ASSURE(iGood);
+   /* a small table reports the bucket count its buckets will have */
+   ASSURE(SymTable_getBucketCount(oSymTable) == 509);
+   SymTable_getStats(oSymTable, &sStats);
+#ifdef SYMTABLE_STATS
+   /* a node per binding, and no bucket array */
+   ASSURE(sStats.uAllocs == SMALL_COUNT);
+#else
+   ASSURE(sStats.uAllocs == 0);
+#endif
+
+   /* a removal fills its slot with another binding */
+   ASSURE(SymTable_remove(oSymTable, "0") == (void*)1);
+   ASSURE(SymTable_remove(oSymTable, "0") == NULL);
+   ASSURE(SymTable_replace(oSymTable, "7", (void*)70) == (void*)8);
+   for (i = 1; i < SMALL_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_get(oSymTable, acKey) ==
+         (void*)(size_t)(i == 7 ? 70 : i + 1);
+   }
+   ASSURE(iGood);
+   ASSURE(! SymTable_contains(oSymTable, "0"));
+   ASSURE(SymTable_put(oSymTable, "0", (void*)1));
+   uMapped = 0;
+   SymTable_map(oSymTable, countAny, &uMapped);
+   ASSURE(uMapped == SMALL_COUNT);
+
+   /* a clone of a small table is small */
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
+   SymTable_getStats(oClone, &sStats);
+#ifdef SYMTABLE_STATS
+   ASSURE(sStats.uAllocs == SMALL_COUNT);
+#endif
+   ASSURE(SymTable_compact(oClone));
+   for (i = 0; i < SMALL_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_get(oClone, acKey) ==
+         (void*)(size_t)(i == 7 ? 70 : i + 1);
+   }
+   ASSURE(iGood);
+
+   /* the ninth binding gets the table its buckets */
+   SymTable_resetStats(oSymTable);
+   ASSURE(SymTable_put(oSymTable, "8", (void*)9));
+   SymTable_getStats(oSymTable, &sStats);
+#ifdef SYMTABLE_STATS
+   ASSURE(sStats.uAllocs == 2);
+#endif
+   ASSURE(SymTable_getBucketCount(oSymTable) == 509);
+   ASSURE(SymTable_getLength(oSymTable) == SMALL_COUNT + 1);
+   for (i = 0; i <= SMALL_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_get(oSymTable, acKey) ==
+         (void*)(size_t)(i == 7 ? 70 : i + 1);
+   }
+   ASSURE(iGood);
+   SymTable_free(oSymTable);
+
+   /* clearing a small table pools its nodes for the next bindings */
+   SymTable_clear(oClone, NULL);
+   ASSURE(SymTable_getLength(oClone) == 0);
+   ASSURE(! SymTable_contains(oClone, "0"));
+   SymTable_resetStats(oClone);
+   for (i = 0; i < SMALL_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_put(oClone, acKey, (void*)(size_t)(i + 1));
+   }
+   ASSURE(iGood);
+   SymTable_getStats(oClone, &sStats);
+   ASSURE(sStats.uAllocs == 0);
+   SymTable_free(oClone);
+
+   /* a snapshot of a small table reads buckets */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "a", (void*)1));
+   oSnapshot = SymTable_snapshot(oSymTable);
+   ASSURE(oSnapshot != NULL);
+   ASSURE(SymTable_put(oSymTable, "b", (void*)2));
+   ASSURE(SymTable_remove(oSymTable, "a") == (void*)1);
+   ASSURE(SymTable_get(oSnapshot, "a") == (void*)1);
+   ASSURE(! SymTable_contains(oSnapshot, "b"));
+   ASSURE(SymTable_get(oSymTable, "b") == (void*)2);
+   SymTable_free(oSnapshot);
+   SymTable_free(oSymTable);
+
+   /* so does a small table with a filter */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "a", (void*)1));
+   ASSURE(SymTable_setFilter(oSymTable, 1));
+   ASSURE(SymTable_get(oSymTable, "a") == (void*)1);
+   ASSURE(! SymTable_contains(oSymTable, "b"));
+   SymTable_free(oSymTable);
+
+   /* with a tree threshold of 1, every bucket is a tree once the
+      table has buckets */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   SymTable_setTreeThreshold(oSymTable, 1);
+   for (i = 0; i < 2 * SMALL_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_put(oSymTable, acKey, (void*)(size_t)(i + 1));
+   }
+   for (i = 0; i < 2 * SMALL_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_remove(oSymTable, acKey) == (void*)(size_t)(i + 1);
+   }
+   ASSURE(iGood);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   SymTable_free(oSymTable);
+
+   /* a small table frees its values with its destructor */
+   oSymTable = SymTable_newWithDestructor(free);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "a", malloc(1)));
+   ASSURE(SymTable_put(oSymTable, "b", malloc(1)));
+   ASSURE(SymTable_delete(oSymTable, "a"));
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* the threads of testSharded, the keys each binds alone, and the keys
+   all of them race to bind */
+enum {SHARD_THREADS = 4, OWN_KEYS = 5000, SHARED_KEYS = 1000};
+
+/* thread structure which describes one thread of testSharded */
+struct ShardedThread
+{
+   pthread_t iThread;
+   SymTable_T oSymTable;
+   int iIndex;
+   size_t uSharedPuts;
+   int iGood;
+};
+
+/* Put, look up and remove the keys of thread pvThread, a struct
+   ShardedThread, in its table, and race the other threads to put and
+   remove the shared keys. Return NULL. */
+
+static void *runShardedThread(void *pvThread)
+{
+   struct ShardedThread *psThread = (struct ShardedThread*)pvThread;
+   char acKey[KEY_SIZE];
+   int i;
+
+   for (i = 0; i < OWN_KEYS; i++)
+   {
+      sprintf(acKey, "%d-%d", psThread->iIndex, i);
+      psThread->iGood &= SymTable_put(psThread->oSymTable, acKey,
+         (void*)(size_t)(i + 1));
+      psThread->iGood &= SymTable_get(psThread->oSymTable, acKey) ==
+         (void*)(size_t)(i + 1);
+      sprintf(acKey, "shared-%d", i % SHARED_KEYS);
+      psThread->uSharedPuts += (size_t)SymTable_put(psThread->oSymTable,
+         acKey, acKey);
+      /* reads the length while the other threads change it */
+      if (i % 1000 == 0)
+         psThread->iGood &=
+            SymTable_getLength(psThread->oSymTable) <=
+               SHARD_THREADS * OWN_KEYS + SHARED_KEYS &&
+            SymTable_getExactLength(psThread->oSymTable) <=
+               SHARD_THREADS * OWN_KEYS + SHARED_KEYS;
+   }
+   /* leaves the even keys bound */
+   for (i = 1; i < OWN_KEYS; i += 2)
+   {
+      sprintf(acKey, "%d-%d", psThread->iIndex, i);
+      psThread->iGood &= SymTable_remove(psThread->oSymTable, acKey) ==
+         (void*)(size_t)(i + 1);
+   }
+   return NULL;
+}
+
+/* Test SymTable_newSharded: the functions of symtable.h on a sharded
+   table from one thread, and puts, gets and removes from several. */
+
+static void testSharded(void)
+{
+   struct ShardedThread asThreads[SHARD_THREADS];
+   SymTable_T oSymTable;
+   SymTable_T oClone;
+   char acKey[KEY_SIZE];
+   struct SymTableStats sStats;
+   size_t uSharedPuts = 0;
+   size_t uMapped;
+   int iGood = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing sharded tables.\n");
+   fflush(stdout);
+
+   ASSURE(SymTable_newSharded(0) == NULL);
+   ASSURE(SymTable_newSharded(65537) == NULL);
+
+   /* 5 shards are rounded up to 8 */
+   oSymTable = SymTable_newSharded(5);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getBucketCount(oSymTable) == 8 * 509);
+   for (i = 0; i < 20000; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_put(oSymTable, acKey, (void*)(size_t)(i + 1));
+   }
+   iGood &= ! SymTable_put(oSymTable, "0", NULL);
+   ASSURE(iGood);
+   ASSURE(SymTable_getLength(oSymTable) == 20000);
+   ASSURE(SymTable_getExactLength(oSymTable) == 20000);
+   /* the shards grew on their own */
+   ASSURE(SymTable_getBucketCount(oSymTable) > 8 * 509);
+   ASSURE(SymTable_bucketOf(oSymTable, "0") <
+      SymTable_getBucketCount(oSymTable));
+   SymTable_getStats(oSymTable, &sStats);
+#ifdef SYMTABLE_STATS
+   ASSURE(sStats.uPuts == 20001);
+#else
+   ASSURE(sStats.uPuts == 0);
+#endif
+   SymTable_resetStats(oSymTable);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uPuts == 0);
+
+   ASSURE(SymTable_replace(oSymTable, "7", (void*)70) == (void*)8);
+   for (i = 0; i < 20000; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_remove(oSymTable, acKey) == (void*)(size_t)(i + 1);
+   }
+   for (i = 0; i < 20000; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_contains(oSymTable, acKey) == (i % 2 == 1);
+      iGood &= SymTable_get(oSymTable, acKey) == (i % 2 == 0 ? NULL :
+         (void*)(size_t)(i == 7 ? 70 : i + 1));
+   }
+   ASSURE(iGood);
+   ASSURE(SymTable_getLength(oSymTable) == 10000);
+   uMapped = 0;
+   SymTable_map(oSymTable, countAny, &uMapped);
+   ASSURE(uMapped == 10000);
+
+   /* a clone is sharded too, and independent */
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
+   ASSURE(SymTable_getLength(oClone) == 10000);
+   ASSURE(SymTable_get(oClone, "7") == (void*)70);
+   SymTable_clear(oSymTable, NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   ASSURE(SymTable_getExactLength(oSymTable) == 0);
+   ASSURE(! SymTable_contains(oSymTable, "7"));
+   ASSURE(SymTable_contains(oClone, "7"));
+   SymTable_free(oClone);
+   SymTable_free(oSymTable);
+
+   /* several threads at once: each binds its own keys, and exactly one
+      put of every shared key succeeds */
+   oSymTable = SymTable_newSharded(16);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < SHARD_THREADS; i++)
+   {
+      asThreads[i].oSymTable = oSymTable;
+      asThreads[i].iIndex = i;
+      asThreads[i].uSharedPuts = 0;
+      asThreads[i].iGood = 1;
+      ASSURE(pthread_create(&asThreads[i].iThread, NULL,
+         runShardedThread, &asThreads[i]) == 0);
+   }
+   for (i = 0; i < SHARD_THREADS; i++)
+   {
+      ASSURE(pthread_join(asThreads[i].iThread, NULL) == 0);
+      iGood &= asThreads[i].iGood;
+      uSharedPuts += asThreads[i].uSharedPuts;
+   }
+   ASSURE(iGood);
+   ASSURE(uSharedPuts == SHARED_KEYS);
+   ASSURE(SymTable_getLength(oSymTable) ==
+      SHARD_THREADS * OWN_KEYS / 2 + SHARED_KEYS);
+   ASSURE(SymTable_getExactLength(oSymTable) ==
+      SHARD_THREADS * OWN_KEYS / 2 + SHARED_KEYS);
+   SymTable_free(oSymTable);
+}
+
+/* the number of values destroyCounted has freed */
+static size_t uDestroyed;
+
+/* Free pvValue and count it in uDestroyed. */
+
+static void destroyCounted(void *pvValue)
+{
+   free(pvValue);
+   uDestroyed++;
+}
+
+/* Return a copy of string pcKey in memory from malloc. */
+
+static char *copyKey(const char *pcKey)
+{
+   char *pcCopy = malloc(strlen(pcKey) + 1);
+   ASSURE(pcCopy != NULL);
+   strcpy(pcCopy, pcKey);
+   return pcCopy;
+}
+
+/* Test SymTable_writerBegin, SymTable_writerPut and
+   SymTable_writerFlush: that logged puts behave as SymTable_put would
+   have in the order they were logged, that any read applies them
+   first, that a long burst is applied in pieces, that a put dropped
+   for lack of memory is reported, and that a table with a destructor
+   destroys the values of logged puts that bind nothing. */
+
+static void testWriter(void)
+{
+   enum {WRITER_COUNT = 70000, WRITER_SHORT = 100};
+   SymTable_T oSymTable;
+   char acKey[KEY_SIZE];
+   char *pcValue;
+   struct SymTableStats sStats;
+   size_t uMapped;
+   size_t uAdded;
+   size_t uFail;
+   int iFlushed;
+   int iGood = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing writers.\n");
+   fflush(stdout);
+
+   /* a small table stays small while a writer fills it */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "bound", (void*)1));
+   ASSURE(SymTable_writerBegin(oSymTable));
+   ASSURE(SymTable_writerBegin(oSymTable));
+   ASSURE(SymTable_writerPut(oSymTable, "bound", (void*)2));
+   ASSURE(SymTable_writerPut(oSymTable, "twice", (void*)3));
+   ASSURE(SymTable_writerPut(oSymTable, "twice", (void*)4));
+   ASSURE(SymTable_writerPutN(oSymTable, "abc", 2, (void*)5));
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+   ASSURE(SymTable_get(oSymTable, "bound") == (void*)1);
+   ASSURE(SymTable_get(oSymTable, "twice") == (void*)3);
+   ASSURE(SymTable_get(oSymTable, "ab") == (void*)5);
+   ASSURE(SymTable_writerFlush(oSymTable, &uAdded) && uAdded == 2);
+   SymTable_getStats(oSymTable, &sStats);
+#ifdef SYMTABLE_STATS
+   /* a node per binding, and no bucket array */
+   ASSURE(sStats.uPuts == 5 && sStats.uAllocs == 3);
+#else
+   ASSURE(sStats.uPuts == 0);
+#endif
+   SymTable_free(oSymTable);
+
+   /* a burst larger than the log, with a put, a remove and a get
+      between the logged puts */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_writerBegin(oSymTable));
+   for (i = 0; i < WRITER_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_writerPut(oSymTable, acKey, (void*)(size_t)(i + 1));
+      if (i == WRITER_COUNT / 2)
+      {
+         iGood &= SymTable_get(oSymTable, "0") == (void*)1;
+         iGood &= SymTable_remove(oSymTable, "1") == (void*)2;
+         iGood &= SymTable_put(oSymTable, "-1", NULL);
+         iGood &= ! SymTable_put(oSymTable, acKey, NULL);
+      }
+   }
+   ASSURE(iGood);
+   ASSURE(SymTable_writerPut(oSymTable, "1", (void*)20));
+   ASSURE(SymTable_writerFlush(oSymTable, &uAdded) &&
+      uAdded == WRITER_COUNT + 1);
+   ASSURE(SymTable_getLength(oSymTable) == WRITER_COUNT + 1);
+   /* the table grew to the size the puts would have left it at */
+   ASSURE(SymTable_getBucketCount(oSymTable) >= WRITER_COUNT);
+   for (i = 0; i < WRITER_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iGood &= SymTable_get(oSymTable, acKey) ==
+         (void*)(size_t)(i == 1 ? 20 : i + 1);
+   }
+   ASSURE(iGood);
+   uMapped = 0;
+   SymTable_map(oSymTable, countAny, &uMapped);
+   ASSURE(uMapped == WRITER_COUNT + 1);
+
+   /* freeing a table drops the puts still in its log */
+   ASSURE(SymTable_writerBegin(oSymTable));
+   ASSURE(SymTable_writerPut(oSymTable, "dropped", NULL));
+   SymTable_free(oSymTable);
+
+   /* a put dropped for lack of memory is reported, and every put
+      that was made stays in the table */
+   for (uFail = 0; ; uFail++)
+   {
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      ASSURE(SymTable_writerBegin(oSymTable));
+      for (i = 0; i < WRITER_SHORT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iGood &= SymTable_writerPut(oSymTable, acKey, NULL);
+      }
+      uAllocsLeft = uFail;
+      iFlushed = SymTable_writerFlush(oSymTable, &uAdded);
+      uAllocsLeft = SIZE_MAX;
+      iGood &= uAdded == SymTable_getLength(oSymTable);
+      iGood &= iFlushed == (uAdded == WRITER_SHORT);
+      SymTable_free(oSymTable);
+      if (iFlushed)
+         break;
+   }
+   ASSURE(iGood);
+   ASSURE(uFail > 0);
+
+   /* a table with a destructor owns the values of logged puts */
+   uDestroyed = 0;
+   oSymTable = SymTable_newWithDestructor(destroyCounted);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "bound", copyKey("bound")));
+   ASSURE(SymTable_writerBegin(oSymTable));
+   ASSURE(SymTable_writerPut(oSymTable, "bound", copyKey("rejected")));
+   pcValue = copyKey("twice");
+   ASSURE(SymTable_writerPut(oSymTable, "twice", pcValue));
+   ASSURE(SymTable_writerPut(oSymTable, "twice", pcValue));
+   ASSURE(SymTable_writerPut(oSymTable, "twice", copyKey("rejected")));
+   ASSURE(SymTable_writerFlush(oSymTable, NULL));
+   ASSURE(uDestroyed == 2);
+   ASSURE(SymTable_get(oSymTable, "twice") == pcValue);
+   /* freeing it makes the puts still in its log, destroying every
+      value once */
+   ASSURE(SymTable_writerBegin(oSymTable));
+   ASSURE(SymTable_writerPut(oSymTable, "pending", copyKey("pending")));
+   ASSURE(SymTable_writerPut(oSymTable, "bound", copyKey("rejected")));
+   SymTable_free(oSymTable);
+   ASSURE(uDestroyed == 6);
+}
+
+/* Test SymTable_buildParallel: that it binds every key to the value of
+   its first occurrence with any number of threads, and that the
+   table it returns behaves as one filled by SymTable_put. */
+
+static void testBuildParallel(void)
+{
+   enum {BUILD_COUNT = 50000, BUILD_DISTINCT = 40000};
+   static const size_t auThreads[] = {1, 3, 0};
+   static const size_t auShort[] = {5, 1000};
+   SymTable_T oSymTable;
+   char (*pacKeys)[KEY_SIZE];
+   const char **ppcKeys;
+   const void **ppvValues;
+   struct SymTableStats sStats;
+   size_t uMapped;
+   size_t uFail;
+   size_t u;
+   int iGood = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing parallel builds.\n");
+   fflush(stdout);
+
+   pacKeys = (char (*)[KEY_SIZE])malloc(BUILD_COUNT * KEY_SIZE);
+   ppcKeys = (const char**)malloc(BUILD_COUNT * sizeof(const char*));
+   ppvValues = (const void**)malloc(BUILD_COUNT * sizeof(const void*));
+   ASSURE(pacKeys != NULL && ppcKeys != NULL && ppvValues != NULL);
+   /* the last keys repeat the first ones with other values */
+   for (i = 0; i < BUILD_COUNT; i++)
+   {
+      sprintf(pacKeys[i], "%d", i % BUILD_DISTINCT);
+      ppcKeys[i] = pacKeys[i];
+      ppvValues[i] = (void*)(size_t)(i + 1);
+   }
+
+   for (u = 0; u < sizeof(auThreads) / sizeof(auThreads[0]); u++)
+   {
+      oSymTable = SymTable_buildParallel(ppcKeys, ppvValues, BUILD_COUNT,
+         auThreads[u]);
+      ASSURE(oSymTable != NULL);
+      ASSURE(SymTable_getLength(oSymTable) == BUILD_DISTINCT);
+      for (i = 0; i < BUILD_DISTINCT; i++)
+         iGood &= SymTable_get(oSymTable, ppcKeys[i]) ==
+            (void*)(size_t)(i + 1);
+      ASSURE(iGood);
+      ASSURE(SymTable_getBucketCount(oSymTable) >= BUILD_COUNT);
+      uMapped = 0;
+      SymTable_map(oSymTable, countAny, &uMapped);
+      ASSURE(uMapped == BUILD_DISTINCT);
+      SymTable_getStats(oSymTable, &sStats);
+#ifdef SYMTABLE_STATS
+      ASSURE(sStats.uPuts == BUILD_COUNT);
+#else
+      ASSURE(sStats.uPuts == 0);
+#endif
+      /* the table is an ordinary one */
+      ASSURE(! SymTable_put(oSymTable, "0", NULL));
+      ASSURE(SymTable_remove(oSymTable, "0") == (void*)1);
+      ASSURE(SymTable_put(oSymTable, "new", NULL));
+      ASSURE(SymTable_getLength(oSymTable) == BUILD_DISTINCT);
+      SymTable_free(oSymTable);
+   }
+
+   /* tables too small for threads */
+   oSymTable = SymTable_buildParallel(NULL, NULL, 0, 4);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   SymTable_free(oSymTable);
+   oSymTable = SymTable_buildParallel(ppcKeys, ppvValues, 5, 4);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 5);
+   ASSURE(SymTable_get(oSymTable, "4") == (void*)5);
+   SymTable_free(oSymTable);
+
+   /* a build short of memory, whether it is left to SymTable_put or
+      made by threads, returns NULL or a whole table */
+   for (u = 0; u < sizeof(auShort) / sizeof(auShort[0]); u++)
+   {
+      for (uFail = 0; ; uFail++)
+      {
+         uAllocsLeft = uFail;
+         oSymTable = SymTable_buildParallel(ppcKeys, ppvValues, auShort[u],
+            3);
+         uAllocsLeft = SIZE_MAX;
+         if (oSymTable != NULL)
+            break;
+      }
+      ASSURE(uFail > 0);
+      ASSURE(SymTable_getLength(oSymTable) == auShort[u]);
+      ASSURE(SymTable_get(oSymTable, ppcKeys[auShort[u] - 1]) ==
+         (void*)auShort[u]);
+      SymTable_free(oSymTable);
+   }
+
+   free(ppvValues);
+   free(ppcKeys);
+   free(pacKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the string pvValue, with its '\0', into the uSize bytes at
+   pvBuffer if it fits, and return its size. */
+
+static size_t encodeString(const void *pvValue, void *pvBuffer,
+   size_t uSize)
+{
+   size_t uLength;
+   assert(pvValue != NULL);
+   uLength = strlen((const char*)pvValue) + 1;
+   if (uLength <= uSize)
+      memcpy(pvBuffer, pvValue, uLength);
+   return uLength;
+}
+
+/* Check that pvValue, a value of a mapped table, is the string that
+   testImage bound to pcKey: the key followed by "!". Add 1 to the
+   count at pvExtra. */
+
+static void checkMappedBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   size_t uLength;
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvExtra != NULL);
+   uLength = strlen(pcKey);
+   ASSURE(strncmp((char*)pvValue, pcKey, uLength) == 0 &&
+      strcmp((char*)pvValue + uLength, "!") == 0);
+   ASSURE((size_t)pvValue % 8 == 0);
+   (*(size_t*)pvExtra)++;
+}
+
+/* the offsets in an image of the fields of its header that
+   testImage corrupts, and of the fields of an entry after the entry's
+   start, as SymTable_save writes them */
+enum {IMAGE_BUCKET_COUNT = 32, IMAGE_STARTS_OFFSET = 56,
+   IMAGE_ENTRIES_OFFSET = 64, IMAGE_SIZE = 72};
+enum {ENTRY_KEY_LENGTH = 8, ENTRY_KEY_OFFSET = 16, ENTRY_VALUE_OFFSET = 24};
+
+/* Return the 64-bit word at byte uOffset of pucImage. */
+
+static uint64_t readImageWord(const unsigned char *pucImage,
+   size_t uOffset)
+{
+   uint64_t uWord;
+   memcpy(&uWord, pucImage + uOffset, sizeof(uWord));
+   return uWord;
+}
+
+/* Write the first uSize bytes of the image pucImage to file pcPath,
+   with the 64-bit word at byte uOffset replaced by uWord, and return
+   the result of SymTable_openMapped on the file. */
+
+static SymTable_T openCorrupted(const char *pcPath,
+   const unsigned char *pucImage, size_t uSize, size_t uOffset,
+   uint64_t uWord)
+{
+   unsigned char *pucCopy;
+   FILE *psFile;
+
+   pucCopy = malloc(uSize);
+   ASSURE(pucCopy != NULL);
+   memcpy(pucCopy, pucImage, uSize);
+   if (uOffset + sizeof(uWord) <= uSize)
+      memcpy(pucCopy + uOffset, &uWord, sizeof(uWord));
+   psFile = fopen(pcPath, "wb");
+   ASSURE(psFile != NULL);
+   ASSURE(fwrite(pucCopy, 1, uSize, psFile) == uSize);
+   ASSURE(fclose(psFile) == 0);
+   free(pucCopy);
+   return SymTable_openMapped(pcPath);
+}
+
+/* Test SymTable_save and SymTable_openMapped on tables with chain and
+   tree buckets, and SymTable_openMapped on files that hold no image or
+   an image whose header, bucket starts or entries are corrupt. */
+
+static void testImage(void)
+{
+   enum {IMAGE_BINDINGS = 3000};
+   const char *pcPath = "testhashext.img";
+   SymTable_T oSymTable;
+   SymTable_T oMapped;
+   char (*acValues)[KEY_SIZE + 1];
+   char acKey[KEY_SIZE];
+   FILE *psFile;
+   unsigned char *pucImage;
+   size_t uImageSize;
+   size_t uStarts;
+   size_t uEntries;
+   size_t uThreshold;
+   size_t uMapped;
+   int iGood = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing images.\n");
+   fflush(stdout);
+
+   acValues = malloc(IMAGE_BINDINGS * sizeof(*acValues));
+   ASSURE(acValues != NULL);
+   for (uThreshold = 0; uThreshold <= 1; uThreshold++)
+   {
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      SymTable_setTreeThreshold(oSymTable, uThreshold);
+      /* the empty key is a key like any other */
+      iGood &= SymTable_put(oSymTable, "", "!");
+      for (i = 1; i < IMAGE_BINDINGS; i++)
+      {
+         sprintf(acKey, "key%d", i);
+         sprintf(acValues[i], "%s!", acKey);
+         iGood &= SymTable_put(oSymTable, acKey, acValues[i]);
+      }
+      ASSURE(iGood);
+
+      psFile = fopen(pcPath, "wb");
+      ASSURE(psFile != NULL);
+      ASSURE(SymTable_save(oSymTable, psFile, encodeString));
+      ASSURE(fclose(psFile) == 0);
+
+      oMapped = SymTable_openMapped(pcPath);
+      ASSURE(oMapped != NULL);
+      ASSURE(SymTable_getLength(oMapped) == IMAGE_BINDINGS);
+      ASSURE(SymTable_getBucketCount(oMapped) ==
+         SymTable_getBucketCount(oSymTable));
+      for (i = 1; i < IMAGE_BINDINGS; i++)
+      {
+         sprintf(acKey, "key%d", i);
+         iGood &= SymTable_contains(oMapped, acKey);
+         iGood &= strcmp((char*)SymTable_get(oMapped, acKey),
+            acValues[i]) == 0;
+         iGood &= SymTable_bucketOf(oMapped, acKey) ==
+            SymTable_bucketOf(oSymTable, acKey);
+      }
+      ASSURE(iGood);
+      ASSURE(strcmp((char*)SymTable_get(oMapped, ""), "!") == 0);
+      ASSURE(! SymTable_contains(oMapped, "key0"));
+      ASSURE(SymTable_get(oMapped, "key") == NULL);
+      uMapped = 0;
+      SymTable_map(oMapped, checkMappedBinding, &uMapped);
+      ASSURE(uMapped == IMAGE_BINDINGS);
+
+      /* the image does not depend on the table it came from */
+      SymTable_free(oSymTable);
+      ASSURE(strcmp((char*)SymTable_get(oMapped, "key7"), "key7!") == 0);
+      SymTable_free(oMapped);
+   }
+   free(acValues);
+
+   /* an empty table makes an image too */
+   oSymTable = SymTable_new();
+   psFile = fopen(pcPath, "wb");
+   ASSURE(oSymTable != NULL && psFile != NULL);
+   ASSURE(SymTable_save(oSymTable, psFile, encodeString));
+   ASSURE(fclose(psFile) == 0);
+   SymTable_free(oSymTable);
+   oMapped = SymTable_openMapped(pcPath);
+   ASSURE(oMapped != NULL);
+   ASSURE(SymTable_getLength(oMapped) == 0);
+   ASSURE(! SymTable_contains(oMapped, "key1"));
+   SymTable_free(oMapped);
+
+   /* images that would make lookups read outside the mapping */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < 3; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, "value"));
+   }
+   psFile = fopen(pcPath, "wb");
+   ASSURE(psFile != NULL);
+   ASSURE(SymTable_save(oSymTable, psFile, encodeString));
+   ASSURE(fclose(psFile) == 0);
+   SymTable_free(oSymTable);
+   psFile = fopen(pcPath, "rb");
+   ASSURE(psFile != NULL);
+   ASSURE(fseek(psFile, 0, SEEK_END) == 0);
+   uImageSize = (size_t)ftell(psFile);
+   rewind(psFile);
+   pucImage = malloc(uImageSize);
+   ASSURE(pucImage != NULL);
+   ASSURE(fread(pucImage, 1, uImageSize, psFile) == uImageSize);
+   ASSURE(fclose(psFile) == 0);
+   uStarts = (size_t)readImageWord(pucImage, IMAGE_STARTS_OFFSET);
+   uEntries = (size_t)readImageWord(pucImage, IMAGE_ENTRIES_OFFSET);
+
+   /* the image as it was written opens, checked or trusted */
+   oMapped = openCorrupted(pcPath, pucImage, uImageSize, 0,
+      readImageWord(pucImage, 0));
+   ASSURE(oMapped != NULL);
+   SymTable_free(oMapped);
+   oMapped = SymTable_openMappedTrusted(pcPath);
+   ASSURE(oMapped != NULL);
+   ASSURE(strcmp((char*)SymTable_get(oMapped, "key1"), "value") == 0);
+   SymTable_free(oMapped);
+
+   /* offsets and counts in the header whose products or sums wrap */
+   ASSURE(openCorrupted(pcPath, pucImage, uImageSize,
+      IMAGE_STARTS_OFFSET, ~(uint64_t)7) == NULL);
+   ASSURE(openCorrupted(pcPath, pucImage, uImageSize,
+      IMAGE_BUCKET_COUNT, (uint64_t)1 << 61) == NULL);
+   /* a truncated image, whose header still gives the truncated size */
+   ASSURE(openCorrupted(pcPath, pucImage, uEntries, IMAGE_SIZE,
+      (uint64_t)uEntries) == NULL);
+   /* bucket starts that fall or leave the entries */
+   ASSURE(openCorrupted(pcPath, pucImage, uImageSize, uStarts,
+      (uint64_t)2) == NULL);
+   ASSURE(openCorrupted(pcPath, pucImage, uImageSize, uStarts + 8,
+      ~(uint64_t)0) == NULL);
+   /* keys and values outside the image, and a key without its '\0' */
+   ASSURE(openCorrupted(pcPath, pucImage, uImageSize,
+      uEntries + ENTRY_KEY_OFFSET, (uint64_t)uImageSize) == NULL);
+   ASSURE(openCorrupted(pcPath, pucImage, uImageSize,
+      uEntries + ENTRY_KEY_LENGTH, ~(uint64_t)0) == NULL);
+   ASSURE(openCorrupted(pcPath, pucImage, uImageSize,
+      uEntries + ENTRY_KEY_LENGTH, (uint64_t)3) == NULL);
+   ASSURE(openCorrupted(pcPath, pucImage, uImageSize,
+      uEntries + ENTRY_VALUE_OFFSET, (uint64_t)uImageSize + 8) == NULL);
+   free(pucImage);
+
+   /* files that hold no image */
+   psFile = fopen(pcPath, "wb");
+   ASSURE(psFile != NULL);
+   fprintf(psFile, "not an image, but long enough to hold a header of "
+      "an image, which is 80 bytes long\n");
+   ASSURE(fclose(psFile) == 0);
+   ASSURE(SymTable_openMapped(pcPath) == NULL);
+   ASSURE(remove(pcPath) == 0);
+   ASSURE(SymTable_openMapped(pcPath) == NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTableText_dump and SymTableText_load on a table that spills
+   into buckets, and SymTableText_load on files with lines that hold no
+   binding, duplicate keys, no final newline, and no lines at all, and
+   short of memory. */
+
+static void testText(void)
+{
+   enum {TEXT_BINDINGS = 3000, TEXT_SHORT = 100};
+   const char *pcPath = "testhashext.txt";
+   SymTable_T oSymTable;
+   SymTable_T oLoaded;
+   SymTableText_T oText;
+   char (*acValues)[KEY_SIZE + 1];
+   char acKey[KEY_SIZE];
+   FILE *psFile;
+   size_t uFail;
+   int iGood = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing text files.\n");
+   fflush(stdout);
+
+   acValues = malloc(TEXT_BINDINGS * sizeof(*acValues));
+   ASSURE(acValues != NULL);
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   /* the empty key and the empty value are written like any other */
+   iGood &= SymTable_put(oSymTable, "", "");
+   for (i = 1; i < TEXT_BINDINGS; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      sprintf(acValues[i], "%s!", acKey);
+      iGood &= SymTable_put(oSymTable, acKey, acValues[i]);
+   }
+   ASSURE(iGood);
+   psFile = fopen(pcPath, "wb");
+   ASSURE(psFile != NULL);
+   ASSURE(SymTableText_dump(oSymTable, psFile));
+   ASSURE(fclose(psFile) == 0);
+   SymTable_free(oSymTable);
+
+   oLoaded = SymTable_new();
+   ASSURE(oLoaded != NULL);
+   oText = SymTableText_load(oLoaded, pcPath);
+   ASSURE(oText != NULL);
+   ASSURE(SymTableText_getBound(oText) == TEXT_BINDINGS);
+   ASSURE(SymTable_getLength(oLoaded) == TEXT_BINDINGS);
+   for (i = 1; i < TEXT_BINDINGS; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      iGood &= strcmp((char*)SymTable_get(oLoaded, acKey),
+         acValues[i]) == 0;
+   }
+   ASSURE(iGood);
+   ASSURE(strcmp((char*)SymTable_get(oLoaded, ""), "") == 0);
+   SymTable_free(oLoaded);
+   SymTableText_free(oText);
+   free(acValues);
+
+   /* a line without a tab is skipped, the first binding of a key
+      wins, a value may hold a tab, and the last line has no
+      newline */
+   psFile = fopen(pcPath, "wb");
+   ASSURE(psFile != NULL);
+   fprintf(psFile, "alpha\t1\nno tab here\nbeta\t2\t3\n\nalpha\t4\n"
+      "gamma\t5");
+   ASSURE(fclose(psFile) == 0);
+   oLoaded = SymTable_new();
+   ASSURE(oLoaded != NULL);
+   oText = SymTableText_load(oLoaded, pcPath);
+   ASSURE(oText != NULL);
+   ASSURE(SymTableText_getBound(oText) == 3);
+   ASSURE(SymTable_getLength(oLoaded) == 3);
+   ASSURE(strcmp((char*)SymTable_get(oLoaded, "alpha"), "1") == 0);
+   ASSURE(strcmp((char*)SymTable_get(oLoaded, "beta"), "2\t3") == 0);
+   ASSURE(strcmp((char*)SymTable_get(oLoaded, "gamma"), "5") == 0);
+   ASSURE(! SymTable_contains(oLoaded, "no tab here"));
+   SymTable_free(oLoaded);
+   SymTableText_free(oText);
+
+   /* a key the table binds already is no error, and keeps its value */
+   oLoaded = SymTable_new();
+   ASSURE(oLoaded != NULL);
+   ASSURE(SymTable_put(oLoaded, "beta", "old"));
+   oText = SymTableText_load(oLoaded, pcPath);
+   ASSURE(oText != NULL);
+   ASSURE(SymTableText_getBound(oText) == 2);
+   ASSURE(SymTable_getLength(oLoaded) == 3);
+   ASSURE(strcmp((char*)SymTable_get(oLoaded, "beta"), "old") == 0);
+   SymTable_free(oLoaded);
+   SymTableText_free(oText);
+
+   /* a load that runs out of memory part way, past a key the table
+      binds already and a key the file repeats, leaves the table as it
+      was */
+   psFile = fopen(pcPath, "wb");
+   ASSURE(psFile != NULL);
+   for (i = 0; i < TEXT_SHORT; i++)
+      fprintf(psFile, "key%d\tvalue%d\n", i, i);
+   fprintf(psFile, "beta\tnew\nkey1\tagain\nlast\tvalue");
+   ASSURE(fclose(psFile) == 0);
+   oLoaded = SymTable_new();
+   ASSURE(oLoaded != NULL);
+   ASSURE(SymTable_put(oLoaded, "beta", "old"));
+   for (uFail = 0; ; uFail++)
+   {
+      uAllocsLeft = uFail;
+      oText = SymTableText_load(oLoaded, pcPath);
+      uAllocsLeft = SIZE_MAX;
+      if (oText != NULL)
+         break;
+      iGood &= SymTable_getLength(oLoaded) == 1;
+      iGood &= strcmp((char*)SymTable_get(oLoaded, "beta"), "old") == 0;
+   }
+   ASSURE(iGood);
+   ASSURE(uFail > 2);
+   ASSURE(SymTableText_getBound(oText) == TEXT_SHORT + 1);
+   ASSURE(SymTable_getLength(oLoaded) == TEXT_SHORT + 2);
+   ASSURE(strcmp((char*)SymTable_get(oLoaded, "key1"), "value1") == 0);
+   ASSURE(strcmp((char*)SymTable_get(oLoaded, "last"), "value") == 0);
+   SymTable_free(oLoaded);
+   SymTableText_free(oText);
+
+   /* an empty file binds nothing, and a missing one is an error */
+   psFile = fopen(pcPath, "wb");
+   ASSURE(psFile != NULL);
+   ASSURE(fclose(psFile) == 0);
+   oLoaded = SymTable_new();
+   ASSURE(oLoaded != NULL);
+   oText = SymTableText_load(oLoaded, pcPath);
+   ASSURE(oText != NULL);
+   ASSURE(SymTableText_getBound(oText) == 0);
+   ASSURE(SymTable_getLength(oLoaded) == 0);
+   SymTableText_free(oText);
+   ASSURE(remove(pcPath) == 0);
+   ASSURE(SymTableText_load(oLoaded, pcPath) == NULL);
+   SymTable_free(oLoaded);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_freeze on tables of several sizes, with chain and
+   tree buckets. */
+
+static void testFreeze(void)
+{
+   static const size_t auSizes[] = {0, 1, 2, 7, 100, 3000};
+   SymTable_T oSymTable;
+   SymTable_T oFrozen;
+   char acKey[KEY_SIZE];
+   struct SymTableStats sStats;
+   size_t uSize;
+   size_t uMapped;
+   size_t u;
+   size_t v;
+   int iGood = 1;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing frozen tables.\n");
+   fflush(stdout);
+
+   for (u = 0; u < sizeof(auSizes) / sizeof(auSizes[0]); u++)
+   {
+      uSize = auSizes[u];
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      SymTable_setTreeThreshold(oSymTable, u % 2);
+      for (v = 0; v < uSize; v++)
+      {
+         sprintf(acKey, "%lu", (unsigned long)v);
+         iGood &= SymTable_put(oSymTable, acKey, (void*)(v + 1));
+      }
+      oFrozen = SymTable_freeze(oSymTable);
+      ASSURE(oFrozen != NULL);
+
+      /* the frozen table does not depend on the live one */
+      SymTable_free(oSymTable);
+      ASSURE(SymTable_getLength(oFrozen) == uSize);
+      SymTable_resetStats(oFrozen);
+      for (v = 0; v < uSize; v++)
+      {
+         sprintf(acKey, "%lu", (unsigned long)v);
+         iGood &= SymTable_get(oFrozen, acKey) == (void*)(v + 1);
+         iGood &= SymTable_contains(oFrozen, acKey);
+      }
+      for (v = uSize; v < uSize + 100; v++)
+      {
+         sprintf(acKey, "%lu", (unsigned long)v);
+         iGood &= SymTable_get(oFrozen, acKey) == NULL;
+         iGood &= ! SymTable_contains(oFrozen, acKey);
+      }
+      iGood &= ! SymTable_contains(oFrozen, "");
+      ASSURE(iGood);
+#ifdef SYMTABLE_STATS
+      /* one slot per lookup */
+      SymTable_getStats(oFrozen, &sStats);
+      ASSURE(sStats.uProbes == 2 * uSize + 201);
+#else
+      SymTable_getStats(oFrozen, &sStats);
+      ASSURE(sStats.uProbes == 0);
+#endif
+      uMapped = 0;
+      SymTable_map(oFrozen, countAny, &uMapped);
+      ASSURE(uMapped == uSize);
+      SymTable_free(oFrozen);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if oSymTable holds exactly the uCount bindings that
+   testSnapshot starts with, each key "v" bound to v + 1, and 0 (FALSE)
+   otherwise. */
+
+static int holdsOriginals(SymTable_T oSymTable, size_t uCount)
+{
+   char acKey[KEY_SIZE];
+   size_t uMapped = 0;
+   size_t v;
+   int iGood = 1;
+
+   for (v = 0; v < uCount; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_get(oSymTable, acKey) == (void*)(v + 1);
+   }
+   sprintf(acKey, "%lu", (unsigned long)uCount);
+   iGood &= ! SymTable_contains(oSymTable, acKey);
+   SymTable_map(oSymTable, countAny, &uMapped);
+   return iGood && uMapped == uCount &&
+      SymTable_getLength(oSymTable) == uCount;
+}
+
+/* Test that snapshots keep the bindings their table had when they
+   were taken through replaces, removes, puts, resizes, clears and
+   the freeing of the table, in chain and in tree buckets, and that
+   the destructor of a table spares the values its snapshots return
+   until the last of them is freed. */
+
+static void testSnapshot(void)
+{
+   enum {COUNT = 2000, FLOOD_COUNT = 300};
+   SymTable_T oSymTable;
+   SymTable_T oFirst;
+   SymTable_T oSecond;
+   SymTable_T oThird;
+   char (*acKeys)[KEY_SIZE];
+   char acKey[KEY_SIZE];
+   struct SymTableStats sStats;
+   size_t uAllocs;
+   size_t uLength;
+   size_t uMapped;
+   size_t v;
+   int iGood = 1;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing snapshots.\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (v = 0; v < COUNT; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_put(oSymTable, acKey, (void*)(v + 1));
+   }
+   ASSURE(iGood);
+
+   SymTable_resetStats(oSymTable);
+   oFirst = SymTable_snapshot(oSymTable);
+   ASSURE(oFirst != NULL);
+   ASSURE(holdsOriginals(oFirst, COUNT));
+
+   /* the first change to a bucket copies it, and later ones do not */
+   ASSURE(SymTable_replace(oSymTable, "0", (void*)1) == (void*)1);
+   SymTable_getStats(oSymTable, &sStats);
+   uAllocs = sStats.uAllocs;
+   ASSURE(SymTable_replace(oSymTable, "0", (void*)1) == (void*)1);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uAllocs == uAllocs);
+#ifdef SYMTABLE_STATS
+   ASSURE(uAllocs > 0);
+#endif
+
+   for (v = 0; v < COUNT; v += 2)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_replace(oSymTable, acKey, (void*)(v + 10001)) ==
+         (void*)(v + 1);
+   }
+   oSecond = SymTable_snapshot(oSymTable);
+   ASSURE(oSecond != NULL);
+   for (v = 0; v < COUNT; v += 3)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_remove(oSymTable, acKey) != NULL;
+   }
+   ASSURE(iGood);
+   ASSURE(holdsOriginals(oFirst, COUNT));
+   for (v = 0; v < COUNT; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_get(oSecond, acKey) ==
+         (void*)(v % 2 == 0 ? v + 10001 : v + 1);
+      iGood &= SymTable_contains(oSymTable, acKey) == (v % 3 != 0);
+   }
+   ASSURE(iGood);
+   ASSURE(SymTable_getLength(oSecond) == COUNT);
+
+   /* growing moves every bucket */
+   for (v = COUNT; v < 2 * COUNT; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_put(oSymTable, acKey, (void*)(v + 1));
+   }
+   ASSURE(iGood);
+   ASSURE(SymTable_getBucketCount(oSymTable) >
+      SymTable_getBucketCount(oFirst));
+   ASSURE(holdsOriginals(oFirst, COUNT));
+   SymTable_free(oFirst);
+
+   /* a snapshot outlives its table */
+   oThird = SymTable_snapshot(oSymTable);
+   ASSURE(oThird != NULL);
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(SymTable_remove(oSymTable, "1") == (void*)2);
+   SymTable_free(oSymTable);
+   ASSURE(SymTable_getLength(oThird) == uLength);
+   ASSURE(SymTable_get(oThird, "1") == (void*)2);
+   ASSURE(SymTable_get(oThird, "2001") == (void*)2002);
+   ASSURE(! SymTable_contains(oThird, "3"));
+   uMapped = 0;
+   SymTable_map(oThird, countAny, &uMapped);
+   ASSURE(uMapped == uLength);
+   ASSURE(SymTable_getLength(oSecond) == COUNT);
+   SymTable_free(oSecond);
+   SymTable_free(oThird);
+
+   /* tree buckets, and clearing */
+   acKeys = malloc(FLOOD_COUNT * sizeof(*acKeys));
+   ASSURE(acKeys != NULL);
+   makeCollidingKeys(acKeys, FLOOD_COUNT);
+   oSymTable = SymTable_newSeeded(TEST_SEED0, TEST_SEED1);
+   ASSURE(oSymTable != NULL);
+   for (v = 0; v < FLOOD_COUNT; v++)
+      iGood &= SymTable_put(oSymTable, acKeys[v], acKeys[v]);
+   oFirst = SymTable_snapshot(oSymTable);
+   ASSURE(oFirst != NULL);
+   for (v = 0; v < FLOOD_COUNT; v += 2)
+      iGood &= SymTable_remove(oSymTable, acKeys[v]) == acKeys[v];
+   iGood &= SymTable_replace(oSymTable, acKeys[1], "value") == acKeys[1];
+   oSecond = SymTable_snapshot(oSymTable);
+   ASSURE(oSecond != NULL);
+   SymTable_clear(oSymTable, NULL);
+   ASSURE(iGood);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   for (v = 0; v < FLOOD_COUNT; v++)
+      iGood &= SymTable_get(oFirst, acKeys[v]) == acKeys[v];
+   ASSURE(iGood);
+   ASSURE(SymTable_get(oSecond, acKeys[0]) == NULL);
+   ASSURE(strcmp(SymTable_get(oSecond, acKeys[1]), "value") == 0);
+   uMapped = 0;
+   SymTable_map(oFirst, countBinding, &uMapped);
+   ASSURE(uMapped == FLOOD_COUNT);
+   ASSURE(SymTable_getLength(oSecond) == FLOOD_COUNT / 2);
+   SymTable_free(oSymTable);
+   SymTable_free(oSecond);
+   SymTable_free(oFirst);
+   free(acKeys);
+
+   /* deleting and clearing with snapshots of a table with a
+      destructor */
+   uDestroyed = 0;
+   oSymTable = SymTable_newWithDestructor(destroyCounted);
+   ASSURE(oSymTable != NULL);
+   for (v = 0; v < COUNT; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_put(oSymTable, acKey, copyKey(acKey));
+   }
+   oFirst = SymTable_snapshot(oSymTable);
+   ASSURE(oFirst != NULL);
+   for (v = 0; v < COUNT; v += 2)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_delete(oSymTable, acKey);
+   }
+   ASSURE(iGood);
+   ASSURE(uDestroyed == 0);
+   oSecond = SymTable_snapshot(oSymTable);
+   ASSURE(oSecond != NULL);
+   SymTable_clear(oSymTable, NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   ASSURE(uDestroyed == 0);
+   uMapped = 0;
+   SymTable_map(oFirst, countBinding, &uMapped);
+   ASSURE(uMapped == COUNT);
+   uMapped = 0;
+   SymTable_map(oSecond, countBinding, &uMapped);
+   ASSURE(uMapped == COUNT / 2);
+   SymTable_free(oFirst);
+   ASSURE(uDestroyed == 0);
+   ASSURE(strcmp(SymTable_get(oSecond, "1"), "1") == 0);
+   SymTable_free(oSecond);
+   ASSURE(uDestroyed == COUNT);
+   /* without snapshots, the destructor runs at once again */
+   ASSURE(SymTable_put(oSymTable, "0", copyKey("0")));
+   ASSURE(SymTable_delete(oSymTable, "0"));
+   ASSURE(uDestroyed == COUNT + 1);
+   SymTable_free(oSymTable);
+
+   /* a snapshot detached by resizing still returns the values after
+      its table deletes them and is freed */
+   uDestroyed = 0;
+   oSymTable = SymTable_newWithDestructor(destroyCounted);
+   ASSURE(oSymTable != NULL);
+   for (v = 0; v < FLOOD_COUNT; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_put(oSymTable, acKey, copyKey(acKey));
+   }
+   oFirst = SymTable_snapshot(oSymTable);
+   ASSURE(oFirst != NULL);
+   for (v = FLOOD_COUNT; v < COUNT; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_put(oSymTable, acKey, copyKey(acKey));
+   }
+   ASSURE(iGood);
+   ASSURE(SymTable_getBucketCount(oSymTable) >
+      SymTable_getBucketCount(oFirst));
+   ASSURE(SymTable_delete(oSymTable, "0"));
+   SymTable_free(oSymTable);
+   ASSURE(uDestroyed == 0);
+   uMapped = 0;
+   SymTable_map(oFirst, countBinding, &uMapped);
+   ASSURE(uMapped == FLOOD_COUNT);
+   SymTable_free(oFirst);
+   ASSURE(uDestroyed == COUNT);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a SymTableScope object resolves each key to its innermost
+   binding through nested scopes, and uncovers shadowed bindings as
+   scopes close. */
+
+static void testScope(void)
+{
+   enum {DEPTH = 40, COUNT = 50};
+   SymTableScope_T oScope;
+   char acKey[KEY_SIZE];
+   int aiValues[DEPTH + 1];
+   size_t uDepth;
+   size_t u;
+   size_t v;
+   int iGood = 1;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing nested scopes.\n");
+   fflush(stdout);
+
+   oScope = SymTableScope_new();
+   ASSURE(oScope != NULL);
+   ASSURE(SymTableScope_getDepth(oScope) == 0);
+   ASSURE(SymTableScope_get(oScope, "x", NULL) == NULL);
+   ASSURE(! SymTableScope_contains(oScope, "x"));
+
+   /* Scope u binds "x" and "only<u>", and the even ones "shared", in
+      more scopes than the object starts with room for. */
+   for (u = 0; u <= DEPTH; u++)
+   {
+      if (u > 0)
+         ASSURE(SymTableScope_push(oScope));
+      ASSURE(SymTableScope_put(oScope, "x", &aiValues[u]));
+      ASSURE(! SymTableScope_put(oScope, "x", &aiValues[0]));
+      sprintf(acKey, "only%lu", (unsigned long)u);
+      ASSURE(SymTableScope_put(oScope, acKey, &aiValues[u]));
+      if (u % 2 == 0)
+         ASSURE(SymTableScope_put(oScope, "shared", &aiValues[u]));
+   }
+   ASSURE(SymTableScope_getDepth(oScope) == DEPTH);
+
+   /* Closing scopes one by one uncovers the bindings they shadowed. */
+   for (u = DEPTH; u > 0; u--)
+   {
+      uDepth = DEPTH + 1;
+      iGood &= SymTableScope_get(oScope, "x", &uDepth) == &aiValues[u];
+      iGood &= uDepth == u;
+      iGood &= SymTableScope_get(oScope, "shared", &uDepth) ==
+         &aiValues[u - u % 2];
+      iGood &= uDepth == u - u % 2;
+      for (v = 0; v <= DEPTH; v++)
+      {
+         sprintf(acKey, "only%lu", (unsigned long)v);
+         iGood &= SymTableScope_contains(oScope, acKey) == (v <= u);
+      }
+      SymTableScope_pop(oScope);
+   }
+   ASSURE(iGood);
+   ASSURE(SymTableScope_getDepth(oScope) == 0);
+   ASSURE(SymTableScope_get(oScope, "x", NULL) == &aiValues[0]);
+   ASSURE(! SymTableScope_contains(oScope, "only1"));
+
+   /* Keys bound again after their scope closed, and a scope closed
+      with bindings still open when the object is freed. */
+   ASSURE(SymTableScope_push(oScope));
+   for (u = 0; u < COUNT; u++)
+   {
+      sprintf(acKey, "only%lu", (unsigned long)u);
+      ASSURE(SymTableScope_put(oScope, acKey, &aiValues[1]));
+   }
+   ASSURE(SymTableScope_get(oScope, "only0", &uDepth) == &aiValues[1]);
+   ASSURE(uDepth == 1);
+   ASSURE(SymTableScope_get(oScope, "only45", NULL) == &aiValues[1]);
+   SymTableScope_free(oScope);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The calls of a slow-operation hook that testTracing counts, with the
+   thresholds the hook was given. */
+
+struct SlowCalls
+{
+   uint64_t uNanoseconds;
+   size_t uDepth;
+   size_t uCalls;
+   size_t uResizes;
+   int iGood;
+};
+
+/* Count the call for psOp in pvExtra, a struct SlowCalls, and check
+   that psOp meets one of its conditions. */
+
+static void countSlow(const struct SymTableSlowOp *psOp, void *pvExtra)
+{
+   struct SlowCalls *psCalls = (struct SlowCalls*)pvExtra;
+   int iResized = psOp->uBucketsBefore != psOp->uBucketsAfter;
+
+   psCalls->uCalls++;
+   psCalls->uResizes += (size_t)iResized;
+   psCalls->iGood &= psOp->pcKey != NULL && psOp->eOp < SYMTABLE_OP_COUNT;
+   psCalls->iGood &= iResized ||
+      (psCalls->uNanoseconds != 0 &&
+         psOp->uNanoseconds >= psCalls->uNanoseconds) ||
+      (psCalls->uDepth != 0 && psOp->uDepth >= psCalls->uDepth);
+}
+
+/* Test that a traced table counts each timed put, lookup and remove in
+   the histogram of its kind, that an interval times one operation in
+   so many, that the slow-operation hook sees every resize and only
+   slow operations, and that SymTable_latencyAt reads the buckets of a
+   histogram. */
+
+static void testTracing(void)
+{
+   enum {COUNT = 5000, MISSES = 100, REMOVES = 4000};
+   SymTable_T oSymTable;
+   char acKey[KEY_SIZE];
+   struct SymTableLatency sLatency;
+   struct SlowCalls sCalls;
+   size_t uBuckets;
+   size_t uResizes = 0;
+   uint64_t uSum;
+   size_t u;
+   size_t v;
+   int iGood = 1;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing latency histograms.\n");
+   fflush(stdout);
+
+   /* an untraced table has empty histograms */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "0", NULL));
+   SymTable_getLatency(oSymTable, SYMTABLE_OP_PUT, &sLatency);
+   ASSURE(sLatency.uCount == 0 && sLatency.uMax == 0);
+   ASSURE(SymTable_latencyAt(&sLatency, 0.5) == 0);
+
+   ASSURE(SymTable_setTracing(oSymTable, 1));
+   ASSURE(SymTable_setTracing(oSymTable, 1));
+   sCalls.uNanoseconds = 0;
+   sCalls.uDepth = 0;
+   sCalls.uCalls = 0;
+   sCalls.uResizes = 0;
+   sCalls.iGood = 1;
+   /* with both thresholds 0 only resizes call the hook */
+   SymTable_setSlowHook(oSymTable, 0, 0, countSlow, &sCalls);
+   uBuckets = SymTable_getBucketCount(oSymTable);
+   for (v = 1; v < COUNT; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_put(oSymTable, acKey, (void*)(v + 1));
+      uResizes += SymTable_getBucketCount(oSymTable) != uBuckets;
+      uBuckets = SymTable_getBucketCount(oSymTable);
+   }
+   for (v = 0; v < COUNT + MISSES; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_contains(oSymTable, acKey) == (v < COUNT);
+   }
+   for (v = 0; v < REMOVES; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_remove(oSymTable, acKey) == (void*)(v + 1) ||
+         v == 0;
+      uResizes += SymTable_getBucketCount(oSymTable) != uBuckets;
+      uBuckets = SymTable_getBucketCount(oSymTable);
+   }
+   ASSURE(iGood);
+   ASSURE(uResizes >= 2);
+   ASSURE(sCalls.iGood);
+   ASSURE(sCalls.uCalls == uResizes && sCalls.uResizes == uResizes);
+
+   SymTable_getLatency(oSymTable, SYMTABLE_OP_PUT, &sLatency);
+   ASSURE(sLatency.uCount == COUNT - 1);
+   SymTable_getLatency(oSymTable, SYMTABLE_OP_GET, &sLatency);
+   ASSURE(sLatency.uCount == COUNT + MISSES);
+   uSum = 0;
+   for (u = 0; u < SYMTABLE_LATENCY_BUCKETS; u++)
+      uSum += sLatency.auBuckets[u];
+   ASSURE(uSum == sLatency.uCount);
+   ASSURE(SymTable_latencyAt(&sLatency, 0.5) <=
+      SymTable_latencyAt(&sLatency, 0.99));
+   ASSURE(SymTable_latencyAt(&sLatency, 0.99) <= sLatency.uMax);
+   ASSURE(SymTable_latencyAt(&sLatency, 1.0) == sLatency.uMax);
+   SymTable_getLatency(oSymTable, SYMTABLE_OP_REMOVE, &sLatency);
+   ASSURE(sLatency.uCount == REMOVES);
+
+   /* every operation at least as slow, or as deep, as the thresholds
+      calls the hook as well */
+   sCalls.uNanoseconds = 1000;
+   sCalls.uDepth = 2;
+   sCalls.uCalls = 0;
+   SymTable_setSlowHook(oSymTable, sCalls.uNanoseconds, sCalls.uDepth,
+      countSlow, &sCalls);
+   for (v = 0; v < COUNT; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      (void)SymTable_get(oSymTable, acKey);
+   }
+   ASSURE(sCalls.iGood);
+   SymTable_setSlowHook(oSymTable, 0, 0, NULL, NULL);
+   sCalls.uCalls = 0;
+   ASSURE(SymTable_put(oSymTable, "0", NULL));
+   ASSURE(sCalls.uCalls == 0);
+
+   SymTable_resetLatency(oSymTable);
+   SymTable_getLatency(oSymTable, SYMTABLE_OP_GET, &sLatency);
+   ASSURE(sLatency.uCount == 0);
+   ASSURE(SymTable_get(oSymTable, "0") == NULL);
+   SymTable_getLatency(oSymTable, SYMTABLE_OP_GET, &sLatency);
+   ASSURE(sLatency.uCount == 1);
+
+   /* a new interval keeps the histograms, and the hook still sees
+      every resize */
+   ASSURE(SymTable_setTracing(oSymTable, 10));
+   for (v = 0; v < 100; v++)
+      (void)SymTable_get(oSymTable, "0");
+   SymTable_getLatency(oSymTable, SYMTABLE_OP_GET, &sLatency);
+   ASSURE(sLatency.uCount == 11);
+   sCalls.uNanoseconds = 0;
+   sCalls.uDepth = 0;
+   sCalls.uCalls = 0;
+   sCalls.uResizes = 0;
+   SymTable_setSlowHook(oSymTable, 0, 0, countSlow, &sCalls);
+   uResizes = 0;
+   uBuckets = SymTable_getBucketCount(oSymTable);
+   for (v = 0; v < COUNT; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      (void)SymTable_remove(oSymTable, acKey);
+      uResizes += SymTable_getBucketCount(oSymTable) != uBuckets;
+      uBuckets = SymTable_getBucketCount(oSymTable);
+   }
+   ASSURE(uResizes >= 1);
+   ASSURE(sCalls.iGood);
+   ASSURE(sCalls.uCalls == uResizes && sCalls.uResizes == uResizes);
+   ASSURE(SymTable_setTracing(oSymTable, 0));
+   SymTable_getLatency(oSymTable, SYMTABLE_OP_GET, &sLatency);
+   ASSURE(sLatency.uCount == 0);
+   SymTable_free(oSymTable);
+
+   /* 5 ns has a bucket of its own; 1000 ns falls in the bucket of
+      992 to 1023 ns, the 111th */
+   memset(&sLatency, 0, sizeof(sLatency));
+   sLatency.uCount = 4;
+   sLatency.uMax = 1010;
+   sLatency.auBuckets[5] = 2;
+   sLatency.auBuckets[111] = 2;
+   ASSURE(SymTable_latencyAt(&sLatency, 0.5) == 5);
+   ASSURE(SymTable_latencyAt(&sLatency, 0.75) == 1010);
+   sLatency.uMax = 2000;
+   ASSURE(SymTable_latencyAt(&sLatency, 0.75) == 1023);
+   ASSURE(SymTable_latencyAt(&sLatency, 0.0) == 5);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a table with a Bloom filter finds every key it holds and
+   none it does not through growth, removals, shrinking, compaction,
+   clearing and cloning, and that the filter keeps most misses from
+   visiting a bucket. */
+
+static void testFilter(void)
+{
+   enum {COUNT = 20000, MISSES = 10000};
+   SymTable_T oSymTable;
+   SymTable_T oClone;
+   char acKey[KEY_SIZE];
+   struct SymTableStats sStats;
+   size_t v;
+   int iGood = 1;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing Bloom filters.\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_setFilter(oSymTable, 1));
+   ASSURE(SymTable_setFilter(oSymTable, 1));
+   ASSURE(! SymTable_contains(oSymTable, "0"));
+
+   /* Growth rebuilds the filter with the buckets. */
+   for (v = 0; v < COUNT; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_put(oSymTable, acKey, (void*)(v + 1));
+      iGood &= ! SymTable_put(oSymTable, acKey, NULL);
+   }
+   SymTable_resetStats(oSymTable);
+   for (v = 0; v < COUNT + MISSES; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_get(oSymTable, acKey) ==
+         (v < COUNT ? (void*)(v + 1) : NULL);
+   }
+   ASSURE(iGood);
+#ifdef SYMTABLE_STATS
+   /* a hit visits at least one node, and at 8 bits per bucket about
+      1 miss in 50 gets past the filter */
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uMisses == MISSES);
+   ASSURE(sStats.uProbes < COUNT * 2 + MISSES / 10);
+#else
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uProbes == 0);
+#endif
+
+   /* Removals, which rebuild the filter and shrink the table. */
+   for (v = 0; v < COUNT; v += 2)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_remove(oSymTable, acKey) == (void*)(v + 1);
+   }
+   for (v = 0; v < COUNT - 100; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      if (v % 2 == 1)
+         iGood &= SymTable_delete(oSymTable, acKey);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == 50);
+   ASSURE(SymTable_compact(oSymTable));
+   for (v = 0; v < COUNT + MISSES; v++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)v);
+      iGood &= SymTable_contains(oSymTable, acKey) ==
+         (v >= COUNT - 100 && v < COUNT && v % 2 == 1);
+   }
+   ASSURE(iGood);
+
+   /* A clone has a filter of its own. */
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
+   ASSURE(SymTable_put(oClone, "clone", NULL));
+   ASSURE(SymTable_contains(oClone, "clone"));
+   ASSURE(! SymTable_contains(oSymTable, "clone"));
+   sprintf(acKey, "%lu", (unsigned long)(COUNT - 1));
+   ASSURE(SymTable_replace(oClone, acKey, NULL) == (void*)COUNT);
+   SymTable_free(oClone);
+
+   /* A cleared table forgets its keys, and a table without a filter
+      finds what it held with one. */
+   SymTable_clear(oSymTable, NULL);
+   ASSURE(! SymTable_contains(oSymTable, acKey));
+   ASSURE(SymTable_put(oSymTable, acKey, NULL));
+   ASSURE(SymTable_setFilter(oSymTable, 0));
+   ASSURE(SymTable_setFilter(oSymTable, 0));
+   ASSURE(SymTable_contains(oSymTable, acKey));
+   ASSURE(! SymTable_contains(oSymTable, "0"));
+   ASSURE(SymTable_setFilter(oSymTable, 1));
+   ASSURE(SymTable_contains(oSymTable, acKey));
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the value at pValue to the sum at pvExtra, and check that it is
+   half of key. */
+
+static void sumValue(long key, double *pValue, void *pvExtra)
+{
+   assert(pValue != NULL);
+   assert(pvExtra != NULL);
+   ASSURE(*pValue == (double)key / 2);
+   *(double*)pvExtra += *pValue;
+}
+
+/* Test the tables symtablegen.h generates: integer keys through
+   growth, removals, shrinking and clearing, with values stored in the
+   table, and string keys with the client's equality function. */
+
+static void testGenerated(void)
+{
+   enum {COUNT = 20000};
+   IntTable_T oInts;
+   NameTable_T oNames;
+   char acKey[KEY_SIZE];
+   double dValue;
+   double dSum = 0;
+   long l;
+   int iGood = 1;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing generated tables.\n");
+   fflush(stdout);
+
+   oInts = IntTable_new();
+   ASSURE(oInts != NULL);
+   ASSURE(IntTable_getLength(oInts) == 0);
+   ASSURE(IntTable_get(oInts, 0) == NULL);
+   for (l = -COUNT; l < COUNT; l++)
+   {
+      iGood &= IntTable_put(oInts, l, (double)l / 2);
+      iGood &= ! IntTable_put(oInts, l, 0);
+   }
+   ASSURE(IntTable_getLength(oInts) == 2 * COUNT);
+   for (l = -COUNT - 100; l < COUNT + 100; l++)
+      iGood &= IntTable_contains(oInts, l) == (l >= -COUNT && l < COUNT);
+   ASSURE(iGood);
+
+   /* Values are updated in place. */
+   *IntTable_get(oInts, 7) = 8;
+   ASSURE(*IntTable_get(oInts, 7) == 8);
+   ASSURE(IntTable_remove(oInts, 7, &dValue) && dValue == 8);
+   ASSURE(! IntTable_remove(oInts, 7, &dValue));
+   ASSURE(IntTable_put(oInts, 7, 3.5));
+
+   IntTable_map(oInts, sumValue, &dSum);
+   ASSURE(dSum == -COUNT / 2.0);
+
+   /* Removing most keys shrinks the table. */
+   for (l = -COUNT; l < COUNT - 10; l++)
+      iGood &= IntTable_remove(oInts, l, NULL);
+   ASSURE(IntTable_getLength(oInts) == 10);
+   for (l = COUNT - 10; l < COUNT; l++)
+      iGood &= *IntTable_get(oInts, l) == (double)l / 2;
+   ASSURE(iGood);
+
+   /* A cleared table reuses its nodes. */
+   IntTable_clear(oInts);
+   ASSURE(IntTable_getLength(oInts) == 0);
+   ASSURE(! IntTable_contains(oInts, COUNT - 1));
+   ASSURE(IntTable_put(oInts, COUNT - 1, 1));
+   ASSURE(*IntTable_get(oInts, COUNT - 1) == 1);
+   IntTable_free(oInts);
+   IntTable_free(NULL);
+
+   /* The keys are compared as strings, not as pointers. */
+   oNames = NameTable_new();
+   ASSURE(oNames != NULL);
+   ASSURE(NameTable_put(oNames, "Ruth", 3));
+   strcpy(acKey, "Ruth");
+   ASSURE(! NameTable_put(oNames, acKey, 4));
+   ASSURE(*NameTable_get(oNames, acKey) == 3);
+   ASSURE(NameTable_remove(oNames, acKey, NULL));
+   ASSURE(NameTable_get(oNames, "Ruth") == NULL);
+   NameTable_free(oNames);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the hash table extensions. Write the output of the tests to
+   stdout. Return 0. */
+
+int main(void)
+{
+   testSeeding();
+   testTreeBuckets();
+   testTreeDepth();
+   testResize();
+   testSmallTable();
+   testSharded();
+   testWriter();
+   testBuildParallel();
+   testImage();
+   testText();
+   testFreeze();
+   testSnapshot();
+   testScope();
+   testFilter();
+   testTracing();
+   testGenerated();
+
+   printf("------------------------------------------------------\n");
+   printf("End of testhashext.\n");
+   return 0;
+}
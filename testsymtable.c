@@ -76,6 +76,7 @@ static void printBindingSimple(const char *pcKey, void *pvValue,
    assert(pcKey != NULL);
    assert(pvValue != NULL);
    assert(pvExtra == NULL);
+   (void)pvExtra;
 
    printf("%s\t%s\n", pcKey, (char*)pvValue);
    fflush(stdout);
@@ -776,12 +777,430 @@ static void testCollisions(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Test the SymTable_getStats() and SymTable_resetStats() functions.
+   The counters are checked only when the implementation is compiled
+   with SYMTABLE_STATS defined; otherwise they must all be 0. */
+
+static void testStats(void)
+{
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acShortstop[] = "Shortstop";
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_getStats() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   iSuccessful = SymTable_put(oSymTable, "Jeter", acShortstop);
+   ASSURE(iSuccessful);
+   (void)SymTable_get(oSymTable, "Jeter");
+   (void)SymTable_get(oSymTable, "Clemens");
+   (void)SymTable_contains(oSymTable, "Maris");
+   (void)SymTable_remove(oSymTable, "Jeter");
+
+   SymTable_getStats(oSymTable, &sStats);
+#ifdef SYMTABLE_STATS
+   ASSURE(sStats.uPuts == 1);
+   ASSURE(sStats.uGets == 2);
+   ASSURE(sStats.uContains == 1);
+   ASSURE(sStats.uRemoves == 1);
+   ASSURE(sStats.uHits == 2);
+   ASSURE(sStats.uMisses == 3);
+   ASSURE(sStats.uAllocs >= 1);
+   ASSURE(sStats.uFrees >= 1);
+#else
+   ASSURE(sStats.uPuts == 0);
+   ASSURE(sStats.uHits == 0);
+   ASSURE(sStats.uProbes == 0);
+#endif
+
+   SymTable_resetStats(oSymTable);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uPuts == 0);
+   ASSURE(sStats.uGets == 0);
+   ASSURE(sStats.uProbes == 0);
+   ASSURE(sStats.uKeyCompares == 0);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add 1 to the count at pvValue. */
+
+static void countValue(void *pvValue)
+{
+   assert(pvValue != NULL);
+   (*(int*)pvValue)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_clear() function. */
+
+static void testClear(void)
+{
+   SymTable_T oSymTable;
+   int aiCounts[3] = {0, 0, 0};
+   char acKey[] = "Ruth";
+   size_t uLength;
+   int iSuccessful;
+   int iFound;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_clear() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Clearing an empty table should work. */
+   SymTable_clear(oSymTable, countValue);
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 0);
+
+   iSuccessful = SymTable_put(oSymTable, "Ruth", &aiCounts[0]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Gehrig", &aiCounts[1]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Mantle", &aiCounts[2]);
+   ASSURE(iSuccessful);
+
+   /* The destructor should see every value exactly once. */
+   SymTable_clear(oSymTable, countValue);
+   ASSURE(aiCounts[0] == 1 && aiCounts[1] == 1 && aiCounts[2] == 1);
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 0);
+   iFound = SymTable_contains(oSymTable, "Ruth");
+   ASSURE(! iFound);
+   ASSURE(SymTable_get(oSymTable, "Gehrig") == NULL);
+
+   /* A cleared table should accept the same and new keys again. */
+   for (i = 0; i < 3; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiCounts[i]);
+      ASSURE(iSuccessful);
+      acKey[0]++;
+   }
+   iSuccessful = SymTable_put(oSymTable, "Gehrig", &aiCounts[1]);
+   ASSURE(iSuccessful);
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 4);
+   ASSURE(SymTable_get(oSymTable, "Suth") == &aiCounts[1]);
+   ASSURE(SymTable_get(oSymTable, "Gehrig") == &aiCounts[1]);
+
+   /* Without a destructor, values should be left alone. */
+   SymTable_clear(oSymTable, NULL);
+   ASSURE(aiCounts[0] == 1 && aiCounts[1] == 1 && aiCounts[2] == 1);
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 0);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a table that grows to a few hundred bindings and shrinks back,
+   one binding at a time, checking every binding after each change.
+   Implementations that change their representation with the length of
+   the table, such as symtablearray.c, cross each limit both ways. */
+
+static void testGrowShrink(void)
+{
+   enum {KEY_COUNT = 300};
+   SymTable_T oSymTable;
+   char aacKeys[KEY_COUNT][8];
+   int iSuccessful;
+   int iGood = 1;
+   int iRemove;
+   int i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a table that grows and shrinks.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(aacKeys[i], "k%d", i);
+      iSuccessful = SymTable_put(oSymTable, aacKeys[i], aacKeys[i]);
+      ASSURE(iSuccessful);
+      for (j = 0; j <= i; j++)
+         iGood &= SymTable_get(oSymTable, aacKeys[j]) == aacKeys[j];
+      iGood &= ! SymTable_contains(oSymTable, "k-1");
+   }
+   ASSURE(iGood);
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT);
+
+   /* removes every key in an order unrelated to the order of the
+      puts: i * 7 mod KEY_COUNT visits each i once */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      iRemove = (i * 7) % KEY_COUNT;
+      iGood &= SymTable_remove(oSymTable, aacKeys[iRemove]) ==
+         aacKeys[iRemove];
+      iGood &= SymTable_getLength(oSymTable) ==
+         (size_t)(KEY_COUNT - i - 1);
+      for (j = i + 1; j < KEY_COUNT; j++)
+         iGood &= SymTable_get(oSymTable, aacKeys[(j * 7) % KEY_COUNT])
+            == aacKeys[(j * 7) % KEY_COUNT];
+      iGood &= SymTable_get(oSymTable, aacKeys[iRemove]) == NULL;
+   }
+   ASSURE(iGood);
+
+   /* the emptied table grows again */
+   for (i = 0; i < KEY_COUNT; i++)
+      iGood &= SymTable_put(oSymTable, aacKeys[i], aacKeys[i]);
+   ASSURE(iGood);
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a SymTable object made by SymTable_newWithDestructor(), and the
+   SymTable_delete() function. */
+
+static void testDestructor(void)
+{
+   SymTable_T oSymTable;
+   SymTable_T oClone;
+   int aiCounts[4] = {0, 0, 0, 0};
+   int iSuccessful;
+   int iFound;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_newWithDestructor() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newWithDestructor(countValue);
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_put(oSymTable, "Ruth", &aiCounts[0]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Gehrig", &aiCounts[1]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Mantle", &aiCounts[2]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Maris", &aiCounts[3]);
+   ASSURE(iSuccessful);
+
+   /* SymTable_delete should free the value, SymTable_remove and
+      SymTable_replace should hand it back. */
+   iFound = SymTable_delete(oSymTable, "Ruth");
+   ASSURE(iFound);
+   ASSURE(aiCounts[0] == 1);
+   iFound = SymTable_delete(oSymTable, "Ruth");
+   ASSURE(! iFound);
+   ASSURE(aiCounts[0] == 1);
+   ASSURE(SymTable_remove(oSymTable, "Gehrig") == &aiCounts[1]);
+   ASSURE(SymTable_replace(oSymTable, "Mantle", &aiCounts[1]) ==
+      &aiCounts[2]);
+   ASSURE(aiCounts[1] == 0 && aiCounts[2] == 0);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+
+   /* A clone shares the values but does not free them. */
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
+   iFound = SymTable_delete(oClone, "Maris");
+   ASSURE(iFound);
+   SymTable_free(oClone);
+   ASSURE(aiCounts[1] == 0 && aiCounts[3] == 0);
+
+   /* SymTable_clear without a function should use the destructor,
+      and SymTable_free should free what is left. */
+   SymTable_clear(oSymTable, NULL);
+   ASSURE(aiCounts[1] == 1 && aiCounts[3] == 1);
+   iSuccessful = SymTable_put(oSymTable, "Ruth", &aiCounts[0]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Maris", &aiCounts[3]);
+   ASSURE(iSuccessful);
+   SymTable_free(oSymTable);
+   ASSURE(aiCounts[0] == 2 && aiCounts[3] == 2);
+   ASSURE(aiCounts[1] == 1 && aiCounts[2] == 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the functions that take keys as a pointer and a length: the
+   key is the slice, not the string that continues past it. */
+
+static void testSizedKeys(void)
+{
+   SymTable_T oSymTable;
+   /* "Ruth" and "Gehrig" as slices of a longer buffer */
+   static const char acBuffer[] = "RuthlessGehrigs";
+   int iSuccessful;
+   int iFound;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the functions with key lengths.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_putN(oSymTable, acBuffer, 4, "Ruth");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, acBuffer + 8, 6, "Gehrig");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, "Ruth", 4, "duplicate");
+   ASSURE(! iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, acBuffer, 0, "empty");
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+
+   /* the stored keys are the slices, as strings*/
+   ASSURE(strcmp((char*)SymTable_get(oSymTable, "Ruth"), "Ruth") == 0);
+   ASSURE(strcmp((char*)SymTable_get(oSymTable, "Gehrig"), "Gehrig") == 0);
+   ASSURE(strcmp((char*)SymTable_get(oSymTable, ""), "empty") == 0);
+   ASSURE(! SymTable_contains(oSymTable, "Ruthless"));
+
+   /* prefixes and extensions of a key are other keys*/
+   iFound = SymTable_containsN(oSymTable, acBuffer, 3);
+   ASSURE(! iFound);
+   iFound = SymTable_containsN(oSymTable, acBuffer, 5);
+   ASSURE(! iFound);
+   iFound = SymTable_containsN(oSymTable, acBuffer + 8, 6);
+   ASSURE(iFound);
+   ASSURE(SymTable_getN(oSymTable, acBuffer + 8, 7) == NULL);
+   ASSURE(strcmp((char*)SymTable_getN(oSymTable, "Ruthie", 4),
+      "Ruth") == 0);
+
+   ASSURE(strcmp((char*)SymTable_replaceN(oSymTable, acBuffer, 4,
+      "Babe"), "Ruth") == 0);
+   ASSURE(SymTable_replaceN(oSymTable, acBuffer, 5, "Babe") == NULL);
+   ASSURE(strcmp((char*)SymTable_removeN(oSymTable, acBuffer, 4),
+      "Babe") == 0);
+   ASSURE(SymTable_removeN(oSymTable, acBuffer, 4) == NULL);
+   ASSURE(SymTable_remove(oSymTable, "") != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_clone() function: a clone and its original should
+   hold the same bindings, and then change independently. */
+
+static void testClone(void)
+{
+   enum {CLONE_KEYS = 2000};
+   SymTable_T oSymTable;
+   SymTable_T oClone;
+   SymTable_T oSecond;
+   char acShortstop[] = "Shortstop";
+   char acCatcher[] = "Catcher";
+   char acKey[16];
+   size_t uLength;
+   int iSuccessful;
+   int iFound;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_clone() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Cloning an empty table should work. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
+   uLength = SymTable_getLength(oClone);
+   ASSURE(uLength == 0);
+   SymTable_free(oClone);
+
+   for (i = 0; i < CLONE_KEYS; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+   }
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
+   uLength = SymTable_getLength(oClone);
+   ASSURE(uLength == CLONE_KEYS);
+
+   /* Changes to the original should not show in the clone. */
+   for (i = 0; i < CLONE_KEYS; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == acShortstop);
+   }
+   ASSURE(SymTable_replace(oSymTable, "1", acCatcher) == acShortstop);
+   iSuccessful = SymTable_put(oSymTable, "Jeter", acShortstop);
+   ASSURE(iSuccessful);
+
+   uLength = SymTable_getLength(oClone);
+   ASSURE(uLength == CLONE_KEYS);
+   for (i = 0; i < CLONE_KEYS; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oClone, acKey) == acShortstop);
+   }
+   iFound = SymTable_contains(oClone, "Jeter");
+   ASSURE(! iFound);
+
+   /* Changes to the clone should not show in the original. */
+   for (i = 1; i < CLONE_KEYS; i += 4)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oClone, acKey) == acShortstop);
+   }
+   ASSURE(SymTable_replace(oClone, "3", acCatcher) == acShortstop);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == CLONE_KEYS / 2 + 1);
+   ASSURE(SymTable_get(oSymTable, "1") == acCatcher);
+   ASSURE(SymTable_get(oSymTable, "3") == acShortstop);
+   ASSURE(SymTable_get(oSymTable, "5") == acShortstop);
+   ASSURE(SymTable_get(oSymTable, "0") == NULL);
+   uLength = SymTable_getLength(oClone);
+   ASSURE(uLength == CLONE_KEYS - CLONE_KEYS / 4);
+   ASSURE(SymTable_get(oClone, "1") == NULL);
+   ASSURE(SymTable_get(oClone, "3") == acCatcher);
+   ASSURE(SymTable_get(oClone, "0") == acShortstop);
+
+   /* A clone of a clone should outlive both, and the original should
+      survive its clone. */
+   oSecond = SymTable_clone(oClone);
+   ASSURE(oSecond != NULL);
+   SymTable_free(oClone);
+   SymTable_clear(oSymTable, NULL);
+   uLength = SymTable_getLength(oSecond);
+   ASSURE(uLength == CLONE_KEYS - CLONE_KEYS / 4);
+   ASSURE(SymTable_get(oSecond, "3") == acCatcher);
+   ASSURE(SymTable_get(oSecond, "2") == acShortstop);
+   iSuccessful = SymTable_put(oSymTable, "Jeter", acCatcher);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_get(oSecond, "Jeter") == NULL);
+   SymTable_free(oSecond);
+   ASSURE(SymTable_get(oSymTable, "Jeter") == acCatcher);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the ability of a SymTable object to be large, that is, to
    contain iBindingCount bindings. Write the time consumed to stdout. */
 
 static void testLargeTable(int iBindingCount)
 {
-   enum {MAX_KEY_LENGTH = 10};
+   /* room for the decimal digits of any int, its sign and '\0' */
+   enum {MAX_KEY_LENGTH = 12};
 
    SymTable_T oSymTable;
    SymTable_T oSymTableSmall;
@@ -960,6 +1379,12 @@ int main(int argc, char *argv[])
    testLongKey();
    testTableOfTables();
    testCollisions();
+   testStats();
+   testClear();
+   testGrowShrink();
+   testClone();
+   testDestructor();
+   testSizedKeys();
    testLargeTable(iBindingCount);
 
    printf("------------------------------------------------------\n");
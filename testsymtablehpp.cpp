@@ -0,0 +1,166 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablehpp.cpp                                                */
+/* Author: Devanna Ritchie                                            */
+/*--------------------------------------------------------------------*/
+
+/* Test the C++ wrapper of symtable.hpp: ownership, string_view keys
+   that are slices of larger strings, and iteration. */
+
+#include "symtable.hpp"
+#include <cstdio>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(bool iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      std::printf("Test at line %d failed.\n", iLineNum);
+      std::fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test lookups through string_view keys, which need not be followed
+   by '\0'. */
+
+static void testKeys(void)
+{
+   symtable::Table<int> oTable;
+   std::string_view sBuffer = "RuthlessGehrigs";
+   int aiValues[3] = {0, 1, 2};
+
+   std::printf("------------------------------------------------------\n");
+   std::printf("Testing string_view keys.\n");
+   std::fflush(stdout);
+
+   ASSURE(oTable.empty());
+   ASSURE(oTable.try_emplace(sBuffer.substr(0, 4), &aiValues[0]) ==
+      std::make_pair(&aiValues[0], true));
+   ASSURE(oTable.try_emplace(sBuffer.substr(8, 6), &aiValues[1]).second);
+   ASSURE(oTable.try_emplace("Ruth", &aiValues[2]) ==
+      std::make_pair(&aiValues[0], false));
+   ASSURE(oTable.size() == 2);
+
+   ASSURE(oTable.find("Ruth") == &aiValues[0]);
+   ASSURE(oTable.find(std::string("Gehrig")) == &aiValues[1]);
+   ASSURE(oTable.find(sBuffer.substr(0, 5)) == nullptr);
+   ASSURE(! oTable.contains(sBuffer));
+   ASSURE(oTable.contains(sBuffer.substr(8, 6)));
+
+   ASSURE(oTable.replace("Ruth", &aiValues[2]) == &aiValues[0]);
+   ASSURE(oTable.replace("Babe", &aiValues[2]) == nullptr);
+   ASSURE(oTable.remove(sBuffer.substr(0, 4)) == &aiValues[2]);
+   ASSURE(oTable.remove("Ruth") == nullptr);
+   ASSURE(oTable.size() == 1);
+
+   /* a default view has no characters, and is the empty key */
+   ASSURE(oTable.try_emplace(std::string_view(), &aiValues[0]).second);
+   ASSURE(oTable.find("") == &aiValues[0]);
+   ASSURE(oTable.contains(std::string_view()));
+   ASSURE(oTable.replace(std::string_view(), &aiValues[2]) ==
+      &aiValues[0]);
+   ASSURE(oTable.remove(std::string_view()) == &aiValues[2]);
+   ASSURE(oTable.find(std::string_view()) == nullptr);
+
+   /* the wrapped table sees the same keys */
+   ASSURE(SymTable_get(oTable.get(), "Gehrig") == &aiValues[1]);
+   oTable.clear();
+   ASSURE(oTable.empty());
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that copies are independent, that moves transfer the table,
+   and that iteration visits every binding once. */
+
+static void testOwnership(void)
+{
+   enum {COUNT = 1000};
+   symtable::Table<const std::string> oTable;
+   std::string asKeys[COUNT];
+   std::map<std::string, int> oSeen;
+   std::size_t u;
+   bool iGood = true;
+
+   std::printf("------------------------------------------------------\n");
+   std::printf("Testing copies, moves and iteration.\n");
+   std::fflush(stdout);
+
+   for (u = 0; u < COUNT; u++)
+   {
+      asKeys[u] = std::to_string(u);
+      iGood &= oTable.try_emplace(asKeys[u], &asKeys[u]).second;
+   }
+   ASSURE(iGood);
+
+   symtable::Table<const std::string> oCopy(oTable);
+   ASSURE(oCopy.remove("0") == &asKeys[0]);
+   ASSURE(oTable.find("0") == &asKeys[0]);
+   ASSURE(oCopy.size() == COUNT - 1);
+
+   symtable::Table<const std::string> oMoved(std::move(oCopy));
+   ASSURE(oMoved.size() == COUNT - 1);
+   oCopy = oTable;
+   ASSURE(oCopy.size() == COUNT);
+   oCopy = std::move(oMoved);
+   ASSURE(oCopy.size() == COUNT - 1);
+
+   for (const auto &sBinding : oTable.bindings())
+   {
+      iGood &= sBinding.key == *sBinding.value;
+      oSeen[std::string(sBinding.key)]++;
+   }
+   ASSURE(iGood);
+   ASSURE(oSeen.size() == COUNT);
+
+   u = 0;
+   oCopy.forEach([&u, &iGood](std::string_view key,
+      const std::string *psValue) {
+      iGood &= key == *psValue;
+      u++;
+   });
+   ASSURE(iGood);
+   ASSURE(u == COUNT - 1);
+
+   /* an exception stops the iteration and reaches the caller */
+   u = 0;
+   try
+   {
+      oCopy.forEach([&u](std::string_view, const std::string *) {
+         if (++u == 10)
+            throw std::runtime_error("stop");
+      });
+      ASSURE(false);
+   }
+   catch (const std::runtime_error &)
+   {
+      ASSURE(u == 10);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the C++ wrapper. Write the output of the tests to stdout.
+   Return 0. */
+
+int main(void)
+{
+   testKeys();
+   testOwnership();
+
+   std::printf("------------------------------------------------------\n");
+   std::printf("End of testsymtablehpp.\n");
+   return 0;
+}